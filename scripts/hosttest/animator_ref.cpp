@@ -0,0 +1,164 @@
+/****************************************************************************
+ * The old key handlers, see animator_ref.h. Unchanged apart from the names.
+ ****************************************************************************/
+#include <math.h>
+#include "animator_ref.h"
+
+void RefAnimator::LoadKeyFrames(const u8 *file, u8 tag_count, u32 offset, u8 key_set)
+{
+	const u32 *tag_offsets = (const u32 *) (file + offset);
+
+	for(u32 tag = 0; tag < tag_count; tag++)
+	{
+		const Anim_Header *animHdr = (const Anim_Header *) (file + tag_offsets[tag]);
+
+		u32 animation_type = animHdr->animation_type;
+		u8 frame_count = animHdr->frame_count;
+
+		const u32 *frame_offsets = (const u32 *) (animHdr + 1);
+
+		for(u32 frame = 0; frame < frame_count; frame++)
+		{
+			const KeyFrame_Header *keyFrame = (const KeyFrame_Header *)(((const u8 *) animHdr) + frame_offsets[frame]);
+			const KeyType frame_type(static_cast<AnimationType>(animation_type), keyFrame->index, keyFrame->target);
+
+			switch (keyFrame->data_type)
+			{
+				// step key frame
+			case 0x01:
+				keys[key_set].step_keys[frame_type].Load((const u8 *) (keyFrame+1), keyFrame->key_count);
+				break;
+
+				// hermite key frame
+			case 0x02:
+				keys[key_set].hermite_keys[frame_type].Load((const u8 *) (keyFrame+1), keyFrame->key_count);
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+}
+
+void RefAnimator::SetFrame(FrameNumber frame_number, u8 key_set)
+{
+	std::map<KeyType, RefHermiteKeyHandler>::iterator itr;
+	for(itr = keys[key_set].hermite_keys.begin(); itr != keys[key_set].hermite_keys.end(); itr++)
+	{
+		const KeyType& frame_type = itr->first;
+		const float frame_value = itr->second.GetFrame(frame_number);
+
+		ProcessHermiteKey(frame_type, frame_value);
+	}
+
+	std::map<KeyType, RefStepKeyHandler>::iterator itr2;
+	for(itr2 = keys[key_set].step_keys.begin(); itr2 != keys[key_set].step_keys.end(); itr2++)
+	{
+		const KeyType& frame_type = itr2->first;
+		StepKeyHandler::KeyData const frame_data = itr2->second.GetFrame(frame_number);
+
+		ProcessStepKey(frame_type, frame_data);
+	}
+}
+
+void RefStepKeyHandler::Load(const u8 *file, u16 count)
+{
+	while (count--)
+	{
+		FrameNumber frame;
+		frame = *((FrameNumber *) file);
+		file += 4;
+
+		KeyData& data = keys[frame];
+		data.data1 = *file;
+		file++;
+		data.data2 = *file;
+		file++;
+
+		file += 2;
+	}
+}
+
+void RefHermiteKeyHandler::Load(const u8 *file, u16 count)
+{
+	while (count--)
+	{
+		std::pair<FrameNumber, KeyData> pair;
+
+		// read the frame number, value and slope
+		pair.first = *((FrameNumber *) file);
+		file += 4;
+		pair.second.value = *((float *) file);
+		file += 4;
+		pair.second.slope = *((float *) file);
+		file += 4;
+
+		keys.insert(pair);
+
+		//std::cout << "\t\t\t" "frame: " << frame << ' ' << keys[frame] << '\n';
+	}
+}
+
+RefStepKeyHandler::KeyData RefStepKeyHandler::GetFrame(FrameNumber frame_number) const
+{
+	// assuming not empty, a safe assumption currently
+
+	// find the current frame, or the one after it
+	std::map<FrameNumber, KeyData>::const_iterator frame_it = keys.lower_bound(frame_number);
+
+	// current frame is higher than any keyframe, use the last keyframe
+	if (keys.end() == frame_it)
+		--frame_it;
+
+	// if this is after the current frame and not the first keyframe, use the previous one
+	if (frame_number < frame_it->first && keys.begin() != frame_it)
+		--frame_it;
+
+	return frame_it->second;
+}
+
+float RefHermiteKeyHandler::GetFrame(FrameNumber frame_number) const
+{
+	// assuming not empty, a safe assumption currently
+
+	// find the current keyframe, or the one after it
+	std::multimap<FrameNumber, KeyData>::const_iterator next = keys.lower_bound(frame_number);
+
+	// current frame is higher than any keyframe, use the last keyframe
+	if (keys.end() == next)
+		--next;
+
+	std::multimap<FrameNumber, KeyData>::const_iterator prev = next;
+
+	// if this is after the current frame and not the first keyframe, use the previous one
+	if (frame_number < prev->first && keys.begin() != prev)
+		--prev;
+
+	const float nf = next->first - prev->first;
+	if (fabs(nf) < 0.01)
+	{
+		// same frame numbers, just return the first's value
+		return prev->second.value;
+	}
+	else
+	{
+		// different frames, blend them together
+		// this is a "Cubic Hermite spline" apparently
+
+		frame_number =	 (frame_number < prev->first) ? prev->first :
+						((frame_number > next->first) ? next->first : frame_number);
+
+		const float t = (frame_number - prev->first) / nf;
+
+		// old curve-less code
+		//return prev->second.value + (next->second.value - prev->second.value) * t;
+
+		// curvy code from marcan, :p
+		return
+			prev->second.slope * nf * (t + pow(t, 3) - 2 * pow(t, 2)) +
+			next->second.slope * nf * (pow(t, 3) - pow(t, 2)) +
+			prev->second.value * (1 + (2 * pow(t, 3) - 3 * pow(t, 2))) +
+			next->second.value * (-2 * pow(t, 3) + 3 * pow(t, 2));
+	}
+}
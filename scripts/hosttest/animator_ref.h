@@ -0,0 +1,57 @@
+/****************************************************************************
+ * The banner key handlers and Animator key loop as they were before the
+ * keyframes got baked into flat arrays in source/banner/Animator.cpp, with
+ * Ref in front of the names so test_animator can hold both.
+ ****************************************************************************/
+#ifndef ANIMATOR_REF_H_
+#define ANIMATOR_REF_H_
+
+#include "banner/Animator.h"
+
+class RefStepKeyHandler
+{
+public:
+	void Load(const u8* file, u16 count);
+
+	typedef StepKeyHandler::KeyData KeyData;
+
+	KeyData GetFrame(FrameNumber frame_number) const;
+
+private:
+	std::map<FrameNumber, KeyData> keys;
+};
+
+class RefHermiteKeyHandler
+{
+public:
+	void Load(const u8* file, u16 count);
+
+	typedef HermiteKeyHandler::KeyData KeyData;
+
+	float GetFrame(FrameNumber frame_number) const;
+
+private:
+	std::multimap<FrameNumber, KeyData> keys;
+};
+
+class RefAnimator
+{
+public:
+	virtual ~RefAnimator() {}
+
+	void LoadKeyFrames(const u8 *file, u8 tag_count, u32 offset, u8 key_set);
+	virtual void SetFrame(FrameNumber frame, u8 key_set);
+
+protected:
+	virtual void ProcessHermiteKey(const KeyType& type, float value) = 0;
+	virtual void ProcessStepKey(const KeyType& type, StepKeyHandler::KeyData data) = 0;
+private:
+
+	struct
+	{
+		std::map<KeyType, RefStepKeyHandler> step_keys;
+		std::map<KeyType, RefHermiteKeyHandler> hermite_keys;
+	} keys[2];
+};
+
+#endif
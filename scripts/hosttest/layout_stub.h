@@ -0,0 +1,20 @@
+/* forced ahead of source/banner/Animator.cpp so it builds without the GX
+   side of Layout.h, nothing in the tests loads a whole brlan */
+#ifndef LAYOUT_H_
+#define LAYOUT_H_
+
+#include <string>
+#include <gctypes.h>
+
+class Pane;
+class Material;
+
+class Layout
+{
+public:
+	Pane *FindPane(const std::string &name) { (void)name; return NULL; }
+	Material *FindMaterial(const std::string &name) { (void)name; return NULL; }
+	void AddPalette(const std::string &name, u8 key_set) { (void)name; (void)key_set; }
+};
+
+#endif
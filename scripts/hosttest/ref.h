@@ -0,0 +1,19 @@
+/* the decoders from before the rewrite, see ash_ref.cpp and lz77_ref.c */
+#ifndef _REF_H_
+#define _REF_H_
+
+#include <gctypes.h>
+
+#ifdef __cplusplus
+u8 *RefDecompressAsh( const u8 *stuff, u32 &len );
+
+extern "C" {
+#endif
+
+int refDecompressLZ77content(const u8 *buffer, u32 length, u8 **output, u32 *outputLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,45 @@
+/* host stand-in for libogc's gccore.h, the caches are coherent here and
+   LWP threads and mutexes map onto pthreads */
+#ifndef __GCCORE_H__
+#define __GCCORE_H__
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <gctypes.h>
+
+typedef pthread_mutex_t *mutex_t;
+typedef pthread_t *lwp_t;
+
+#define LWP_MUTEX_NULL	NULL
+#define LWP_THREAD_NULL	NULL
+
+static inline void DCFlushRange(void *p, u32 len) { (void)p; (void)len; }
+
+static inline s32 LWP_MutexInit(mutex_t *m, bool recursive)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	if(recursive)
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	*m = (mutex_t)malloc(sizeof(pthread_mutex_t));
+	return pthread_mutex_init(*m, &attr);
+}
+
+static inline s32 LWP_MutexLock(mutex_t m) { return pthread_mutex_lock(m); }
+static inline s32 LWP_MutexUnlock(mutex_t m) { return pthread_mutex_unlock(m); }
+
+static inline s32 LWP_CreateThread(lwp_t *t, void *(*entry)(void *), void *arg, void *stack, u32 stackSize, u8 prio)
+{
+	(void)stack; (void)stackSize; (void)prio;
+	*t = (lwp_t)malloc(sizeof(pthread_t));
+	return pthread_create(*t, NULL, entry, arg);
+}
+
+static inline s32 LWP_JoinThread(lwp_t t, void **ret)
+{
+	s32 r = pthread_join(*t, ret);
+	free(t);
+	return r;
+}
+
+#endif
@@ -0,0 +1,28 @@
+/* host stand-in for libogc's gctypes.h */
+#ifndef __GCTYPES_H__
+#define __GCTYPES_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef float f32;
+typedef double f64;
+typedef volatile u8 vu8;
+typedef volatile u16 vu16;
+typedef volatile u32 vu32;
+
+#define ATTRIBUTE_ALIGN(v)	__attribute__((aligned(v)))
+#define ATTRIBUTE_PACKED	__attribute__((packed))
+
+#endif
@@ -0,0 +1,9 @@
+/* host stand-in for source/gecko/gecko.hpp, logs go to stderr */
+#ifndef _GECKO_HPP_
+#define _GECKO_HPP_
+
+#include <stdio.h>
+
+#define gprintf(...)	fprintf(stderr, __VA_ARGS__)
+
+#endif
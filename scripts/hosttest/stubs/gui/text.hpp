@@ -0,0 +1,16 @@
+/* host stand-in for gui/text.hpp, the string helpers without FreeType */
+#ifndef __TEXT_HPP
+#define __TEXT_HPP
+
+#include <string>
+#include <gctypes.h>
+#include "wstringEx/wstringEx.hpp"
+
+using std::string;
+
+string sfmt(const char *format, ...);
+string upperCase(string text);
+string lowerCase(string text);
+bool wchar_cmp(const wchar_t *first, const wchar_t *second, u32 first_len, u32 second_len);
+
+#endif
@@ -0,0 +1,13 @@
+/* host stand-in for gui/vector.hpp, just the fields */
+#ifndef __VECTOR_HPP
+#define __VECTOR_HPP
+
+class Vector3D
+{
+public:
+	float x, y, z;
+	Vector3D(void) { x = 0.f; y = 0.f; z = 0.f; }
+	Vector3D(float px, float py, float pz) { x = px; y = py; z = pz; }
+};
+
+#endif
@@ -0,0 +1,18 @@
+/* host stand-in for gui/video.hpp, only CColor without the GX side */
+#ifndef __VIDEO_HPP
+#define __VIDEO_HPP
+
+#include <gccore.h>
+
+class CColor
+{
+public:
+	u8 r, g, b, a;
+	CColor(void) { r = 0; g = 0; b = 0; a = 0xFF; }
+	CColor(u8 pr, u8 pg, u8 pb) { r = pr; g = pg; b = pb; a = 0xFF; }
+	CColor(u8 pr, u8 pg, u8 pb, u8 pa) { r = pr; g = pg; b = pb; a = pa; }
+	bool operator==(const CColor &c) const { return c.r == r && c.g == g && c.b == b && c.a == a; }
+	bool operator!=(const CColor &c) const { return !(*this == c); }
+};
+
+#endif
@@ -0,0 +1,29 @@
+/* host stand-in for source/memory/mem2.hpp, every pool is the C heap */
+#ifndef __MEM2_HPP
+#define __MEM2_HPP
+
+#include <stdlib.h>
+
+static inline void *MEM2_alloc(unsigned int s) { return malloc(s); }
+static inline void *MEM2_realloc(void *p, unsigned int s) { return realloc(p, s); }
+static inline void MEM2_free(void *p) { free(p); }
+static inline void *MEM2_lo_alloc(unsigned int s) { return malloc(s); }
+static inline void MEM2_lo_free(void *p) { free(p); }
+
+/* pool telemetry for mem_trace.cpp, a test using it provides these */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+unsigned int MEM1_freesize();
+unsigned int MEM1_lo_freesize();
+unsigned int MEM1_lo_largestfree();
+unsigned int MEM2_lo_freesize();
+unsigned int MEM2_lo_largestfree();
+unsigned int MEM2_freesize();
+unsigned int MEM2_largestfree();
+#ifdef __cplusplus
+}
+#endif
+
+#endif
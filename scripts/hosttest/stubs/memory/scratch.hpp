@@ -0,0 +1,23 @@
+/* host stand-in for source/memory/scratch.hpp, no thread has an arena */
+#ifndef _SCRATCH_HPP_
+#define _SCRATCH_HPP_
+
+#include <gctypes.h>
+
+class ScratchArena
+{
+public:
+	void *Alloc(u32 size) { (void)size; return NULL; }
+	static ScratchArena *Current() { return NULL; }
+};
+
+class ScratchScope
+{
+public:
+	ScratchScope(ScratchArena &a) : arena(a) {}
+	void *Alloc(u32 size) { return arena.Alloc(size); }
+private:
+	ScratchArena &arena;
+};
+
+#endif
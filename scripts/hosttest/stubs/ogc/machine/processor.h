@@ -0,0 +1,8 @@
+/* host stand-in for libogc's processor.h, there are no interrupts to mask */
+#ifndef __PROCESSOR_H__
+#define __PROCESSOR_H__
+
+#define _CPU_ISR_Disable(level)	((level) = 0)
+#define _CPU_ISR_Restore(level)	((void)(level))
+
+#endif
@@ -0,0 +1,47 @@
+/* sfmt, upperCase, lowerCase and wchar_cmp as source/gui/text.cpp has them */
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "gui/text.hpp"
+
+string sfmt(const char *format, ...)
+{
+	char buffer[1024];
+	va_list va;
+	va_start(va, format);
+	size_t len = vsnprintf(buffer, sizeof buffer - 1, format, va);
+	va_end(va);
+	buffer[sizeof buffer - 1] = '\0';
+	return string(buffer, len < sizeof buffer ? len : sizeof buffer - 1);
+}
+
+string upperCase(string text)
+{
+	for (string::size_type i = 0; i < text.size(); ++i)
+		if (text[i] >= 'a' && text[i] <= 'z')
+			text[i] &= 0xDF;
+	return text;
+}
+
+string lowerCase(string text)
+{
+	for (string::size_type i = 0; i < text.size(); ++i)
+		if (text[i] >= 'A' && text[i] <= 'Z')
+			text[i] |= 0x20;
+	return text;
+}
+
+bool wchar_cmp(const wchar_t *first, const wchar_t *second, u32 first_len, u32 second_len)
+{
+	u32 i = 0;
+	while((i < first_len) && (i < second_len))
+	{
+		if(tolower(first[i]) < tolower(second[i]))
+			return true;
+		else if(tolower(first[i]) > tolower(second[i]))
+			return false;
+		++i;
+	}
+	return first_len < second_len;
+}
@@ -0,0 +1,265 @@
+/****************************************************************************
+ * Replays a generated channel banner through the Animator from source/banner
+ * and through the old std::map/pow() key handlers in animator_ref: the start
+ * sequence once, then the loop the way Layout::AdvanceFrame steps it, plus
+ * fractional and out of range frames. Every key value has to match, then
+ * both play the full loop for the benchmark.
+ ****************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "banner/Animator.h"
+#include "animator_ref.h"
+
+static u32 rngState = 0x3C6EF372;
+static u32 Rand()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return rngState;
+}
+
+static float RandFloat(float lo, float hi)
+{
+	return lo + (hi - lo) * (Rand() % 100000) / 100000.f;
+}
+
+template<typename T> static void Put(std::vector<u8> &blob, T v)
+{
+	blob.insert(blob.end(), (const u8 *)&v, (const u8 *)&v + sizeof(v));
+}
+
+template<typename T> static T &At(std::vector<u8> &blob, u32 offset)
+{
+	return *(T *)&blob[offset];
+}
+
+/* one pai1 animator entry: AnimatorHeader, tag offsets, then per tag an
+   Anim_Header, its key frame offsets and the key frames with their keys,
+   laid out the way Animator::LoadKeyFrames walks them */
+struct Tag
+{
+	AnimationType type;
+	u8 dataType;
+	u8 lists;
+	u8 maxTarget;
+};
+
+static std::vector<u8> MakeAnimator(const std::vector<Tag> &tags, u32 frames)
+{
+	std::vector<u8> blob(sizeof(AnimatorHeader), 0);
+	At<AnimatorHeader>(blob, 0).tag_count = tags.size();
+	u32 tagOffsets = blob.size();
+	blob.resize(blob.size() + 4 * tags.size());
+	for(u32 t = 0; t < tags.size(); ++t)
+	{
+		u32 anim = blob.size();
+		At<u32>(blob, tagOffsets + 4 * t) = anim;
+		Put(blob, (u32)tags[t].type);
+		Put(blob, (u32)0);
+		At<Anim_Header>(blob, anim).frame_count = tags[t].lists;
+		u32 listOffsets = blob.size();
+		blob.resize(blob.size() + 4 * tags[t].lists);
+		for(u32 l = 0; l < tags[t].lists; ++l)
+		{
+			At<u32>(blob, listOffsets + 4 * l) = blob.size() - anim;
+			u16 count = 1 + Rand() % 24;
+			KeyFrame_Header kf;
+			memset(&kf, 0, sizeof(kf));
+			kf.index = Rand() % 2;
+			kf.target = l % (tags[t].maxTarget + 1);
+			kf.data_type = tags[t].dataType;
+			kf.key_count = count;
+			Put(blob, kf);
+			for(u16 k = 0; k < count; ++k)
+			{
+				/* mostly ascending, some out of order and some sharing a frame */
+				float frame = (float)(k * frames / count);
+				if(Rand() % 8 == 0)
+					frame = (float)(Rand() % frames);
+				else if(Rand() % 8 == 0)
+					frame += 0.5f;
+				Put(blob, frame);
+				if(tags[t].dataType == 2)
+				{
+					Put(blob, RandFloat(-300.f, 300.f));
+					Put(blob, Rand() % 4 == 0 ? 0.f : RandFloat(-8.f, 8.f));
+				}
+				else
+				{
+					Put(blob, (u8)(Rand() % 256));
+					Put(blob, (u8)(Rand() % 256));
+					Put(blob, (u16)0);
+				}
+			}
+		}
+	}
+	return blob;
+}
+
+/* both animators hand each key to a sink, either to compare or to sum up */
+struct Sink
+{
+	std::vector<float> *values;
+	double sum;
+	void Hermite(const KeyType &type, float value)
+	{
+		if(values != NULL)
+			values->push_back(value);
+		sum += value + type.target;
+	}
+	void Step(const KeyType &type, StepKeyHandler::KeyData data)
+	{
+		if(values != NULL)
+		{
+			values->push_back(data.data1);
+			values->push_back(data.data2);
+		}
+		sum += data.data1 + data.data2 + type.target;
+	}
+};
+
+class NewAnimator final : public Animator
+{
+public:
+	NewAnimator(Sink &s) : sink(s) {}
+protected:
+	void ProcessHermiteKey(const KeyType &type, float value) { sink.Hermite(type, value); }
+	void ProcessStepKey(const KeyType &type, StepKeyHandler::KeyData data) { sink.Step(type, data); }
+private:
+	Sink &sink;
+};
+
+class OldAnimator final : public RefAnimator
+{
+public:
+	OldAnimator(Sink &s) : sink(s) {}
+protected:
+	void ProcessHermiteKey(const KeyType &type, float value) { sink.Hermite(type, value); }
+	void ProcessStepKey(const KeyType &type, StepKeyHandler::KeyData data) { sink.Step(type, data); }
+private:
+	Sink &sink;
+};
+
+static const u32 startFrames = 120;
+static const u32 loopFrames = 600;
+
+/* 60 panes and 20 materials, the start sequence in key set 0 and the loop in 1 */
+template<typename A> struct Banner
+{
+	Sink sink;
+	std::vector<A *> animators;
+	Banner(const std::vector<std::vector<u8> > &blobs)
+	{
+		sink.values = NULL;
+		sink.sum = 0;
+		for(u32 i = 0; i < blobs.size(); i += 2)
+		{
+			A *a = new A(sink);
+			a->LoadKeyFrames(blobs[i].data(), ((const AnimatorHeader *)blobs[i].data())->tag_count, sizeof(AnimatorHeader), 0);
+			a->LoadKeyFrames(blobs[i+1].data(), ((const AnimatorHeader *)blobs[i+1].data())->tag_count, sizeof(AnimatorHeader), 1);
+			animators.push_back(a);
+		}
+	}
+	~Banner()
+	{
+		for(u32 i = 0; i < animators.size(); ++i)
+			delete animators[i];
+	}
+	/* Layout::SetFrame */
+	void SetFrame(FrameNumber frame)
+	{
+		const u8 key_set = frame >= startFrames;
+		if(key_set)
+			frame -= startFrames;
+		for(u32 i = 0; i < animators.size(); ++i)
+			animators[i]->SetFrame(frame, key_set);
+	}
+	/* the start sequence, then the loop the given number of times */
+	void Play(u32 loops)
+	{
+		for(u32 f = 0; f < startFrames + loops * loopFrames; ++f)
+			SetFrame(f < startFrames ? f : startFrames + (f - startFrames) % loopFrames);
+	}
+};
+
+static std::vector<std::vector<u8> > MakeBanner(void)
+{
+	std::vector<Tag> pane = { { ANIMATION_TYPE_PANE, 2, 6, 9 }, { ANIMATION_TYPE_VISIBILITY, 1, 1, 0 },
+		{ ANIMATION_TYPE_VERTEX_COLOR, 2, 4, 15 } };
+	std::vector<Tag> material = { { ANIMATION_TYPE_MATERIAL_COLOR, 2, 4, 15 }, { ANIMATION_TYPE_TEXTURE_SRT, 2, 3, 4 },
+		{ ANIMATION_TYPE_TEXTURE_PALETTE, 1, 1, 0 } };
+	std::vector<std::vector<u8> > blobs;
+	for(u32 i = 0; i < 80; ++i)
+	{
+		blobs.push_back(MakeAnimator(i < 60 ? pane : material, startFrames));
+		blobs.push_back(MakeAnimator(i < 60 ? pane : material, loopFrames));
+	}
+	return blobs;
+}
+
+static bool Close(float a, float b)
+{
+	return fabsf(a - b) <= 1e-3f + 1e-4f * (fabsf(a) + fabsf(b));
+}
+
+template<typename F> static double Ms(F f)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main()
+{
+	std::vector<std::vector<u8> > blobs = MakeBanner();
+	Banner<NewAnimator> newBanner(blobs);
+	Banner<OldAnimator> oldBanner(blobs);
+
+	std::vector<FrameNumber> frames;
+	for(u32 f = 0; f < startFrames + 2 * loopFrames; ++f)
+		frames.push_back(f < startFrames ? f : startFrames + (f - startFrames) % loopFrames);
+	for(float f = 0.f; f < startFrames + loopFrames; f += 0.25f)
+		frames.push_back(f);
+	for(u32 i = 0; i < 2000; ++i)
+		frames.push_back(RandFloat(-20.f, startFrames + loopFrames + 20.f));
+
+	std::vector<float> got, want;
+	newBanner.sink.values = &got;
+	oldBanner.sink.values = &want;
+	u32 wrong = 0;
+	for(u32 i = 0; i < frames.size(); ++i)
+	{
+		got.clear();
+		want.clear();
+		newBanner.SetFrame(frames[i]);
+		oldBanner.SetFrame(frames[i]);
+		if(got.size() != want.size())
+		{
+			printf("FAIL frame %g: %zu keys, the old handlers give %zu\n", frames[i], got.size(), want.size());
+			return 1;
+		}
+		for(u32 k = 0; k < got.size(); ++k)
+		{
+			if(!Close(got[k], want[k]) && wrong++ < 5)
+				printf("FAIL frame %g key %u: %g, the old handlers give %g\n", frames[i], k, got[k], want[k]);
+		}
+	}
+	printf("%zu frames compared, %u keys differ\n", frames.size(), wrong);
+	if(wrong != 0)
+		return 1;
+
+	newBanner.sink.values = NULL;
+	oldBanner.sink.values = NULL;
+	const u32 loops = 20;
+	double newMs = Ms([&] { newBanner.Play(loops); });
+	double oldMs = Ms([&] { oldBanner.Play(loops); });
+	u32 played = startFrames + loops * loopFrames;
+	printf("%zu animators, %u frames: baked %.2f ms (%.2f us/frame), old %.2f ms (%.2f us/frame)\n",
+		newBanner.animators.size(), played, newMs, newMs * 1000 / played, oldMs, oldMs * 1000 / played);
+	return 0;
+}
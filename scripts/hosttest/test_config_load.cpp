@@ -0,0 +1,207 @@
+/****************************************************************************
+ * Checks Config::load from source/config against the old getline parser in
+ * RefConfig: an ini full of odd lines and a generated 50k line plugin CRC
+ * database (the <platform>.ini files in plugins_data) have to end up as the
+ * same domains, keys and values. Then times loading the database with both
+ * and counts the heap allocations a load makes.
+ ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <new>
+#include <string>
+
+#include "config/config.hpp"
+#include "config_ref.hpp"
+
+static u64 allocCount = 0;
+
+void *operator new(size_t size)
+{
+	++allocCount;
+	void *p = malloc(size != 0 ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+/* lines the parser has to skip, trim, lower case, unescape or ignore */
+static const char *oddIni =
+	"# comment before any domain\n"
+	"orphan=no domain yet\n"
+	"[General]\r\n"
+	"Key One = spaced value  \r\n"
+	"\tTabbed\t=\ttabbed value\t\n"
+	"UPPER=Value Stays\n"
+	"escaped=line\\nbreak and \\\\ and \\q\n"
+	"empty=\n"
+	"=no key\n"
+	"no equals sign\n"
+	"a=b=c\n"
+	"dup=first\n"
+	"dup=second\n"
+	"   # not a comment once indented=1\n"
+	"\n"
+	"   \n"
+	"[]\n"
+	"lost=in the empty domain\n"
+	"[Missing bracket\n"
+	"after=missing bracket\n"
+	"[second]  \n"
+	"x=1\n"
+	"[GENERAL]\n"
+	"again=ignored, the domain was already read\n"
+	"[empty domain]\n"
+	"[third]\n"
+	"trailing=backslash\\\n"
+	"last=no newline at the end";
+
+static u32 rngState = 0x1B873593;
+static u32 Rand()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return rngState;
+}
+
+/* filename=GameID|crc1|crc2|... the way Plugin::GetRomId reads it */
+static std::string MakeDatabase(u32 lines)
+{
+	static const char *words[] = { "Super", "Mario", "Kart", "Street", "Fighter", "Final", "Fantasy",
+		"Aleste", "Donkey", "Kong", "Country", "Star", "Fox", "Secret", "of", "Mana", "Chrono", "Trigger" };
+	static const char *tags[] = { "", " (USA)", " (Europe)", " (Japan)", " (Rev 1)", " (Beta)", " (Proto)" };
+	std::string db("[SUPERNES]\n");
+	char buf[64];
+	for(u32 i = 1; i < lines; ++i)
+	{
+		u32 w = 1 + Rand() % 4;
+		for(u32 j = 0; j < w; ++j)
+		{
+			if(j > 0)
+				db += ' ';
+			db += words[Rand() % (sizeof words / sizeof words[0])];
+		}
+		snprintf(buf, sizeof buf, " %u%s=%06X", i, tags[Rand() % (sizeof tags / sizeof tags[0])], Rand() & 0xFFFFFF);
+		db += buf;
+		for(u32 crcs = 1 + Rand() % 3; crcs > 0; --crcs)
+		{
+			snprintf(buf, sizeof buf, "|%08X", Rand());
+			db += buf;
+		}
+		db += '\n';
+	}
+	return db;
+}
+
+static void WriteFile(const char *path, const std::string &data)
+{
+	FILE *f = fopen(path, "wb");
+	fwrite(data.data(), 1, data.size(), f);
+	fclose(f);
+}
+
+static std::string ReadFile(const char *path)
+{
+	std::string data;
+	FILE *f = fopen(path, "rb");
+	if(f == NULL)
+		return data;
+	char buf[65536];
+	size_t len;
+	while((len = fread(buf, 1, sizeof buf, f)) > 0)
+		data.append(buf, len);
+	fclose(f);
+	return data;
+}
+
+/* loads the text, then saves it back through the class so both can be
+   compared as plain files. the marker makes sure save() writes */
+template<typename C> static std::string LoadAndSave(const std::string &text, const char *path)
+{
+	WriteFile(path, text);
+	C c;
+	c.load(path);
+	c.setString("zzzz", "saved", "1");
+	c.save();
+	std::string data(ReadFile(path));
+	unlink(path);
+	return data;
+}
+
+static bool Compare(const char *name, const std::string &text)
+{
+	std::string got(LoadAndSave<Config>(text, "build/load_new.ini"));
+	std::string want(LoadAndSave<RefConfig>(text, "build/load_old.ini"));
+	if(got == want)
+	{
+		printf("%-9s %zu bytes loaded the same\n", name, text.size());
+		return true;
+	}
+	size_t i = 0;
+	while(i < got.size() && i < want.size() && got[i] == want[i])
+		++i;
+	size_t start = i > 40 ? i - 40 : 0;
+	printf("FAIL %s differs at %zu:\n--- Config\n%s\n--- RefConfig\n%s\n", name, i,
+		got.substr(start, 80).c_str(), want.substr(start, 80).c_str());
+	return false;
+}
+
+template<typename C> static void Bench(const char *name, const char *path, u32 runs)
+{
+	u64 allocs = allocCount;
+	double best = 0;
+	for(u32 i = 0; i < runs; ++i)
+	{
+		C c;
+		auto t0 = std::chrono::steady_clock::now();
+		c.load(path);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+		if(i == 0)
+		{
+			allocs = allocCount - allocs;
+			best = ms;
+		}
+		best = ms < best ? ms : best;
+	}
+	/* the fastest run, the others only add noise from the rest of the machine */
+	printf("%-9s load %7.2f ms, %llu allocations\n", name, best, (unsigned long long)allocs);
+}
+
+int main()
+{
+	std::string db(MakeDatabase(50000));
+	if(!Compare("odd lines", oddIni) || !Compare("database", db))
+		return 1;
+
+	/* a save cut off before the rename leaves only the .tmp behind, Config
+	   loads that and puts it in place */
+	const char *path = "build/load_tmp.ini";
+	std::string tmp(std::string(path) + ".tmp");
+	unlink(path);
+	WriteFile(tmp.c_str(), "[A]\nk=v\n");
+	{
+		Config c;
+		c.load(path);
+		if(c.getString("A", "k") != "v" || access(path, F_OK) != 0 || access(tmp.c_str(), F_OK) == 0)
+		{
+			printf("FAIL the leftover .tmp file wasn't loaded and renamed\n");
+			return 1;
+		}
+	}
+	unlink(path);
+
+	path = "build/load_db.ini";
+	WriteFile(path, db);
+	Bench<Config>("Config", path, 20);
+	Bench<RefConfig>("RefConfig", path, 20);
+	unlink(path);
+	return 0;
+}
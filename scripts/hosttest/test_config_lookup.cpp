@@ -0,0 +1,263 @@
+/****************************************************************************
+ * Checks the string_view lookups of Config from source/config against the
+ * old RefConfig: the same calls on the same data return the same values and
+ * leave the same file behind. Then times getString, getInt, getBool and has
+ * on a config the size of a full gameconfig and counts the heap allocations
+ * each lookup makes.
+ ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "config/config.hpp"
+#include "config_ref.hpp"
+
+static u64 allocCount = 0;
+
+void *operator new(size_t size)
+{
+	++allocCount;
+	void *p = malloc(size != 0 ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+static std::string ColorText(const CColor &c)
+{
+	char buf[16];
+	snprintf(buf, sizeof buf, "%02X%02X%02X%02X", c.r, c.g, c.b, c.a);
+	return buf;
+}
+
+/* runs the same calls on either class, every result goes into out as text */
+template<typename C> static void Scenario(C &c, std::vector<std::string> &out)
+{
+	std::string longKey(100, 'Q');
+	std::string longDomain(80, 'd');
+
+	c.setString("General", "Title", "WiiFlow");
+	c.setInt("general", "cover_buffer", 20);
+	c.setBool("GENERAL", "Parental", true);
+	c.setOptBool("rmcp01", "cheat", 1);
+	c.setUInt("RMCP01", "Hooktype", 7u);
+	c.setFloat("rmcp01", "Zoom", 1.25f);
+	c.setVector3D("Coverflow", "Top_Angle", Vector3D(1.f, -2.5f, 30.f));
+	c.setColor("Coverflow", "Color", CColor(0x12, 0x34, 0x56, 0x78));
+	c.setString("general", longKey, "long key");
+	c.setString(longDomain, "k", "long domain");
+	c.setString("multi", "text", "line one\nline two\\end");
+	c.setWString("multi", "wide", wstringEx(L"wéde"));
+	c.setString("lists", "ids", "RMCP01, SMNE01,,RSBE01 ");
+
+	out.push_back(c.getString("GENERAL", "TITLE"));
+	out.push_back(std::to_string(c.getInt("General", "Cover_Buffer")));
+	out.push_back(std::to_string(c.getBool("general", "parental")));
+	out.push_back(std::to_string(c.getOptBool("RMCP01", "CHEAT")));
+	out.push_back(std::to_string(c.testOptBool("rmcp01", "cheat", false)));
+	out.push_back(std::to_string(c.getUInt("rmcp01", "hooktype")));
+	out.push_back(std::to_string(c.getFloat("RMCP01", "zoom")));
+	Vector3D v = c.getVector3D("coverflow", "top_angle");
+	out.push_back(std::to_string(v.x) + " " + std::to_string(v.y) + " " + std::to_string(v.z));
+	out.push_back(ColorText(c.getColor("COVERFLOW", "COLOR")));
+	out.push_back(c.getString("GENERAL", std::string(100, 'q')));
+	out.push_back(c.getString(std::string(80, 'D'), "K"));
+	out.push_back(c.getString("Multi", "Text"));
+	out.push_back(c.getWString("multi", "wide").toUTF8());
+	for(const std::string &s : c.getStrings("LISTS", "IDS"))
+		out.push_back("[" + s + "]");
+	int value = -1;
+	out.push_back(std::to_string(c.getInt("general", "cover_buffer", &value)) + " " + std::to_string(value));
+	out.push_back(std::to_string(c.getInt("general", "missing", &value)) + " " + std::to_string(value));
+
+	/* missing values come back as the default and get added */
+	out.push_back(std::to_string(c.getInt("new", "thing", 5)));
+	out.push_back(std::to_string(c.has("NEW", "THING")));
+	out.push_back(std::to_string(c.getBool("new", "flag", true)));
+	out.push_back(c.getString("new", "name", "def"));
+	out.push_back(std::to_string(c.getOptBool("new", "opt")));
+	out.push_back(std::to_string(c.getUInt("new", "u", 9u)));
+	for(const std::string &s : c.getStrings("new", "list", ',', "a,b"))
+		out.push_back("[" + s + "]");
+
+	/* values the parsers have to cope with. getColor keeps string positions in
+	   a u32, which only matches npos on the Wii, so no missing colors and
+	   nothing shorter than a color behind the # */
+	c.setString("parse", "b1", "Yes");
+	c.setString("parse", "b2", "ON");
+	c.setString("parse", "b3", "1");
+	c.setString("parse", "b4", "no");
+	c.setString("parse", "b5", "maybe");
+	c.setString("parse", "i1", " 42abc");
+	c.setString("parse", "c1", "#abcdef");
+	c.setString("parse", "c2", "#12345G");
+	c.setString("parse", "v1", "1,2");
+	for(const char *k : { "b1", "b2", "b3", "b4", "b5" })
+		out.push_back(std::to_string(c.getBool("parse", k, true)) + std::to_string(c.getOptBool("parse", k)));
+	out.push_back(std::to_string(c.getInt("parse", "i1")));
+	out.push_back(ColorText(c.getColor("parse", "c1")));
+	out.push_back(ColorText(c.getColor("parse", "c2", CColor(9, 9, 9))));
+	v = c.getVector3D("parse", "v1", Vector3D(4.f, 5.f, 6.f));
+	out.push_back(std::to_string(v.x) + " " + std::to_string(v.y) + " " + std::to_string(v.z));
+
+	/* empty names never match or add anything */
+	out.push_back(std::to_string(c.has("", "title")) + std::to_string(c.has("general", "")));
+	out.push_back(c.getString("", "x", "empty") + c.getString("general", "", "empty"));
+
+	c.remove("general", "PARENTAL");
+	out.push_back(std::to_string(c.has("general", "parental")));
+
+	c.copyDomain("copy", "RMCP01");
+	c.copyDomain("coverflow", "coverflow");
+	out.push_back(std::to_string(c.getUInt("COPY", "hooktype")) + " " + c.getString("coverflow", "color"));
+	out.push_back(c.nextDomain("COPY") + " " + c.prevDomain("COPY") + " " + c.nextDomain("ZZZ") + " " + c.prevDomain("AAA"));
+	for(std::string d = c.firstDomain(); !d.empty(); d = c.nextDomain())
+		out.push_back("<" + d + ">");
+}
+
+/* both classes only write changed files, the marker makes sure they do */
+template<typename C> static std::string SavedFile(C &c, const char *path)
+{
+	c.setString("zzzz", "saved", "1");
+	c.save();
+	std::string data;
+	FILE *f = fopen(path, "rb");
+	if(f == NULL)
+		return data;
+	char buf[4096];
+	size_t len;
+	while((len = fread(buf, 1, sizeof buf, f)) > 0)
+		data.append(buf, len);
+	fclose(f);
+	return data;
+}
+
+static u32 rngState = 0x2545F491;
+static u32 Rand()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return rngState;
+}
+
+/* game IDs as domains with the keys a gameconfig has for each of them */
+static const char *gameKeys[] = { "language", "video_mode", "ios", "hooktype", "cheat", "debugger",
+	"emulate_save", "ocarina", "vipatch", "country_patch", "private_server", "aspect_ratio",
+	"patch_video_modes", "return_to_channel", "adult_only", "deflicker_wii" };
+
+template<typename C> static void Fill(C &c, std::vector<std::string> &ids)
+{
+	for(u32 i = 0; i < 2000; ++i)
+	{
+		char id[8];
+		snprintf(id, sizeof id, "R%c%c%c%02u", 'A' + Rand() % 26, 'A' + Rand() % 26, 'A' + Rand() % 26, i % 100);
+		ids.push_back(id);
+		for(const char *key : gameKeys)
+			c.setInt(id, key, Rand() % 8);
+	}
+	c.setString("GENERAL", "partition", "USB1");
+	c.setBool("GENERAL", "parental", false);
+}
+
+struct Timing
+{
+	double ns;
+	double allocs;
+};
+
+template<typename F> static Timing Measure(u32 count, F f)
+{
+	u64 allocs = allocCount;
+	auto t0 = std::chrono::steady_clock::now();
+	f();
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+	return { ns / count, (double)(allocCount - allocs) / count };
+}
+
+/* each lookup the way menu code does it: a game ID in a std::string, key and
+   fallback domain as literals */
+template<typename C> static void Bench(const char *name, const std::vector<std::string> &ids, const std::vector<u32> &order)
+{
+	C c;
+	std::vector<std::string> fill;
+	rngState = 0x2545F491;
+	Fill(c, fill);
+	u32 n = order.size();
+	u64 sum = 0;
+	Timing s = Measure(n, [&] { for(u32 i : order) sum += c.getString(ids[i], "language").size(); });
+	Timing v = Measure(n, [&] { for(u32 i : order) sum += c.getInt(ids[i], "video_mode"); });
+	Timing b = Measure(n, [&] { for(u32 i : order) sum += c.getBool(ids[i], "patch_video_modes"); });
+	Timing h = Measure(n, [&] { for(u32 i : order) sum += c.has(ids[i], "return_to_channel"); });
+	Timing g = Measure(n, [&] { for(u32 i = 0; i < n; ++i) sum += c.getBool("GENERAL", "parental"); });
+	printf("%-9s getString %6.1f ns %4.2f allocs, getInt %6.1f ns %4.2f allocs, getBool %6.1f ns %4.2f allocs,"
+		" has %6.1f ns %4.2f allocs, GENERAL getBool %6.1f ns %4.2f allocs (%llu)\n", name,
+		s.ns, s.allocs, v.ns, v.allocs, b.ns, b.allocs, h.ns, h.allocs, g.ns, g.allocs, (unsigned long long)sum);
+}
+
+int main()
+{
+	const char *newPath = "build/lookup_new.ini";
+	const char *oldPath = "build/lookup_old.ini";
+	unlink(newPath);
+	unlink(oldPath);
+
+	Config c;
+	RefConfig r;
+	c.load(newPath);
+	r.load(oldPath);
+	std::vector<std::string> got, want;
+	Scenario(c, got);
+	Scenario(r, want);
+	int failures = 0;
+	for(size_t i = 0; i < got.size() || i < want.size(); ++i)
+	{
+		const char *g = i < got.size() ? got[i].c_str() : "(none)";
+		const char *w = i < want.size() ? want[i].c_str() : "(none)";
+		if(i >= got.size() || i >= want.size() || got[i] != want[i])
+		{
+			printf("FAIL result %zu: '%s', RefConfig gives '%s'\n", i, g, w);
+			++failures;
+		}
+	}
+	/* RefConfig added an empty domain when removing from one that wasn't there */
+	c.remove("nothere", "x");
+	if(c.hasDomain("NOTHERE"))
+	{
+		printf("FAIL remove() added a domain\n");
+		++failures;
+	}
+	if(SavedFile(c, newPath) != SavedFile(r, oldPath))
+	{
+		printf("FAIL saved files differ, compare %s and %s\n", newPath, oldPath);
+		++failures;
+	}
+	printf("%zu results compared, %d differ\n", got.size(), failures);
+	if(failures != 0)
+		return 1;
+	unlink(newPath);
+	unlink(oldPath);
+
+	std::vector<std::string> ids;
+	{
+		Config fill;
+		rngState = 0x2545F491;
+		Fill(fill, ids);
+	}
+	std::vector<u32> order;
+	for(u32 i = 0; i < 500000; ++i)
+		order.push_back(Rand() % ids.size());
+	Bench<Config>("Config", ids, order);
+	Bench<RefConfig>("RefConfig", ids, order);
+	return 0;
+}
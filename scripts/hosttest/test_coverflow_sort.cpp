@@ -0,0 +1,305 @@
+/****************************************************************************
+ * Sorts 50k generated games the way CCoverFlow does, with the sort keys
+ * CItem builds once and _sortItems' index sort, and the old way, by-value
+ * comparators over whole items and std::sort moving the items. Every sort
+ * mode has to give the same order, then both are timed.
+ * coverflow.cpp needs GX, so CItem's keys, the comparators and _sortItems
+ * are copied below and have to be kept in step with source/gui/coverflow.cpp.
+ ****************************************************************************/
+#include <ctype.h>
+#include <string.h>
+#include <stdio.h>
+#include <wchar.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <gccore.h>
+#include "loader/disc.h"
+#include "gui/texture.hpp"
+#include "gui/text.hpp"
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
+
+using std::vector;
+
+enum TexState { STATE_Loading, STATE_Ready, STATE_NoCover };
+enum Sort { SORT_ALPHA, SORT_PLAYCOUNT, SORT_LASTPLAYED, SORT_GAMEID, SORT_PLAYERS, SORT_WIFIPLAYERS, SORT_BTN_NUMBERS, SORT_COUNT };
+static const char *sortNames[SORT_COUNT] = { "alpha", "playcount", "lastplayed", "gameid", "players", "wifi", "buttons" };
+
+/* CCoverFlow::CItem, its constructor and comparators */
+struct CItem
+{
+	CItem(dir_discHdr *itemHdr, int playcount, unsigned int lastPlayed);
+	dir_discHdr *hdr;
+	int playcount;
+	unsigned int lastPlayed;
+	u64 alphaKey;
+	u64 idKey;
+	u16 titleLen;
+	u8 navStart;
+	TexData texture;
+	volatile bool boxTexture;
+	volatile enum TexState state;
+} ATTRIBUTE_PACKED;
+
+CItem::CItem(dir_discHdr *itemHdr, int playcount, unsigned int lastPlayed) :
+	hdr(itemHdr),
+	playcount(playcount),
+	lastPlayed(lastPlayed),
+	boxTexture(false),
+	state(STATE_Loading)
+{
+	titleLen = wcsnlen(hdr->title, ARRAY_SIZE(hdr->title));
+	navStart = 0;// only for letter jumps, not sorting
+	alphaKey = 0;
+	for(u32 i = 0; i < 2 && i < titleLen; ++i)
+		alphaKey |= (u64)(u32)tolower(hdr->title[i]) << (32 - i * 32);
+	idKey = 0;
+	for(u32 i = 0; i < sizeof(hdr->id) && hdr->id[i] != '\0'; ++i)
+		idKey |= (u64)(u8)toupper(hdr->id[i]) << (56 - i * 8);
+}
+
+static bool _sortByAlpha(const CItem &item1, const CItem &item2)
+{
+	if(item1.alphaKey != item2.alphaKey)
+		return item1.alphaKey < item2.alphaKey;
+	return wchar_cmp(item1.hdr->title, item2.hdr->title, item1.titleLen, item2.titleLen);
+}
+
+static bool _sortByPlayCount(const CItem &item1, const CItem &item2)
+{
+	return (item1.playcount == item2.playcount) ? _sortByAlpha(item1, item2) : item1.playcount > item2.playcount;
+}
+
+static bool _sortByLastPlayed(const CItem &item1, const CItem &item2)
+{
+	return (item1.lastPlayed == item2.lastPlayed) ? _sortByPlayCount(item1, item2) : item1.lastPlayed > item2.lastPlayed;
+}
+
+static bool _sortByGameID(const CItem &item1, const CItem &item2)
+{
+	return item1.idKey < item2.idKey;
+}
+
+static bool _sortByPlayers(const CItem &item1, const CItem &item2)
+{
+	if(item1.hdr->players == item2.hdr->players) return _sortByAlpha(item1, item2);
+	return item1.hdr->players < item2.hdr->players;
+}
+
+static bool _sortByWifiPlayers(const CItem &item1, const CItem &item2)
+{
+	if(item1.hdr->wifi == item2.hdr->wifi) return _sortByAlpha(item1, item2);
+	return item1.hdr->wifi < item2.hdr->wifi;
+}
+
+static bool _sortByBtnNumbers(const CItem &item1, const CItem &item2)
+{
+	if(item1.hdr->settings[0] == item2.hdr->settings[0]) return _sortByAlpha(item1, item2);
+	return item1.hdr->settings[0] < item2.hdr->settings[0];
+}
+
+static void _sortItems(vector<CItem> &m_items, int m_sorting)
+{
+	bool (*cmp)(const CItem &, const CItem &) = NULL;
+	switch(m_sorting)
+	{
+		case SORT_ALPHA: cmp = _sortByAlpha; break;
+		case SORT_PLAYCOUNT: cmp = _sortByPlayCount; break;
+		case SORT_LASTPLAYED: cmp = _sortByLastPlayed; break;
+		case SORT_GAMEID: cmp = _sortByGameID; break;
+		case SORT_PLAYERS: cmp = _sortByPlayers; break;
+		case SORT_WIFIPLAYERS: cmp = _sortByWifiPlayers; break;
+		case SORT_BTN_NUMBERS: cmp = _sortByBtnNumbers; break;
+		default: return;
+	}
+
+	u32 n = m_items.size();
+	vector<u32> order(n);
+	for(u32 i = 0; i < n; ++i)
+		order[i] = i;
+	sort(order.begin(), order.end(), [&m_items, cmp](u32 a, u32 b) { return cmp(m_items[a], m_items[b]); });
+
+	for(u32 i = 0; i < n; ++i)
+	{
+		if(order[i] == i)
+			continue;
+		CItem tmp = m_items[i];
+		u32 j = i;
+		while(order[j] != i)
+		{
+			u32 k = order[j];
+			m_items[j] = m_items[k];
+			order[j] = j;
+			j = k;
+		}
+		m_items[j] = tmp;
+		order[j] = j;
+	}
+}
+
+/* the item and comparators before the sort keys */
+struct RefItem
+{
+	RefItem(dir_discHdr *itemHdr, int playcount, unsigned int lastPlayed) :
+		hdr(itemHdr), playcount(playcount), lastPlayed(lastPlayed), boxTexture(false), state(STATE_Loading) { }
+	dir_discHdr *hdr;
+	int playcount;
+	unsigned int lastPlayed;
+	TexData texture;
+	volatile bool boxTexture;
+	volatile enum TexState state;
+} ATTRIBUTE_PACKED;
+
+static bool _refSortByAlpha(RefItem item1, RefItem item2)
+{
+	const wchar_t *first = item1.hdr->title;
+	const wchar_t *second = item2.hdr->title;
+	return wchar_cmp(first, second, wcslen(first), wcslen(second));
+}
+
+static bool _refSortByPlayCount(RefItem item1, RefItem item2)
+{
+	return (item1.playcount == item2.playcount) ? _refSortByAlpha(item1, item2) : item1.playcount > item2.playcount;
+}
+
+static bool _refSortByLastPlayed(RefItem item1, RefItem item2)
+{
+	return (item1.lastPlayed == item2.lastPlayed) ? _refSortByPlayCount(item1, item2) : item1.lastPlayed > item2.lastPlayed;
+}
+
+static bool _refSortByGameID(RefItem item1, RefItem item2)
+{
+	u32 s = std::min(strlen(item1.hdr->id), strlen(item2.hdr->id));
+	for(u32 k = 0; k < s; ++k)
+	{
+		if(toupper(item1.hdr->id[k]) > toupper(item2.hdr->id[k]))
+			return false;
+		else if(toupper(item1.hdr->id[k]) < toupper(item2.hdr->id[k]))
+			return true;
+	}
+
+	return strlen(item1.hdr->id) < strlen(item2.hdr->id);
+}
+
+static bool _refSortByPlayers(RefItem item1, RefItem item2)
+{
+	if(item1.hdr->players == item2.hdr->players) return _refSortByAlpha(item1, item2);
+	return item1.hdr->players < item2.hdr->players;
+}
+
+static bool _refSortByWifiPlayers(RefItem item1, RefItem item2)
+{
+	if(item1.hdr->wifi == item2.hdr->wifi) return _refSortByAlpha(item1, item2);
+	return item1.hdr->wifi < item2.hdr->wifi;
+}
+
+static bool _refSortByBtnNumbers(RefItem item1, RefItem item2)
+{
+	if(item1.hdr->settings[0] == item2.hdr->settings[0]) return _refSortByAlpha(item1, item2);
+	return item1.hdr->settings[0] < item2.hdr->settings[0];
+}
+
+static bool (*refSorts[SORT_COUNT])(RefItem, RefItem) = { _refSortByAlpha, _refSortByPlayCount, _refSortByLastPlayed,
+	_refSortByGameID, _refSortByPlayers, _refSortByWifiPlayers, _refSortByBtnNumbers };
+
+static u32 rngState = 0x510E527F;
+static u32 Rand()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return rngState;
+}
+
+/* titles share their first words a lot so the alpha keys tie and wchar_cmp
+   has to decide, case differs between otherwise equal titles. only Latin-1,
+   wchar_cmp calls tolower on every char and glibc's table ends at 255 */
+static vector<dir_discHdr> MakeGames(u32 count)
+{
+	static const wchar_t *words[] = { L"the", L"The", L"Super", L"super", L"Mario", L"Zelda", L"Legend", L"of",
+		L"Star", L"Wars", L"Pokémon", L"Écran", L"2", L"3D", L"Deluxe", L"Party", L"Sports", L"Kart", L"A", L"a" };
+	static const u32 magics[] = { 0, 0x4E45535F, 0x534E4553, 0x47424100, 0x4D454741 };
+	vector<dir_discHdr> games(count);
+	for(u32 i = 0; i < count; ++i)
+	{
+		dir_discHdr &h = games[i];
+		memset(&h, 0, sizeof(h));
+		u32 len = 0;
+		for(u32 w = 1 + Rand() % 5; w > 0; --w)
+		{
+			const wchar_t *word = words[Rand() % ARRAY_SIZE(words)];
+			if(len > 0 && len < ARRAY_SIZE(h.title) - 1)
+				h.title[len++] = L' ';
+			for(; *word != L'\0' && len < ARRAY_SIZE(h.title) - 1; ++word)
+				h.title[len++] = *word;
+		}
+		if(Rand() % 4 == 0)
+			swprintf(h.title + len, ARRAY_SIZE(h.title) - len, L" %u", Rand() % 100);
+		/* disc ids, channel ids and the odd lower case or short id */
+		u32 idLen = Rand() % 8 == 0 ? 4 : (Rand() % 16 == 0 ? 1 + Rand() % 6 : 6);
+		for(u32 c = 0; c < idLen; ++c)
+		{
+			u32 r = Rand() % 40;
+			h.id[c] = r < 26 ? 'A' + r : (r < 36 ? '0' + r - 26 : 'a' + r % 4);
+		}
+		h.players = 1 + Rand() % 4;
+		h.wifi = Rand() % 9;
+		h.settings[0] = magics[Rand() % ARRAY_SIZE(magics)];
+	}
+	return games;
+}
+
+/* sorts only promise the order of items that aren't equal to each other */
+static bool Equivalent(const RefItem &a, const RefItem &b, int mode)
+{
+	return !refSorts[mode](a, b) && !refSorts[mode](b, a);
+}
+
+template<typename F> static double Ms(F f)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main()
+{
+	vector<dir_discHdr> games = MakeGames(50000);
+	vector<int> playcount(games.size());
+	vector<unsigned int> lastPlayed(games.size());
+	for(u32 i = 0; i < games.size(); ++i)
+	{
+		playcount[i] = Rand() % 4 == 0 ? Rand() % 20 : 0;
+		lastPlayed[i] = playcount[i] > 0 ? 1700000000 + Rand() % 1000 : 0;
+	}
+
+	int failures = 0;
+	for(int mode = 0; mode < SORT_COUNT; ++mode)
+	{
+		vector<CItem> items;
+		vector<RefItem> refItems;
+		double keyMs = Ms([&] {
+			for(u32 i = 0; i < games.size(); ++i)
+				items.push_back(CItem(&games[i], playcount[i], lastPlayed[i]));
+		});
+		for(u32 i = 0; i < games.size(); ++i)
+			refItems.push_back(RefItem(&games[i], playcount[i], lastPlayed[i]));
+		double newMs = Ms([&] { _sortItems(items, mode); });
+		double oldMs = Ms([&] { std::sort(refItems.begin(), refItems.end(), refSorts[mode]); });
+
+		u32 wrong = 0;
+		for(u32 i = 0; i < items.size(); ++i)
+		{
+			RefItem got(items[i].hdr, items[i].playcount, items[i].lastPlayed);
+			if(!Equivalent(got, refItems[i], mode) && wrong++ < 3)
+				printf("FAIL %s position %u: %ls (%s), the old sort has %ls (%s)\n", sortNames[mode], i,
+					got.hdr->title, got.hdr->id, refItems[i].hdr->title, refItems[i].hdr->id);
+		}
+		printf("%-10s keys %6.2f ms, index sort %7.2f ms, old sort %7.2f ms, %u out of place\n",
+			sortNames[mode], keyMs, newMs, oldMs, wrong);
+		failures += wrong;
+	}
+	return failures != 0;
+}
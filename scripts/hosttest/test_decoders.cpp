@@ -0,0 +1,507 @@
+/****************************************************************************
+ * Checks the ASH0 and LZ77 decoders in source/unzip against the ones they
+ * replaced, byte for byte, through every entry point: the allocating one,
+ * the caller buffer one and streaming with several chunk sizes. The corpus
+ * is generated and compressed here, then both sides decode the same data.
+ * Ends with a timing of the old and new one shot decoders.
+ ****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "unzip/ash.h"
+#include "unzip/lz77.h"
+#include "ref.h"
+
+typedef std::vector<u8> Bytes;
+
+static u32 rngState = 0x12345678;
+static u32 Rand()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return rngState;
+}
+
+/* corpus */
+
+static Bytes MakeRandom(u32 size)
+{
+	Bytes b(size);
+	for(u32 i = 0; i < size; ++i)
+		b[i] = Rand();
+	return b;
+}
+
+static Bytes MakeText(u32 size)
+{
+	static const char *words[] = { "banner", "sound", "layout", "texture", "pane", "group",
+		"the ", "wii", "channel", "\n", "  ", "animation", "material", "<xml>", "</xml>" };
+	Bytes b;
+	while(b.size() < size)
+	{
+		const char *w = words[Rand() % (sizeof(words) / sizeof(words[0]))];
+		b.insert(b.end(), w, w + strlen(w));
+		b.push_back(' ');
+	}
+	b.resize(size);
+	return b;
+}
+
+static Bytes MakeRuns(u32 size)
+{
+	Bytes b;
+	while(b.size() < size)
+	{
+		u8 v = Rand();
+		u32 n = 1 + Rand() % 600;
+		b.insert(b.end(), n, v);
+	}
+	b.resize(size);
+	return b;
+}
+
+/* fixed size records with a few changed bytes, like texture and layout data */
+static Bytes MakeRecords(u32 size)
+{
+	Bytes rec = MakeRandom(48);
+	Bytes b;
+	while(b.size() < size)
+	{
+		rec[Rand() % rec.size()] = Rand();
+		if(Rand() % 8 == 0)
+		{
+			Bytes noise = MakeRandom(Rand() % 64);
+			b.insert(b.end(), noise.begin(), noise.end());
+		}
+		b.insert(b.end(), rec.begin(), rec.end());
+	}
+	b.resize(size);
+	return b;
+}
+
+/* greedy matcher shared by both encoders */
+
+struct Token
+{
+	u32 len;	// 0 for a literal
+	u32 dist;
+	u8 lit;
+};
+
+static std::vector<Token> Tokenize(const Bytes &in, u32 maxDist, u32 minLen, u32 maxLen)
+{
+	std::vector<Token> out;
+	std::vector<s32> head(1 << 16, -1);
+	std::vector<s32> prev(in.size(), -1);
+	u32 i = 0;
+	while(i < in.size())
+	{
+		u32 bestLen = 0, bestDist = 0;
+		if(i + 3 <= in.size())
+		{
+			u32 h = ((in[i] << 8) ^ (in[i + 1] << 4) ^ in[i + 2]) & 0xFFFF;
+			u32 tries = 64;
+			for(s32 p = head[h]; p >= 0 && i - p <= maxDist && tries--; p = prev[p])
+			{
+				u32 l = 0;
+				while(l < maxLen && i + l < in.size() && in[p + l] == in[i + l])
+					l++;
+				if(l > bestLen)
+				{
+					bestLen = l;
+					bestDist = i - p;
+				}
+			}
+		}
+		u32 step = 1;
+		if(bestLen >= minLen)
+		{
+			out.push_back((Token){ bestLen, bestDist, 0 });
+			step = bestLen;
+		}
+		else
+			out.push_back((Token){ 0, 0, in[i] });
+		for(u32 k = 0; k < step; ++k, ++i)
+		{
+			if(i + 3 > in.size())
+				continue;
+			u32 h = ((in[i] << 8) ^ (in[i + 1] << 4) ^ in[i + 2]) & 0xFFFF;
+			prev[i] = head[h];
+			head[h] = i;
+		}
+	}
+	return out;
+}
+
+/* ASH0 encoder */
+
+struct BitWriter
+{
+	std::vector<u32> words;
+	u32 cur = 0;
+	u32 used = 0;
+	void Put(u32 value, u32 bits)
+	{
+		while(bits--)
+		{
+			cur = (cur << 1) | ((value >> bits) & 1);
+			if(++used == 32)
+			{
+				words.push_back(cur);
+				cur = used = 0;
+			}
+		}
+	}
+	void Finish()
+	{
+		if(used > 0)
+			words.push_back(cur << (32 - used));
+		/* the old decoder fetches the next word as soon as the last bit of one is used */
+		words.push_back(0);
+		words.push_back(0);
+		cur = used = 0;
+	}
+};
+
+struct HuffTree
+{
+	std::vector<s32> left, right;	// inner nodes, children >= 0 are nodes, < 0 are ~symbol
+	s32 root;
+	std::vector<u32> code, length;	// per symbol
+
+	void Build(std::vector<u32> freq)
+	{
+		/* two leaves at least, a single leaf can't be encoded */
+		u32 used = 0;
+		for(u32 f : freq)
+			used += f > 0;
+		for(u32 s = 0; used < 2; ++s)
+		{
+			if(freq[s] == 0)
+			{
+				freq[s] = 1;
+				used++;
+			}
+		}
+		typedef std::pair<u64, s32> Item;
+		std::priority_queue<Item, std::vector<Item>, std::greater<Item> > q;
+		for(u32 s = 0; s < freq.size(); ++s)
+			if(freq[s] > 0)
+				q.push(Item(freq[s], ~(s32)s));
+		left.clear();
+		right.clear();
+		while(q.size() > 1)
+		{
+			Item a = q.top(); q.pop();
+			Item b = q.top(); q.pop();
+			left.push_back(a.second);
+			right.push_back(b.second);
+			q.push(Item(a.first + b.first, left.size() - 1));
+		}
+		root = q.top().second;
+		code.assign(freq.size(), 0);
+		length.assign(freq.size(), 0);
+		Assign(root, 0, 0);
+	}
+	void Assign(s32 node, u32 c, u32 len)
+	{
+		if(node < 0)
+		{
+			code[~node] = c;
+			length[~node] = len;
+			return;
+		}
+		Assign(left[node], c << 1, len + 1);
+		Assign(right[node], (c << 1) | 1, len + 1);
+	}
+	void Write(BitWriter &bw, s32 node, u32 leafBits) const
+	{
+		if(node < 0)
+		{
+			bw.Put(0, 1);
+			bw.Put(~node, leafBits);
+			return;
+		}
+		bw.Put(1, 1);
+		Write(bw, left[node], leafBits);
+		Write(bw, right[node], leafBits);
+	}
+	void Put(BitWriter &bw, u32 sym) const { bw.Put(code[sym], length[sym]); }
+};
+
+static Bytes EncodeAsh(const Bytes &in)
+{
+	std::vector<Token> tokens = Tokenize(in, 0x800, 3, 258);
+	std::vector<u32> symFreq(0x200, 0), distFreq(0x800, 0);
+	for(const Token &t : tokens)
+	{
+		if(t.len == 0)
+			symFreq[t.lit]++;
+		else
+		{
+			symFreq[t.len + 0xFD]++;
+			distFreq[t.dist - 1]++;
+		}
+	}
+	HuffTree sym, dist;
+	sym.Build(symFreq);
+	dist.Build(distFreq);
+	BitWriter sb, db;
+	sym.Write(sb, sym.root, 9);
+	dist.Write(db, dist.root, 11);
+	for(const Token &t : tokens)
+	{
+		if(t.len == 0)
+			sym.Put(sb, t.lit);
+		else
+		{
+			sym.Put(sb, t.len + 0xFD);
+			dist.Put(db, t.dist - 1);
+		}
+	}
+	sb.Finish();
+	db.Finish();
+
+	Bytes out;
+	auto put32 = [&out](u32 v) { for(int s = 24; s >= 0; s -= 8) out.push_back(v >> s); };
+	put32(0x41534830);
+	put32(in.size());
+	put32(0xC + sb.words.size() * 4);
+	for(u32 w : sb.words)
+		put32(w);
+	for(u32 w : db.words)
+		put32(w);
+	return out;
+}
+
+/* LZ77 encoders, type 0x10 and 0x11 */
+
+static Bytes EncodeLZ77(const Bytes &in, u8 type)
+{
+	u32 maxLen = type == LZ77_0x10_FLAG ? 18 : 65808;
+	std::vector<Token> tokens = Tokenize(in, 0x1000, 3, maxLen);
+	Bytes out;
+	u32 size = in.size();
+	out.push_back(type);
+	if(type == LZ77_0x11_FLAG && size >= (1 << 24))
+	{
+		out.insert(out.end(), 3, 0);
+		for(int s = 0; s < 32; s += 8)
+			out.push_back(size >> s);
+	}
+	else
+	{
+		for(int s = 0; s < 24; s += 8)
+			out.push_back(size >> s);
+	}
+	for(u32 t = 0; t < tokens.size(); t += 8)
+	{
+		u32 flagPos = out.size();
+		out.push_back(0);
+		for(u32 k = 0; k < 8 && t + k < tokens.size(); ++k)
+		{
+			const Token &tok = tokens[t + k];
+			if(tok.len == 0)
+			{
+				out.push_back(tok.lit);
+				continue;
+			}
+			out[flagPos] |= 0x80 >> k;
+			u32 d = tok.dist - 1;
+			if(type == LZ77_0x10_FLAG)
+			{
+				out.push_back(((tok.len - 3) << 4) | (d >> 8));
+				out.push_back(d);
+			}
+			else if(tok.len <= 16)
+			{
+				out.push_back(((tok.len - 1) << 4) | (d >> 8));
+				out.push_back(d);
+			}
+			else if(tok.len <= 272)
+			{
+				u32 l = tok.len - 17;
+				out.push_back(l >> 4);
+				out.push_back(((l & 0xF) << 4) | (d >> 8));
+				out.push_back(d);
+			}
+			else
+			{
+				u32 l = tok.len - 273;
+				out.push_back(0x10 | (l >> 12));
+				out.push_back(l >> 4);
+				out.push_back(((l & 0xF) << 4) | (d >> 8));
+				out.push_back(d);
+			}
+		}
+	}
+	return out;
+}
+
+/* checks */
+
+static int failures = 0;
+
+static void Check(bool ok, const std::string &what)
+{
+	if(!ok)
+	{
+		printf("FAIL %s\n", what.c_str());
+		failures++;
+	}
+}
+
+static const u32 chunkSizes[] = { 1, 7, 4096, 0x7FFFFFFF };
+
+static void CheckAsh(const Bytes &plain, const std::string &name)
+{
+	Bytes packed = EncodeAsh(plain);
+	u32 refLen = packed.size();
+	u8 *ref = RefDecompressAsh(packed.data(), refLen);
+	Check(ref != NULL && refLen == plain.size() && memcmp(ref, plain.data(), refLen) == 0,
+		"ash reference " + name);
+	if(ref == NULL)
+		return;
+	Bytes want(ref, ref + refLen);
+	free(ref);
+
+	u32 len = packed.size();
+	u8 *got = DecompressAsh(packed.data(), len);
+	Check(got != NULL && Bytes(got, got + len) == want, "DecompressAsh " + name);
+	free(got);
+
+	Check(GetAshDecompressedSize(packed.data(), packed.size()) == want.size(), "GetAshDecompressedSize " + name);
+	Bytes to(want.size() + 1, 0xAA);
+	Check(DecompressAshTo(packed.data(), packed.size(), to.data(), want.size()) == want.size()
+		&& Bytes(to.begin(), to.end() - 1) == want && to.back() == 0xAA, "DecompressAshTo " + name);
+	if(want.size() > 0)
+		Check(DecompressAshTo(packed.data(), packed.size(), to.data(), want.size() - 1) == 0,
+			"DecompressAshTo too small " + name);
+
+	AshDecoder *ash = new AshDecoder;
+	for(u32 chunk : chunkSizes)
+	{
+		Bytes streamed;
+		Bytes buf(chunk < want.size() + 1 ? chunk : want.size() + 1);
+		bool ok = ash->Open(packed.data(), packed.size());
+		while(ok)
+		{
+			u32 n = ash->Read(buf.data(), buf.size());
+			if(n == 0)
+				break;
+			streamed.insert(streamed.end(), buf.begin(), buf.begin() + n);
+		}
+		Check(ok && !ash->Failed() && streamed == want, "AshDecoder::Read " + name + " chunk " + std::to_string(chunk));
+	}
+	delete ash;
+}
+
+static void CheckLZ77(const Bytes &plain, u8 type, const std::string &name)
+{
+	Bytes packed = EncodeLZ77(plain, type);
+	u8 *ref = NULL;
+	u32 refLen = 0;
+	Check(refDecompressLZ77content(packed.data(), packed.size(), &ref, &refLen) == 0
+		&& refLen == plain.size() && memcmp(ref, plain.data(), refLen) == 0, "lz77 reference " + name);
+	if(ref == NULL)
+		return;
+	Bytes want(ref, ref + refLen);
+	free(ref);
+
+	u8 *got = NULL;
+	u32 len = 0;
+	Check(decompressLZ77content(packed.data(), packed.size(), &got, &len) == 0
+		&& Bytes(got, got + len) == want, "decompressLZ77content " + name);
+	free(got);
+
+	Check(getLZ77decompressedSize(packed.data(), packed.size()) == want.size(), "getLZ77decompressedSize " + name);
+	Bytes to(want.size() + 1, 0xAA);
+	Check(decompressLZ77contentTo(packed.data(), packed.size(), to.data(), want.size()) == 0
+		&& Bytes(to.begin(), to.end() - 1) == want && to.back() == 0xAA, "decompressLZ77contentTo " + name);
+	Check(decompressLZ77contentTo(packed.data(), packed.size(), to.data(), want.size() - 1) != 0,
+		"decompressLZ77contentTo too small " + name);
+
+	lz77Stream *s = new lz77Stream;
+	for(u32 chunk : chunkSizes)
+	{
+		Bytes streamed;
+		Bytes buf(chunk < want.size() + 1 ? chunk : want.size() + 1);
+		bool ok = lz77StreamInit(s, packed.data(), packed.size()) == 0;
+		while(ok)
+		{
+			u32 n = lz77StreamRead(s, buf.data(), buf.size());
+			if(n == 0)
+				break;
+			streamed.insert(streamed.end(), buf.begin(), buf.begin() + n);
+		}
+		Check(ok && streamed == want, "lz77StreamRead " + name + " chunk " + std::to_string(chunk));
+	}
+	delete s;
+}
+
+/* timing */
+
+template<typename F> static double BestMs(F f)
+{
+	double best = 1e30;
+	for(int i = 0; i < 5; ++i)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		f();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+		if(ms < best)
+			best = ms;
+	}
+	return best;
+}
+
+static void Bench(const Bytes &plain, const char *name)
+{
+	Bytes ash = EncodeAsh(plain);
+	double oldMs = BestMs([&] { u32 l = ash.size(); free(RefDecompressAsh(ash.data(), l)); });
+	double newMs = BestMs([&] { u32 l = ash.size(); free(DecompressAsh(ash.data(), l)); });
+	printf("%-8s ash    old %7.2f ms  new %7.2f ms\n", name, oldMs, newMs);
+	for(u8 type : { LZ77_0x10_FLAG, LZ77_0x11_FLAG })
+	{
+		Bytes lz = EncodeLZ77(plain, type);
+		u8 *out;
+		u32 len;
+		oldMs = BestMs([&] { refDecompressLZ77content(lz.data(), lz.size(), &out, &len); free(out); });
+		newMs = BestMs([&] { decompressLZ77content(lz.data(), lz.size(), &out, &len); free(out); });
+		printf("%-8s lz77%02x old %7.2f ms  new %7.2f ms\n", name, type, oldMs, newMs);
+	}
+}
+
+int main()
+{
+	typedef Bytes (*Maker)(u32);
+	static const struct { const char *name; Maker make; } kinds[] = {
+		{ "random", MakeRandom }, { "text", MakeText }, { "runs", MakeRuns }, { "records", MakeRecords } };
+	static const u32 sizes[] = { 1, 2, 3, 17, 100, 4095, 4096, 4097, 65536, 300000 };
+	u32 cases = 0;
+	for(const auto &k : kinds)
+	{
+		for(u32 size : sizes)
+		{
+			Bytes plain = k.make(size);
+			std::string name = std::string(k.name) + "/" + std::to_string(size);
+			CheckAsh(plain, name);
+			CheckLZ77(plain, LZ77_0x10_FLAG, name);
+			CheckLZ77(plain, LZ77_0x11_FLAG, name);
+			cases++;
+		}
+	}
+	printf("%u inputs, %d failures\n", cases, failures);
+	if(failures == 0)
+	{
+		for(const auto &k : kinds)
+			Bench(k.make(4 << 20), k.name);
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/****************************************************************************
+ * Checks FileNameMatcher from source/list against std::regex, extended and
+ * case insensitive the way ListGenerator used to build it, on 100k
+ * generated rom filenames. Ends with the time both take for the default
+ * skip pattern, std::regex also on the full path with the string copy
+ * Add_Plugin_Game used to make.
+ ****************************************************************************/
+#include <stdio.h>
+#include <chrono>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "list/FileNameMatcher.hpp"
+
+/* CONFIG_FILENAME_SKIP_DEFAULT from source/list/ListGenerator.hpp */
+static const char *defaultPattern = "((dis[ck]|tape|side|track)[ _-]([b-l][^a-z]|0*[2-9]|0*[1-9][0-9]))|(^disc2[.]iso$)|(^neogeo[.]zip$)|(^funboot[.]rom$)|(^(ecs|exec|grom)[.]bin$)";
+
+static const char *patterns[] = {
+	defaultPattern,
+	"^a",
+	"z$",
+	"(foo|bar)+baz",
+	"[^a-z]x",
+	"ab*c?d",
+	"(^|[ _])rev[ _]?[0-9]",
+	"[.](sav|srm|state[0-9]*)$",
+	/* these need std::regex, the matcher has to hand them over */
+	"x{2,3}",
+	"[[:digit:]]{3}",
+};
+
+static u32 rngState = 0x9E3779B9;
+static u32 Rand()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return rngState;
+}
+
+static std::string Pick(const std::vector<const char *> &v)
+{
+	return v[Rand() % v.size()];
+}
+
+static std::vector<std::string> MakeNames(u32 count)
+{
+	static const std::vector<const char *> words = { "Super", "Mario", "Zelda", "Sonic", "Street", "Fighter",
+		"Final", "Fantasy", "Metroid", "Castlevania", "Tetris", "Pac-Man", "Xevious", "Abadox", "Baz", "foobarbaz" };
+	static const std::vector<const char *> tags = { "", " (USA)", " (Europe)", " (Rev 1)", " [!]", " (Disc 1)",
+		" (Disc 2)", " (Disk B)", " (Side A)", " (Side b)", " Track 02", " track_10", " tape-3", " (Disc 01)",
+		" (Disc 12)", " disc 1x", " (Tape 1)", " rev2", " XXX", " 123" };
+	static const std::vector<const char *> exts = { ".zip", ".iso", ".bin", ".cue", ".nes", ".sfc", ".gba",
+		".rom", ".sav", ".state3", ".7z" };
+	static const std::vector<const char *> fixed = { "disc2.iso", "DISC2.ISO", "neogeo.zip", "funboot.rom",
+		"ecs.bin", "Exec.bin", "grom.bin", "grom.bin.bak", "my disc2.iso", "a", "z", "" };
+	std::vector<std::string> names;
+	names.reserve(count);
+	while(names.size() < count)
+	{
+		if(Rand() % 50 == 0)
+		{
+			names.push_back(Pick(fixed));
+			continue;
+		}
+		std::string n = Pick(words);
+		for(u32 w = Rand() % 3; w > 0; --w)
+			n += (Rand() % 2 ? " " : "_") + Pick(words);
+		n += Pick(tags) + Pick(exts);
+		names.push_back(n);
+	}
+	return names;
+}
+
+template<typename F> static double Ms(F f)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main()
+{
+	std::vector<std::string> names = MakeNames(100000);
+	int failures = 0;
+	for(const char *pattern : patterns)
+	{
+		FileNameMatcher matcher;
+		matcher.Compile(pattern);
+		std::regex re(pattern, std::regex_constants::extended | std::regex_constants::icase);
+		u32 hits = 0, wrong = 0;
+		for(const std::string &n : names)
+		{
+			bool want = std::regex_search(n, re);
+			if(matcher.Search(n.c_str()) != want)
+			{
+				if(wrong++ < 5)
+					printf("FAIL '%s' on '%s', std::regex says %d\n", pattern, n.c_str(), want);
+			}
+			hits += want;
+		}
+		printf("%-40.40s %6u matches, %u differ\n", pattern, hits, wrong);
+		failures += wrong;
+	}
+	if(failures != 0)
+		return 1;
+
+	FileNameMatcher matcher;
+	matcher.Compile(defaultPattern);
+	std::regex re(defaultPattern, std::regex_constants::extended | std::regex_constants::icase);
+	std::vector<std::string> paths;
+	for(const std::string &n : names)
+		paths.push_back("sd:/roms/snes/" + n);
+	u32 a = 0, b = 0, c = 0;
+	double dfaMs = Ms([&] { for(const std::string &n : names) a += matcher.Search(n.c_str()); });
+	double reMs = Ms([&] { for(const std::string &n : names) b += std::regex_search(n, re); });
+	double oldMs = Ms([&] { for(const std::string &p : paths) c += std::regex_search(std::string(p.c_str()), re); });
+	printf("%zu names: matcher %.2f ms, std::regex %.2f ms, std::regex on the full path %.2f ms\n",
+		names.size(), dfaMs, reMs, oldMs);
+	return a == b ? 0 : 1;
+}
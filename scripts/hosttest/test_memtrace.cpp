@@ -0,0 +1,198 @@
+/****************************************************************************
+ * Drives mem_trace.cpp from source/memory with a cover cache like workload
+ * on simulated first fit pools and writes build/memtrace.bin. The pool
+ * counters in the file have to match what the simulation did, then the
+ * Makefile hands the file to scripts/memtrace.py --check, which replays the
+ * records and has to end up at the same counters.
+ ****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+#include "memory/mem_trace.hpp"
+
+/* first fit over a fake address range, freed blocks merge with their neighbours */
+class Pool
+{
+public:
+	Pool(u32 base, u32 size) : m_size(size) { m_free[base] = size; }
+	u32 Alloc(u32 size)
+	{
+		size = (size + 31) & ~31;
+		for(std::map<u32, u32>::iterator i = m_free.begin(); i != m_free.end(); ++i)
+		{
+			if(i->second < size)
+				continue;
+			u32 p = i->first;
+			u32 left = i->second - size;
+			m_free.erase(i);
+			if(left > 0)
+				m_free[p + size] = left;
+			m_used[p] = size;
+			return p;
+		}
+		return 0;
+	}
+	u32 Free(u32 p)
+	{
+		u32 size = m_used[p];
+		m_used.erase(p);
+		std::map<u32, u32>::iterator next = m_free.insert(std::make_pair(p, size)).first;
+		std::map<u32, u32>::iterator cur = next++;
+		if(next != m_free.end() && cur->first + cur->second == next->first)
+		{
+			cur->second += next->second;
+			m_free.erase(next);
+		}
+		if(cur != m_free.begin())
+		{
+			std::map<u32, u32>::iterator prev = cur;
+			--prev;
+			if(prev->first + prev->second == cur->first)
+			{
+				prev->second += cur->second;
+				m_free.erase(cur);
+			}
+		}
+		return size;
+	}
+	u32 BlockSize(u32 p) { return m_used[p]; }
+	u32 Size(void) const { return m_size; }
+	u32 FreeSize(void)
+	{
+		u32 n = 0;
+		for(std::map<u32, u32>::iterator i = m_free.begin(); i != m_free.end(); ++i)
+			n += i->second;
+		return n;
+	}
+	u32 LargestFree(void)
+	{
+		u32 n = 0;
+		for(std::map<u32, u32>::iterator i = m_free.begin(); i != m_free.end(); ++i)
+			n = i->second > n ? i->second : n;
+		return n;
+	}
+	std::vector<u32> Used(void)
+	{
+		std::vector<u32> v;
+		for(std::map<u32, u32>::iterator i = m_used.begin(); i != m_used.end(); ++i)
+			v.push_back(i->first);
+		return v;
+	}
+private:
+	u32 m_size;
+	std::map<u32, u32> m_free;
+	std::map<u32, u32> m_used;
+};
+
+static Pool pools[MEM_POOL_COUNT] = {
+	Pool(0x80100000, 0x00800000),
+	Pool(0x80900000, 0x00400000),
+	Pool(0x90000000, 0x01000000),
+	Pool(0x91000000, 0x02800000),
+};
+
+extern "C"
+{
+unsigned int MEM1_freesize() { return pools[MEM_POOL_MEM1].FreeSize(); }
+unsigned int MEM1_lo_freesize() { return pools[MEM_POOL_MEM1_LO].FreeSize(); }
+unsigned int MEM1_lo_largestfree() { return pools[MEM_POOL_MEM1_LO].LargestFree(); }
+unsigned int MEM2_lo_freesize() { return pools[MEM_POOL_MEM2_LO].FreeSize(); }
+unsigned int MEM2_lo_largestfree() { return pools[MEM_POOL_MEM2_LO].LargestFree(); }
+unsigned int MEM2_freesize() { return pools[MEM_POOL_MEM2].FreeSize(); }
+unsigned int MEM2_largestfree() { return pools[MEM_POOL_MEM2].LargestFree(); }
+}
+
+static u32 rngState = 0x68E31DA4;
+static u32 Rand()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return rngState;
+}
+
+/* the addresses only have to fit the u32 fields, they are never dereferenced */
+static void *Ptr(u32 p) { return (void *)(uintptr_t)p; }
+
+/* covers of a few sizes, banner buffers and lots of small strings, each kind
+   from a couple of call sites */
+static u32 Size(u32 pool)
+{
+	switch(pool)
+	{
+		case MEM_POOL_MEM1:
+			return 16 + Rand() % 512;
+		case MEM_POOL_MEM1_LO:
+			return 4096 + Rand() % 65536;
+		case MEM_POOL_MEM2_LO:
+			return (Rand() % 2 ? 0x20000 : 0x80000) + Rand() % 4096;
+		default:
+			return (Rand() % 3 == 0 ? 0x200000 : 0x40000) + (Rand() % 16) * 4096;
+	}
+}
+
+int main()
+{
+	u32 allocs[MEM_POOL_COUNT] = {}, frees[MEM_POOL_COUNT] = {};
+	u32 live[MEM_POOL_COUNT] = {}, highWater[MEM_POOL_COUNT] = {};
+	for(u32 n = 0; n < 12000; ++n)
+	{
+		u32 pool = Rand() % MEM_POOL_COUNT;
+		std::vector<u32> used = pools[pool].Used();
+		/* frees get more likely once a pool is two thirds full, holes build up */
+		bool full = pools[pool].FreeSize() < pools[pool].Size() / 3;
+		if(!used.empty() && Rand() % (full ? 2 : 3) == 0)
+		{
+			u32 p = used[Rand() % used.size()];
+			u32 size = pools[pool].BlockSize(p);
+			MEM_trace_free(pool, Ptr(p), size);
+			pools[pool].Free(p);
+			frees[pool]++;
+			live[pool] -= size;
+			continue;
+		}
+		u32 p = pools[pool].Alloc(Size(pool));
+		if(p == 0)
+			continue;
+		u32 size = pools[pool].BlockSize(p);
+		MEM_trace_alloc(pool, Ptr(p), size, Ptr(0x80004000 + pool * 0x100 + (Rand() % 4) * 0x10));
+		allocs[pool]++;
+		live[pool] += size;
+		if(live[pool] > highWater[pool])
+			highWater[pool] = live[pool];
+	}
+
+	const char *path = "build/memtrace.bin";
+	if(!MEM_trace_write(path))
+	{
+		printf("FAIL couldn't write %s\n", path);
+		return 1;
+	}
+	FILE *f = fopen(path, "rb");
+	u32 header[4];
+	MemTracePool filePools[MEM_POOL_COUNT];
+	bool ok = f != NULL && fread(header, sizeof header, 1, f) == 1 && fread(filePools, sizeof filePools, 1, f) == 1;
+	if(f != NULL)
+		fclose(f);
+	if(!ok || memcmp(header, "TMFW", 4) != 0 || header[1] != MEM_TRACE_VERSION || header[3] != 0)
+	{
+		printf("FAIL bad header in %s\n", path);
+		return 1;
+	}
+	int failures = 0;
+	for(u32 i = 0; i < MEM_POOL_COUNT; ++i)
+	{
+		MemTracePool *p = &filePools[i];
+		if(p->allocs != allocs[i] || p->frees != frees[i] || p->liveBytes != live[i] || p->highWater != highWater[i]
+			|| p->freeBytes != pools[i].FreeSize() || (i != MEM_POOL_MEM1 && p->largestFree != pools[i].LargestFree()))
+		{
+			printf("FAIL pool %u: %u/%u allocs, %u/%u frees, %u/%u live, %u/%u high water\n", i,
+				p->allocs, allocs[i], p->frees, frees[i], p->liveBytes, live[i], p->highWater, highWater[i]);
+			++failures;
+		}
+	}
+	printf("%u records written to %s, %d pools differ\n", header[2], path, failures);
+	return failures != 0;
+}
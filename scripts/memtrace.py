@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+#
+# Loads a memtrace.bin written by a MEMTRACE=1 build and replays it:
+#   ./memtrace.py memtrace.bin
+#   ./memtrace.py --check memtrace.bin
+# The replay puts every block back at its recorded address, so the holes
+# between live blocks are the fragmentation the Wii had when the file was
+# written. --check fails if the replay doesn't add up to the pool counters.
+# The layout is described in source/memory/mem_trace.hpp.
+
+import struct
+import sys
+
+POOLS = ("MEM1", "MEM1 lo", "MEM2 lo", "MEM2")
+TRACE_ALLOC = 1
+TRACE_FREE = 2
+TOP_SITES = 16
+
+def load(path):
+	with open(path, "rb") as f:
+		data = f.read()
+	# the Wii writes big endian, a host build of mem_trace.cpp little endian
+	if data[:4] == b"WFMT":
+		order = ">"
+	elif data[:4] == b"TMFW":
+		order = "<"
+	else:
+		sys.exit("%s is not a memory trace" % path)
+	version, count, dropped = struct.unpack_from(order + "3I", data, 4)
+	if version != 1:
+		sys.exit("%s has version %d, only 1 is known" % (path, version))
+	pos = 16
+	pools = []
+	for p in POOLS:
+		pools.append(struct.unpack_from(order + "6I", data, pos))
+		pos += 24
+	if len(data) < pos + count * 16:
+		sys.exit("%s is cut off, %d records expected" % (path, count))
+	records = list(struct.iter_unpack(order + "BBHIII", data[pos:pos + count * 16]))
+	return pools, records, dropped
+
+def holes(live):
+	# gaps between live blocks, by address
+	blocks = sorted(live.items())
+	gaps = []
+	for (a, (asize, _)), (b, _) in zip(blocks, blocks[1:]):
+		if b > a + asize:
+			gaps.append(b - a - asize)
+	return gaps
+
+def main():
+	args = sys.argv[1:]
+	check = "--check" in args
+	args = [a for a in args if a != "--check"]
+	if len(args) != 1:
+		sys.exit("usage: %s [--check] memtrace.bin" % sys.argv[0])
+	pools, records, dropped = load(args[0])
+
+	live = [dict() for p in POOLS]
+	allocs = [0] * len(POOLS)
+	frees = [0] * len(POOLS)
+	liveBytes = [0] * len(POOLS)
+	highWater = [0] * len(POOLS)
+	sites = {}
+	errors = 0
+	for op, pool, pad, ptr, size, site in records:
+		if pool >= len(POOLS):
+			print("record for unknown pool %d" % pool)
+			errors += 1
+			continue
+		if op == TRACE_ALLOC:
+			if ptr in live[pool]:
+				print("%s: %08x handed out twice" % (POOLS[pool], ptr))
+				errors += 1
+			live[pool][ptr] = (size, site)
+			allocs[pool] += 1
+			liveBytes[pool] += size
+			highWater[pool] = max(highWater[pool], liveBytes[pool])
+			s = sites.setdefault(site, [0, 0, 0])
+			s[0] += 1
+			s[1] += 1
+			s[2] += size
+		elif op == TRACE_FREE:
+			frees[pool] += 1
+			liveBytes[pool] -= min(size, liveBytes[pool])
+			block = live[pool].pop(ptr, None)
+			if block is None:
+				print("%s: free of %08x which isn't live" % (POOLS[pool], ptr))
+				errors += 1
+				continue
+			s = sites[block[1]]
+			s[1] -= 1
+			s[2] -= block[0]
+		else:
+			print("record with unknown op %d" % op)
+			errors += 1
+
+	print("%d records, %d dropped" % (len(records), dropped))
+	for i, name in enumerate(POOLS):
+		a, f, lb, hw, fb, lf = pools[i]
+		gaps = holes(live[i])
+		print("%-7s %6d allocs %6d frees, live %9d, high water %9d, free %9d, largest free %9d" % (name, a, f, lb, hw, fb, lf))
+		print("        replay: %d blocks live, %d holes between them, largest %d of %d bytes" %
+			(len(live[i]), len(gaps), max(gaps, default=0), sum(gaps)))
+		if dropped == 0 and (allocs[i], frees[i], liveBytes[i], highWater[i]) != (a, f, lb, hw):
+			print("        replay ends at %d allocs %d frees, live %d, high water %d" %
+				(allocs[i], frees[i], liveBytes[i], highWater[i]))
+			errors += 1
+
+	print("biggest live call sites:")
+	top = sorted(sites.items(), key=lambda s: s[1][2], reverse=True)[:TOP_SITES]
+	for site, (count, liveCount, size) in top:
+		if liveCount > 0:
+			print("  %08x: %d allocs, %d live (%d bytes)" % (site, count, liveCount, size))
+
+	if dropped != 0:
+		sys.stderr.write("records were dropped, the counters can't be checked\n")
+	if check and errors != 0:
+		sys.exit("%d problems in %s" % (errors, args[0]))
+
+if __name__ == "__main__":
+	main()
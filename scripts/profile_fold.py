@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+#
+# Turns a profile.txt capture of a PROFILER=1 build into folded stacks:
+#   ./profile_fold.py profile.txt > profile.folded
+#   flamegraph.pl profile.folded > profile.svg
+# Time of the frame outside of any zone shows up as "frame" itself.
+
+import sys
+
+def main():
+	if len(sys.argv) != 2:
+		sys.exit("usage: %s profile.txt" % sys.argv[0])
+	zones = None
+	totals = None
+	frames = 0
+	with open(sys.argv[1]) as f:
+		for line in f:
+			fields = line.split()
+			if not fields or fields[0].startswith("#"):
+				continue
+			if fields[0] == "zones":
+				zones = fields[1:]
+				totals = [0] * len(zones)
+				continue
+			if zones is None or len(fields) != len(zones):
+				continue
+			for z, usec in enumerate(fields):
+				totals[z] += int(usec)
+			frames += 1
+	if frames == 0:
+		sys.exit("no frames in %s" % sys.argv[1])
+	inner = sum(totals[1:])
+	print("%s %d" % (zones[0], max(totals[0] - inner, 0)))
+	for z in range(1, len(zones)):
+		print("%s;%s %d" % (zones[0], zones[z], totals[z]))
+	sys.stderr.write("%d frames, %.2f ms average\n" % (frames, totals[0] / frames / 1000.0))
+
+if __name__ == "__main__":
+	main()
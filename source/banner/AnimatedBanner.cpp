@@ -34,7 +34,9 @@ AnimatedBanner::AnimatedBanner()
 {
 	layout_banner = NULL;
 	newBanner = NULL;
-	oriBanner = NULL;
+	newBannerSize = 0;
+	newBannerAlloc = NULL;
+	borrowed = false;
 }
 
 void AnimatedBanner::LoadFont(u8 *font1, u8 *font2)
@@ -45,31 +47,51 @@ void AnimatedBanner::LoadFont(u8 *font1, u8 *font2)
 
 void AnimatedBanner::Clear()
 {
-	if(layout_banner != NULL)
-	{
+	if(layout_banner != NULL && !borrowed)
 		delete layout_banner;
-		layout_banner = NULL;
-	}
-	if(newBanner != NULL)
-	{
-		if(newBanner != oriBanner)
-			free(newBanner);
-		newBanner = NULL;
-		oriBanner = NULL;
-	}
+	layout_banner = NULL;
+	if(newBannerAlloc != NULL && !borrowed)
+		free(newBannerAlloc);
+	newBannerAlloc = NULL;
+	newBanner = NULL;
+	newBannerSize = 0;
+	borrowed = false;
 }
 
-bool AnimatedBanner::LoadBanner()
+bool AnimatedBanner::LoadBanner(Banner &banner)
 {
 	u32 banner_bin_size;
-	u8 *banner_bin = CurrentBanner.GetFile("banner.bin", &banner_bin_size);
+	u8 *banner_bin = banner.GetFile("banner.bin", &banner_bin_size);
 	if(banner_bin == NULL)
 		return false;
 	bool ret = LoadBannerBin(banner_bin, banner_bin_size);
-	free(banner_bin);
+	/* an uncompressed banner.bin is used in place, keep it then */
+	if(newBanner != NULL && newBannerAlloc == NULL)
+		newBannerAlloc = banner_bin;
+	else
+		free(banner_bin);
 	return ret;
 }
 
+bool AnimatedBanner::GetLayout(Layout *&layout, u8 *&archive, u32 &archive_size) const
+{
+	if(layout_banner == NULL || newBannerAlloc == NULL || borrowed)
+		return false;
+	layout = layout_banner;
+	archive = newBannerAlloc;
+	archive_size = newBannerSize;
+	return true;
+}
+
+void AnimatedBanner::Borrow(Layout *layout, u8 *archive)
+{
+	Clear();
+	layout_banner = layout;
+	newBanner = archive;
+	borrowed = true;
+	layout_banner->SetFrame(0);
+}
+
 bool AnimatedBanner::LoadBannerBin(const u8 *banner_bin, u32 banner_bin_size)
 {
 	Clear();
@@ -110,14 +132,23 @@ void AnimatedBanner::SetBannerTexture(const char *tex_name, const u8 *data, floa
 Layout* AnimatedBanner::LoadLayout(const u8 *bnr, u32 bnr_size, const std::string& lyt_name, const std::string &language)
 {
 	u32 brlyt_size = 0;
-	oriBanner = bnr;
-	newBanner = DecompressCopy(bnr, bnr_size, &bnr_size);
+	newBanner = DecompressCopy(bnr, bnr_size, &newBannerSize);
 	if(newBanner == NULL)
 		return NULL;
+	/* DecompressCopy hands back the input when there was nothing to decompress */
+	if(newBanner < bnr || newBanner >= bnr + bnr_size)
+		newBannerAlloc = newBanner;
+
+	U8Index arc;
+	if(!u8_index_init(&arc, newBanner, newBannerSize))
+		return NULL;
 
-	const u8 *brlyt = u8_get_file(newBanner, fmt("%s.brlyt", lyt_name.c_str()), &brlyt_size);
+	const u8 *brlyt = u8_index_get_file(&arc, fmt("%s.brlyt", lyt_name.c_str()), &brlyt_size);
 	if(!brlyt)
+	{
+		u8_index_free(&arc);
 		return NULL;
+	}
 
 	Layout *layout = new Layout(sysFont1, sysFont2);
 	layout->Load(brlyt);
@@ -125,29 +156,31 @@ Layout* AnimatedBanner::LoadLayout(const u8 *bnr, u32 bnr_size, const std::strin
 	u32 length_start = 0, length_loop = 0;
 
 	u32 brlan_start_size = 0;
-	const u8 *brlan_start = u8_get_file(newBanner, fmt("%s_Start.brlan", lyt_name.c_str()), &brlan_start_size);
+	const u8 *brlan_start = u8_index_get_file(&arc, fmt("%s_Start.brlan", lyt_name.c_str()), &brlan_start_size);
 	const u8 *brlan_loop = 0;
 
 	// try the alternative file
 	if(!brlan_start)
-		brlan_start = u8_get_file(newBanner, fmt("%s_In.brlan", lyt_name.c_str()), &brlan_start_size);
+		brlan_start = u8_index_get_file(&arc, fmt("%s_In.brlan", lyt_name.c_str()), &brlan_start_size);
 
 	if(brlan_start)
 		length_start = Animator::LoadAnimators((const RLAN_Header *)brlan_start, *layout, 0);
 
 	u32 brlan_loop_size = 0;
-	brlan_loop = u8_get_file(newBanner, fmt("%s.brlan", lyt_name.c_str()), &brlan_loop_size);
+	brlan_loop = u8_index_get_file(&arc, fmt("%s.brlan", lyt_name.c_str()), &brlan_loop_size);
 	if(!brlan_loop)
-		brlan_loop = u8_get_file(newBanner, fmt("%s_Loop.brlan", lyt_name.c_str()), &brlan_loop_size);
+		brlan_loop = u8_index_get_file(&arc, fmt("%s_Loop.brlan", lyt_name.c_str()), &brlan_loop_size);
 	if(!brlan_loop)
-		brlan_loop = u8_get_file(newBanner, fmt("%s_Rso0.brlan", lyt_name.c_str()), &brlan_loop_size); // added for "artstyle" wiiware
+		brlan_loop = u8_index_get_file(&arc, fmt("%s_Rso0.brlan", lyt_name.c_str()), &brlan_loop_size); // added for "artstyle" wiiware
 
 	if(brlan_loop)
 		length_loop = Animator::LoadAnimators((const RLAN_Header *)brlan_loop, *layout, 1);
 
 	// load textures after loading the animations so we get the list of tpl filenames from the brlans
-	layout->LoadTextures(newBanner);
-	layout->LoadFonts(newBanner);
+	layout->LoadTextures(arc);
+	layout->LoadFonts(arc);
+	u8_index_free(&arc);
+
 	layout->SetLanguage(language);
 	layout->SetLoopStart(length_start);
 	layout->SetLoopEnd(length_start + length_loop);
@@ -156,14 +189,60 @@ Layout* AnimatedBanner::LoadLayout(const u8 *bnr, u32 bnr_size, const std::strin
 	return layout;
 }
 
-u8 *DecompressCopy(const u8 *stuff, u32 len, u32 *size)
+static inline void SkipIMD5(const u8 *&stuff, u32 &len)
 {
-	// check for IMD5 header and skip it
 	if(len > 0x40 && *(u32*)stuff == 0x494d4435) // IMD5
 	{
 		stuff += 0x20;
 		len -= 0x20;
 	}
+}
+
+static u32 PlainSize(const u8 *stuff, u32 len)
+{
+	if(IsAshCompressed(stuff, len))
+		return GetAshDecompressedSize(stuff, len);
+	else if(isLZ77compressed(stuff))
+		return getLZ77decompressedSize(stuff, len);
+	else if(*(u32*)(stuff) == 0x4C5A3737) // LZ77
+		return getLZ77decompressedSize(stuff + 4, len - 4);
+	return len;
+}
+
+u32 DecompressedSize(const u8 *stuff, u32 len)
+{
+	SkipIMD5(stuff, len);
+	return PlainSize(stuff, len);
+}
+
+u32 DecompressTo(const u8 *stuff, u32 len, u8 *out, u32 outSize)
+{
+	SkipIMD5(stuff, len);
+	u32 size = PlainSize(stuff, len);
+	if(size == 0 || size > outSize)
+		return 0;
+	if(IsAshCompressed(stuff, len))
+		size = DecompressAshTo(stuff, len, out, outSize);
+	else if(isLZ77compressed(stuff))
+	{
+		if(decompressLZ77contentTo(stuff, len, out, outSize))
+			return 0;
+	}
+	else if(*(u32*)(stuff) == 0x4C5A3737) // LZ77
+	{
+		if(decompressLZ77contentTo(stuff + 4, len - 4, out, outSize))
+			return 0;
+	}
+	else
+		memcpy(out, stuff, len);
+	DCFlushRange(out, size);
+	return size;
+}
+
+u8 *DecompressCopy(const u8 *stuff, u32 len, u32 *size)
+{
+	// check for IMD5 header and skip it
+	SkipIMD5(stuff, len);
 	u8 *ret = NULL;
 	// determine if it needs to be decompressed
 	if(IsAshCompressed(stuff, len))
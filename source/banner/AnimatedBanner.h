@@ -36,21 +36,33 @@ public:
 	void LoadFont(u8 *font1, u8 *font2);
 	void Clear();
 
-	bool LoadBanner();
+	bool LoadBanner(Banner &banner = CurrentBanner);
 	bool LoadBannerBin(const u8 *banner_bin, u32 banner_bin_size);
 	Layout *getBanner() const { return layout_banner; }
 	void SetBannerTexture(const char *tex_name, const u8 *data, float width, float height, u8 fmt);
 	void SetBannerText(const char *text_name, const wchar_t *wText);
+	/* the loaded layout and the archive it points into, false if the archive is not ours */
+	bool GetLayout(Layout *&layout, u8 *&archive, u32 &archive_size) const;
+	/* someone else took over layout and archive, keep displaying them without freeing */
+	void Release() { borrowed = true; }
+	/* display a layout owned by someone else, Clear will not free it */
+	void Borrow(Layout *layout, u8 *archive);
 protected:
 	Layout* LoadLayout(const u8 *bnr, u32 bnr_size, const std::string& lyt_name, const std::string &language);
 	Layout *layout_banner;
 	u8 *newBanner;
-	const u8 *oriBanner;
+	u32 newBannerSize;
+	u8 *newBannerAlloc;// what to free, NULL if newBanner points into someone else's buffer
+	bool borrowed;
 	u8 *sysFont1;
 	u8 *sysFont2;
 };
 
 u8 *DecompressCopy(const u8 *stuff, u32 len, u32 *size);
+/* size DecompressTo needs, the plain size for data that isn't compressed. 0 on broken headers */
+u32 DecompressedSize(const u8 *stuff, u32 len);
+/* decompresses into a caller provided buffer of outSize bytes, returns the decompressed size or 0 */
+u32 DecompressTo(const u8 *stuff, u32 len, u8 *out, u32 outSize);
 
 extern AnimatedBanner gameBanner;
 #endif
@@ -23,6 +23,7 @@ distribution.
 */
 
 #include <math.h>
+#include <algorithm>
 #include "Animator.h"
 #include "Layout.h"
 
@@ -138,105 +139,175 @@ void Animator::SetFrame(FrameNumber frame_number, u8 key_set)
 	}
 }
 
+template <class T>
+static inline bool KeyFrameLess(const T &lhs, const T &rhs)
+{
+	return lhs.frame < rhs.frame;
+}
+
 void StepKeyHandler::Load(const u8 *file, u16 count)
 {
 	while (count--)
 	{
-		FrameNumber frame;
-		frame = *((FrameNumber *) file);
+		Key key;
+		key.frame = *((FrameNumber *) file);
 		file += 4;
-
-		KeyData& data = keys[frame];
-		data.data1 = *file;
+		key.data.data1 = *file;
 		file++;
-		data.data2 = *file;
+		key.data.data2 = *file;
 		file++;
 
 		file += 2;
+
+		keys.push_back(key);
+	}
+
+	// sort by frame, a later key replaces an earlier one on the same frame
+	std::stable_sort(keys.begin(), keys.end(), KeyFrameLess<Key>);
+
+	u32 n = 0;
+	for(u32 i = 0; i < keys.size(); ++i)
+	{
+		if(n > 0 && keys[n-1].frame == keys[i].frame)
+			--n;
+		keys[n++] = keys[i];
 	}
+	keys.resize(n);
+	cursor = 0;
 }
 
 void HermiteKeyHandler::Load(const u8 *file, u16 count)
 {
 	while (count--)
 	{
-		std::pair<FrameNumber, KeyData> pair;
+		Key key;
 
 		// read the frame number, value and slope
-		pair.first = *((FrameNumber *) file);
+		key.frame = *((FrameNumber *) file);
 		file += 4;
-		pair.second.value = *((float *) file);
+		key.data.value = *((float *) file);
 		file += 4;
-		pair.second.slope = *((float *) file);
+		key.data.slope = *((float *) file);
 		file += 4;
 
-		keys.insert(pair);
-
-		//std::cout << "\t\t\t" "frame: " << frame << ' ' << keys[frame] << '\n';
+		keys.push_back(key);
 	}
+
+	// keys on the same frame stay in file order
+	std::stable_sort(keys.begin(), keys.end(), KeyFrameLess<Key>);
+	Bake();
 }
 
-StepKeyHandler::KeyData StepKeyHandler::GetFrame(FrameNumber frame_number) const
+void HermiteKeyHandler::Bake()
 {
-	// assuming not empty, a safe assumption currently
-
-	// find the current frame, or the one after it
-	std::map<FrameNumber, KeyData>::const_iterator frame_it = keys.lower_bound(frame_number);
+	segments.resize(keys.empty() ? 0 : keys.size() - 1);
+	cursor = 0;
 
-	// current frame is higher than any keyframe, use the last keyframe
-	if (keys.end() == frame_it)
-		--frame_it;
+	for(u32 i = 0; i < segments.size(); ++i)
+	{
+		const Key &prev = keys[i];
+		const Key &next = keys[i+1];
+		Segment &seg = segments[i];
 
-	// if this is after the current frame and not the first keyframe, use the previous one
-	if (frame_number < frame_it->first && keys.begin() != frame_it)
-		--frame_it;
+		const float nf = next.frame - prev.frame;
+		if (fabs(nf) < 0.01)
+		{
+			// same frame numbers, just use the first's value
+			seg.a = prev.data.value;
+			seg.b = seg.c = seg.d = seg.inv = 0.f;
+			continue;
+		}
 
-	return frame_it->second;
+		// cubic Hermite spline (curvy code from marcan) expanded into a polynomial in t
+		const float p0 = prev.data.value;
+		const float p1 = next.data.value;
+		const float m0 = prev.data.slope * nf;
+		const float m1 = next.data.slope * nf;
+
+		seg.a = p0;
+		seg.b = m0;
+		seg.c = 3.f * (p1 - p0) - 2.f * m0 - m1;
+		seg.d = 2.f * (p0 - p1) + m0 + m1;
+		seg.inv = 1.f / nf;
+	}
 }
 
-float HermiteKeyHandler::GetFrame(FrameNumber frame_number) const
+StepKeyHandler::KeyData StepKeyHandler::GetFrame(FrameNumber frame_number) const
 {
 	// assuming not empty, a safe assumption currently
+	const u32 n = keys.size();
 
-	// find the current keyframe, or the one after it
-	std::multimap<FrameNumber, KeyData>::const_iterator next = keys.lower_bound(frame_number);
-
-	// current frame is higher than any keyframe, use the last keyframe
-	if (keys.end() == next)
-		--next;
+	// the last key at or before the current frame, or the first keyframe
+	u32 i = cursor < n ? cursor : 0;
+	if ((i > 0 && frame_number < keys[i].frame) || (i + 1 < n && keys[i+1].frame <= frame_number))
+	{
+		if (i + 1 < n && keys[i+1].frame <= frame_number && (i + 2 == n || frame_number < keys[i+2].frame))
+			++i;
+		else
+		{
+			u32 lo = 0, hi = n;
+			while (lo < hi)
+			{
+				const u32 mid = (lo + hi) / 2;
+				if (keys[mid].frame <= frame_number)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			i = lo ? lo - 1 : 0;
+		}
+		cursor = i;
+	}
 
-	std::multimap<FrameNumber, KeyData>::const_iterator prev = next;
+	return keys[i].data;
+}
 
-	// if this is after the current frame and not the first keyframe, use the previous one
-	if (frame_number < prev->first && keys.begin() != prev)
-		--prev;
+u32 HermiteKeyHandler::Seek(FrameNumber frame_number) const
+{
+	// index of the first key at or after the current frame
+	const u32 n = keys.size();
 
-	const float nf = next->first - prev->first;
-	if (fabs(nf) < 0.01)
+	u32 i = cursor <= n ? cursor : 0;
+	if ((i > 0 && !(keys[i-1].frame < frame_number)) || (i < n && keys[i].frame < frame_number))
 	{
-		// same frame numbers, just return the first's value
-		return prev->second.value;
+		if (i < n && keys[i].frame < frame_number && (i + 1 == n || frame_number <= keys[i+1].frame))
+			++i;
+		else
+		{
+			u32 lo = 0, hi = n;
+			while (lo < hi)
+			{
+				const u32 mid = (lo + hi) / 2;
+				if (keys[mid].frame < frame_number)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			i = lo;
+		}
+		cursor = i;
 	}
-	else
-	{
-		// different frames, blend them together
-		// this is a "Cubic Hermite spline" apparently
 
-		frame_number =	 (frame_number < prev->first) ? prev->first :
-						((frame_number > next->first) ? next->first : frame_number);
+	return i;
+}
 
-		const float t = (frame_number - prev->first) / nf;
+float HermiteKeyHandler::GetFrame(FrameNumber frame_number) const
+{
+	// assuming not empty, a safe assumption currently
+	const u32 next = Seek(frame_number);
 
-		// old curve-less code
-		//return prev->second.value + (next->second.value - prev->second.value) * t;
+	// current frame is higher than any keyframe, use the last keyframe
+	if (next == keys.size())
+		return keys[next-1].data.value;
 
-		// curvy code from marcan, :p
-		return
-			prev->second.slope * nf * (t + pow(t, 3) - 2 * pow(t, 2)) +
-			next->second.slope * nf * (pow(t, 3) - pow(t, 2)) +
-			prev->second.value * (1 + (2 * pow(t, 3) - 3 * pow(t, 2))) +
-			next->second.value * (-2 * pow(t, 3) + 3 * pow(t, 2));
-	}
+	// on a keyframe or before the first one
+	if (next == 0 || !(frame_number < keys[next].frame))
+		return keys[next].data.value;
+
+	const Segment &seg = segments[next-1];
+	const float t = (frame_number - keys[next-1].frame) * seg.inv;
+
+	return ((seg.d * t + seg.c) * t + seg.b) * t + seg.a;
 }
 
 void Animator::ProcessHermiteKey(const KeyType& type, float value)
@@ -26,6 +26,7 @@ distribution.
 #define WII_BNR_ANIMATOR_H_
 
 #include <map>
+#include <vector>
 #include <cstring>
 #include <string>
 #include "BannerTools.h"
@@ -108,9 +109,13 @@ struct KeyType
 	const u8 index, target;
 };
 
+// Keyframes are kept sorted in flat arrays. Frames mostly advance one at a time,
+// so lookups first try the key found last time before falling back to a binary search.
 class StepKeyHandler
 {
 public:
+	StepKeyHandler() : cursor(0) {}
+
 	void Load(const u8* file, u16 count);
 
 	struct KeyData
@@ -121,12 +126,21 @@ public:
 	KeyData GetFrame(FrameNumber frame_number) const;
 
 private:
-	std::map<FrameNumber, KeyData> keys;
+	struct Key
+	{
+		FrameNumber frame;
+		KeyData data;
+	};
+
+	std::vector<Key> keys;
+	mutable u32 cursor;
 };
 
 class HermiteKeyHandler
 {
 public:
+	HermiteKeyHandler() : cursor(0) {}
+
 	void Load(const u8* file, u16 count);
 
 	struct KeyData
@@ -137,7 +151,24 @@ public:
 	float GetFrame(FrameNumber frame_number) const;
 
 private:
-	std::multimap<FrameNumber, KeyData> keys;
+	struct Key
+	{
+		FrameNumber frame;
+		KeyData data;
+	};
+
+	// the curve between key i and key i+1 as a + b*t + c*t^2 + d*t^3, t = (frame - key i) * inv
+	struct Segment
+	{
+		float a, b, c, d, inv;
+	};
+
+	void Bake();
+	u32 Seek(FrameNumber frame_number) const;
+
+	std::vector<Key> keys;
+	std::vector<Segment> segments;
+	mutable u32 cursor;
 };
 
 class Layout;
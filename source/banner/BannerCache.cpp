@@ -0,0 +1,173 @@
+/****************************************************************************
+ * Banner cache, see BannerCache.hpp
+ ****************************************************************************/
+#include <string.h>
+#include <malloc.h>
+
+#include "BannerCache.hpp"
+#include "gecko/gecko.hpp"
+#include "lockMutex.hpp"
+#include "memory/mem2.hpp"
+
+/* rough cost of the parsed layout itself, panes, materials and animators */
+#define LAYOUT_OVERHEAD		0x8000
+/* some archives and sound.bin copies come from MEM2_lo, leave room for everyone else */
+#define MEM2_LO_RESERVE		0x100000
+
+BannerCache BnrCache;
+
+BannerCache::BannerCache()
+{
+	memset(entries, 0, sizeof(entries));
+	active = NULL;
+	budget = 0;
+	used = 0;
+	useCounter = 0;
+	hits = 0;
+	misses = 0;
+	LWP_MutexInit(&mutex, false);
+}
+
+void BannerCache::Init(u32 size)
+{
+	Clear();
+	LockMutex lock(mutex);
+	budget = size;
+}
+
+void BannerCache::Clear()
+{
+	LockMutex lock(mutex);
+	if(hits + misses > 0)
+		gprintf("Banner cache: %u hits, %u misses\n", hits, misses);
+	for(u32 i = 0; i < BANNER_CACHE_ENTRIES; ++i)
+		_free(entries[i]);
+	active = NULL;
+	used = 0;
+	hits = 0;
+	misses = 0;
+}
+
+void BannerCache::_free(BannerCacheEntry &entry)
+{
+	if(entry.layout == NULL)
+		return;
+	delete entry.layout;
+	free(entry.archive);
+	if(entry.sound != NULL)
+		free(entry.sound);
+	used -= entry.size;
+	memset(&entry, 0, sizeof(BannerCacheEntry));
+}
+
+int BannerCache::_find(const dir_discHdr *hdr) const
+{
+	for(u32 i = 0; i < BANNER_CACHE_ENTRIES; ++i)
+	{
+		if(entries[i].layout != NULL && entries[i].type == hdr->type && strncmp(entries[i].id, hdr->id, 6) == 0)
+			return i;
+	}
+	return -1;
+}
+
+bool BannerCache::Fits(u32 archiveSize, u32 soundSize) const
+{
+	return budget > 0 && archiveSize + soundSize + LAYOUT_OVERHEAD <= budget;
+}
+
+bool BannerCache::Contains(const dir_discHdr *hdr)
+{
+	LockMutex lock(mutex);
+	return _find(hdr) >= 0;
+}
+
+void BannerCache::SetActive(const BannerCacheEntry *entry)
+{
+	LockMutex lock(mutex);
+	active = entry;
+}
+
+const BannerCacheEntry *BannerCache::Find(const dir_discHdr *hdr)
+{
+	LockMutex lock(mutex);
+	int i = _find(hdr);
+	if(i < 0)
+	{
+		misses++;
+		return NULL;
+	}
+	hits++;
+	entries[i].lastUse = ++useCounter;
+	active = &entries[i];
+	return active;
+}
+
+bool BannerCache::_inMem2lo(const u8 *archive, const u8 *sound)
+{
+	return MEM2_lo_contains(archive) || (sound != NULL && MEM2_lo_contains(sound));
+}
+
+bool BannerCache::_evictOne(bool mem2loOnly)
+{
+	BannerCacheEntry *oldest = NULL;
+	for(u32 i = 0; i < BANNER_CACHE_ENTRIES; ++i)
+	{
+		if(entries[i].layout == NULL || &entries[i] == active)
+			continue;
+		if(mem2loOnly && !_inMem2lo(entries[i].archive, entries[i].sound))
+			continue;
+		if(oldest == NULL || entries[i].lastUse < oldest->lastUse)
+			oldest = &entries[i];
+	}
+	if(oldest == NULL)
+		return false;
+	_free(*oldest);
+	return true;
+}
+
+int BannerCache::_freeSlot(void) const
+{
+	for(u32 i = 0; i < BANNER_CACHE_ENTRIES; ++i)
+	{
+		if(entries[i].layout == NULL)
+			return i;
+	}
+	return -1;
+}
+
+const BannerCacheEntry *BannerCache::Insert(const dir_discHdr *hdr, Layout *layout, u8 *archive, u32 archiveSize, u8 *sound, u32 soundSize, bool activate)
+{
+	LockMutex lock(mutex);
+	if(!Fits(archiveSize, soundSize) || _find(hdr) >= 0)
+		return NULL;
+	u32 size = archiveSize + soundSize + LAYOUT_OVERHEAD;
+	int slot = _freeSlot();
+	while((slot < 0 || used + size > budget) && _evictOne(false))
+		slot = _freeSlot();
+	if(slot < 0 || used + size > budget)
+		return NULL;
+
+	/* only banners holding MEM2_lo buffers give memory back to that pool */
+	if(_inMem2lo(archive, sound))
+	{
+		while(MEM2_lo_freesize() < MEM2_LO_RESERVE && _evictOne(true))
+			;
+		if(MEM2_lo_freesize() < MEM2_LO_RESERVE)
+			return NULL;
+	}
+
+	BannerCacheEntry &entry = entries[slot];
+	strncpy(entry.id, hdr->id, 6);
+	entry.id[6] = '\0';
+	entry.type = hdr->type;
+	entry.layout = layout;
+	entry.archive = archive;
+	entry.sound = sound;
+	entry.soundSize = soundSize;
+	entry.size = size;
+	entry.lastUse = ++useCounter;
+	used += size;
+	if(activate)
+		active = &entry;
+	return &entry;
+}
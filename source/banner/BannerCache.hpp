@@ -0,0 +1,67 @@
+/****************************************************************************
+ * Banner cache
+ *
+ * Keeps a few fully prepared banners (decompressed archive, parsed layout and
+ * decompressed sound.bin) around so going back and forth between games does
+ * not read, decompress and parse the same .bnr again. Bounded by a MEM2 budget,
+ * the least recently used banner goes first. The game sound thread and the
+ * prefetch worker use it at the same time, every call takes the cache mutex.
+ ****************************************************************************/
+#ifndef _BANNERCACHE_HPP_
+#define _BANNERCACHE_HPP_
+
+#include <gccore.h>
+
+#include "Layout.h"
+#include "loader/disc.h"
+
+#define BANNER_CACHE_ENTRIES	16
+
+struct BannerCacheEntry
+{
+	char id[7];
+	u8 type;
+	Layout *layout;
+	u8 *archive;// decompressed banner.bin the layout points into
+	u8 *sound;// decompressed sound.bin, NULL if the banner has none
+	u32 soundSize;
+	u32 size;// bytes charged against the budget
+	u32 lastUse;
+};
+
+class BannerCache
+{
+public:
+	BannerCache();
+	void Init(u32 budget);
+	void Clear();
+	bool Enabled() const { return budget > 0; }
+	/* true if a banner of that size can be added without going over the budget */
+	bool Fits(u32 archiveSize, u32 soundSize) const;
+	/* a found banner becomes the active one right away, so it can't be evicted in between */
+	const BannerCacheEntry *Find(const dir_discHdr *hdr);
+	bool Contains(const dir_discHdr *hdr);
+	/* takes ownership of layout, archive and sound, unless it returns NULL */
+	const BannerCacheEntry *Insert(const dir_discHdr *hdr, Layout *layout, u8 *archive, u32 archiveSize, u8 *sound, u32 soundSize, bool activate);
+	/* the banner currently shown, never evicted */
+	void SetActive(const BannerCacheEntry *entry);
+private:
+	int _find(const dir_discHdr *hdr) const;
+	int _freeSlot(void) const;
+	void _free(BannerCacheEntry &entry);
+	bool _evictOne(bool mem2loOnly);
+	static bool _inMem2lo(const u8 *archive, const u8 *sound);
+
+	mutex_t mutex;
+	BannerCacheEntry entries[BANNER_CACHE_ENTRIES];
+	const BannerCacheEntry *active;
+	u32 budget;
+	u32 used;
+	u32 useCounter;
+	u32 hits;
+	u32 misses;
+};
+
+extern BannerCache BnrCache;
+
+#endif
@@ -105,6 +105,16 @@ void BannerWindow::LoadBannerBin(u8 *bnr, u32 bnr_size, u8 *font1, u8 *font2)
 	ShowBanner = true;
 }
 
+void BannerWindow::LoadCachedBanner(Layout *layout, u8 *archive, u8 *font1, u8 *font2)
+{
+	changing = true;
+	Init(font1, font2);
+	gameBanner.Borrow(layout, archive);
+	gameSelected = 1;
+	changing = false;
+	ShowBanner = true;
+}
+
 void BannerWindow::CreateGCBanner(u8 *bnr, u8 *font1, u8 *font2, const wchar_t *title)
 {
 	GC_OpeningBnr *openingBnr = (GC_OpeningBnr *)bnr;
@@ -49,6 +49,7 @@ public:
 	void DeleteBanner(bool gamechange = false);
 	void LoadBanner(u8 *font1, u8 *font2);
 	void LoadBannerBin(u8 *bnr, u32 bnr_size, u8 *font1, u8 *font2);
+	void LoadCachedBanner(Layout *layout, u8 *archive, u8 *font1, u8 *font2);
 	int GetSelectedGame() { return gameSelected; }
 	bool GetZoomSetting() { return AnimZoom; }
 	bool GetInGameSettings() { return (Brightness == 200 ? true : false); }
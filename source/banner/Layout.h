@@ -37,6 +37,7 @@ distribution.
 #include "Window.h"
 #include "WiiFont.h"
 #include "Textbox.h"
+#include "unzip/U8Archive.h"
 
 typedef std::vector<std::string> PaletteList;
 
@@ -64,8 +65,8 @@ public:
 	static const u32 MAGIC_GROUP_POP = MAKE_FOURCC('g', 'r', 'e', '1');
 
 	bool Load(const u8 *brlyt);
-	bool LoadTextures(const u8 *banner_file);
-	bool LoadFonts(const u8 *banner_file);
+	bool LoadTextures(const U8Index &banner_file);
+	bool LoadFonts(const U8Index &banner_file);
 
 	void Render(Mtx &modelview, const Vec2f &ScreenProps, bool widescreen, u8 render_alpha = 0xFF) const;
 
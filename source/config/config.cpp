@@ -1,8 +1,9 @@
 
-#include <fstream>
+#include <stdio.h>
 #include <sstream>
 
 #include "config.hpp"
+#include "lockMutex.hpp"
 #include "gecko/gecko.hpp"
 #include "gui/text.hpp"
 
@@ -11,17 +12,40 @@ static const int g_floatPrecision = 10;
 
 const std::string Config::emptyString;
 
-Config::Config(void) :
-	m_loaded(false), m_changed(false), m_domains(), m_filename(), m_iter() 
+/* upper cased domain or lower cased key for map lookups, built on the stack
+   unless it's unusually long so a lookup that hits allocates nothing */
+class CaseKey
 {
-}
+public:
+	CaseKey(std::string_view text, bool upper)
+	{
+		char *dst = m_buf;
+		if (text.size() > sizeof m_buf)
+		{
+			m_long.resize(text.size());
+			dst = &m_long[0];
+		}
+		for (std::string_view::size_type i = 0; i < text.size(); ++i)
+		{
+			char c = text[i];
+			if (upper && c >= 'a' && c <= 'z')
+				c &= 0xDF;
+			else if (!upper && c >= 'A' && c <= 'Z')
+				c |= 0x20;
+			dst[i] = c;
+		}
+		m_view = std::string_view(dst, text.size());
+	}
+	std::string_view view(void) const { return m_view; }
+private:
+	char m_buf[64];
+	std::string m_long;
+	std::string_view m_view;
+};
 
-static std::string trimEnd(std::string line)
+Config::Config(void) :
+	m_loaded(false), m_changed(false), m_domains(), m_filename(), m_iter() 
 {
-	std::string::size_type i = line.find_last_not_of(g_whitespaces);
-	if (i == std::string::npos) line.clear();
-	else line.resize(i + 1);
-	return line;
 }
 
 static std::string trim(std::string line)
@@ -40,13 +64,13 @@ static std::string trim(std::string line)
 	return line;
 }
 
-static std::string unescNewlines(const std::string &text)
+static void unescNewlines(std::string &s, std::string_view text)
 {
-	std::string s;
 	bool escaping = false;
 
+	s.clear();
 	s.reserve(text.size());
-	for (std::string::size_type i = 0; i < text.size(); ++i)
+	for (std::string_view::size_type i = 0; i < text.size(); ++i)
 	{
 		if (escaping)
 		{
@@ -65,7 +89,71 @@ static std::string unescNewlines(const std::string &text)
 		else
 			s.push_back(text[i]);
 	}
-	return s;
+}
+
+struct PendingSave
+{
+	std::string filename;
+	std::string data;
+};
+
+/* saveLater() queue. both mutexes are set up by the first saveLater(), the write
+   mutex makes sure only one thread at a time writes files and keeps them in order */
+static std::vector<PendingSave> g_pendingSaves;
+static mutex_t g_pendingMutex = LWP_MUTEX_NULL;
+static mutex_t g_writeMutex = LWP_MUTEX_NULL;
+static lwp_t g_saveThread = LWP_THREAD_NULL;
+static bool g_saveThreadRunning = false;
+
+/* the new contents go to a temp file which then replaces the old file, so a
+   power loss while writing leaves either the old or the new file behind */
+static bool writeFile(const std::string &filename, const std::string &data)
+{
+	if (filename.empty())
+		return false;
+	std::string tmp(filename + ".tmp");
+	FILE *file = fopen(tmp.c_str(), "wb");
+	if (file == NULL)
+		return false;
+	bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+	ok = fclose(file) == 0 && ok;
+	if (!ok)
+	{
+		::remove(tmp.c_str());
+		gprintf("Failed to write %s\n", filename.c_str());
+		return false;
+	}
+	/* FAT won't rename over an existing file */
+	::remove(filename.c_str());
+	return rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+/* writes the oldest queued file, false once the queue is empty */
+static bool writeNextSave(bool saveThread)
+{
+	LockMutex write(g_writeMutex);
+	PendingSave save;
+	{
+		LockMutex lock(g_pendingMutex);
+		if (g_pendingSaves.empty())
+		{
+			if (saveThread)
+				g_saveThreadRunning = false;
+			return false;
+		}
+		save.filename.swap(g_pendingSaves.front().filename);
+		save.data.swap(g_pendingSaves.front().data);
+		g_pendingSaves.erase(g_pendingSaves.begin());
+	}
+	writeFile(save.filename, save.data);
+	return true;
+}
+
+static void *saveThread(void *)
+{
+	while (writeNextSave(true))
+		;
+	return NULL;
 }
 
 static std::string escNewlines(const std::string &text)
@@ -92,14 +180,84 @@ static std::string escNewlines(const std::string &text)
 	return s;
 }
 
-bool Config::hasDomain(const std::string &domain) const
+/* the value stored for domain/key or NULL, never adds anything */
+const std::string *Config::_find(std::string_view domain, std::string_view key) const
+{
+	DomainMap::const_iterator i = m_domains.find(CaseKey(domain, true).view());
+	if (i == m_domains.end()) return NULL;
+	KeyMap::const_iterator j = i->second.find(CaseKey(key, false).view());
+	return j == i->second.end() ? NULL : &j->second;
+}
+
+/* the value stored for domain/key, an empty one is added if there's none yet */
+std::string &Config::_get(std::string_view domain, std::string_view key, bool *added)
+{
+	CaseKey d(domain, true);
+	DomainMap::iterator i = m_domains.find(d.view());
+	if (i == m_domains.end())
+		i = m_domains.emplace(std::string(d.view()), KeyMap()).first;
+	CaseKey k(key, false);
+	KeyMap::iterator j = i->second.find(k.view());
+	if (j == i->second.end())
+	{
+		j = i->second.emplace(std::string(k.view()), std::string()).first;
+		if (added != NULL) *added = true;
+	}
+	return j->second;
+}
+
+/* stores val, it only counts as a change if the file would end up different */
+void Config::_set(std::string_view domain, std::string_view key, const std::string &val)
+{
+	bool added = false;
+	std::string &data = _get(domain, key, &added);
+	if (added || data != val)
+	{
+		data = val;
+		m_changed = true;
+	}
+}
+
+bool Config::hasDomain(std::string_view domain) const
 {
 	return m_domains.find(domain) != m_domains.end();
 }
 
-void Config::copyDomain(const std::string &dst, const std::string &src)
+const Config::KeyMap *Config::getDomain(std::string_view domain) const
+{
+	DomainMap::const_iterator i = m_domains.find(CaseKey(domain, true).view());
+	return i == m_domains.end() ? NULL : &i->second;
+}
+
+/* 1 for yes/true/y/1, 0 for no/false/n/0 and -1 for anything else */
+static int boolValue(const std::string &value)
+{
+	std::string::size_type i = value.find_first_not_of(g_whitespaces);
+	if (i == std::string::npos) return -1;
+	std::string::size_type j = value.find_last_not_of(g_whitespaces);
+	CaseKey k(std::string_view(value).substr(i, j - i + 1), false);
+	std::string_view s(k.view());
+	if (s == "yes" || s == "true" || s == "y" || s == "1")
+		return 1;
+	if (s == "no" || s == "false" || s == "n" || s == "0")
+		return 0;
+	return -1;
+}
+
+bool Config::isTrue(const std::string &value)
+{
+	return boolValue(value) == 1;
+}
+
+void Config::copyDomain(std::string_view dst, std::string_view src)
 {
-	m_domains[upperCase(dst)] = m_domains[upperCase(src)];
+	CaseKey s(src, true);
+	DomainMap::iterator i = m_domains.find(s.view());
+	if (i == m_domains.end())
+		i = m_domains.emplace(std::string(s.view()), KeyMap()).first;
+	CaseKey d(dst, true);
+	if (d.view() != s.view())
+		m_domains[std::string(d.view())] = i->second;
 }
 
 const std::string &Config::firstDomain(void)
@@ -118,7 +276,7 @@ const std::string &Config::nextDomain(void)
 	return m_iter->first;
 }
 
-const std::string &Config::nextDomain(const std::string &start) const
+const std::string &Config::nextDomain(std::string_view start) const
 {
 	Config::DomainMap::const_iterator i;
 	Config::DomainMap::const_iterator j;
@@ -132,7 +290,7 @@ const std::string &Config::nextDomain(const std::string &start) const
 	return j != m_domains.end() ? j->first : i->first;
 }
 
-const std::string &Config::prevDomain(const std::string &start) const
+const std::string &Config::prevDomain(std::string_view start) const
 {
 	Config::DomainMap::const_iterator i;
 	if (m_domains.empty())
@@ -144,51 +302,96 @@ const std::string &Config::prevDomain(const std::string &start) const
 	return i->first;
 }
 
+static std::string_view trimView(std::string_view text)
+{
+	std::string_view::size_type i = text.find_first_not_of(g_whitespaces);
+	if (i == std::string_view::npos)
+		return std::string_view();
+	return text.substr(i, text.find_last_not_of(g_whitespaces) - i + 1);
+}
+
 bool Config::load(const char *filename)
 {
 	if(m_loaded)
 		return true;
 	//if (m_loaded && m_changed) save();
-	
-	std::ifstream file(filename, std::ios::in | std::ios::binary);
-	std::string line;
-	std::string domain("");
 
 	m_changed = false;
 	m_loaded = false;
 	m_filename = filename;
-	u32 n = 0;
-	if (!file.is_open()) return m_loaded;
+	flushSaves();// a queued copy of this file may not be written yet
+
+	/* read the whole file at once and split it up in place */
+	FILE *file = fopen(filename, "rb");
+	std::string tmp;
+	if (file == NULL)
+	{
+		/* the temp file is only ever complete when the old file is already gone */
+		tmp = sfmt("%s.tmp", filename);
+		file = fopen(tmp.c_str(), "rb");
+		if (file == NULL) return m_loaded;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	std::string buf;
+	if (size > 0)
+	{
+		buf.resize(size);
+		buf.resize(fread(&buf[0], 1, size, file));
+	}
+	fclose(file);
+	/* finish the save that was cut off, the original is missing so the rename works on FAT */
+	if (!tmp.empty())
+		rename(tmp.c_str(), filename);
+
 	m_domains.clear();
-	while (file.good())
+	std::string domain;
+	KeyMap *km = NULL;
+	std::string key;
+	std::string_view text(buf);
+	while (!text.empty())
 	{
-		line.clear();
-		std::getline(file, line, '\n');
-		++n;
-		if (!file.bad() && !file.fail())
+		std::string_view::size_type eol = text.find('\n');
+		std::string_view line = text.substr(0, eol);
+		text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+		std::string_view::size_type i = line.find_last_not_of(g_whitespaces);
+		if (i == std::string_view::npos) continue;
+		line = line.substr(0, i + 1);
+		if (line[0] == '#' || line[0] == '\0') continue;
+		if (line[0] == '[')
 		{
-			line = trimEnd(line);
-			if (line.empty() || line[0] == '#' || line[0] == '\0') continue;
-			if (line[0] == '[')
+			i = line.find_first_of(']');
+			if (i != std::string_view::npos && i > 1)
 			{
-				std::string::size_type i = line.find_first_of(']');
-				if (i != std::string::npos && i > 1)
-				{
-					domain = upperCase(line.substr(1, i - 1));
-					if (m_domains.find(domain) != m_domains.end())
-						domain.clear();
-				}
+				/* a domain is only read the first time it shows up */
+				CaseKey d(line.substr(1, i - 1), true);
+				km = NULL;
+				if (m_domains.find(d.view()) != m_domains.end())
+					domain.clear();
+				else
+					domain.assign(d.view());
+			}
+		}
+		else if (!domain.empty())
+		{
+			i = line.find_first_of('=');
+			if (i != std::string_view::npos && i > 0)
+			{
+				if (km == NULL)
+					km = &m_domains[domain];
+				key.assign(CaseKey(trimView(line.substr(0, i)), false).view());
+				/* saved files are sorted so keys mostly go at the end */
+				KeyMap::iterator k;
+				if (km->empty() || km->rbegin()->first < key)
+					k = km->emplace_hint(km->end(), key, std::string());
+				else
+					k = km->try_emplace(key).first;
+				unescNewlines(k->second, trimView(line.substr(i + 1)));
 			}
-			else
-				if (!domain.empty())
-				{
-					std::string::size_type i = line.find_first_of('=');
-					if (i != std::string::npos && i > 0)
-						m_domains[domain][lowerCase(trim(line.substr(0, i)))] = unescNewlines(trim(line.substr(i + 1)));
-				}
 		}
 	}
-	file.close(); /* not sure if needed */
 	m_loaded = true;
 	return m_loaded;
 }
@@ -202,31 +405,91 @@ void Config::unload(void)
 	m_groupCustomTitles.clear();
 }
 
+std::string Config::_serialize(void) const
+{
+	std::string data;
+	for (Config::DomainMap::const_iterator k = m_domains.begin(); k != m_domains.end(); ++k)
+	{
+		const Config::KeyMap *m = &k->second;
+		data += '\n';
+		data += '[';
+		data += k->first;
+		data += "]\n";
+		for (Config::KeyMap::const_iterator l = m->begin(); l != m->end(); ++l)
+		{
+			data += l->first;
+			data += '=';
+			data += escNewlines(l->second);
+			data += '\n';
+		}
+	}
+	return data;
+}
+
 void Config::save(bool unload)
 {
+	/* anything still queued for this or another file goes first */
+	flushSaves();
 	if (m_changed)
 	{
 		//gprintf("changed:%d\n",m_changed);
-		std::ofstream file(m_filename.c_str(), std::ios::out | std::ios::binary);
-		for (Config::DomainMap::iterator k = m_domains.begin(); k != m_domains.end(); ++k)
-		{
-			Config::KeyMap *m = &k->second;
-			file << '\n' << '[' << k->first << ']' << '\n';
-			for (Config::KeyMap::iterator l = m->begin(); l != m->end(); ++l)
-				file << l->first << '=' << escNewlines(l->second) << '\n';
-		}
-		file.close(); /* not sure if needed */
+		writeFile(m_filename, _serialize());
 		m_changed = false;
 	}
 	if(unload) this->unload();
 }
 
-bool Config::has(const std::string &domain, const std::string &key) const
+void Config::saveLater(void)
+{
+	if (!m_changed)
+		return;
+	if (g_pendingMutex == LWP_MUTEX_NULL)
+	{
+		LWP_MutexInit(&g_pendingMutex, false);
+		LWP_MutexInit(&g_writeMutex, false);
+	}
+	std::string data(_serialize());
+	m_changed = false;
+
+	bool start = false;
+	{
+		LockMutex lock(g_pendingMutex);
+		/* a newer copy of a file still waiting replaces the old one */
+		std::vector<PendingSave>::iterator i;
+		for (i = g_pendingSaves.begin(); i != g_pendingSaves.end(); ++i)
+			if (i->filename == m_filename)
+				break;
+		if (i != g_pendingSaves.end())
+			i->data.swap(data);
+		else
+		{
+			g_pendingSaves.push_back(PendingSave());
+			g_pendingSaves.back().filename = m_filename;
+			g_pendingSaves.back().data.swap(data);
+		}
+		if (!g_saveThreadRunning)
+			start = g_saveThreadRunning = true;
+	}
+	if (start)
+	{
+		if (g_saveThread != LWP_THREAD_NULL)
+			LWP_JoinThread(g_saveThread, NULL);
+		LWP_CreateThread(&g_saveThread, saveThread, NULL, 0, 32768, 40);
+	}
+}
+
+void Config::flushSaves(void)
+{
+	if (g_pendingMutex == LWP_MUTEX_NULL)
+		return;
+	while (writeNextSave(false))
+		;
+}
+
+bool Config::has(std::string_view domain, std::string_view key) const
 {
 	if (domain.empty() || key.empty()) return false;
-	DomainMap::const_iterator i = m_domains.find(upperCase(domain));
-	if (i == m_domains.end()) return false;
-	return i->second.find(lowerCase(key)) != i->second.end();
+	return _find(domain, key) != NULL;
 }
 
 void Config::groupCustomTitles(void)
@@ -241,100 +504,95 @@ void Config::groupCustomTitles(void)
 	}
 }
 
-void Config::setWString(const std::string &domain, const std::string &key, const wstringEx &val)
+void Config::setWString(std::string_view domain, std::string_view key, const wstringEx &val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setWString %s\n", val.toUTF8().c_str());
-	m_changed = true;
-	m_domains[upperCase(domain)][lowerCase(key)] = val.toUTF8();
+	_set(domain, key, val.toUTF8());
 }
 
-void Config::setString(const std::string &domain, const std::string &key, const std::string &val)
+void Config::setString(std::string_view domain, std::string_view key, const std::string &val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setString %s\n", val.c_str());
-	m_changed = true;
-	m_domains[upperCase(domain)][lowerCase(key)] = val;
+	_set(domain, key, val);
 }
 
-void Config::setBool(const std::string &domain, const std::string &key, bool val)
+void Config::setBool(std::string_view domain, std::string_view key, bool val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setBool %d\n", val);
-	m_changed = true;
-	m_domains[upperCase(domain)][lowerCase(key)] = val ? "yes" : "no";
+	_set(domain, key, val ? "yes" : "no");
 }
 
-void Config::remove(const std::string &domain, const std::string &key)
+void Config::remove(std::string_view domain, std::string_view key)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("remove %s\n", key.c_str());
+	DomainMap::iterator i = m_domains.find(CaseKey(domain, true).view());
+	if (i == m_domains.end()) return;
+	KeyMap::iterator j = i->second.find(CaseKey(key, false).view());
+	if (j == i->second.end()) return;
+	i->second.erase(j);
 	m_changed = true;
-	m_domains[upperCase(domain)].erase(lowerCase(key));
 }
 
-void Config::setOptBool(const std::string &domain, const std::string &key, int val)
+void Config::setOptBool(std::string_view domain, std::string_view key, int val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setOptBool %d\n", val);
-	m_changed = true;
 	switch (val)
 	{
 		case 0:
-			m_domains[upperCase(domain)][lowerCase(key)] = "no";
+			_set(domain, key, "no");
 			break;
 		case 1:
-			m_domains[upperCase(domain)][lowerCase(key)] = "yes";
+			_set(domain, key, "yes");
 			break;
 		default:
-			m_domains[upperCase(domain)][lowerCase(key)] = "default";
+			_set(domain, key, "default");
 	}
 }
 
-void Config::setInt(const std::string &domain, const std::string &key, int val)
+void Config::setInt(std::string_view domain, std::string_view key, int val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setInt %i\n", val);
-	m_changed = true;
-	m_domains[upperCase(domain)][lowerCase(key)] = sfmt("%i", val);
+	_set(domain, key, sfmt("%i", val));
 }
 
-void Config::setUInt(const std::string &domain, const std::string &key, unsigned int val)
+void Config::setUInt(std::string_view domain, std::string_view key, unsigned int val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setUInt %u\n", val);
-	m_changed = true;
-	m_domains[upperCase(domain)][lowerCase(key)] = sfmt("%u", val);
+	_set(domain, key, sfmt("%u", val));
 }
 
-void Config::setFloat(const std::string &domain, const std::string &key, float val)
+void Config::setFloat(std::string_view domain, std::string_view key, float val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setFloat %f\n", val);
-	m_changed = true;
-	m_domains[upperCase(domain)][lowerCase(key)] = sfmt("%.*g", g_floatPrecision, val);
+	_set(domain, key, sfmt("%.*g", g_floatPrecision, val));
 }
 
-void Config::setVector3D(const std::string &domain, const std::string &key, const Vector3D &val)
+void Config::setVector3D(std::string_view domain, std::string_view key, const Vector3D &val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setVector3D\n");
-	m_changed = true;
-	m_domains[upperCase(domain)][lowerCase(key)] = sfmt("%.*g, %.*g, %.*g", g_floatPrecision, val.x, g_floatPrecision, val.y, g_floatPrecision, val.z);
+	_set(domain, key, sfmt("%.*g, %.*g, %.*g", g_floatPrecision, val.x, g_floatPrecision, val.y, g_floatPrecision, val.z));
 }
 
-void Config::setColor(const std::string &domain, const std::string &key, const CColor &val)
+void Config::setColor(std::string_view domain, std::string_view key, const CColor &val)
 {
 	if (domain.empty() || key.empty()) return;
 	//gprintf("setColor\n");
-	m_changed = true;
-	m_domains[upperCase(domain)][lowerCase(key)] = sfmt("#%.2X%.2X%.2X%.2X", val.r, val.g, val.b, val.a);
+	_set(domain, key, sfmt("#%.2X%.2X%.2X%.2X", val.r, val.g, val.b, val.a));
 }
 
-wstringEx Config::getWString(const std::string &domain, const std::string &key, const wstringEx &defVal)
+wstringEx Config::getWString(std::string_view domain, std::string_view key, const wstringEx &defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if (data.empty())
 	{
 		data = defVal.toUTF8();
@@ -347,11 +605,11 @@ wstringEx Config::getWString(const std::string &domain, const std::string &key,
 	return ws;
 }
 
-std::string Config::getString(const std::string &domain, const std::string &key, const std::string &defVal)
+std::string Config::getString(std::string_view domain, std::string_view key, const std::string &defVal)
 {
 	if(domain.empty() || key.empty())
 		return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if(data.empty())
 	{
 		data = defVal;
@@ -361,13 +619,13 @@ std::string Config::getString(const std::string &domain, const std::string &key,
 	return data;
 }
 
-std::string Config::getStringCustomTitles(const std::string &domain, const std::string &key, const std::string &defVal)
+std::string Config::getStringCustomTitles(std::string_view domain, std::string_view key, const std::string &defVal)
 {
 	if(domain.empty() || key.empty())
 		return defVal;
-	KeyMap::iterator i = m_groupCustomTitles.find(upperCase(domain));
+	KeyMap::iterator i = m_groupCustomTitles.find(CaseKey(domain, true).view());
 	if (i == m_groupCustomTitles.end()) return defVal;
-	std::string &data = m_domains[i->second][lowerCase(key)];
+	std::string &data = _get(i->second, key);
 	if(data.empty())
 	{
 		data = defVal;
@@ -377,7 +635,7 @@ std::string Config::getStringCustomTitles(const std::string &domain, const std::
 	return data;
 }
 
-std::vector<std::string> Config::getStrings(const std::string &domain, const std::string &key, char seperator, const std::string &defVal)
+std::vector<std::string> Config::getStrings(std::string_view domain, std::string_view key, char seperator, const std::string &defVal)
 {
 	std::vector<std::string> retval;
 
@@ -388,7 +646,7 @@ std::vector<std::string> Config::getStrings(const std::string &domain, const std
 		return retval;
 	}
 
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if(data.empty())
 	{
 		if(!defVal.empty())
@@ -425,10 +683,10 @@ std::vector<std::string> Config::getStrings(const std::string &domain, const std
 	return retval;
 }
 
-bool Config::getBool(const std::string &domain, const std::string &key, bool defVal)
+bool Config::getBool(std::string_view domain, std::string_view key, bool defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if (data.empty())
 	{
 		data = defVal ? "yes" : "no";
@@ -436,30 +694,22 @@ bool Config::getBool(const std::string &domain, const std::string &key, bool def
 		m_changed = true;
 		return defVal;
 	}
-	std::string s(lowerCase(trim(data)));
-	if (s == "yes" || s == "true" || s == "y" || s == "1")
-		return true;
-	return false;
+	return isTrue(data);
 }
 
-bool Config::testOptBool(const std::string &domain, const std::string &key, bool defVal)
+bool Config::testOptBool(std::string_view domain, std::string_view key, bool defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	KeyMap &km = m_domains[upperCase(domain)];
-	KeyMap::iterator i = km.find(lowerCase(key));
-	if (i == km.end()) return defVal;
-	std::string s(lowerCase(trim(i->second)));
-	if (s == "yes" || s == "true" || s == "y" || s == "1")
-		return true;
-	if (s == "no" || s == "false" || s == "n" || s == "0")
-		return false;
-	return defVal;
+	const std::string *data = _find(domain, key);
+	if (data == NULL) return defVal;
+	int b = boolValue(*data);
+	return b < 0 ? defVal : b == 1;
 }
 
-int Config::getOptBool(const std::string &domain, const std::string &key, int defVal)
+int Config::getOptBool(std::string_view domain, std::string_view key, int defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if (data.empty())
 	{
 		switch (defVal)
@@ -477,18 +727,14 @@ int Config::getOptBool(const std::string &domain, const std::string &key, int de
 		m_changed = true;
 		return defVal;
 	}
-	std::string s(lowerCase(trim(data)));
-	if (s == "yes" || s == "true" || s == "y" || s == "1")
-		return 1;
-	if (s == "no" || s == "false" || s == "n" || s == "0")
-		return 0;
-	return 2;
+	int b = boolValue(data);
+	return b < 0 ? 2 : b;
 }
 
-int Config::getInt(const std::string &domain, const std::string &key, int defVal)
+int Config::getInt(std::string_view domain, std::string_view key, int defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if (data.empty())
 	{
 		data = sfmt("%i", defVal);
@@ -500,19 +746,19 @@ int Config::getInt(const std::string &domain, const std::string &key, int defVal
 }
 
 /* this returns true only if there's something after the '=' and value is set to the integer value */
-bool Config::getInt(const std::string &domain, const std::string &key, int *value)
+bool Config::getInt(std::string_view domain, std::string_view key, int *value)
 {
 	if (domain.empty() || key.empty()) return false;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if (data.empty()) return false;
 	*value = strtol(data.c_str(), 0, 10);
 	return true;
 }
 
-unsigned int Config::getUInt(const std::string &domain, const std::string &key, unsigned int defVal)
+unsigned int Config::getUInt(std::string_view domain, std::string_view key, unsigned int defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if (data.empty())
 	{
 		data = sfmt("%u", defVal);
@@ -523,10 +769,10 @@ unsigned int Config::getUInt(const std::string &domain, const std::string &key,
 	return strtoul(data.c_str(), 0, 10);
 }
 
-float Config::getFloat(const std::string &domain, const std::string &key, float defVal)
+float Config::getFloat(std::string_view domain, std::string_view key, float defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	if (data.empty())
 	{
 		data = sfmt("%.*g", g_floatPrecision, defVal);
@@ -537,10 +783,10 @@ float Config::getFloat(const std::string &domain, const std::string &key, float
 	return strtod(data.c_str(), 0);
 }
 
-Vector3D Config::getVector3D(const std::string &domain, const std::string &key, const Vector3D &defVal)
+Vector3D Config::getVector3D(std::string_view domain, std::string_view key, const Vector3D &defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	std::string::size_type i;
 	std::string::size_type j = std::string::npos;
 	i = data.find_first_of(',');
@@ -555,10 +801,10 @@ Vector3D Config::getVector3D(const std::string &domain, const std::string &key,
 	return Vector3D(strtod(data.substr(0, i).c_str(), 0), strtod(data.substr(i + 1, j - i - 1).c_str(), 0), strtod(data.substr(j + 1).c_str(), 0));
 }
 
-CColor Config::getColor(const std::string &domain, const std::string &key, const CColor &defVal)
+CColor Config::getColor(std::string_view domain, std::string_view key, const CColor &defVal)
 {
 	if (domain.empty() || key.empty()) return defVal;
-	std::string &data = m_domains[upperCase(domain)][lowerCase(key)];
+	std::string &data = _get(domain, key);
 	std::string text(upperCase(trim(data)));
 	u32 i = (u32)text.find_first_of('#');
 	if (i != std::string::npos)
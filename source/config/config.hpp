@@ -3,7 +3,9 @@
 #define __CONFIG_HPP
 
 #include <map>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "gui/vector.hpp"
 #include "gui/video.hpp"
@@ -11,6 +13,9 @@
 
 class Config
 {
+public:
+	// keys are lower case, lookups work with any string type without copies
+	typedef std::map<std::string, std::string, std::less<> > KeyMap;
 public:
 	Config(void);
 	void clear(void) { m_domains.clear(); m_groupCustomTitles.clear();}
@@ -18,44 +23,53 @@ public:
 	void groupCustomTitles(void);
 	void unload(void);
 	void save(bool unload = false);
+	// hands the file to a background thread, save() and flushSaves() wait for what's queued
+	void saveLater(void);
+	static void flushSaves(void);
 	bool loaded(void) const { return m_loaded; }
-	bool has(const std::string &domain, const std::string &key) const;
+	bool has(std::string_view domain, std::string_view key) const;
 	// Set
-	void setWString(const std::string &domain, const std::string &key, const wstringEx &val);
-	void setString(const std::string &domain, const std::string &key, const std::string &val);
-	void setBool(const std::string &domain, const std::string &key, bool val);
-	void setOptBool(const std::string &domain, const std::string &key, int val);
-	void setInt(const std::string &domain, const std::string &key, int val);
-	void setUInt(const std::string &domain, const std::string &key, unsigned int val);
-	void setFloat(const std::string &domain, const std::string &key, float val);
-	void setVector3D(const std::string &domain, const std::string &key, const Vector3D &val);
-	void setColor(const std::string &domain, const std::string &key, const CColor &val);
+	void setWString(std::string_view domain, std::string_view key, const wstringEx &val);
+	void setString(std::string_view domain, std::string_view key, const std::string &val);
+	void setBool(std::string_view domain, std::string_view key, bool val);
+	void setOptBool(std::string_view domain, std::string_view key, int val);
+	void setInt(std::string_view domain, std::string_view key, int val);
+	void setUInt(std::string_view domain, std::string_view key, unsigned int val);
+	void setFloat(std::string_view domain, std::string_view key, float val);
+	void setVector3D(std::string_view domain, std::string_view key, const Vector3D &val);
+	void setColor(std::string_view domain, std::string_view key, const CColor &val);
 	// Get
-	wstringEx getWString(const std::string &domain, const std::string &key, const wstringEx &defVal = wstringEx());
-	std::string getString(const std::string &domain, const std::string &key, const std::string &defVal = std::string());
-	std::string getStringCustomTitles(const std::string &domain, const std::string &key, const std::string &defVal = std::string());
-	std::vector<std::string> getStrings(const std::string &domain, const std::string &key, char seperator = ',', const std::string &defval = std::string());
-	bool getBool(const std::string &domain, const std::string &key, bool defVal = false);
-	int getOptBool(const std::string &domain, const std::string &key, int defVal = 2);
-	bool testOptBool(const std::string &domain, const std::string &key, bool defVal);
-	int getInt(const std::string &domain, const std::string &key, int defVal = 0);
-	bool getInt(const std::string &domain, const std::string &key, int *value);
-	unsigned int getUInt(const std::string &domain, const std::string &key, unsigned int defVal = 0);
-	float getFloat(const std::string &domain, const std::string &key, float defVal = 0.f);
-	Vector3D getVector3D(const std::string &domain, const std::string &key, const Vector3D &defVal = Vector3D());
-	CColor getColor(const std::string &domain, const std::string &key, const CColor &defVal = CColor());
+	wstringEx getWString(std::string_view domain, std::string_view key, const wstringEx &defVal = wstringEx());
+	std::string getString(std::string_view domain, std::string_view key, const std::string &defVal = std::string());
+	std::string getStringCustomTitles(std::string_view domain, std::string_view key, const std::string &defVal = std::string());
+	std::vector<std::string> getStrings(std::string_view domain, std::string_view key, char seperator = ',', const std::string &defval = std::string());
+	bool getBool(std::string_view domain, std::string_view key, bool defVal = false);
+	int getOptBool(std::string_view domain, std::string_view key, int defVal = 2);
+	bool testOptBool(std::string_view domain, std::string_view key, bool defVal);
+	int getInt(std::string_view domain, std::string_view key, int defVal = 0);
+	bool getInt(std::string_view domain, std::string_view key, int *value);
+	unsigned int getUInt(std::string_view domain, std::string_view key, unsigned int defVal = 0);
+	float getFloat(std::string_view domain, std::string_view key, float defVal = 0.f);
+	Vector3D getVector3D(std::string_view domain, std::string_view key, const Vector3D &defVal = Vector3D());
+	CColor getColor(std::string_view domain, std::string_view key, const CColor &defVal = CColor());
 	// Remove
-	void remove(const std::string &domain, const std::string &key);
+	void remove(std::string_view domain, std::string_view key);
 	// 
 	const std::string &firstDomain(void);
 	const std::string &nextDomain(void);
-	const std::string &nextDomain(const std::string &start) const;
-	const std::string &prevDomain(const std::string &start) const;
-	bool hasDomain(const std::string &domain) const;
-	void copyDomain(const std::string &dst, const std::string &src);
+	const std::string &nextDomain(std::string_view start) const;
+	const std::string &prevDomain(std::string_view start) const;
+	bool hasDomain(std::string_view domain) const;
+	void copyDomain(std::string_view dst, std::string_view src);
+	// read only access to a whole domain, NULL if it doesn't exist. nothing gets added to it
+	const KeyMap *getDomain(std::string_view domain) const;
+	static bool isTrue(const std::string &value);
 private:
-	typedef std::map<std::string, std::string> KeyMap;
-	typedef std::map<std::string, KeyMap> DomainMap;
+	typedef std::map<std::string, KeyMap, std::less<> > DomainMap;
+	const std::string *_find(std::string_view domain, std::string_view key) const;
+	std::string &_get(std::string_view domain, std::string_view key, bool *added = NULL);
+	void _set(std::string_view domain, std::string_view key, const std::string &val);
+	std::string _serialize(void) const;
 private:
 	bool m_loaded;
 	bool m_changed;
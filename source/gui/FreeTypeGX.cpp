@@ -28,6 +28,8 @@ FreeTypeGX::FreeTypeGX()
 	FT_Init_FreeType(&ftLibrary);
     reset();
 	ftFace = 0;
+	lastSizeCache = NULL;
+	atlasChanged = false;
 }
 
 FreeTypeGX::~FreeTypeGX()
@@ -86,31 +88,78 @@ void FreeTypeGX::unloadFont()
 {
 	if (this->fontData.size() == 0) return;
 
-	std::map<int16_t, std::map<wchar_t, ftgxCharData> >::iterator itr;
-	std::map<wchar_t, ftgxCharData>::iterator itr2;
-
-	for (itr = fontData.begin(); itr != fontData.end(); itr++)
+	for (u32 i = 0; i < fontData.size(); ++i)
 	{
-		for (itr2 = itr->second.begin(); itr2 != itr->second.end(); itr2++)
-			MEM2_free(itr2->second.glyphDataTexture);
-
-		itr->second.clear();
+		ftgxSizeCache *sizeCache = fontData[i];
+		for (u32 j = 0; j < FTGX_GLYPH_PAGE_COUNT; ++j)
+			delete sizeCache->pages[j];
+		for (u32 j = 0; j < sizeCache->atlases.size(); ++j)
+			MEM2_free(sizeCache->atlases[j].texture);
+		delete sizeCache;
 	}
 
 	fontData.clear();
+	lastSizeCache = NULL;
 	ftgxAlign.clear();
 }
 
+ftgxSizeCache *FreeTypeGX::getSizeCache(int16_t pixelSize)
+{
+	if (lastSizeCache != NULL && lastSizeCache->pixelSize == pixelSize)
+		return lastSizeCache;
+
+	for (u32 i = 0; i < fontData.size(); ++i)
+	{
+		if (fontData[i]->pixelSize == pixelSize)
+		{
+			lastSizeCache = fontData[i];
+			return lastSizeCache;
+		}
+	}
+
+	ftgxSizeCache *sizeCache = new (std::nothrow) ftgxSizeCache;
+	if (sizeCache == NULL)
+		return NULL;
+	sizeCache->pixelSize = pixelSize;
+	memset(sizeCache->pages, 0, sizeof(sizeCache->pages));
+	fontData.push_back(sizeCache);
+
+	lastSizeCache = sizeCache;
+	return sizeCache;
+}
+
 ftgxCharData * FreeTypeGX::cacheGlyphData(wchar_t charCode, int16_t pixelSize)
 {
-	std::map<int16_t, std::map<wchar_t, ftgxCharData> >::iterator itr = fontData.find(pixelSize);
-	if (itr != fontData.end())
+	ftgxSizeCache *sizeCache = getSizeCache(pixelSize);
+	if (sizeCache == NULL)
+		return NULL;
+
+	ftgxCharData *charData = NULL;
+	uint8_t *glyphState = NULL;
+
+	if ((uint32_t)charCode < 0x10000)
 	{
-		std::map<wchar_t, ftgxCharData>::iterator itr2 = itr->second.find(charCode);
-		if (itr2 != itr->second.end())
+		ftgxGlyphPage *&page = sizeCache->pages[charCode >> FTGX_GLYPH_PAGE_BITS];
+		if (page == NULL)
 		{
-			return &itr2->second;
+			page = new (std::nothrow) ftgxGlyphPage;
+			if (page == NULL)
+				return NULL;
+			memset(page->state, FTGX_GLYPH_UNKNOWN, sizeof(page->state));
 		}
+		u32 idx = charCode & (FTGX_GLYPH_PAGE_SIZE - 1);
+		if (page->state[idx] == FTGX_GLYPH_CACHED)
+			return &page->glyphs[idx];
+		if (page->state[idx] == FTGX_GLYPH_MISSING)
+			return NULL;
+		charData = &page->glyphs[idx];
+		glyphState = &page->state[idx];
+	}
+	else
+	{
+		std::unordered_map<wchar_t, ftgxCharData>::iterator itr = sizeCache->extGlyphs.find(charCode);
+		if (itr != sizeCache->extGlyphs.end())
+			return itr->second.glyphIndex != 0 ? &itr->second : NULL;
 	}
 
 	FT_UInt gIndex;
@@ -147,21 +196,44 @@ ftgxCharData * FreeTypeGX::cacheGlyphData(wchar_t charCode, int16_t pixelSize)
 			if(textureHeight == 0)
 				textureHeight = 8;
 
-			fontData[pixelSize][charCode].renderOffsetX = (int16_t) ftFace->glyph->bitmap_left;
-			fontData[pixelSize][charCode].glyphAdvanceX = (uint16_t) (ftFace->glyph->advance.x >> 6);
-			fontData[pixelSize][charCode].glyphIndex = (uint32_t) gIndex;
-			fontData[pixelSize][charCode].textureWidth = (uint16_t) textureWidth;
-			fontData[pixelSize][charCode].textureHeight = (uint16_t) textureHeight;
-			fontData[pixelSize][charCode].renderOffsetY = (int16_t) ftFace->glyph->bitmap_top;
-			fontData[pixelSize][charCode].renderOffsetMax = (int16_t) ftFace->glyph->bitmap_top;
-			fontData[pixelSize][charCode].renderOffsetMin = (int16_t) glyphBitmap->rows - ftFace->glyph->bitmap_top;
-			fontData[pixelSize][charCode].glyphDataTexture = NULL;
-
-			loadGlyphData(glyphBitmap, &fontData[pixelSize][charCode]);
+			if (charData == NULL)
+				charData = &sizeCache->extGlyphs[charCode];
+
+			charData->renderOffsetX = (int16_t) ftFace->glyph->bitmap_left;
+			charData->glyphAdvanceX = (uint16_t) (ftFace->glyph->advance.x >> 6);
+			charData->glyphIndex = (uint32_t) gIndex;
+			charData->textureWidth = (uint16_t) textureWidth;
+			charData->textureHeight = (uint16_t) textureHeight;
+			charData->renderOffsetY = (int16_t) ftFace->glyph->bitmap_top;
+			charData->renderOffsetMax = (int16_t) ftFace->glyph->bitmap_top;
+			charData->renderOffsetMin = (int16_t) glyphBitmap->rows - ftFace->glyph->bitmap_top;
+			charData->atlasIndex = FTGX_NO_ATLAS;
+
+			// empty glyphs like spaces only advance the pen, they don't need any atlas space
+			if (glyphBitmap->width > 0 && glyphBitmap->rows > 0)
+			{
+				// reserve at least one blank row and column so filtering never picks up the neighbour glyph
+				if (!allocAtlasSlot(sizeCache, ALIGN8(glyphBitmap->width + 1), ALIGN8(glyphBitmap->rows + 1), charData))
+				{
+					// out of memory, don't remember the glyph so it is tried again later
+					if (glyphState == NULL)
+						sizeCache->extGlyphs.erase(charCode);
+					return NULL;
+				}
+				loadGlyphData(glyphBitmap, &sizeCache->atlases[charData->atlasIndex], charData);
+			}
 
-			return &fontData[pixelSize][charCode];
+			if (glyphState != NULL)
+				*glyphState = FTGX_GLYPH_CACHED;
+			return charData;
 		}
 	}
+
+	// remember missing glyphs so FreeType isn't asked for them again on every draw
+	if (glyphState != NULL)
+		*glyphState = FTGX_GLYPH_MISSING;
+	else
+		sizeCache->extGlyphs[charCode].glyphIndex = 0;
 	return NULL;
 }
 
@@ -179,41 +251,82 @@ uint16_t FreeTypeGX::cacheGlyphDataComplete(int16_t pixelSize)
 	return i;
 }
 
-void FreeTypeGX::loadGlyphData(FT_Bitmap *bmp, ftgxCharData *charData)
+bool FreeTypeGX::allocAtlasSlot(ftgxSizeCache *sizeCache, uint16_t width, uint16_t height, ftgxCharData *charData)
 {
-    int glyphSize = (charData->textureWidth * charData->textureHeight) >> 1;
+	// simple shelf packing, only the last atlas page still takes new glyphs
+	if (!sizeCache->atlases.empty())
+	{
+		ftgxAtlas *atlas = &sizeCache->atlases.back();
+		if (atlas->shelfX + width > atlas->width)
+		{
+			atlas->shelfY += atlas->shelfHeight;
+			atlas->shelfX = 0;
+			atlas->shelfHeight = 0;
+		}
+		if (atlas->shelfX + width <= atlas->width && atlas->shelfY + height <= atlas->height)
+		{
+			charData->atlasIndex = sizeCache->atlases.size() - 1;
+			charData->atlasX = atlas->shelfX;
+			charData->atlasY = atlas->shelfY;
+			atlas->shelfX += width;
+			if (height > atlas->shelfHeight)
+				atlas->shelfHeight = height;
+			return true;
+		}
+	}
 
-    uint8_t *glyphData = (uint8_t *) MEM2_alloc(glyphSize);
-	if(glyphData == NULL)
-		return;
-    memset(glyphData, 0x00, glyphSize);
-
-    uint8_t *src = (uint8_t *)bmp->buffer;
-    uint8_t *dst = glyphData;
-    uint32_t pos, x1, y1, x, y;
-
-    for(y1 = 0; y1 < bmp->rows; y1 += 8)
-    {
-            for(x1 = 0; x1 < bmp->width; x1 += 8)
-            {
-                    for(y = y1; y < (y1 + 8); y++)
-                    {
-                            for(x = x1; x < (x1 + 8); x += 2, dst++)
-                            {
-                                    if(x >= bmp->width || y >= bmp->rows)
-                                            continue;
-
-                                    pos = y * bmp->width + x;
-                                    *dst = (src[pos] & 0xF0);
-
-                                        if(x+1 < bmp->width)
-                                            *dst |= (src[pos + 1] >> 4);
-                            }
-                    }
-            }
-    }
-    DCFlushRange(glyphData, glyphSize);
-    charData->glyphDataTexture = glyphData;
+	ftgxAtlas atlas;
+	uint16_t atlasSize = sizeCache->pixelSize > 48 ? FTGX_ATLAS_SIZE_LARGE : FTGX_ATLAS_SIZE;
+	// huge glyphs get a page of their own
+	atlas.width = width > atlasSize ? width : atlasSize;
+	atlas.height = height > atlasSize ? height : atlasSize;
+
+	u32 atlasBytes = (atlas.width * atlas.height) >> 1;
+	atlas.texture = (uint8_t *) MEM2_alloc(atlasBytes);
+	if (atlas.texture == NULL)
+		return false;
+	memset(atlas.texture, 0x00, atlasBytes);
+	DCFlushRange(atlas.texture, atlasBytes);
+	GX_InitTexObj(&atlas.texObj, atlas.texture, atlas.width, atlas.height, GX_TF_I4, GX_CLAMP, GX_CLAMP, GX_FALSE);
+
+	atlas.shelfX = width;
+	atlas.shelfY = 0;
+	atlas.shelfHeight = height;
+	sizeCache->atlases.push_back(atlas);
+
+	charData->atlasIndex = sizeCache->atlases.size() - 1;
+	charData->atlasX = 0;
+	charData->atlasY = 0;
+	return true;
+}
+
+void FreeTypeGX::loadGlyphData(FT_Bitmap *bmp, ftgxAtlas *atlas, ftgxCharData *charData)
+{
+	// I4 textures are made of 8x8 pixel tiles of 32 bytes each, two pixels per byte
+	uint8_t *src = (uint8_t *)bmp->buffer;
+	uint32_t pitch = bmp->pitch < 0 ? -bmp->pitch : bmp->pitch;
+	uint32_t tilesPerRow = atlas->width >> 3;
+	uint32_t x, y, ax, ay;
+
+	for(y = 0; y < bmp->rows; y++)
+	{
+		ay = charData->atlasY + y;
+		uint8_t *tileRow = atlas->texture + (((ay >> 3) * tilesPerRow) << 5) + ((ay & 7) << 2);
+		for(x = 0; x < bmp->width; x++)
+		{
+			ax = charData->atlasX + x;
+			uint8_t *dst = tileRow + ((ax >> 3) << 5) + ((ax & 7) >> 1);
+			uint8_t value = src[y * pitch + x] >> 4;
+			*dst |= (ax & 1) ? value : (value << 4);
+		}
+	}
+
+	// flush only the tiles touched by the glyph
+	uint32_t tileX = charData->atlasX >> 3;
+	uint32_t tileCount = (ALIGN8(bmp->width) >> 3);
+	for(y = charData->atlasY >> 3; y < ((charData->atlasY + ALIGN8(bmp->rows)) >> 3); y++)
+		DCFlushRange(atlas->texture + ((y * tilesPerRow + tileX) << 5), tileCount << 5);
+	atlasChanged = true;
 }
 
 int16_t FreeTypeGX::getStyleOffsetWidth(uint16_t width, uint16_t format)
@@ -267,8 +380,11 @@ uint16_t FreeTypeGX::drawText(int16_t x, int16_t y, const wchar_t *text, int16_t
 	uint16_t fullTextWidth = textWidth > 0 ? textWidth : getWidth(text, pixelSize);
 	uint16_t x_pos = x, printed = 0;
 	uint16_t x_offset = 0, y_offset = 0;
-	GXTexObj glyphTexture;
 	FT_Vector pairDelta;
+	ftgxCharData *prevGlyph = NULL;
+
+	ftgxSizeCache *sizeCache = getSizeCache(pixelSize);
+	if (sizeCache == NULL) return 0;
 
 	if (textStyle & FTGX_JUSTIFY_MASK)
 	{
@@ -279,6 +395,7 @@ uint16_t FreeTypeGX::drawText(int16_t x, int16_t y, const wchar_t *text, int16_t
 		y_offset = getStyleOffsetHeight(textStyle, pixelSize);
 	}
 
+	quadBuffer.clear();
 	int i = 0;
 	while (text[i])
 	{
@@ -288,9 +405,9 @@ uint16_t FreeTypeGX::drawText(int16_t x, int16_t y, const wchar_t *text, int16_t
 
 		if (glyphData != NULL)
 		{
-			if (ftKerningEnabled && i > 0)
+			if (ftKerningEnabled && prevGlyph != NULL)
 			{
-				FT_Get_Kerning(ftFace, fontData[pixelSize][text[i - 1]].glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT, &pairDelta);
+				FT_Get_Kerning(ftFace, prevGlyph->glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT, &pairDelta);
 				x_pos += pairDelta.x >> 6;
 			}
 
@@ -298,15 +415,24 @@ uint16_t FreeTypeGX::drawText(int16_t x, int16_t y, const wchar_t *text, int16_t
 			// renderoffsetx is to properly space wide letters like w or short letters like j.
 			// x_offset and y_offset are used for justify x and align y the text.
 			// in wiiflow they are 0. getStyleOffsetWidth and getStyleOffsetHeight above are not called. wiiflow does style prior to calling drawText.
-			GX_InitTexObj(&glyphTexture, glyphData->glyphDataTexture, glyphData->textureWidth, glyphData->textureHeight, GX_TF_I4, GX_CLAMP, GX_CLAMP, GX_FALSE);
-			copyTextureToFramebuffer(&glyphTexture, glyphData->textureWidth, glyphData->textureHeight, x_pos + glyphData->renderOffsetX - x_offset, y - glyphData->renderOffsetY - y_offset, color);
+			if (glyphData->atlasIndex != FTGX_NO_ATLAS)
+			{
+				ftgxQuad quad;
+				quad.glyph = glyphData;
+				quad.x = (float)(int16_t)(x_pos + glyphData->renderOffsetX - x_offset);
+				quad.y = (float)(int16_t)(y - glyphData->renderOffsetY - y_offset);
+				quadBuffer.push_back(quad);
+			}
 
 			x_pos += glyphData->glyphAdvanceX;
+			prevGlyph = glyphData;
 			++printed;
 		}
 		++i;
 	}
 
+	flushQuads(sizeCache, color);
+
 	if (textStyle & FTGX_STYLE_MASK)
 	{
 		getOffset(text, pixelSize, widthLimit);
@@ -332,6 +458,7 @@ uint16_t FreeTypeGX::getWidth(const wchar_t *text, int16_t pixelSize)
 
 	uint16_t strWidth = 0;
 	FT_Vector pairDelta;
+	ftgxCharData *prevGlyph = NULL;
 
 	int i = 0;
 	while (text[i])
@@ -340,13 +467,14 @@ uint16_t FreeTypeGX::getWidth(const wchar_t *text, int16_t pixelSize)
 
 		if (glyphData != NULL)
 		{
-			if (ftKerningEnabled && (i > 0))
+			if (ftKerningEnabled && prevGlyph != NULL)
 			{
-				FT_Get_Kerning(ftFace, fontData[pixelSize][text[i - 1]].glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT, &pairDelta);
+				FT_Get_Kerning(ftFace, prevGlyph->glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT, &pairDelta);
 				strWidth += pairDelta.x >> 6;
 			}
 
 			strWidth += glyphData->glyphAdvanceX;
+			prevGlyph = glyphData;
 		}
 		++i;
 	}
@@ -360,10 +488,11 @@ uint16_t FreeTypeGX::getCharWidth(const wchar_t wChar, int16_t pixelSize, const
 
 	if (glyphData != NULL)
 	{
-		if (ftKerningEnabled && prevChar != 0x0000)
+		ftgxCharData *prevGlyph = (ftKerningEnabled && prevChar != 0x0000) ? cacheGlyphData(prevChar, pixelSize) : NULL;
+		if (prevGlyph != NULL)
 		{
 			FT_Vector pairDelta;
-			FT_Get_Kerning(ftFace, fontData[pixelSize][prevChar].glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT,
+			FT_Get_Kerning(ftFace, prevGlyph->glyphIndex, glyphData->glyphIndex, FT_KERNING_DEFAULT,
 					&pairDelta);
 			strWidth += pairDelta.x >> 6;
 		}
@@ -418,34 +547,79 @@ void FreeTypeGX::getOffset(const wchar_t *text, int16_t pixelSize, uint16_t widt
 }
 
 
-void FreeTypeGX::copyTextureToFramebuffer(GXTexObj *texObj, uint16_t texWidth, uint16_t texHeight, int16_t screenX, int16_t screenY, GXColor color)
+void FreeTypeGX::flushQuads(ftgxSizeCache *sizeCache, GXColor color)
 {
-	f32	f32TexWidth = (float)texWidth;
-	f32 f32TexHeight = (float)texHeight;
-	float x = (float)screenX + xPos;
-	float y = (float)screenY + yPos;
+	if (quadBuffer.empty())
+		return;
 
-	GX_LoadTexObj(texObj, GX_TEXMAP0);
+	// glyphs were added to atlases that may already sit in the texture cache
+	if (atlasChanged)
+	{
+		GX_InvalidateTexAll();
+		atlasChanged = false;
+	}
 
-	GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
+	// group the quads by atlas page so every page is bound only once
+	u32 first = 0;
+	while (first < quadBuffer.size())
+	{
+		uint16_t atlasIndex = quadBuffer[first].glyph->atlasIndex;
+		u32 last = first;
+		for (u32 i = first; i < quadBuffer.size(); ++i)
+		{
+			if (quadBuffer[i].glyph->atlasIndex == atlasIndex)
+				std::swap(quadBuffer[i], quadBuffer[last++]);
+		}
+		copyQuadsToFramebuffer(&sizeCache->atlases[atlasIndex], &quadBuffer[first], last - first, color);
+		first = last;
+	}
+	quadBuffer.clear();
+}
 
-	GX_Position3f32(x * xScale, y * yScale, 0);
-	GX_Color4u8(color.r, color.g, color.b, color.a);
-	GX_TexCoord2f32(0.0f, 0.0f);
-	
-	GX_Position3f32((f32TexWidth + x) * xScale, y * yScale, 0);
-	GX_Color4u8(color.r, color.g, color.b, color.a);
-	GX_TexCoord2f32(1.0f, 0.0f);
-	
-	GX_Position3f32((f32TexWidth + x) * xScale, (f32TexHeight + y) * yScale, 0);
-	GX_Color4u8(color.r, color.g, color.b, color.a);
-	GX_TexCoord2f32(1.0f, 1.0f);
-	
-	GX_Position3f32(x * xScale, (f32TexHeight + y) * yScale, 0);
-	GX_Color4u8(color.r, color.g, color.b, color.a);
-	GX_TexCoord2f32(0.0f, 1.0f);
+void FreeTypeGX::copyQuadsToFramebuffer(ftgxAtlas *atlas, const ftgxQuad *quads, uint32_t count, GXColor color)
+{
+	f32 atlasWidth = (float)atlas->width;
+	f32 atlasHeight = (float)atlas->height;
 
-	GX_End();
+	GX_LoadTexObj(&atlas->texObj, GX_TEXMAP0);
+
+	while (count > 0)
+	{
+		// GX_Begin takes a 16 bit vertex count
+		uint32_t batch = count > 0x3FFF ? 0x3FFF : count;
+		GX_Begin(GX_QUADS, GX_VTXFMT0, batch * 4);
+		for (uint32_t i = 0; i < batch; ++i)
+		{
+			const ftgxCharData *glyph = quads[i].glyph;
+			float x = quads[i].x + xPos;
+			float y = quads[i].y + yPos;
+			float w = (float)glyph->textureWidth;
+			float h = (float)glyph->textureHeight;
+			float s0 = (float)glyph->atlasX / atlasWidth;
+			float t0 = (float)glyph->atlasY / atlasHeight;
+			float s1 = (float)(glyph->atlasX + glyph->textureWidth) / atlasWidth;
+			float t1 = (float)(glyph->atlasY + glyph->textureHeight) / atlasHeight;
+
+			GX_Position3f32(x * xScale, y * yScale, 0);
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2f32(s0, t0);
+
+			GX_Position3f32((w + x) * xScale, y * yScale, 0);
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2f32(s1, t0);
+
+			GX_Position3f32((w + x) * xScale, (h + y) * yScale, 0);
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2f32(s1, t1);
+
+			GX_Position3f32(x * xScale, (h + y) * yScale, 0);
+			GX_Color4u8(color.r, color.g, color.b, color.a);
+			GX_TexCoord2f32(s0, t1);
+		}
+		GX_End();
+		quads += batch;
+		count -= batch;
+	}
 }
 
 void FreeTypeGX::copyFeatureToFramebuffer(uint16_t featureWidth, uint16_t featureHeight, int16_t screenX, int16_t screenY, GXColor color)
@@ -32,6 +32,15 @@
 #include <string.h>
 #include <wchar.h>
 #include <map>
+#include <unordered_map>
+#include <vector>
+
+#define FTGX_ATLAS_SIZE			256		/**< Default width and height of a glyph atlas page in pixels. */
+#define FTGX_ATLAS_SIZE_LARGE	512		/**< Atlas page size used for big pixel sizes. */
+#define FTGX_GLYPH_PAGE_BITS	8
+#define FTGX_GLYPH_PAGE_SIZE	(1 << FTGX_GLYPH_PAGE_BITS)
+#define FTGX_GLYPH_PAGE_COUNT	(0x10000 >> FTGX_GLYPH_PAGE_BITS)	/**< Glyph pages covering the whole BMP. */
+#define FTGX_NO_ATLAS			0xFFFF	/**< Glyph has no bitmap (spaces), nothing to draw. */
 
 typedef struct ftgxCharData_
 {
@@ -46,9 +55,52 @@ typedef struct ftgxCharData_
 	int16_t renderOffsetMax; /**< Texture Y axis bearing maximum value. */
 	int16_t renderOffsetMin; /**< Texture Y axis bearing minimum value. */
 
-	uint8_t* glyphDataTexture; /**< Glyph texture bitmap data buffer. */
+	uint16_t atlasIndex; /**< Atlas page holding the glyph bitmap or FTGX_NO_ATLAS. */
+	uint16_t atlasX; /**< Glyph X position inside the atlas page. */
+	uint16_t atlasY; /**< Glyph Y position inside the atlas page. */
 } ftgxCharData;
 
+typedef struct ftgxAtlas_
+{
+	uint8_t *texture; /**< I4 texture data of the whole page. */
+	GXTexObj texObj; /**< Texture object bound once per batch of quads. */
+	uint16_t width; /**< Page width in pixels. */
+	uint16_t height; /**< Page height in pixels. */
+	uint16_t shelfX; /**< Next free X position on the current shelf. */
+	uint16_t shelfY; /**< Y position of the current shelf. */
+	uint16_t shelfHeight; /**< Height of the tallest glyph on the current shelf. */
+} ftgxAtlas;
+
+enum ftgxGlyphState
+{
+	FTGX_GLYPH_UNKNOWN = 0,
+	FTGX_GLYPH_CACHED,
+	FTGX_GLYPH_MISSING,
+};
+
+typedef struct ftgxGlyphPage_
+{
+	ftgxCharData glyphs[FTGX_GLYPH_PAGE_SIZE];
+	uint8_t state[FTGX_GLYPH_PAGE_SIZE]; /**< ftgxGlyphState of every glyph in the page. */
+} ftgxGlyphPage;
+
+/* All glyphs of one pixel size. Characters of the BMP are looked up directly */
+/* through a two level table, anything beyond it goes through a hash map. */
+typedef struct ftgxSizeCache_
+{
+	int16_t pixelSize;
+	ftgxGlyphPage *pages[FTGX_GLYPH_PAGE_COUNT];
+	std::unordered_map<wchar_t, ftgxCharData> extGlyphs; /**< Glyphs outside the BMP, glyphIndex 0 marks a missing one. */
+	std::vector<ftgxAtlas> atlases;
+} ftgxSizeCache;
+
+typedef struct ftgxQuad_
+{
+	const ftgxCharData *glyph;
+	float x;
+	float y;
+} ftgxQuad;
+
 typedef struct ftgxDataOffset_
 {
 	int16_t ascender; /**< Maximum data offset. */
@@ -93,20 +145,25 @@ class FreeTypeGX {
 		float xPos;
 		float yPos;
 
-		std::map<int16_t, std::map<wchar_t, ftgxCharData> > fontData; /**< Map which holds the glyph data structures for the corresponding characters in one size. */
+		std::vector<ftgxSizeCache *> fontData; /**< Glyph caches, one per pixel size. */
+		ftgxSizeCache *lastSizeCache; /**< Last used glyph cache, text is mostly drawn in one size at a time. */
+		std::vector<ftgxQuad> quadBuffer; /**< Glyph quads of the current drawText call, reused between calls. */
+		bool atlasChanged; /**< Set when glyphs were written into an atlas since the last draw. */
 		std::map<int16_t, ftgxDataOffset> ftgxAlign; /**< Map which holds the ascender and decender for different sizes. */
 		
 		int16_t getStyleOffsetWidth(uint16_t width, uint16_t format);
 		int16_t getStyleOffsetHeight(int16_t format, uint16_t pixelSize);
 
 		void unloadFont();
+		ftgxSizeCache *getSizeCache(int16_t pixelSize);
 		ftgxCharData *cacheGlyphData(wchar_t charCode, int16_t pixelSize);
-		uint16_t cacheGlyphDataComplete(int16_t pixelSize);
-		void loadGlyphData(FT_Bitmap *bmp, ftgxCharData *charData);
+		bool allocAtlasSlot(ftgxSizeCache *sizeCache, uint16_t width, uint16_t height, ftgxCharData *charData);
+		void loadGlyphData(FT_Bitmap *bmp, ftgxAtlas *atlas, ftgxCharData *charData);
 		
 		void drawTextFeature(int16_t x, int16_t y, int16_t pixelSize, uint16_t width,
 				ftgxDataOffset *offsetData, uint16_t format, GXColor color);
-		void copyTextureToFramebuffer(GXTexObj *texObj, uint16_t texWidth, uint16_t texHeight, int16_t screenX, int16_t screenY, GXColor color);
+		void flushQuads(ftgxSizeCache *sizeCache, GXColor color);
+		void copyQuadsToFramebuffer(ftgxAtlas *atlas, const ftgxQuad *quads, uint32_t count, GXColor color);
 		void copyFeatureToFramebuffer(uint16_t featureWidth, uint16_t featureHeight, int16_t screenX, int16_t screenY, GXColor color);
 
 	public:
@@ -116,6 +173,7 @@ class FreeTypeGX {
 		static wchar_t* charToWideChar(char* p);
 
 		void loadFont(const uint8_t* fontBuffer, FT_Long bufferSize, FT_Pos weight = 0, bool lastFace = false);
+		uint16_t cacheGlyphDataComplete(int16_t pixelSize);
 
 		uint16_t drawText(int16_t x, int16_t y, const wchar_t *text, int16_t pixelSize, GXColor color = ftgxWhite, 
 						uint16_t textStyling = FTGX_NULL, uint16_t textWidth = 0, uint16_t widthLimit = 0);
@@ -56,12 +56,12 @@ static const ReplaceStruct Replacements[] =
 };
 
 GameTDB::GameTDB()
-	: isLoaded(false), file(0), LangCode("EN"), GameNodeCache(NULL)
+	: isLoaded(false), file(0), LangCode("EN"), GameNodeCache(NULL), GameNodeCopy(NULL), GameNodeCopySize(0)
 {
 }
 
 GameTDB::GameTDB(const char *filepath)
-	: isLoaded(false), file(0), LangCode("EN"), GameNodeCache(NULL)
+	: isLoaded(false), file(0), LangCode("EN"), GameNodeCache(NULL), GameNodeCopy(NULL), GameNodeCopySize(0)
 {
 	OpenFile(filepath);
 }
@@ -102,6 +102,11 @@ void GameTDB::CloseFile()
 		MEM2_free(GameNodeCache);
 	GameNodeCache = NULL;
 
+	if(GameNodeCopy)
+		MEM2_free(GameNodeCopy);
+	GameNodeCopy = NULL;
+	GameNodeCopySize = 0;
+
 	if(file)
 		fclose(file);
 	file = NULL;
@@ -253,31 +258,33 @@ char *GameTDB::LoadGameNode(const char *id)
 	return data;
 }
 
+/* the getters parse in place, so they get a copy of the cached node. the copy */
+/* lives in one buffer that only grows, which also keeps the returned strings */
+/* valid until the next getter call. */
 char *GameTDB::GetGameNode(const char *id)
 {
-	char *data = NULL;
-
-	if(GameNodeCache != NULL && strncmp(id, GameIDCache, strlen(GameIDCache)) == 0)
-	{
-		data = (char*)MEM2_alloc(strlen(GameNodeCache)+1);
-		if(data)
-			strcpy(data, GameNodeCache);
-	}
-	else
+	if(GameNodeCache == NULL || strncmp(id, GameIDCache, strlen(GameIDCache)) != 0)
 	{
 		if(GameNodeCache)
 			MEM2_free(GameNodeCache);
 		GameNodeCache = LoadGameNode(id);
-		if(GameNodeCache)
-		{
-			snprintf(GameIDCache, sizeof(GameIDCache), id);
-			data = (char*)MEM2_alloc(strlen(GameNodeCache)+1);
-			if(data)
-				strcpy(data, GameNodeCache);
-		}
+		if(GameNodeCache == NULL)
+			return NULL;
+		snprintf(GameIDCache, sizeof(GameIDCache), id);
 	}
 
-	return data;
+	u32 size = strlen(GameNodeCache) + 1;
+	if(size > GameNodeCopySize)
+	{
+		char *copy = (char*)MEM2_realloc(GameNodeCopy, size);
+		if(copy == NULL)
+			return NULL;
+		GameNodeCopy = copy;
+		GameNodeCopySize = size;
+	}
+	memcpy(GameNodeCopy, GameNodeCache, size);
+
+	return GameNodeCopy;
 }
 
 GameOffsets *GameTDB::GetGameOffset(const char *gameID)
@@ -452,7 +459,6 @@ bool GameTDB::GetTitle(const char *id, const char * &title, bool plugin)
 		language = SeekLang(data, "EN");
 		if(language == NULL)
 		{
-			MEM2_free(data);
 			return false;
 		}
 	}
@@ -464,15 +470,12 @@ bool GameTDB::GetTitle(const char *id, const char * &title, bool plugin)
 		language = SeekLang(data, "EN");
 		if(language == NULL)
 		{
-			MEM2_free(data);
 			return false;
 		}
 
 		title = GetNodeText(language, "<title>", "</title>");
 	}
 	
-	MEM2_free(data);
-
 	if(title == NULL)
 		return false;
 	return true;
@@ -491,7 +494,6 @@ bool GameTDB::GetName(const char *id, const char * &name)
 		return false;
 
 	name = GetNodeText(data, "<game name=\"", "\"");
-	MEM2_free(data);
 
 	if(name == NULL)
 		return false;
@@ -514,7 +516,6 @@ bool GameTDB::GetSynopsis(const char *id, const char * &synopsis)
 		language = SeekLang(data, "EN");
 		if(language == NULL)
 		{
-			MEM2_free(data);
 			return false;
 		}
 	}
@@ -528,15 +529,12 @@ bool GameTDB::GetSynopsis(const char *id, const char * &synopsis)
 			language = SeekLang(data, "EN");
 			if(language == NULL)
 			{
-				MEM2_free(data);
 				return false;
 			}
 			synopsis = GetNodeText(language, "<synopsis>", "</synopsis>");
 		}
 	}
 
-	MEM2_free(data);
-
 	if(synopsis == NULL)
 		return false;
 	return true;
@@ -552,7 +550,6 @@ bool GameTDB::GetRegion(const char *id, const char * &region)
 	if(!data)
 		return false;
 	region = GetNodeText(data, "<region>", "</region>");
-	MEM2_free(data);
 
 	if(region == NULL)
 		return false;
@@ -570,7 +567,6 @@ bool GameTDB::GetDeveloper(const char *id, const char * &dev)
 		return false;
 
 	dev = GetNodeText(data, "<developer>", "</developer>");
-	MEM2_free(data);
 
 	if(dev == NULL)
 		return false;
@@ -588,7 +584,6 @@ bool GameTDB::GetPublisher(const char *id, const char * &pub)
 		return false;
 
 	pub = GetNodeText(data, "<publisher>", "</publisher>");
-	MEM2_free(data);
 
 	if(pub == NULL)
 		return false;
@@ -607,7 +602,6 @@ u32 GameTDB::GetPublishDate(const char *id)
 	char *year_string = GetNodeText(data, "<date year=\"", "/>");
 	if(!year_string)
 	{
-		MEM2_free(data);
 		return 0;
 	}
 
@@ -618,7 +612,6 @@ u32 GameTDB::GetPublishDate(const char *id)
 	char *month_string = strstr(year_string, "month=\"");
 	if(!month_string)
 	{
-		MEM2_free(data);
 		return 0;
 	}
 
@@ -629,7 +622,6 @@ u32 GameTDB::GetPublishDate(const char *id)
 	char *day_string = strstr(month_string, "day=\"");
 	if(!day_string)
 	{
-		MEM2_free(data);
 		return 0;
 	}
 
@@ -637,8 +629,6 @@ u32 GameTDB::GetPublishDate(const char *id)
 
 	day = atoi(day_string);
 
-	MEM2_free(data);
-
 	return ((year & 0xFFFF) << 16 | (month & 0xFF) << 8 | (day & 0xFF));
 }
 
@@ -661,7 +651,6 @@ bool GameTDB::GetGenres(const char *id, const char * &gen)
 			language = SeekLang(data, "EN");
 			if(language == NULL)
 			{
-				MEM2_free(data);
 				return false;
 			}
 		}
@@ -673,13 +662,11 @@ bool GameTDB::GetGenres(const char *id, const char * &gen)
 			language = SeekLang(data, "EN");
 			if(language == NULL)
 			{
-				MEM2_free(data);
 				return false;
 			}
 
 			gen = GetNodeText(language, "<genre>", "</genre>");
 		}
-		MEM2_free(data);
 
 		if(gen == NULL)
 			return false;
@@ -694,7 +681,6 @@ bool GameTDB::GetGenres(const char *id, const char * &gen)
 		return false;
 
 	gen = GetNodeText(data, "<genre>", "</genre>");
-	MEM2_free(data);
 
 	if(gen == NULL)
 		return false;
@@ -734,7 +720,6 @@ int GameTDB::GetRating(const char *id)
 	char *rating_text = GetNodeText(data, "<rating type=\"", "/>");
 	if(!rating_text)
 	{
-		MEM2_free(data);
 		return rating;
 	}
 
@@ -747,8 +732,6 @@ int GameTDB::GetRating(const char *id)
 	else if(strncmp(rating_text, "GRB", 4) == 0)
 		rating = GAMETDB_RATING_TYPE_GRB;
 
-	MEM2_free(data);
-
 	return rating;
 }
 
@@ -765,12 +748,10 @@ bool GameTDB::GetRatingValue(const char *id, const char * &rating_value)
 	char *rating_text = GetNodeText(data, "<rating type=\"", "/>");
 	if(!rating_text)
 	{
-		MEM2_free(data);
 		return false;
 	}
 
 	rating_value = GetNodeText(rating_text, "value=\"", "\"");
-	MEM2_free(data);
 
 	if(rating_value == NULL)
 		return false;
@@ -790,7 +771,6 @@ int GameTDB::GetRatingDescriptors(const char *id, std::vector<std::string> & des
 	char *descriptor_text = GetNodeText(data, "<descriptor>", "</rating>");
 	if(!descriptor_text)
 	{
-		MEM2_free(data);
 		return -1;
 	}
 
@@ -816,8 +796,6 @@ int GameTDB::GetRatingDescriptors(const char *id, std::vector<std::string> & des
 		++descriptor_text;
 	}
 
-	MEM2_free(data);
-
 	return desc_list.size();
 }
 
@@ -835,13 +813,11 @@ int GameTDB::GetWifiPlayers(const char *id)
 	char *PlayersNode = GetNodeText(data, "<wi-fi players=\"", "\">");
 	if(!PlayersNode)
 	{
-		MEM2_free(data);
 		return players;
 	}
 
 	players = atoi(PlayersNode);
 
-	MEM2_free(data);
 	return players;
 }
 
@@ -858,7 +834,6 @@ int GameTDB::GetWifiFeatures(const char *id, std::vector<std::string> & feat_lis
 	char *feature_text = GetNodeText(data, "<feature>", "</wi-fi>");
 	if(!feature_text)
 	{
-		MEM2_free(data);
 		return -1;
 	}
 
@@ -888,8 +863,6 @@ int GameTDB::GetWifiFeatures(const char *id, std::vector<std::string> & feat_lis
 		++feature_text;
 	}
 
-	MEM2_free(data);
-
 	return feat_list.size();
 }
 
@@ -907,13 +880,11 @@ int GameTDB::GetPlayers(const char *id)
 	char *PlayersNode = GetNodeText(data, "<input players=\"", "\">");
 	if(!PlayersNode)
 	{
-		MEM2_free(data);
 		return players;
 	}
 
 	players = atoi(PlayersNode);
 
-	MEM2_free(data);
 	return players;
 }
 
@@ -930,7 +901,6 @@ int GameTDB::GetAccessories(const char *id, std::vector<Accessory> & acc_list)
 	char *ControlsNode = GetNodeText(data, "<control type=\"", "</input>");
 	if(!ControlsNode)
 	{
-		MEM2_free(data);
 		return -1;
 	}
 
@@ -948,7 +918,6 @@ int GameTDB::GetAccessories(const char *id, std::vector<Accessory> & acc_list)
 		char *requiredField = strstr(ControlsNode, "required=\"");
 		if(!requiredField)
 		{
-			MEM2_free(data);
 			return -1;
 		}
 
@@ -963,8 +932,6 @@ int GameTDB::GetAccessories(const char *id, std::vector<Accessory> & acc_list)
 		list_num++;
 	}
 
-	MEM2_free(data);
-
 	return acc_list.size();
 }
 
@@ -981,7 +948,6 @@ u32 GameTDB::GetCaseColor(const char *id)
 	char *ColorNode = GetNodeText(data, "<case color=\"", "\"");
 	if(!ColorNode)
 	{
-		MEM2_free(data);
 		return color;
 	}
 
@@ -989,7 +955,6 @@ u32 GameTDB::GetCaseColor(const char *id)
 	//if(color != 0xffffffff)
 	//	gprintf("GameTDB: Found alternate color(%x) for: %s\n", color, id);
 
-	MEM2_free(data);
 	return color;
 }
 
@@ -1010,13 +975,11 @@ int GameTDB::GetCaseVersions(const char *id)
 	char *CaseVersionsNode = GetNodeText(data, "case versions=\"", "\"");
 	if(!CaseVersionsNode)
 	{
-		MEM2_free(data);
 		return altcase;
 	}
 
 	altcase = atoi(CaseVersionsNode);
 
-	MEM2_free(data);
 	return altcase;
 }
 
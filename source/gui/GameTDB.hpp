@@ -136,6 +136,8 @@ private:
 	FILE * file;
 	std::string LangCode;
 	char *GameNodeCache;
+	char *GameNodeCopy;
+	u32 GameNodeCopySize;
 	char GameIDCache[7];
 };
 
@@ -184,3 +184,87 @@ const u32 g_boxMeshQSize = sizeof g_boxMeshQ / sizeof g_boxMeshQ[0];
 const u32 g_boxMeshTSize = sizeof g_boxMeshT / sizeof g_boxMeshT[0];
 const u32 g_boxCoverMeshSize = sizeof g_boxCoverMesh / sizeof g_boxCoverMesh[0];
 const u32 g_boxBackCoverMeshSize = sizeof g_boxBackCoverMesh / sizeof g_boxBackCoverMesh[0];
+
+static void sendMesh(u8 primitive, const SMeshVert *mesh, const CTexCoord *texCoords, u32 size, bool withTex)
+{
+	GX_Begin(primitive, GX_VTXFMT0, size);
+	for (u32 j = 0; j < size; ++j)
+	{
+		GX_Position3f32(mesh[j].pos.x, mesh[j].pos.y, mesh[j].pos.z);
+		if (withTex)
+		{
+			if (texCoords != NULL)
+				GX_TexCoord2f32(texCoords[j].x, texCoords[j].y);
+			else
+				GX_TexCoord2f32(mesh[j].texCoord.x, mesh[j].texCoord.y);
+		}
+	}
+	GX_End();
+}
+
+static void sendMeshList(EMeshList mesh, bool withTex)
+{
+	switch (mesh)
+	{
+		case MESH_BOX_SPINE:
+			sendMesh(GX_QUADS, g_boxMeshQ, NULL, g_boxMeshQSize, withTex);
+			sendMesh(GX_TRIANGLES, g_boxMeshT, NULL, g_boxMeshTSize, withTex);
+			break;
+		case MESH_BOX_BACK:
+			sendMesh(GX_QUADS, g_boxBackCoverMesh, NULL, g_boxBackCoverMeshSize, withTex);
+			break;
+		case MESH_BOX_FRONT:
+			sendMesh(GX_QUADS, g_boxCoverMesh, NULL, g_boxCoverMeshSize, withTex);
+			break;
+		case MESH_BOX_FRONT_FLATTEX:
+			sendMesh(GX_QUADS, g_boxCoverMesh, g_boxCoverFlatTex, g_boxCoverMeshSize, withTex);
+			break;
+		case MESH_FLAT:
+			sendMesh(GX_QUADS, g_flatCoverMesh, NULL, g_flatCoverMeshSize, withTex);
+			break;
+		case MESH_FLAT_BOXTEX:
+			sendMesh(GX_QUADS, g_flatCoverMesh, g_flatCoverBoxTex, g_flatCoverMeshSize, withTex);
+			break;
+		default:
+			break;
+	}
+}
+
+// all lists with and without texture coordinates take a bit over 3 KB
+static u8 g_meshListPool[4096] ATTRIBUTE_ALIGN(32);
+static u8 *g_meshList[MESH_LIST_MAX][2];
+static u32 g_meshListSize[MESH_LIST_MAX][2];
+
+void initMeshLists(void)
+{
+	u32 used = 0;
+	for (u32 i = 0; i < MESH_LIST_MAX; ++i)
+	{
+		for (u32 t = 0; t < 2; ++t)
+		{
+			u8 *list = g_meshListPool + used;
+			u32 room = sizeof g_meshListPool - used;
+			g_meshList[i][t] = NULL;
+			g_meshListSize[i][t] = 0;
+			if (room < 32)
+				continue;
+			DCInvalidateRange(list, room);
+			GX_BeginDispList(list, room);
+			sendMeshList((EMeshList)i, t != 0);
+			u32 size = GX_EndDispList();
+			if (size == 0)// didn't fit, drawn the slow way
+				continue;
+			g_meshList[i][t] = list;
+			g_meshListSize[i][t] = size;
+			used += (size + 31) & ~31;
+		}
+	}
+}
+
+void drawMeshList(EMeshList mesh, bool texCoords)
+{
+	if (g_meshList[mesh][texCoords] != NULL)
+		GX_CallDispList(g_meshList[mesh][texCoords], g_meshListSize[mesh][texCoords]);
+	else
+		sendMeshList(mesh, texCoords);
+}
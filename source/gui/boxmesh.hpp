@@ -38,4 +38,19 @@ extern const float g_coverYCenter;
 // Bounding box size
 extern const Vector3D g_boxSize;
 
+// The meshes above compiled into display lists once, so a cover only needs
+// its matrix and colour set. Direct F32 positions and texture coordinates in GX_VTXFMT0.
+enum EMeshList
+{
+	MESH_BOX_SPINE,		// g_boxMeshQ and g_boxMeshT
+	MESH_BOX_BACK,
+	MESH_BOX_FRONT,
+	MESH_BOX_FRONT_FLATTEX,
+	MESH_FLAT,
+	MESH_FLAT_BOXTEX,
+	MESH_LIST_MAX
+};
+void initMeshLists(void);
+void drawMeshList(EMeshList mesh, bool texCoords);
+
 #endif // !defined(__BOXMESH_HPP)
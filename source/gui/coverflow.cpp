@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <algorithm>
+#include <functional>
 #include <new>
 #include <zlib.h>
 #include <cwctype>
@@ -18,6 +19,8 @@
 #include "menu/menu.hpp"
 #include "plugin/plugin.hpp"
 #include "memory/mem2.hpp"
+#include "memory/mem_trace.hpp"
+#include "memory/scratch.hpp"
 #include "fileOps/fileOps.h"
 #include "wstringEx/wstringEx.hpp"
 
@@ -70,7 +73,14 @@ CCoverFlow::CItem::CItem(dir_discHdr *itemHdr, int playcount, unsigned int lastP
 	boxTexture(false),
 	state(STATE_Loading)
 {
-
+	titleLen = wcsnlen(hdr->title, ARRAY_SIZE(hdr->title));
+	navStart = CCoverFlow::navTitle(hdr->title) - hdr->title;
+	alphaKey = 0;
+	for(u32 i = 0; i < 2 && i < titleLen; ++i)
+		alphaKey |= (u64)(u32)tolower(hdr->title[i]) << (32 - i * 32);
+	idKey = 0;
+	for(u32 i = 0; i < sizeof(hdr->id) && hdr->id[i] != '\0'; ++i)
+		idKey |= (u64)(u8)toupper(hdr->id[i]) << (56 - i * 8);
 }
 
 static inline wchar_t upperCaseWChar(wchar_t c)
@@ -183,6 +193,11 @@ CCoverFlow::CCoverFlow(void)
 	m_selected = false;
 	m_hideCover = false;
 	m_tickCount = 0;
+	m_curTex = NULL;
+	m_curMtx = NULL;
+	m_curColorSet = false;
+	memset(&m_renderStats, 0, sizeof(m_renderStats));
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
 	m_blurRadius = 3;
 	m_blurFactor = 1.f;
 	// 
@@ -215,6 +230,8 @@ CCoverFlow::CCoverFlow(void)
 	sndCopyNum = 0;
 	m_soundVolume = 0xFF;
 	m_sorting = SORT_ALPHA;
+	m_itemsSorting = SORT_MAX;
+	m_navType = NAV_NONE;
 	m_normal_speed = 0.1f;
 	m_selected_speed = 0.07f;
 	// 
@@ -245,6 +262,9 @@ bool CCoverFlow::init(const u8 *font, const u32 font_size, bool vid_50hz)
 		guPerspective(m_projMtx, 45, 16.f / 9.f, .1f, 300.f);
 	else
 		guPerspective(m_projMtx, RadToDeg(2.f * atan(tan(DegToRad(45 / 2)) / (4.f / 3.f) * (16.f / 9.f))), 4.f / 3.f, .1f, 300.f);
+
+	// static cover meshes as display lists
+	initMeshLists();
 	return true;
 }
 
@@ -576,6 +596,7 @@ void CCoverFlow::setBlur(u32 blurResolution, u32 blurRadius, float blurFactor)
 void CCoverFlow::setSorting(Sorting sorting)
 {
 	m_sorting = sorting;
+	m_navType = NAV_NONE;
 }
 
 void CCoverFlow::setSounds(GuiSound *flipSound, GuiSound *hoverSound, GuiSound *selectSound, GuiSound *cancelSound)
@@ -666,6 +687,8 @@ void CCoverFlow::clear(void)
 	m_covers = NULL;
 	m_items.clear();
 	//vector<CItem>().swap(m_items);
+	m_itemsSorting = SORT_MAX;
+	m_navType = NAV_NONE;
 }
 
 void CCoverFlow::shutdown(void)
@@ -698,6 +721,7 @@ void CCoverFlow::addItem(dir_discHdr *hdr, int playcount, unsigned int lastPlaye
 {
 	if (m_covers != NULL) return;
 	m_items.push_back(CCoverFlow::CItem(hdr, playcount, lastPlayed));
+	m_navType = NAV_NONE;
 }
 
 // Draws a plane in the Z-Buffer only.
@@ -1102,6 +1126,7 @@ void CCoverFlow::_draw(DrawMode dm, bool mirror, bool blend)
 			else
 				_drawCover(xx, mirror, dm);
 		}
+		_flushCovers(mirror, dm, false);
 	}
 	else
 	{
@@ -1116,6 +1141,7 @@ void CCoverFlow::_draw(DrawMode dm, bool mirror, bool blend)
 			else
 				_drawCover(xx, mirror, dm);
 		}
+		_flushCovers(mirror, dm, true);
 		// Vanishing covers
 		GX_SetZMode(GX_ENABLE, GX_LEQUAL, GX_FALSE);
 		for (u32 y = 0; y < m_rows; ++y)
@@ -1129,6 +1155,7 @@ void CCoverFlow::_draw(DrawMode dm, bool mirror, bool blend)
 				_drawCover(x * m_rows, mirror, dm);
 				_drawCover(x * m_rows + m_rows - 1, mirror, dm);
 			}
+		_flushCovers(mirror, dm, false);
 	}
 }
 
@@ -1259,7 +1286,6 @@ void CCoverFlow::_drawCover(int i, bool mirror, CCoverFlow::DrawMode dm)
 {
 	Mtx modelMtx;
 	Mtx rotMtx;
-	Mtx modelViewMtx;
 	Vector3D osc;
 	Vector3D oscP;
 
@@ -1274,6 +1300,8 @@ void CCoverFlow::_drawCover(int i, bool mirror, CCoverFlow::DrawMode dm)
 		osc = _coverMovesA();
 		oscP = _coverMovesP();
 	}
+	m_drawQueue.push_back(SCoverDraw());
+	SCoverDraw &cd = m_drawQueue.back();
 	// 
 	guMtxIdentity(modelMtx);
 	guMtxScaleApply(modelMtx, modelMtx, m_covers[i].scale.x, m_covers[i].scale.y, m_covers[i].scale.z);
@@ -1288,75 +1316,177 @@ void CCoverFlow::_drawCover(int i, bool mirror, CCoverFlow::DrawMode dm)
 	guMtxTransApply(modelMtx, modelMtx, m_covers[i].pos.x + oscP.x, m_covers[i].pos.y + oscP.y + g_coverYCenter, m_covers[i].pos.z + oscP.z);
 	if (mirror)
 		guMtxScaleApply(modelMtx, modelMtx, 1.f, -1.f, 1.f);
-	guMtxConcat(m_viewMtx, modelMtx, modelViewMtx);
-	GX_LoadPosMtxImm(modelViewMtx, GX_PNMTX0);
-	// Cover
+	guMtxConcat(m_viewMtx, modelMtx, cd.modelViewMtx);
+	// Color
+	switch (dm)
+	{
+		case CCoverFlow::CFDR_NORMAL:
+			cd.color = m_covers[i].color;
+			if (mirror)
+				cd.color.a = (u8)((float)cd.color.a * m_mirrorAlpha);
+			break;
+		case CCoverFlow::CFDR_STENCIL:
+			cd.color = CColor(i + 1, 0xFF, 0xFF, 0xFF);
+			break;
+		case CCoverFlow::CFDR_SHADOW:
+			cd.color = m_covers[i].shadowColor;
+			if (mirror)
+				cd.color.a = (u8)((float)cd.color.a * m_mirrorAlpha);
+			break;
+	}
+	// Textures
+	const CItem &item = m_items[m_covers[i].index];
+	cd.tex = _coverTexture(m_covers[i].index);
+	cd.skin = NULL;
+	cd.front = NULL;
+	cd.boxTex = false;
 	if (m_box)
-		_drawCoverBox(i, mirror, dm);
+	{
+		cd.skin = _coverSkin(item.hdr->casecolor);
+		/* if we have front cover texture only then draw back and spine textures using the default box no cover texture */
+		if (!item.boxTexture && item.texture.data != NULL)
+		{
+			cd.front = cd.tex;
+			cd.tex = &m_boxNoCoverTexture;
+		}
+	}
 	else
-		_drawCoverFlat(i, mirror, dm);
+		cd.boxTex = item.boxTexture && item.texture.data != NULL;
 }
 
-const TexData *CCoverFlow::_coverTexture(int i)
+void CCoverFlow::_flushCovers(bool mirror, CCoverFlow::DrawMode dm, bool sort)
 {
-	if(m_items[i].texture.data == NULL)
+	if (m_drawQueue.empty())
+		return;
+	// the GX state is only known between our own draws
+	m_curTex = NULL;
+	m_curMtx = NULL;
+	m_curColorSet = false;
+
+	std::vector<SCoverDraw>::iterator opaqueEnd = m_drawQueue.begin();
+	if (sort && dm == CCoverFlow::CFDR_NORMAL)
+	{
+		/* with depth writes on, covers without a single translucent pixel can be drawn
+		   in any order, so they get grouped by texture. everything else follows in the
+		   original front to back order. */
+		opaqueEnd = std::stable_partition(m_drawQueue.begin(), m_drawQueue.end(),
+			[this](const SCoverDraw &cd) { return _opaqueDraw(cd); });
+		if (m_box)
+		{
+			// all spines first, there are only a few skins
+			std::stable_sort(m_drawQueue.begin(), opaqueEnd,
+				[](const SCoverDraw &l, const SCoverDraw &r) { return std::less<const TexData *>()(l.skin, r.skin); });
+			m_curMtx = NULL;
+			for (std::vector<SCoverDraw>::iterator cd = m_drawQueue.begin(); cd != opaqueEnd; ++cd)
+				_drawCoverSpine(*cd, dm);
+		}
+		std::stable_sort(m_drawQueue.begin(), opaqueEnd,
+			[](const SCoverDraw &l, const SCoverDraw &r) { return std::less<const TexData *>()(l.tex, r.tex); });
+		m_curMtx = NULL;
+		for (std::vector<SCoverDraw>::iterator cd = m_drawQueue.begin(); cd != opaqueEnd; ++cd)
+		{
+			if (m_box)
+				_drawCoverSides(*cd, mirror, dm);
+			else
+				_drawCoverFlat(*cd, mirror, dm);
+		}
+	}
+	for (std::vector<SCoverDraw>::iterator cd = opaqueEnd; cd != m_drawQueue.end(); ++cd)
 	{
-		if(m_box)
-			return (m_items[i].state == STATE_Loading) ? &m_boxLoadingTexture : &m_boxNoCoverTexture;
+		if (m_box)
+			_drawCoverBox(*cd, mirror, dm);
 		else
-			return (m_items[i].state == STATE_Loading) ? &m_flatLoadingTexture : &m_flatNoCoverTexture;
+			_drawCoverFlat(*cd, mirror, dm);
 	}
-	return &m_items[i].texture;
+	m_drawQueue.clear();
 }
 
-void CCoverFlow::_drawCoverFlat(int i, bool mirror, CCoverFlow::DrawMode dm)
+void CCoverFlow::_setCoverTex(const TexData *tex, bool mirror, bool mipmaps)
 {
 	GXTexObj texObj;
-	const TexData *tex = _coverTexture(m_covers[i].index);
-	bool boxTex = m_items[m_covers[i].index].boxTexture && !!m_items[m_covers[i].index].texture.data;
 
-	switch (dm)
+	if (tex == m_curTex)
+		return;
+	GX_InitTexObj(&texObj, tex->data, tex->width, tex->height, tex->format, GX_CLAMP, GX_CLAMP, GX_FALSE);
+	if (mipmaps && tex->maxLOD > 0)
+		GX_InitTexObjLOD(&texObj, GX_LIN_MIP_LIN, GX_LINEAR, 0.f, (float)tex->maxLOD, mirror ? 1.f : m_lodBias, GX_FALSE, m_edgeLOD ? GX_TRUE : GX_FALSE, m_aniso);
+	GX_LoadTexObj(&texObj, GX_TEXMAP0);
+	m_curTex = tex;
+	++m_renderStats.texLoads;
+}
+
+void CCoverFlow::_setCoverColor(const CColor &color)
+{
+	if (m_curColorSet && color == m_curColor)
+		return;
+	GX_SetTevKColor(GX_KCOLOR0, color);
+	m_curColor = color;
+	m_curColorSet = true;
+	++m_renderStats.colorChanges;
+}
+
+void CCoverFlow::_setCoverMtx(const SCoverDraw &cd)
+{
+	if (&cd == m_curMtx)
+		return;
+	GX_LoadPosMtxImm((f32 (*)[4])cd.modelViewMtx, GX_PNMTX0);
+	m_curMtx = &cd;
+	++m_renderStats.mtxLoads;
+}
+
+/* texture formats without an alpha channel, and CMPR covers the loader found no cut out corners in */
+static inline bool alphaFreeTex(const TexData *tex)
+{
+	return tex != NULL && (tex->format == GX_TF_RGB565 || tex->format == GX_TF_I4 || tex->format == GX_TF_I8
+		|| (tex->format == GX_TF_CMPR && tex->opaque));
+}
+
+/* a CMPR block is transparent where color0 <= color1 and a texel uses index 3 */
+static bool cmprOpaque(const u8 *data, u32 len)
+{
+	for(u32 i = 0; i + 8 <= len; i += 8)
 	{
-		case CCoverFlow::CFDR_NORMAL:
+		const u8 *b = data + i;
+		if(((b[0] << 8) | b[1]) > ((b[2] << 8) | b[3]))
+			continue;
+		for(u32 j = 4; j < 8; ++j)
 		{
-			CColor color(m_covers[i].color);
-			if (mirror)
-				color.a = (u8)((float)color.a * m_mirrorAlpha);
-			GX_SetTevKColor(GX_KCOLOR0, color);
-			break;
-		}
-		case CCoverFlow::CFDR_STENCIL:
-			GX_SetTevKColor(GX_KCOLOR0, CColor(i + 1, 0xFF, 0xFF, 0xFF));
-			break;
-		case CCoverFlow::CFDR_SHADOW:
-		{
-			CColor color(m_covers[i].shadowColor);
-			if (mirror)
-				color.a = (u8)((float)color.a * m_mirrorAlpha);
-			GX_SetTevKColor(GX_KCOLOR0, color);
-			break;
+			if(b[j] & (b[j] >> 1) & 0x55)
+				return false;
 		}
 	}
-	if(dm == CCoverFlow::CFDR_NORMAL)
-	{
-		GX_InitTexObj(&texObj, tex->data, tex->width, tex->height, tex->format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-		if(tex->maxLOD > 0)
-			GX_InitTexObjLOD(&texObj, GX_LIN_MIP_LIN, GX_LINEAR, 0.f, (float)tex->maxLOD, mirror ? 1.f : m_lodBias, GX_FALSE, m_edgeLOD ? GX_TRUE : GX_FALSE, m_aniso);
-		GX_LoadTexObj(&texObj, GX_TEXMAP0);
-	}
-	GX_Begin(GX_QUADS, GX_VTXFMT0, g_flatCoverMeshSize);
-	for (u32 j = 0; j < g_flatCoverMeshSize; ++j)
+	return true;
+}
+
+bool CCoverFlow::_opaqueDraw(const SCoverDraw &cd) const
+{
+	if (cd.color.a != 0xFF || !alphaFreeTex(cd.tex))
+		return false;
+	if (cd.front != NULL && !alphaFreeTex(cd.front))
+		return false;
+	return !m_box || (cd.skin != &m_dvdSkin_Clear && alphaFreeTex(cd.skin));
+}
+
+const TexData *CCoverFlow::_coverTexture(int i)
+{
+	if(m_items[i].texture.data == NULL)
 	{
-		GX_Position3f32(g_flatCoverMesh[j].pos.x, g_flatCoverMesh[j].pos.y, g_flatCoverMesh[j].pos.z);
-		if (dm == CCoverFlow::CFDR_NORMAL)
-		{
-			if (boxTex)
-				GX_TexCoord2f32(g_flatCoverBoxTex[j].x, g_flatCoverBoxTex[j].y);
-			else
-				GX_TexCoord2f32(g_flatCoverMesh[j].texCoord.x, g_flatCoverMesh[j].texCoord.y);
-		}
+		if(m_box)
+			return (m_items[i].state == STATE_Loading) ? &m_boxLoadingTexture : &m_boxNoCoverTexture;
+		else
+			return (m_items[i].state == STATE_Loading) ? &m_flatLoadingTexture : &m_flatNoCoverTexture;
 	}
-	GX_End();
+	return &m_items[i].texture;
+}
+
+void CCoverFlow::_drawCoverFlat(const SCoverDraw &cd, bool mirror, CCoverFlow::DrawMode dm)
+{
+	_setCoverColor(cd.color);
+	if (dm == CCoverFlow::CFDR_NORMAL)
+		_setCoverTex(cd.tex, mirror, true);
+	_setCoverMtx(cd);
+	drawMeshList(cd.boxTex ? MESH_FLAT_BOXTEX : MESH_FLAT, dm == CCoverFlow::CFDR_NORMAL);
+	++m_renderStats.meshes;
 }
 
 bool CCoverFlow::checkCoverColor(const char *gameID, const char *checkID[], u32 len)
@@ -1384,120 +1514,60 @@ u32 CCoverFlow::InternalCoverColor(const char *ID, u32 DefCaseColor)
 	return DefCaseColor;
 }
 
-void CCoverFlow::_drawCoverBox(int i, bool mirror, CCoverFlow::DrawMode dm)
+const TexData *CCoverFlow::_coverSkin(u32 caseColor)
+{
+	// dvd spine color texture, depending on game
+	switch(caseColor)
+	{
+		case 0x000000:
+		case 0x181919:
+			return &m_dvdSkin_Black;
+		case 0xFF0000:
+			return &m_dvdSkin_Red;
+		case 0xFCFF00:
+			return &m_dvdSkin_Yellow;
+		case 0x01A300:
+			return &m_dvdSkin_GreenOne;
+		case 0x00E360:
+			return &m_dvdSkin_GreenTwo;
+		case 0x111111:
+			return &m_dvdSkin_Clear;
+		default:
+			return &m_dvdSkin;
+	}
+}
+
+void CCoverFlow::_drawCoverBox(const SCoverDraw &cd, bool mirror, CCoverFlow::DrawMode dm)
 {
-	CColor color;
-	GXTexObj texObj;
-	const TexData *tex = _coverTexture(m_covers[i].index);
-	bool flatTex = !m_items[m_covers[i].index].boxTexture && !!m_items[m_covers[i].index].texture.data;
+	_drawCoverSpine(cd, dm);
+	_drawCoverSides(cd, mirror, dm);
+}
 
-	switch (dm)
-	{
-		case CCoverFlow::CFDR_NORMAL:
-			color = m_covers[i].color;
-			if (mirror)
-				color.a = (u8)((float)color.a * m_mirrorAlpha);
-			GX_SetTevKColor(GX_KCOLOR0, color);
-			break;
-		case CCoverFlow::CFDR_STENCIL:
-			GX_SetTevKColor(GX_KCOLOR0, CColor(i + 1, 0xFF, 0xFF, 0xFF));
-			break;
-		case CCoverFlow::CFDR_SHADOW:
-			color = m_covers[i].shadowColor;
-			if (mirror)
-				color.a = (u8)((float)color.a * m_mirrorAlpha);
-			GX_SetTevKColor(GX_KCOLOR0, color);
-			break;
-	}
-	/* this draws the colored spine of the box */
-	if(dm == CCoverFlow::CFDR_NORMAL)
-	{
-		// set dvd spine color texture, depending on game
-		switch(m_items[m_covers[i].index].hdr->casecolor)
-		{
-			case 0x000000:
-			case 0x181919:
-				GX_InitTexObj(&texObj, m_dvdSkin_Black.data, m_dvdSkin_Black.width, m_dvdSkin_Black.height, m_dvdSkin_Black.format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-				break;
-			case 0xFF0000:
-				GX_InitTexObj(&texObj, m_dvdSkin_Red.data, m_dvdSkin_Red.width, m_dvdSkin_Red.height, m_dvdSkin_Red.format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-				break;
-			case 0xFCFF00:
-				GX_InitTexObj(&texObj, m_dvdSkin_Yellow.data, m_dvdSkin_Yellow.width, m_dvdSkin_Yellow.height, m_dvdSkin_Yellow.format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-				break;
-			case 0x01A300:
-				GX_InitTexObj(&texObj, m_dvdSkin_GreenOne.data, m_dvdSkin_GreenOne.width, m_dvdSkin_GreenOne.height, m_dvdSkin_GreenOne.format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-				break;
-			case 0x00E360:
-				GX_InitTexObj(&texObj, m_dvdSkin_GreenTwo.data, m_dvdSkin_GreenTwo.width, m_dvdSkin_GreenTwo.height, m_dvdSkin_GreenTwo.format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-				break;
-			case 0x111111:
-				GX_InitTexObj(&texObj, m_dvdSkin_Clear.data, m_dvdSkin_Clear.width, m_dvdSkin_Clear.height, m_dvdSkin_Clear.format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-				break;
-			default:
-				GX_InitTexObj(&texObj, m_dvdSkin.data, m_dvdSkin.width, m_dvdSkin.height, m_dvdSkin.format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-				break;
-		}
-		GX_LoadTexObj(&texObj, GX_TEXMAP0);
-	}
-	GX_Begin(GX_QUADS, GX_VTXFMT0, g_boxMeshQSize);// Quads
-	for (u32 j = 0; j < g_boxMeshQSize; ++j)
-	{
-		GX_Position3f32(g_boxMeshQ[j].pos.x, g_boxMeshQ[j].pos.y, g_boxMeshQ[j].pos.z);
-		if (dm == CCoverFlow::CFDR_NORMAL)
-			GX_TexCoord2f32(g_boxMeshQ[j].texCoord.x, g_boxMeshQ[j].texCoord.y);
-	}
-	GX_End();
-	GX_Begin(GX_TRIANGLES, GX_VTXFMT0, g_boxMeshTSize);// triangles
-	for (u32 j = 0; j < g_boxMeshTSize; ++j)
-	{
-		GX_Position3f32(g_boxMeshT[j].pos.x, g_boxMeshT[j].pos.y, g_boxMeshT[j].pos.z);
-		if (dm == CCoverFlow::CFDR_NORMAL)
-			GX_TexCoord2f32(g_boxMeshT[j].texCoord.x, g_boxMeshT[j].texCoord.y);
-	}
-	GX_End();
-	/* draw back of cover and title spine texture */
+/* this draws the colored spine of the box */
+void CCoverFlow::_drawCoverSpine(const SCoverDraw &cd, CCoverFlow::DrawMode dm)
+{
+	_setCoverColor(cd.color);
 	if (dm == CCoverFlow::CFDR_NORMAL)
-	{
-		const TexData *myTex = tex;
-		/* if we have front cover texture only then draw back and spine textures using the default box no cover texture */
-		if(flatTex)
-			myTex = &m_boxNoCoverTexture;
-		GX_InitTexObj(&texObj, myTex->data, myTex->width, myTex->height, myTex->format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-		if (myTex->maxLOD > 0)
-			GX_InitTexObjLOD(&texObj, GX_LIN_MIP_LIN, GX_LINEAR, 0.f, (float)myTex->maxLOD, mirror ? 1.f : m_lodBias, GX_FALSE, m_edgeLOD ? GX_TRUE : GX_FALSE, m_aniso);
-		GX_LoadTexObj(&texObj, GX_TEXMAP0);
-	}
-	GX_Begin(GX_QUADS, GX_VTXFMT0, g_boxBackCoverMeshSize);
-	for (u32 j = 0; j < g_boxBackCoverMeshSize; ++j)
-	{
-		GX_Position3f32(g_boxBackCoverMesh[j].pos.x, g_boxBackCoverMesh[j].pos.y, g_boxBackCoverMesh[j].pos.z);
-		if (dm == CCoverFlow::CFDR_NORMAL)
-			GX_TexCoord2f32(g_boxBackCoverMesh[j].texCoord.x, g_boxBackCoverMesh[j].texCoord.y);
-	}
-	GX_End();
-	/* draw front of cover texture */
-	/* if front cover only we need to change texObj from box no cover texture to the front cover texture */
+		_setCoverTex(cd.skin, false, false);
+	_setCoverMtx(cd);
+	drawMeshList(MESH_BOX_SPINE, dm == CCoverFlow::CFDR_NORMAL);
+	++m_renderStats.meshes;
+}
+
+/* draws the back of cover and title spine texture, then the front */
+void CCoverFlow::_drawCoverSides(const SCoverDraw &cd, bool mirror, CCoverFlow::DrawMode dm)
+{
+	_setCoverColor(cd.color);
+	if (dm == CCoverFlow::CFDR_NORMAL)
+		_setCoverTex(cd.tex, mirror, true);
+	_setCoverMtx(cd);
+	drawMeshList(MESH_BOX_BACK, dm == CCoverFlow::CFDR_NORMAL);
+	/* if front cover only we need to change from the box no cover texture to the front cover texture */
+	bool flatTex = cd.front != NULL;
 	if (dm == CCoverFlow::CFDR_NORMAL && flatTex)
-	{
-		GX_InitTexObj(&texObj, tex->data, tex->width, tex->height, tex->format, GX_CLAMP, GX_CLAMP, GX_FALSE);
-		if (tex->maxLOD > 0)
-			GX_InitTexObjLOD(&texObj, GX_LIN_MIP_LIN, GX_LINEAR, 0.f, (float)tex->maxLOD, mirror ? 1.f : m_lodBias, GX_FALSE, m_edgeLOD ? GX_TRUE : GX_FALSE, m_aniso);
-		GX_LoadTexObj(&texObj, GX_TEXMAP0);
-	}
-	GX_Begin(GX_QUADS, GX_VTXFMT0, g_boxCoverMeshSize);
-	for (u32 j = 0; j < g_boxCoverMeshSize; ++j)
-	{
-		GX_Position3f32(g_boxCoverMesh[j].pos.x, g_boxCoverMesh[j].pos.y, g_boxCoverMesh[j].pos.z);
-		if (dm == CCoverFlow::CFDR_NORMAL)
-		{
-			if (flatTex)
-				GX_TexCoord2f32(g_boxCoverFlatTex[j].x, g_boxCoverFlatTex[j].y);
-			else
-				GX_TexCoord2f32(g_boxCoverMesh[j].texCoord.x, g_boxCoverMesh[j].texCoord.y);
-		}
-	}
-	GX_End();
+		_setCoverTex(cd.front, mirror, true);
+	drawMeshList(flatTex ? MESH_BOX_FRONT_FLATTEX : MESH_BOX_FRONT, dm == CCoverFlow::CFDR_NORMAL);
+	m_renderStats.meshes += 2;
 }
 
 void CCoverFlow::_loadCover(int i, int item)
@@ -1530,6 +1600,12 @@ const dir_discHdr * CCoverFlow::getNextHdr(void) const
 	return m_items[loopNum(m_covers[m_range / 2].index + m_jump + 1, m_items.size())].hdr;
 }
 
+const dir_discHdr * CCoverFlow::getPrevHdr(void) const
+{
+	if (m_covers == NULL || m_items.empty()) return NULL;
+	return m_items[loopNum(m_covers[m_range / 2].index + m_jump - 1, m_items.size())].hdr;
+}
+
 const dir_discHdr * CCoverFlow::getSpecificHdr(u32 place) const
 {
 	if (m_covers == NULL || m_items.empty() || place >= m_items.size()) return NULL;
@@ -1867,74 +1943,95 @@ void CCoverFlow::_instantTarget(int i)
 	cvr.txtColor = cvr.txtTargetColor;
 }
 
-bool CCoverFlow::_sortByPlayCount(CItem item1, CItem item2)
+bool CCoverFlow::_sortByPlayCount(const CItem &item1, const CItem &item2)
 {
 	return (item1.playcount == item2.playcount) ? _sortByAlpha(item1, item2) : item1.playcount > item2.playcount;
 }
 
-bool CCoverFlow::_sortByLastPlayed(CItem item1, CItem item2)
+bool CCoverFlow::_sortByLastPlayed(const CItem &item1, const CItem &item2)
 {
 	return (item1.lastPlayed == item2.lastPlayed) ? _sortByPlayCount(item1, item2) : item1.lastPlayed > item2.lastPlayed;
 }
 
-bool CCoverFlow::_sortByGameID(CItem item1, CItem item2)
+bool CCoverFlow::_sortByGameID(const CItem &item1, const CItem &item2)
 {
-	u32 s = min(strlen(item1.hdr->id), strlen(item2.hdr->id));
-	for(u32 k = 0; k < s; ++k)
-	{
-		if(toupper(item1.hdr->id[k]) > toupper(item2.hdr->id[k]))
-			return false;
-		else if(toupper(item1.hdr->id[k]) < toupper(item2.hdr->id[k]))
-			return true;
-	}
-
-	return strlen(item1.hdr->id) < strlen(item2.hdr->id);
+	return item1.idKey < item2.idKey;
 }
 
-bool CCoverFlow::_sortByAlpha(CItem item1, CItem item2)
+bool CCoverFlow::_sortByAlpha(const CItem &item1, const CItem &item2)
 {
-	const wchar_t *first = item1.hdr->title;
-	const wchar_t *second = item2.hdr->title;
-	return wchar_cmp(first, second, wcslen(first), wcslen(second));
+	// the key decides unless both titles start with the same two chars
+	if(item1.alphaKey != item2.alphaKey)
+		return item1.alphaKey < item2.alphaKey;
+	return wchar_cmp(item1.hdr->title, item2.hdr->title, item1.titleLen, item2.titleLen);
 }
 
-bool CCoverFlow::_sortByPlayers(CItem item1, CItem item2)
+bool CCoverFlow::_sortByPlayers(const CItem &item1, const CItem &item2)
 {
 	if(item1.hdr->players == item2.hdr->players) return _sortByAlpha(item1, item2);
 	return item1.hdr->players < item2.hdr->players;
 }
 
-bool CCoverFlow::_sortByWifiPlayers(CItem item1, CItem item2)
+bool CCoverFlow::_sortByWifiPlayers(const CItem &item1, const CItem &item2)
 {
 	if(item1.hdr->wifi == item2.hdr->wifi) return _sortByAlpha(item1, item2);
 	return item1.hdr->wifi < item2.hdr->wifi;
 }
 
-bool CCoverFlow::_sortByBtnNumbers(CItem item1, CItem item2)
+bool CCoverFlow::_sortByBtnNumbers(const CItem &item1, const CItem &item2)
 {
 	if(item1.hdr->settings[0] == item2.hdr->settings[0]) return _sortByAlpha(item1, item2);
 	return item1.hdr->settings[0] < item2.hdr->settings[0];
 }
 
+void CCoverFlow::_sortItems(void)
+{
+	bool (*cmp)(const CItem &, const CItem &) = NULL;
+	switch(m_sorting)
+	{
+		case SORT_ALPHA: cmp = _sortByAlpha; break;
+		case SORT_PLAYCOUNT: cmp = _sortByPlayCount; break;
+		case SORT_LASTPLAYED: cmp = _sortByLastPlayed; break;
+		case SORT_GAMEID: cmp = _sortByGameID; break;
+		case SORT_PLAYERS: cmp = _sortByPlayers; break;
+		case SORT_WIFIPLAYERS: cmp = _sortByWifiPlayers; break;
+		case SORT_BTN_NUMBERS: cmp = _sortByBtnNumbers; break;
+		default: return;
+	}
+	m_itemsSorting = m_sorting;
+	m_navType = NAV_NONE;
+
+	/* sort indices, then move every item straight to its place by following the permutation's cycles */
+	u32 n = m_items.size();
+	vector<u32> order(n);
+	for(u32 i = 0; i < n; ++i)
+		order[i] = i;
+	sort(order.begin(), order.end(), [this, cmp](u32 a, u32 b) { return cmp(m_items[a], m_items[b]); });
+
+	for(u32 i = 0; i < n; ++i)
+	{
+		if(order[i] == i)
+			continue;
+		CItem tmp = m_items[i];
+		u32 j = i;
+		while(order[j] != i)
+		{
+			u32 k = order[j];
+			m_items[j] = m_items[k];
+			order[j] = j;
+			j = k;
+		}
+		m_items[j] = tmp;
+		order[j] = j;
+	}
+}
+
 bool CCoverFlow::start(const string &m_imgsDir)
 {
 	if (m_items.empty()) return true;
 
 	/* sort coverflow items list based on sort type */
-	if (m_sorting == SORT_ALPHA)
-		sort(m_items.begin(), m_items.end(), CCoverFlow::_sortByAlpha);
-	else if (m_sorting == SORT_PLAYCOUNT)
-		sort(m_items.begin(), m_items.end(), CCoverFlow::_sortByPlayCount);
-	else if (m_sorting == SORT_LASTPLAYED)
-		sort(m_items.begin(), m_items.end(), CCoverFlow::_sortByLastPlayed);
-	else if (m_sorting == SORT_GAMEID)
-		sort(m_items.begin(), m_items.end(), CCoverFlow::_sortByGameID);
-	else if (m_sorting == SORT_PLAYERS)
-		sort(m_items.begin(), m_items.end(), CCoverFlow::_sortByPlayers);
-	else if (m_sorting == SORT_WIFIPLAYERS)
-		sort(m_items.begin(), m_items.end(), CCoverFlow::_sortByWifiPlayers);
-	else if (m_sorting == SORT_BTN_NUMBERS)
-		sort(m_items.begin(), m_items.end(), CCoverFlow::_sortByBtnNumbers);
+	_sortItems();
 
 	/* load the colored skin/spine images if not already done */
 	if(!m_dvdskin_loaded)
@@ -2278,6 +2375,81 @@ void CCoverFlow::_completeJump(void)
 	}
 }
 
+u32 CCoverFlow::_navKeyOf(const CItem &item, NavKey type)
+{
+	switch(type)
+	{
+		case NAV_PLAYERS:
+			return item.hdr->players;
+		case NAV_WIFI:
+			return item.hdr->wifi;
+		case NAV_ID:
+			return (u8)item.hdr->id[0];
+		default:
+			break;
+	}
+	return upperCaseWChar(item.hdr->title[item.navStart]);
+}
+
+const wchar_t *CCoverFlow::navTitle(const wchar_t *title)
+{
+	u32 j = 0;
+	while (!iswalnum(title[j]) && title[j+1] != L'\0') j++;
+	return title + j;
+}
+
+void CCoverFlow::_buildNavIndex(NavKey type)
+{
+	if (m_navType == type)
+		return;
+	m_navType = type;
+	m_navStart.clear();
+	m_navKey.clear();
+
+	u32 n = m_items.size();
+	m_navRun.resize(n);
+	for (u32 i = 0; i < n; ++i)
+	{
+		u32 key = _navKeyOf(m_items[i], type);
+		if (m_navKey.empty() || key != m_navKey.back())
+		{
+			m_navStart.push_back(i);
+			m_navKey.push_back(key);
+		}
+		m_navRun[i] = m_navStart.size() - 1;
+	}
+
+	/* the list wraps around, a last run with the first run's key is part of it */
+	u32 runs = m_navStart.size();
+	if (runs > 1 && m_navKey[runs - 1] == m_navKey[0])
+	{
+		m_navStart[0] = m_navStart[runs - 1];
+		for (u32 i = m_navStart[0]; i < n; ++i)
+			m_navRun[i] = 0;
+		m_navStart.pop_back();
+		m_navKey.pop_back();
+	}
+}
+
+/* jumps to the first item of the next or previous run and returns its key */
+u32 CCoverFlow::_navJump(NavKey type, bool next)
+{
+	_buildNavIndex(type);
+	_completeJump();
+	int n = m_items.size();
+	int runs = m_navStart.size();
+	int curPos = _currentPos();
+	int run = m_navRun[curPos];
+
+	if (runs > 1)
+	{
+		run = loopNum(run + (next ? 1 : -1), runs);
+		int target = m_navStart[run];
+		_setJump(next ? loopNum(target - curPos, n) : -loopNum(curPos - target, n));
+	}
+	return m_navKey[run];
+}
+
 void CCoverFlow::nextLetter(wchar_t *c)
 {
 	if (m_covers == NULL || m_sorting == SORT_BTN_NUMBERS)
@@ -2293,27 +2465,7 @@ void CCoverFlow::nextLetter(wchar_t *c)
 		return nextID(c);
 
 	LockMutex lock(m_mutex);
-
-	u32 i, j = 0, k = 0, n = m_items.size();
-
-	_completeJump();
-	u32 curPos = _currentPos();
-
-	while (!iswalnum(m_items[curPos].hdr->title[j]) && m_items[curPos].hdr->title[j+1] != L'\0') j++;
-	c[0] = upperCaseWChar(m_items[curPos].hdr->title[j]);
-
-	for (i = 1; i < n; ++i)
-	{
-		k = 0;
-		while (!iswalnum(m_items[loopNum(curPos + i, n)].hdr->title[k]) && m_items[loopNum(curPos + i, n)].hdr->title[k+1] != L'\0') k++;
-		if (upperCaseWChar(m_items[loopNum(curPos + i, n)].hdr->title[k]) != c[0])
-			break;
-	}
-	if (i < n)
-	{
-		_setJump(i);
-		c[0] = upperCaseWChar(m_items[loopNum(curPos + i, n)].hdr->title[k]);
-	}
+	c[0] = _navJump(NAV_LETTER, true);
 	_updateAllTargets();
 }
 
@@ -2332,63 +2484,14 @@ void CCoverFlow::prevLetter(wchar_t *c)
 		return prevID(c);
 
 	LockMutex lock(m_mutex);
-	u32 i, j = 0, k = 0, n = m_items.size();
-
-	_completeJump();
-	u32 curPos = _currentPos();
-	
-	while (!iswalnum(m_items[curPos].hdr->title[j]) && m_items[curPos].hdr->title[j+1] != L'\0') j++;
-	c[0] = upperCaseWChar(m_items[curPos].hdr->title[j]);
-
-	for (i = 1; i < n; ++i)
-	{
-		k = 0;
-		while (!iswalnum(m_items[loopNum(curPos - i, n)].hdr->title[k]) && m_items[loopNum(curPos - i, n)].hdr->title[k+1] != L'\0') k++;
-		if (upperCaseWChar(m_items[loopNum(curPos - i, n)].hdr->title[k]) != c[0])
-		{
-			c[0] = upperCaseWChar(m_items[loopNum(curPos - i, n)].hdr->title[k]);
-			while(i < n)
-			{
-				++i;
-				k = 0;
-				while (!iswalnum(m_items[loopNum(curPos - i, n)].hdr->title[k]) && m_items[loopNum(curPos - i, n)].hdr->title[k+1] != L'\0') k++;
-				if(upperCaseWChar(m_items[loopNum(curPos - i, n)].hdr->title[k]) != c[0])
-					break;
-			}
-			i--;
-			break;
-		}
-	}
-
-	if (i < n)
-	{
-		_setJump(-i);
-		k = 0;
-		while (!iswalnum(m_items[loopNum(curPos - i, n)].hdr->title[k]) && m_items[loopNum(curPos - i, n)].hdr->title[k+1] != L'\0') k++;
-		c[0] = upperCaseWChar(m_items[loopNum(curPos - i, n)].hdr->title[k]);
-	}
-
+	c[0] = _navJump(NAV_LETTER, false);
 	_updateAllTargets();
 }
 
 void CCoverFlow::nextPlayers(bool wifi, wchar_t *c)
 {
 	LockMutex lock(m_mutex);
-	u32 i, n = m_items.size();
-
-	_completeJump();
-	u32 curPos = _currentPos();
-	int players = wifi ? m_items[curPos].hdr->wifi : m_items[curPos].hdr->players;
-
-	for (i = 1; i < n; ++i)
-		if ((wifi ? m_items[loopNum(curPos + i, n)].hdr->wifi : m_items[loopNum(curPos + i, n)].hdr->players) != players)
-			break;
-
-	if (i < n)
-	{
-		_setJump(i);
-		players = wifi ? m_items[loopNum(curPos + i, n)].hdr->wifi : m_items[loopNum(curPos + i, n)].hdr->players;
-	}
+	int players = _navJump(wifi ? NAV_WIFI : NAV_PLAYERS, true);
 
 	char p[4] = {0 ,0 ,0 ,0};
 	sprintf(p, "%d", players);
@@ -2400,26 +2503,7 @@ void CCoverFlow::nextPlayers(bool wifi, wchar_t *c)
 void CCoverFlow::prevPlayers(bool wifi, wchar_t *c)
 {
 	LockMutex lock(m_mutex);
-	u32 i, n = m_items.size();
-
-	_completeJump();
-	u32 curPos = _currentPos();
-	int players = wifi ? m_items[curPos].hdr->wifi : m_items[curPos].hdr->players;
-
-	for (i = 1; i < n; ++i)
-		if ((wifi ? m_items[loopNum(curPos - i, n)].hdr->wifi : m_items[loopNum(curPos - i, n)].hdr->players) != players)
-		{
-			players = wifi ? m_items[loopNum(curPos - i, n)].hdr->wifi : m_items[loopNum(curPos - i, n)].hdr->players;
-			while(i < n && (wifi ? m_items[loopNum(curPos - i, n)].hdr->wifi : m_items[loopNum(curPos - i, n)].hdr->players) == players) ++i;
-			i--;
-			break;
-		}
-
-	if (i < n)
-	{
-		_setJump(-i);
-		players = wifi ? m_items[loopNum(curPos - i, n)].hdr->wifi : m_items[loopNum(curPos - i, n)].hdr->players;
-	}
+	int players = _navJump(wifi ? NAV_WIFI : NAV_PLAYERS, false);
 
 	char p[4] = {0 ,0 ,0 ,0};
 	sprintf(p, "%d", players);
@@ -2431,56 +2515,69 @@ void CCoverFlow::prevPlayers(bool wifi, wchar_t *c)
 void CCoverFlow::nextID(wchar_t *c)
 {
 	LockMutex lock(m_mutex);
-	u32 i, n = m_items.size();
-
-	_completeJump();
-	u32 curPos = _currentPos();
-	char *system = m_items[curPos].hdr->id;
-
-	for (i = 1; i < n; ++i)
-		if (m_items[loopNum(curPos + i, n)].hdr->id[0] != system[0])
-			break;
+	char system[2] = {(char)_navJump(NAV_ID, true), '\0'};
+	mbstowcs(c, system, 1);
 
-	if (i < n)
-	{
-		_setJump(i);
-		system = m_items[loopNum(curPos + i, n)].hdr->id;
-	}
+	_updateAllTargets();
+}
 
-	system[1] = '\0';
+void CCoverFlow::prevID(wchar_t *c)
+{
+	LockMutex lock(m_mutex);
+	char system[2] = {(char)_navJump(NAV_ID, false), '\0'};
 	mbstowcs(c, system, 1);
 
 	_updateAllTargets();
 }
 
-void CCoverFlow::prevID(wchar_t *c)
+/* moves to the first item whose title starts with prefix, ignoring case */
+bool CCoverFlow::jumpToPrefix(const wchar_t *prefix)
 {
+	u32 len = wcslen(prefix);
+	if (m_covers == NULL || len == 0)
+		return false;
+
 	LockMutex lock(m_mutex);
 	u32 i, n = m_items.size();
+	auto matches = [prefix, len](const CItem &item) {
+		const wchar_t *title = item.hdr->title + item.navStart;
+		return (u32)(item.titleLen - item.navStart) >= len && !wchar_cmp(title, prefix, len, len) && !wchar_cmp(prefix, title, len, len);
+	};
 
-	_completeJump();
-	u32 curPos = _currentPos();
-	char *system = m_items[curPos].hdr->id;
-
-	for(i = 1; i < n; ++i)
-		if(m_items[loopNum(curPos - i, n)].hdr->id[0] != system[0])
+	if (m_itemsSorting == SORT_ALPHA)
+	{
+		/* titles sharing the prefix sit together, find the first of them */
+		i = lower_bound(m_items.begin(), m_items.end(), prefix, [len](const CItem &item, const wchar_t *p) {
+			return wchar_cmp(item.hdr->title, p, min((u32)item.titleLen, len), len);
+		}) - m_items.begin();
+		if (i < n && !matches(m_items[i]))
+			i = n;
+		/* titles with leading punctuation are sorted by it, look at them one by one */
+		for (u32 k = 0; k < i; ++k)
 		{
-			system = m_items[loopNum(curPos - i, n)].hdr->id;
-			while(i < n && m_items[loopNum(curPos - i, n)].hdr->id[0] == system[0]) ++i;
-			i--;
-			break;
+			if (m_items[k].navStart > 0 && matches(m_items[k]))
+			{
+				i = k;
+				break;
+			}
 		}
-
-	if (i < n)
+	}
+	else
 	{
-		_setJump(-i);
-		system = m_items[loopNum(curPos - i, n)].hdr->id;
+		for (i = 0; i < n && !matches(m_items[i]); ++i)
+			;
 	}
+	if (i >= n || !matches(m_items[i]))
+		return false;
 
-	system[1] = '\0';
-	mbstowcs(c, system, 1);
-
+	_completeJump();
+	int j = (int)i - (int)_currentPos();
+	if (abs(j) <= (int)n / 2)
+		_setJump(j);
+	else
+		_setJump(j < 0 ? j + (int)n : j - (int)n);
 	_updateAllTargets();
+	return true;
 }
 
 void CCoverFlow::_coverTick(int i)
@@ -2558,6 +2655,8 @@ void CCoverFlow::tick(void)
 
 	LockMutex lock(m_mutex);
 	++m_tickCount;
+	m_frameStats = m_renderStats;
+	memset(&m_renderStats, 0, sizeof(m_renderStats));
 	if (m_delay > 0)
 		--m_delay;
 	else
@@ -2704,6 +2803,7 @@ void CCoverFlow::_dropHQLOD(int i)
 	newTex.width = prevTex.width;
 	newTex.height = prevTex.height;
 	newTex.format = prevTex.format;
+	newTex.opaque = prevTex.opaque;
 
 	if (!CCoverFlow::_calcTexLQLOD(newTex)) return;
 
@@ -2749,10 +2849,6 @@ CCoverFlow::CLRet CCoverFlow::_loadCoverTex(u32 i, bool box, bool hq, bool blank
 		char wfcTitle[128];
 		wfcTitle[127] = '\0';
 		const char *wfcCoverDir = NULL;
-		char *full_path = (char*)MEM2_alloc(MAX_FAT_PATH+1);
-		if(full_path == NULL)
-			return CL_NOMEM;
-		memset(full_path, 0, MAX_FAT_PATH+1);
 		
 		/* get title for wfc file */
 		if(blankBoxCover)
@@ -2774,6 +2870,16 @@ CCoverFlow::CLRet CCoverFlow::_loadCoverTex(u32 i, bool box, bool hq, bool blank
 		if(m_items[i].hdr->type == TYPE_HOMEBREW)
 			wfcCoverDir = "homebrew";
 			
+		/* the path is only needed until the file is open */
+		ScratchScope scratch(ScratchArena::Get(SCRATCH_COVERS));
+		char *full_path = (char*)scratch.Alloc(MAX_FAT_PATH+1);
+		char *heap_path = NULL;
+		if(full_path == NULL)
+			full_path = heap_path = (char*)MEM2_alloc(MAX_FAT_PATH+1);
+		if(full_path == NULL)
+			return CL_NOMEM;
+		memset(full_path, 0, MAX_FAT_PATH+1);
+		
 		/* set full path of wfc file */
 		if(wfcCoverDir != NULL)
 		{
@@ -2804,7 +2910,8 @@ CCoverFlow::CLRet CCoverFlow::_loadCoverTex(u32 i, bool box, bool hq, bool blank
 		/* load wfc file */
 		FILE *fp;
 		fp = fopen(full_path, "rb");
-		free(full_path);
+		if(heap_path != NULL)
+			MEM2_free(heap_path);
 
 		if(fp != NULL)//if wfc chache file is found
 		{
@@ -2855,6 +2962,7 @@ CCoverFlow::CLRet CCoverFlow::_loadCoverTex(u32 i, bool box, bool hq, bool blank
 						if(fread(tex.data, 1, texLen, fp) == texLen)
 						{
 							DCFlushRange(tex.data, texLen);
+							tex.opaque = tex.format == GX_TF_CMPR && cmprOpaque(tex.data, texLen);
 							LockMutex lock(m_mutex);
 							TexHandle.Cleanup(m_items[i].texture);
 							m_items[i].texture = tex;
@@ -2892,9 +3000,12 @@ void * CCoverFlow::_coverLoader(void *obj)
 	bool hq_req = cf->m_useHQcover;
 	bool cur_pos_hq = false;
 	u32 bufferSize = min(cf->m_numBufCovers * max(2u, cf->m_rows), 80u);
+	ScratchArena &scratch = ScratchArena::Get(SCRATCH_COVERS);
+	scratch.Bind();
 
 	while(cf->m_loadingCovers)
 	{
+		scratch.Reset();
 		update = cf->m_moved;
 		cf->m_moved = false;
 		firstItem = cf->m_covers[cf->m_range / 2].index;
@@ -2936,9 +3047,14 @@ void * CCoverFlow::_coverLoader(void *obj)
 				hq_done = (hq_done == false && ret == CL_OK && cur_pos_hq);
 			}
 		}
+#ifdef MEM_TRACE
+		if(ret == CL_NOMEM)
+			MEM_trace_dump();
+#endif
 		if(ret == CL_NOMEM && bufferSize > 3)
 			bufferSize -= 2;
 	}
+	scratch.Unbind();
 	cf->m_coverThrdBusy = false;
 	return 0;
 }
@@ -68,6 +68,9 @@ public:
 	void prevPlayers(bool wifi, wchar_t *c);
 	void nextID(wchar_t *c);
 	void prevID(wchar_t *c);
+	/* prefix is matched from the first letter or digit of the titles on, the same as letter jumps */
+	bool jumpToPrefix(const wchar_t *prefix);
+	static const wchar_t *navTitle(const wchar_t *title);
 	void left(void);
 	void right(void);
 	void up(void);
@@ -135,6 +138,7 @@ public:
 	const char *getNextId(void) const;
 	const dir_discHdr * getHdr(void) const;
 	const dir_discHdr * getNextHdr(void) const;
+	const dir_discHdr * getPrevHdr(void) const;
 	const dir_discHdr * getSpecificHdr(u32) const;
 	wstringEx getTitle(void) const;
 	u64 getChanTitle(void) const;
@@ -145,6 +149,15 @@ public:
 	//
 	static u32 InternalCoverColor(const char *ID, u32 DefCaseColor);
 	static bool checkCoverColor(const char *ID, const char *checkID[], u32 len);
+	// GX work done by the cover draws of the last frame
+	struct SRenderStats
+	{
+		u32 texLoads;
+		u32 colorChanges;
+		u32 mtxLoads;
+		u32 meshes;
+	};
+	const SRenderStats &getRenderStats(void) const { return m_frameStats; }
 private:
 	enum DrawMode { CFDR_NORMAL, CFDR_STENCIL, CFDR_SHADOW };
 	struct SLayout
@@ -198,12 +211,18 @@ private:
 		Vector3D bottomDeltaAngle;
 	};
 	enum TexState { STATE_Loading, STATE_Ready, STATE_NoCover };
+	enum NavKey { NAV_NONE, NAV_LETTER, NAV_PLAYERS, NAV_WIFI, NAV_ID };
 	struct CItem//should be SItem because it's a struct
 	{
 		CItem(dir_discHdr *itemHdr, int playcount, unsigned int lastPlayed);
 		dir_discHdr *hdr;
 		int playcount;
 		unsigned int lastPlayed;
+		/* sort keys worked out once so the comparators don't rescan hdr */
+		u64 alphaKey;// first two title chars as lowered for wchar_cmp
+		u64 idKey;// uppercased game id, shorter ids sort first
+		u16 titleLen;
+		u8 navStart;// first letter or digit of the title, letter jumps go by it
 		TexData texture;
 		volatile bool boxTexture;
 		volatile enum TexState state;
@@ -231,6 +250,16 @@ private:
 		// 
 		CCover(void);
 	};
+	// a cover recorded by _drawCover, submitted by _flushCovers
+	struct SCoverDraw
+	{
+		Mtx modelViewMtx;
+		CColor color;
+		const TexData *skin;// box spine, NULL in flat mode
+		const TexData *tex;// flat cover or back and spine of the box
+		const TexData *front;// front of the box if it differs from tex
+		bool boxTex;// flat mode showing a box texture
+	};
 	enum CLRet { CL_OK, CL_ERROR, CL_NOMEM };
 private:
 	Mtx44 m_projMtx;
@@ -311,6 +340,20 @@ private:
 	u8 m_aniso;
 	bool m_edgeLOD;
 	Sorting m_sorting;
+	Sorting m_itemsSorting;// order m_items is actually in
+	// runs of equal jump keys in m_items, built on first use
+	NavKey m_navType;
+	std::vector<u32> m_navStart;// first item of each run
+	std::vector<u32> m_navKey;// key shared by the run
+	std::vector<u32> m_navRun;// run each item belongs to
+	// render queue
+	std::vector<SCoverDraw> m_drawQueue;
+	const TexData *m_curTex;
+	const SCoverDraw *m_curMtx;
+	CColor m_curColor;
+	bool m_curColorSet;
+	SRenderStats m_renderStats;
+	SRenderStats m_frameStats;
 	//thread stack
 	static u8 coverThreadStack[32768];
 	static const u32 coverThreadStackSize;
@@ -322,8 +365,16 @@ private:
 	void _drawMirrorZ(void);
 	void _drawTitle(int i, bool mirror, bool rectangle);
 	void _drawCover(int i, bool mirror, CCoverFlow::DrawMode dm);
-	void _drawCoverFlat(int i, bool mirror, CCoverFlow::DrawMode dm);
-	void _drawCoverBox(int i, bool mirror, CCoverFlow::DrawMode dm);
+	void _flushCovers(bool mirror, CCoverFlow::DrawMode dm, bool sort);
+	void _drawCoverFlat(const SCoverDraw &cd, bool mirror, CCoverFlow::DrawMode dm);
+	void _drawCoverBox(const SCoverDraw &cd, bool mirror, CCoverFlow::DrawMode dm);
+	void _drawCoverSpine(const SCoverDraw &cd, CCoverFlow::DrawMode dm);
+	void _drawCoverSides(const SCoverDraw &cd, bool mirror, CCoverFlow::DrawMode dm);
+	void _setCoverTex(const TexData *tex, bool mirror, bool mipmaps);
+	void _setCoverColor(const CColor &color);
+	void _setCoverMtx(const SCoverDraw &cd);
+	bool _opaqueDraw(const SCoverDraw &cd) const;
+	const TexData *_coverSkin(u32 caseColor);
 	void _updateTarget(int i, bool instant = false);
 	void _updateAllTargets(bool instant = false);
 	void _loadCover(int i, int item);
@@ -350,13 +401,17 @@ private:
 	void _stopSound(GuiSound * &snd);
 	void _playSound(GuiSound * &snd);
 
-	static bool _sortByPlayCount(CItem item1, CItem item2);
-	static bool _sortByLastPlayed(CItem item1, CItem item2);
-	static bool _sortByGameID(CItem item1, CItem item2);
-	static bool _sortByAlpha(CItem item1, CItem item2);
-	static bool _sortByPlayers(CItem item1, CItem item2);
-	static bool _sortByWifiPlayers(CItem item1, CItem item2);
-	static bool _sortByBtnNumbers(CItem item1, CItem item2);
+	void _sortItems(void);
+	static u32 _navKeyOf(const CItem &item, NavKey type);
+	void _buildNavIndex(NavKey type);
+	u32 _navJump(NavKey type, bool next);
+	static bool _sortByPlayCount(const CItem &item1, const CItem &item2);
+	static bool _sortByLastPlayed(const CItem &item1, const CItem &item2);
+	static bool _sortByGameID(const CItem &item1, const CItem &item2);
+	static bool _sortByAlpha(const CItem &item1, const CItem &item2);
+	static bool _sortByPlayers(const CItem &item1, const CItem &item2);
+	static bool _sortByWifiPlayers(const CItem &item1, const CItem &item2);
+	static bool _sortByBtnNumbers(const CItem &item1, const CItem &item2);
 
 private:
 	static void * _coverLoader(void *obj);
@@ -6,6 +6,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include "memory/mem2.hpp"
+#include "memory/scratch.hpp"
 
 int currentStr = 0;
 static char fmt_buffer[MAX_USES][MAX_MSG_SIZE];
@@ -13,11 +14,17 @@ char *fmt(const char *format, ...)
 {
 	va_list va;
 	va_start(va, format);
-	currentStr = (currentStr + 1) % MAX_USES;
-	vsnprintf(fmt_buffer[currentStr], MAX_MSG_SIZE - 1, format, va);
-	fmt_buffer[currentStr][MAX_MSG_SIZE - 1] = '\0';
+	/* threads with a scratch arena rotate their own buffers */
+	char *buffer = Scratch_FmtBuffer();
+	if(buffer == NULL)
+	{
+		currentStr = (currentStr + 1) % MAX_USES;
+		buffer = fmt_buffer[currentStr];
+	}
+	vsnprintf(buffer, MAX_MSG_SIZE - 1, format, va);
+	buffer[MAX_MSG_SIZE - 1] = '\0';
 	va_end(va);
-	return fmt_buffer[currentStr];
+	return buffer;
 }
 
 char *fmt_malloc(const char *format, ...)
@@ -0,0 +1,141 @@
+/****************************************************************************
+ * Frame profiler, see profiler.hpp
+ ****************************************************************************/
+#include "profiler.hpp"
+
+#ifdef FRAME_PROFILER
+
+#include <stdio.h>
+#include <string.h>
+#include "video.hpp"
+#include "gecko/gecko.hpp"
+
+static const char *zoneNames[PROF_ZONES] = {
+	"frame", "cf_tick", "gui_tick", "fanart_tick", "background",
+	"cf_draw", "banner", "gui_draw", "input", "render"
+};
+
+static const char *counterNames[PROF_COUNTERS] = {
+	"tex_loads", "colors", "mtx_loads", "meshes"
+};
+
+static const GXColor zoneColors[PROF_ZONES] = {
+	{ 0xFF, 0xFF, 0xFF, 0xC0 }, { 0x40, 0x80, 0xFF, 0xC0 }, { 0x40, 0xFF, 0xFF, 0xC0 },
+	{ 0x80, 0x40, 0xFF, 0xC0 }, { 0x80, 0x80, 0x80, 0xC0 }, { 0x40, 0xFF, 0x40, 0xC0 },
+	{ 0xFF, 0x80, 0x00, 0xC0 }, { 0xFF, 0xFF, 0x40, 0xC0 }, { 0xFF, 0x40, 0xFF, 0xC0 },
+	{ 0xFF, 0x40, 0x40, 0xC0 }
+};
+
+/* microseconds per zone, all tables static so profiling never allocates */
+static u32 samples[PROFILER_FRAMES][PROF_ZONES];
+static u32 current[PROF_ZONES];
+static u32 frames = 0;// frames recorded so far
+static u32 counters[PROF_COUNTERS];// since the last gecko line
+
+bool Profiler::overlay = true;
+
+void Profiler::Add(u32 zone, u64 ticks)
+{
+	if(zone < PROF_ZONES)
+		current[zone] += ticks_to_microsecs(ticks);
+}
+
+void Profiler::Count(u32 counter, u32 n)
+{
+	if(counter < PROF_COUNTERS)
+		counters[counter] += n;
+}
+
+void Profiler::NextFrame(void)
+{
+	if(current[PROF_FRAME] == 0)
+		return;
+	memcpy(samples[frames % PROFILER_FRAMES], current, sizeof(current));
+	memset(current, 0, sizeof(current));
+	if(++frames % PROFILER_FRAMES != 0)
+		return;
+
+	char line[256];
+	u32 len = 0;
+	for(u32 z = 0; z < PROF_ZONES && len < sizeof(line); ++z)
+	{
+		u32 total = 0;
+		for(u32 i = 0; i < PROFILER_FRAMES; ++i)
+			total += samples[i][z];
+		len += snprintf(line + len, sizeof(line) - len, " %s %u.%02u", zoneNames[z],
+			total / PROFILER_FRAMES / 1000, total / PROFILER_FRAMES % 1000 / 10);
+	}
+	gprintf("Profiler (ms):%s\n", line);
+
+	len = 0;
+	for(u32 c = 0; c < PROF_COUNTERS && len < sizeof(line); ++c)
+		len += snprintf(line + len, sizeof(line) - len, " %s %u", counterNames[c], counters[c] / PROFILER_FRAMES);
+	memset(counters, 0, sizeof(counters));
+	gprintf("Profiler (per frame):%s\n", line);
+}
+
+void Profiler::DrawOverlay(bool pal)
+{
+	if(!overlay)
+		return;
+	u32 count = frames < PROFILER_FRAMES ? frames : PROFILER_FRAMES;
+	if(count == 0)
+		return;
+
+	/* frame time history, 2 pixels per ms, the line is the retrace period */
+	const f32 bottom = 460.f;
+	const f32 scale = 2.f / 1000.f;
+	const u32 history = 128;
+	u32 shown = count < history ? count : history;
+	DrawRectangle(40.f, bottom - 50.f, history * 2.f, 50.f, (GXColor){ 0, 0, 0, 0x80 });
+	for(u32 i = 0; i < shown; ++i)
+	{
+		const u32 *s = samples[(frames - shown + i) % PROFILER_FRAMES];
+		f32 h = s[PROF_FRAME] * scale;
+		if(h > 50.f)
+			h = 50.f;
+		DrawRectangle(40.f + i * 2.f, bottom - h, 2.f, h, zoneColors[PROF_FRAME]);
+	}
+	DrawRectangle(40.f, bottom - (pal ? 20000 : 16683) * scale, history * 2.f, 1.f, (GXColor){ 0xFF, 0, 0, 0xFF });
+
+	/* average of each zone side by side, 12 pixels per ms */
+	f32 x = 320.f;
+	DrawRectangle(x, bottom - 10.f, 280.f, 10.f, (GXColor){ 0, 0, 0, 0x80 });
+	for(u32 z = PROF_FRAME + 1; z < PROF_ZONES; ++z)
+	{
+		u32 total = 0;
+		for(u32 i = 0; i < count; ++i)
+			total += samples[i][z];
+		f32 w = (f32)total / count * 12.f / 1000.f;
+		if(x + w > 600.f)
+			w = 600.f - x;
+		if(w <= 0.f)
+			continue;
+		DrawRectangle(x, bottom - 10.f, w, 10.f, zoneColors[z]);
+		x += w;
+	}
+}
+
+bool Profiler::Write(const char *path)
+{
+	FILE *file = fopen(path, "w");
+	if(file == NULL)
+		return false;
+	fprintf(file, "# wiiflow frame profile 1\nzones");
+	for(u32 z = 0; z < PROF_ZONES; ++z)
+		fprintf(file, " %s", zoneNames[z]);
+	fprintf(file, "\n");
+	u32 count = frames < PROFILER_FRAMES ? frames : PROFILER_FRAMES;
+	for(u32 i = 0; i < count; ++i)
+	{
+		const u32 *s = samples[(frames - count + i) % PROFILER_FRAMES];
+		for(u32 z = 0; z < PROF_ZONES; ++z)
+			fprintf(file, z == 0 ? "%u" : " %u", s[z]);
+		fprintf(file, "\n");
+	}
+	fclose(file);
+	gprintf("Profiler: %u frames written to %s\n", count, path);
+	return true;
+}
+
+#endif
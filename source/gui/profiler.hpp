@@ -0,0 +1,85 @@
+/****************************************************************************
+ * Frame profiler, build with PROFILER=1 to enable it.
+ *
+ * The main loop is split into zones. A ProfileScope adds the time spent in
+ * its zone to the current frame, and the last PROFILER_FRAMES frames are
+ * kept in a ring buffer. The overlay draws the frame time history and the
+ * average time of each zone, an average line goes to gecko every
+ * PROFILER_FRAMES frames. Counters add up events such as GX loads per frame,
+ * their averages are part of the gecko line.
+ *
+ * Capture file (text):
+ *   # wiiflow frame profile 1
+ *   zones <name of each zone, PROF_FRAME first>
+ *   <microseconds of each zone>, one line per frame, oldest first
+ * PROF_FRAME holds the whole frame, the other zones are parts of it.
+ * scripts/profile_fold.py turns a capture into folded stacks for flamegraph.pl.
+ ****************************************************************************/
+#ifndef _PROFILER_HPP_
+#define _PROFILER_HPP_
+
+#include <gctypes.h>
+#include <ogc/lwp_watchdog.h>
+
+enum
+{
+	PROF_FRAME = 0,		// all of CMenu::_mainLoopCommon
+	PROF_CF_TICK,
+	PROF_GUI_TICK,
+	PROF_FANART_TICK,
+	PROF_BACKGROUND,
+	PROF_CF_DRAW,
+	PROF_BANNER,		// banner, fanart or game video
+	PROF_GUI_DRAW,
+	PROF_INPUT,
+	PROF_RENDER,		// includes waiting for the retrace
+	PROF_ZONES
+};
+
+enum
+{
+	PROF_CNT_TEX_LOADS = 0,	// coverflow GX texture loads
+	PROF_CNT_COLORS,		// coverflow TEV color changes
+	PROF_CNT_MTX_LOADS,		// coverflow matrix loads
+	PROF_CNT_MESHES,		// coverflow meshes drawn
+	PROF_COUNTERS
+};
+
+#define PROFILER_FRAMES	256
+
+#ifdef FRAME_PROFILER
+class Profiler
+{
+public:
+	static void Add(u32 zone, u64 ticks);
+	static void Count(u32 counter, u32 n);
+	static void NextFrame(void);
+	static void SetOverlay(bool show) { overlay = show; }
+	static void DrawOverlay(bool pal);
+	static bool Write(const char *path);
+private:
+	static bool overlay;
+};
+
+class ProfileScope
+{
+public:
+	ProfileScope(u32 z) : zone(z), start(gettime()) {}
+	~ProfileScope() { Profiler::Add(zone, gettime() - start); }
+private:
+	u32 zone;
+	u64 start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(zone) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(zone)
+#define PROFILE_NEXT_FRAME() Profiler::NextFrame()
+#define PROFILE_COUNT(counter, n) Profiler::Count(counter, n)
+#else
+#define PROFILE_ZONE(zone)
+#define PROFILE_COUNT(counter, n)
+#define PROFILE_NEXT_FRAME()
+#endif
+
+#endif // !defined(_PROFILER_HPP_)
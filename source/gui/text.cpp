@@ -210,15 +210,71 @@ bool SFont::fromFile(const char *path, u32 size, u32 lspacing, u32 w, u32 idx, c
 	return true;
 }
 
+/* Layout cache. setFrame results are kept in a small direct mapped table keyed by */
+/* font, frame and a hash of the text, so static or re-set text is never measured twice. */
+/* the text itself is kept too, an entry is only used if it matches. */
+#define TEXT_LAYOUT_CACHE_SIZE	256
+
+struct STextLayout
+{
+	STextLayout(void) : font(NULL), fSize(0), lineSpacing(0), width(0.f), style(0), ignoreNewlines(false),
+		firstLine(0), textHash(0), totalHeight(0) { }
+	FreeTypeGX *font;
+	u32 fSize;
+	u32 lineSpacing;
+	float width;
+	u16 style;
+	bool ignoreNewlines;
+	u32 firstLine;
+	u32 textHash;
+	u32 totalHeight;
+	wstringEx text;
+	vector<Vector3D> positions;
+	vector<float> widths;
+};
+
+static STextLayout g_layoutCache[TEXT_LAYOUT_CACHE_SIZE];
+static u32 g_layoutCacheHits = 0;
+static u32 g_layoutCacheMisses = 0;
+
+static inline u32 fnv1a(u32 hash, u32 value)
+{
+	for (u32 i = 0; i < 4; ++i)
+	{
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+void CText::clearLayoutCache(void)
+{
+	for (u32 i = 0; i < TEXT_LAYOUT_CACHE_SIZE; ++i)
+	{
+		g_layoutCache[i].font = NULL;
+		g_layoutCache[i].text.clear();
+		g_layoutCache[i].positions.clear();
+		g_layoutCache[i].widths.clear();
+	}
+}
+
+void CText::getLayoutCacheStats(u32 &hits, u32 &misses)
+{
+	hits = g_layoutCacheHits;
+	misses = g_layoutCacheMisses;
+}
+
 static const wchar_t *g_whitespaces = L" \f\n\r\t\v";// notice the first character is a space
-void CText::setText(const SFont &font, const wstringEx &t)
+void CText::_splitLines(const wstringEx &t)
 {
 	SWord w;
-	m_lines.clear();
-	if(font.font == NULL)
-		return;
-	m_font = font;
-	firstLine = 0;
+	w.width = 0.f;
+
+	m_text = t;
+	m_textHash = 2166136261u;
+	for (u32 i = 0; i < t.size(); ++i)
+		m_textHash = fnv1a(m_textHash, (u32)t[i]);
+
 	// Don't care about performance
 	vector<wstringEx> lines = stringToVector(t, L'\n');
 	m_lines.reserve(lines.size());
@@ -249,9 +305,18 @@ void CText::setText(const SFont &font, const wstringEx &t)
 	}
 }
 
+void CText::setText(const SFont &font, const wstringEx &t)
+{
+	m_lines.clear();
+	if(font.font == NULL)
+		return;
+	m_font = font;
+	firstLine = 0;
+	_splitLines(t);
+}
+
 void CText::setText(const SFont &font, const wstringEx &t, u32 startline)
 {
-	SWord w;
 	totalHeight = 0;
 
 	m_lines.clear();
@@ -261,34 +326,7 @@ void CText::setText(const SFont &font, const wstringEx &t, u32 startline)
 		return;
 
 	firstLine = startline;
-	// Don't care about performance
-	vector<wstringEx> lines = stringToVector(t, L'\n');
-	m_lines.reserve(lines.size());
-	// 
-	for (u32 k = 0; k < lines.size(); ++k)
-	{
-		wstringEx &l = lines[k];
-		m_lines.push_back(CLine());
-		m_lines.back().reserve(32);
-		wstringEx::size_type i = l.find_first_not_of(g_whitespaces);
-		wstringEx::size_type j;
-		while (i != wstringEx::npos)
-		{
-			j = l.find_first_of(g_whitespaces, i);
-			if (j != wstringEx::npos && j > i)
-			{
-				w.text.assign(l, i, j - i);
-				m_lines.back().push_back(w);
-				i = l.find_first_not_of(g_whitespaces, j);
-			}
-			else if (j == wstringEx::npos)
-			{
-				w.text.assign(l, i, l.size() - i);
-				m_lines.back().push_back(w);
-				i = wstringEx::npos;
-			}
-		}
-	}
+	_splitLines(t);
 }
 
 void CText::setFrame(float width, u16 style, bool ignoreNewlines, bool instant)
@@ -296,6 +334,41 @@ void CText::setFrame(float width, u16 style, bool ignoreNewlines, bool instant)
 	if(m_font.font == NULL)
 		return;
 
+	if(firstLine > m_lines.size()) firstLine = 0;
+
+	u32 wordCount = 0;
+	for (u32 k = firstLine; k < m_lines.size(); ++k)
+		wordCount += m_lines[k].size();
+
+	u32 keyHash = m_textHash;
+	keyHash = fnv1a(keyHash, (u32)(uintptr_t)m_font.font);
+	keyHash = fnv1a(keyHash, m_font.fSize);
+	keyHash = fnv1a(keyHash, m_font.lineSpacing);
+	keyHash = fnv1a(keyHash, (u32)width);
+	keyHash = fnv1a(keyHash, style | (ignoreNewlines << 16));
+	keyHash = fnv1a(keyHash, firstLine);
+	STextLayout &layout = g_layoutCache[keyHash & (TEXT_LAYOUT_CACHE_SIZE - 1)];
+
+	if (layout.font == m_font.font && layout.fSize == m_font.fSize && layout.lineSpacing == m_font.lineSpacing
+		&& layout.width == width && layout.style == style && layout.ignoreNewlines == ignoreNewlines
+		&& layout.firstLine == firstLine && layout.textHash == m_textHash && layout.positions.size() == wordCount
+		&& layout.text == m_text)
+	{
+		++g_layoutCacheHits;
+		u32 w = 0;
+		for (u32 k = firstLine; k < m_lines.size(); ++k)
+			for (u32 i = 0; i < m_lines[k].size(); ++i, ++w)
+			{
+				m_lines[k][i].targetPos = layout.positions[w];
+				m_lines[k][i].width = layout.widths[w];
+				if (instant)
+					m_lines[k][i].pos = m_lines[k][i].targetPos;
+			}
+		totalHeight = layout.totalHeight;
+		return;
+	}
+	++g_layoutCacheMisses;
+
 	float shift;
 	totalHeight = 0;
 	float space = m_font.font->getWidth(L" ", m_font.fSize);//
@@ -303,8 +376,6 @@ void CText::setFrame(float width, u16 style, bool ignoreNewlines, bool instant)
 	float posY = 0.f;
 	u32 lineBeg = 0;
 
-	if(firstLine > m_lines.size()) firstLine = 0;
-
 	for (u32 k = firstLine; k < m_lines.size(); ++k)
 	{
 		CLine &words = m_lines[k];
@@ -317,6 +388,7 @@ void CText::setFrame(float width, u16 style, bool ignoreNewlines, bool instant)
 		for (u32 i = 0; i < words.size(); ++i)
 		{
 			float wordWidth = m_font.font->getWidth(words[i].text.c_str(), m_font.fSize);//
+			words[i].width = wordWidth;
 			if (posX == 0.f || posX + (float)wordWidth + space * 2 <= width)
 			{
 				words[i].targetPos = Vector3D(posX, posY, 0.f);
@@ -363,6 +435,27 @@ void CText::setFrame(float width, u16 style, bool ignoreNewlines, bool instant)
 		for (u32 k = firstLine; k < m_lines.size(); ++k)
 			for (u32 i = 0; i < m_lines[k].size(); ++i)
 				m_lines[k][i].pos = m_lines[k][i].targetPos;
+
+	layout.font = m_font.font;
+	layout.fSize = m_font.fSize;
+	layout.lineSpacing = m_font.lineSpacing;
+	layout.width = width;
+	layout.style = style;
+	layout.ignoreNewlines = ignoreNewlines;
+	layout.firstLine = firstLine;
+	layout.textHash = m_textHash;
+	layout.text = m_text;
+	layout.totalHeight = totalHeight;
+	layout.positions.clear();
+	layout.widths.clear();
+	layout.positions.reserve(wordCount);
+	layout.widths.reserve(wordCount);
+	for (u32 k = firstLine; k < m_lines.size(); ++k)
+		for (u32 i = 0; i < m_lines[k].size(); ++i)
+		{
+			layout.positions.push_back(m_lines[k][i].targetPos);
+			layout.widths.push_back(m_lines[k][i].width);
+		}
 }
 
 void CText::setColor(const CColor &c)
@@ -388,7 +481,7 @@ void CText::draw(void)
 		{
 			m_font.font->setX(m_lines[k][i].pos.x);
 			m_font.font->setY(m_lines[k][i].pos.y);
-			m_font.font->drawText(0, m_font.lineSpacing, m_lines[k][i].text.c_str(), m_font.fSize, m_color);
+			m_font.font->drawText(0, m_font.lineSpacing, m_lines[k][i].text.c_str(), m_font.fSize, m_color, FTGX_NULL, (u16)m_lines[k][i].width);
 		}
 }
 
@@ -37,6 +37,7 @@ struct SWord
 	wstringEx text;
 	Vector3D pos;
 	Vector3D targetPos;
+	float width;
 };
 typedef vector<SWord> CLine;
 
@@ -50,12 +51,17 @@ public:
 	void tick(void);
 	void draw(void);
 	int getTotalHeight();
+	static void clearLayoutCache(void);
+	static void getLayoutCacheStats(u32 &hits, u32 &misses);
 private:
+	void _splitLines(const wstringEx &t);
 	vector<CLine> m_lines;
 	SFont m_font;
 	CColor m_color;
 	u32 firstLine;
 	u32 totalHeight;
+	u32 m_textHash;
+	wstringEx m_text;// compared on layout cache hits, the hash alone can collide
 };
 
 // Nothing to do with CText. Q&D helpers for string formating.
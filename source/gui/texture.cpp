@@ -196,6 +196,7 @@ void STexture::Cleanup(TexData &tex)
 	tex.height = 0;
 	tex.format = -1;
 	tex.maxLOD = 0;
+	tex.opaque = false;
 }
 
 bool STexture::CopyTexture(const TexData &src, TexData &dest)
@@ -215,6 +216,7 @@ bool STexture::CopyTexture(const TexData &src, TexData &dest)
 	dest.height = src.height;
 	dest.format = src.format;
 	dest.maxLOD = src.maxLOD;
+	dest.opaque = src.opaque;
 	return true;
 }
 
@@ -13,7 +13,7 @@ enum TexErr
 
 struct TexData
 {
-	TexData() : data(NULL), dataSize(0), width(0), height(0), format(-1), maxLOD(0), thread(false) { }
+	TexData() : data(NULL), dataSize(0), width(0), height(0), format(-1), maxLOD(0), thread(false), opaque(false) { }
 	u8 *data;
 	u32 dataSize;
 	u32 width;
@@ -21,6 +21,7 @@ struct TexData
 	u8 format;
 	u8 maxLOD;
 	bool thread;
+	bool opaque;// CMPR without any transparent texel, only set for covers
 } ATTRIBUTE_PACKED;
 
 class STexture
@@ -141,17 +141,9 @@ void writeStub()
 	/* Clear potential homebrew channel stub */
 	memset((void*)0x80001800, 0, 0x1800);
 
-	/* Extract our stub */
-	u32 StubSize = 0;
-	u8 *Stub = DecompressCopy(wfstub_bin, wfstub_bin_size, &StubSize);
-
-	/* Copy our own stub into memory */
-	memcpy((void*)0x80001800, Stub, StubSize);
-	DCFlushRange((void*)0x80001800, StubSize);
-
-	/* And free the memory again */
-	if(Stub != wfstub_bin)
-		free(Stub);
+	/* Extract our stub straight to its place */
+	if(DecompressTo(wfstub_bin, wfstub_bin_size, (u8*)0x80001800, 0x1800) == 0)
+		gprintf("Stub doesn't fit\n");
 }
 
 //extern "C" { void __exception_closeall(); }
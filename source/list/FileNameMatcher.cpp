@@ -0,0 +1,397 @@
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include "FileNameMatcher.hpp"
+
+using std::string;
+using std::vector;
+
+typedef std::bitset<256> CharSet;
+
+static const u32 MAX_DFA_STATES = 1024;
+
+enum
+{
+	DFA_MATCH = 1,
+	DFA_MATCH_AT_END = 2,
+};
+
+enum NodeType
+{
+	NODE_EPS,
+	NODE_SET,
+	NODE_BOL,
+	NODE_EOL,
+	NODE_MATCH,
+};
+
+struct PatternNode
+{
+	u8 type;
+	int set;
+	int out[2];
+};
+
+/* builds an NFA from the pattern, every fragment ends in an epsilon node
+   whose first exit is still free */
+class PatternParser
+{
+public:
+	PatternParser(const string &pattern) : pat(pattern), pos(0), ok(true) {}
+
+	bool Parse(int &start)
+	{
+		Frag f = alt();
+		if(!ok || pos != pat.size())
+			return false;
+		nodes[f.end].out[0] = newNode(NODE_MATCH);
+		start = f.start;
+		return true;
+	}
+
+	vector<PatternNode> nodes;
+	vector<CharSet> sets;
+
+private:
+	struct Frag
+	{
+		int start;
+		int end;
+	};
+
+	int newNode(u8 type, int set = -1)
+	{
+		PatternNode n = { type, set, { -1, -1 } };
+		nodes.push_back(n);
+		return nodes.size() - 1;
+	}
+
+	Frag empty(void)
+	{
+		int e = newNode(NODE_EPS);
+		Frag f = { e, e };
+		return f;
+	}
+
+	Frag single(u8 type, int set = -1)
+	{
+		Frag f = { newNode(type, set), newNode(NODE_EPS) };
+		nodes[f.start].out[0] = f.end;
+		return f;
+	}
+
+	Frag charSet(const CharSet &s)
+	{
+		sets.push_back(s);
+		return single(NODE_SET, sets.size() - 1);
+	}
+
+	static void addFolded(CharSet &s, u8 c)
+	{
+		s.set(c);
+		s.set(tolower(c));
+		s.set(toupper(c));
+	}
+
+	Frag alt(void)
+	{
+		Frag f = concat();
+		while(ok && pos < pat.size() && pat[pos] == '|')
+		{
+			++pos;
+			Frag g = concat();
+			int split = newNode(NODE_EPS);
+			int join = newNode(NODE_EPS);
+			nodes[split].out[0] = f.start;
+			nodes[split].out[1] = g.start;
+			nodes[f.end].out[0] = join;
+			nodes[g.end].out[0] = join;
+			f.start = split;
+			f.end = join;
+		}
+		return f;
+	}
+
+	Frag concat(void)
+	{
+		Frag f = empty();
+		while(ok && pos < pat.size() && pat[pos] != '|' && pat[pos] != ')')
+		{
+			Frag g = repeat();
+			nodes[f.end].out[0] = g.start;
+			f.end = g.end;
+		}
+		return f;
+	}
+
+	Frag repeat(void)
+	{
+		Frag f = atom();
+		while(ok && pos < pat.size() && (pat[pos] == '*' || pat[pos] == '+' || pat[pos] == '?' || pat[pos] == '{'))
+		{
+			char op = pat[pos++];
+			if(op == '{')
+			{
+				ok = false;
+				break;
+			}
+			int split = newNode(NODE_EPS);
+			int e = newNode(NODE_EPS);
+			nodes[split].out[0] = f.start;
+			nodes[split].out[1] = e;
+			nodes[f.end].out[0] = op == '?' ? e : split;
+			if(op != '+')
+				f.start = split;
+			f.end = e;
+		}
+		return f;
+	}
+
+	Frag atom(void)
+	{
+		CharSet s;
+		u8 c = pat[pos++];
+		switch(c)
+		{
+			case '(':
+			{
+				Frag f = alt();
+				if(pos < pat.size() && pat[pos] == ')')
+					++pos;
+				else
+					ok = false;
+				return f;
+			}
+			case '^':
+				return single(NODE_BOL);
+			case '$':
+				return single(NODE_EOL);
+			case '.':
+				s.set();
+				s.reset(0);
+				return charSet(s);
+			case '[':
+				return bracket();
+			case '\\':
+				if(pos >= pat.size() || isalnum((u8)pat[pos]))
+					break;
+				addFolded(s, pat[pos++]);
+				return charSet(s);
+			case '*':
+			case '+':
+			case '?':
+			case '{':
+				break;
+			default:
+				addFolded(s, c);
+				return charSet(s);
+		}
+		ok = false;
+		return empty();
+	}
+
+	Frag bracket(void)
+	{
+		CharSet s;
+		bool negate = pos < pat.size() && pat[pos] == '^';
+		if(negate)
+			++pos;
+		for(bool first = true; ; first = false)
+		{
+			if(pos >= pat.size())
+			{
+				ok = false;
+				return empty();
+			}
+			u8 lo = pat[pos++];
+			if(lo == ']' && !first)
+				break;
+			/* [:class:], [=x=], [.x.] and escapes are left to std::regex */
+			if(lo == '\\' || (lo == '[' && pos < pat.size() && (pat[pos] == ':' || pat[pos] == '=' || pat[pos] == '.')))
+			{
+				ok = false;
+				return empty();
+			}
+			u8 hi = lo;
+			if(pos + 1 < pat.size() && pat[pos] == '-' && pat[pos + 1] != ']')
+			{
+				hi = pat[pos + 1];
+				pos += 2;
+				if(hi < lo || hi == '[' || hi == '\\')
+				{
+					ok = false;
+					return empty();
+				}
+			}
+			for(u32 i = lo; i <= hi; ++i)
+				addFolded(s, i);
+		}
+		if(negate)
+		{
+			s.flip();
+			s.reset(0);
+		}
+		return charSet(s);
+	}
+
+	const string &pat;
+	u32 pos;
+	bool ok;
+};
+
+/* collect the char and match nodes reachable from n without reading a char.
+   $ is only passed at the end of the name and kept as a node otherwise. */
+static void closure(const vector<PatternNode> &nodes, int n, bool atStart, bool atEnd,
+			vector<bool> &seen, vector<int> &out)
+{
+	vector<int> stack(1, n);
+	while(!stack.empty())
+	{
+		n = stack.back();
+		stack.pop_back();
+		if(n < 0 || seen[n])
+			continue;
+		seen[n] = true;
+		const PatternNode &node = nodes[n];
+		switch(node.type)
+		{
+			case NODE_EPS:
+				stack.push_back(node.out[1]);
+				stack.push_back(node.out[0]);
+				break;
+			case NODE_BOL:
+				if(atStart)
+					stack.push_back(node.out[0]);
+				break;
+			case NODE_EOL:
+				if(atEnd)
+					stack.push_back(node.out[0]);
+				else
+					out.push_back(n);
+				break;
+			default:
+				out.push_back(n);
+				break;
+		}
+	}
+}
+
+FileNameMatcher::FileNameMatcher(void) : m_useRegex(false), m_classes(1), m_next(1, 0), m_flags(1, 0)
+{
+	memset(m_class, 0, sizeof(m_class));
+}
+
+void FileNameMatcher::Compile(const string &pattern)
+{
+	m_useRegex = !_compileDFA(pattern);
+	if(m_useRegex)
+		m_regex = std::regex(pattern, std::regex_constants::extended | std::regex_constants::icase);
+	else
+		m_regex = std::regex();
+}
+
+bool FileNameMatcher::_compileDFA(const string &pattern)
+{
+	PatternParser parser(pattern);
+	int start;
+	if(!parser.Parse(start))
+		return false;
+	const vector<PatternNode> &nodes = parser.nodes;
+	const vector<CharSet> &sets = parser.sets;
+
+	/* bytes that every set treats alike share one column of the table */
+	std::map<string, u32> classIds;
+	vector<u8> classChar;
+	string key(sets.size(), '0');
+	for(u32 c = 0; c < 256; ++c)
+	{
+		for(u32 i = 0; i < sets.size(); ++i)
+			key[i] = sets[i][c] ? '1' : '0';
+		std::map<string, u32>::iterator id = classIds.find(key);
+		if(id == classIds.end())
+		{
+			id = classIds.insert(std::make_pair(key, (u32)classChar.size())).first;
+			classChar.push_back(c);
+		}
+		m_class[c] = id->second;
+	}
+	m_classes = classChar.size();
+
+	/* the start state is only used before the first char, so it stays out of
+	   the lookup and ^ can be passed there alone */
+	vector<vector<int> > states(1);
+	std::map<vector<int>, u32> stateIds;
+	vector<bool> seen(nodes.size(), false);
+	closure(nodes, start, true, false, seen, states[0]);
+	std::sort(states[0].begin(), states[0].end());
+
+	m_next.clear();
+	m_flags.clear();
+	for(u32 s = 0; s < states.size(); ++s)
+	{
+		if(states.size() > MAX_DFA_STATES)
+			return false;
+		const vector<int> cur = states[s];
+		u8 flags = 0;
+		vector<int> end;
+		seen.assign(nodes.size(), false);
+		for(u32 i = 0; i < cur.size(); ++i)
+		{
+			if(nodes[cur[i]].type == NODE_MATCH)
+				flags |= DFA_MATCH;
+			else if(nodes[cur[i]].type == NODE_EOL)
+				closure(nodes, cur[i], s == 0, true, seen, end);
+		}
+		for(u32 i = 0; i < end.size(); ++i)
+		{
+			if(nodes[end[i]].type == NODE_MATCH)
+				flags |= DFA_MATCH_AT_END;
+		}
+		m_flags.push_back(flags);
+		if(flags & DFA_MATCH) // the search stops here
+		{
+			m_next.insert(m_next.end(), m_classes, s);
+			continue;
+		}
+		for(u32 c = 0; c < m_classes; ++c)
+		{
+			vector<int> next;
+			seen.assign(nodes.size(), false);
+			for(u32 i = 0; i < cur.size(); ++i)
+			{
+				const PatternNode &node = nodes[cur[i]];
+				if(node.type == NODE_SET && sets[node.set][classChar[c]])
+					closure(nodes, node.out[0], false, false, seen, next);
+			}
+			closure(nodes, start, false, false, seen, next);// a match can begin at any char
+			std::sort(next.begin(), next.end());
+			std::map<vector<int>, u32>::iterator id = stateIds.find(next);
+			if(id == stateIds.end())
+			{
+				id = stateIds.insert(std::make_pair(next, (u32)states.size())).first;
+				states.push_back(next);
+			}
+			m_next.push_back(id->second);
+		}
+	}
+	return true;
+}
+
+bool FileNameMatcher::Search(const char *name) const
+{
+	if(m_useRegex)
+		return std::regex_search(name, m_regex);
+
+	u32 state = 0;
+	for(const u8 *p = (const u8 *)name; ; ++p)
+	{
+		const u8 flags = m_flags[state];
+		if(flags & DFA_MATCH)
+			return true;
+		if(*p == '\0')
+			return (flags & DFA_MATCH_AT_END) != 0;
+		state = m_next[state * m_classes + m_class[*p]];
+	}
+}
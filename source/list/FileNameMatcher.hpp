@@ -0,0 +1,31 @@
+#ifndef _FILENAMEMATCHER_HPP_
+#define _FILENAMEMATCHER_HPP_
+
+#include <regex>
+#include <string>
+#include <vector>
+#include <gctypes.h>
+
+/* Case-insensitive POSIX extended pattern compiled to a DFA for searching
+   rom filenames. Syntax the DFA does not handle ({m,n}, [:class:], escapes
+   like \w) keeps using std::regex. */
+class FileNameMatcher
+{
+public:
+	FileNameMatcher(void);
+	void Compile(const std::string &pattern);
+	/* true if the pattern matches anywhere in name */
+	bool Search(const char *name) const;
+
+private:
+	bool _compileDFA(const std::string &pattern);
+
+	bool m_useRegex;
+	std::regex m_regex;
+	u32 m_classes;
+	u8 m_class[256];
+	std::vector<u16> m_next; // m_next[state * m_classes + class]
+	std::vector<u8> m_flags;
+};
+
+#endif /*_FILENAMEMATCHER_HPP_*/
@@ -16,7 +16,6 @@
  ****************************************************************************/
 #include <dirent.h>
 #include <unistd.h>
-#include <regex>
 #include "ListGenerator.hpp"
 #include "cache.hpp"
 #include "channel/channels.h"
@@ -26,14 +25,7 @@
 #include "gui/text.hpp"
 #include "loader/sys.h"
 
-ListGenerator m_cacheList;// needed by the static void functions since they are not part of ListGenerator class.
-dir_discHdr ListElement;
-Config CustomTitles;
-GameTDB gameTDB;
-Config romNamesDB;
-string platformName;
-string pluginsDataDir;
-std::regex fileNameSkipRegex;
+ListGenerator m_cacheList;
 
 void ListGenerator::Init(const char *settingsDir, const char *Language,
 			 const char *plgnsDataDir, const std::string& fileNameSkipPattern)
@@ -44,17 +36,22 @@ void ListGenerator::Init(const char *settingsDir, const char *Language,
 		CustomTitlesPath = fmt("%s/" CTITLES_FILENAME, settingsDir);
 	}
 	if(Language != NULL) gameTDB_Language = Language;
-	if(plgnsDataDir != NULL) pluginsDataDir = fmt("%s", plgnsDataDir);
+	if(plgnsDataDir != NULL) pluginsDataDir = plgnsDataDir;
 
-	fileNameSkipRegex = std::regex(fileNameSkipPattern,
-					  std::regex_constants::extended |
-					  std::regex_constants::icase);
+	fileNameSkip.Compile(fileNameSkipPattern);
 }
 
 void ListGenerator::Clear(void)
 {
-	m_cacheList.clear();
-	vector<dir_discHdr>().swap(m_cacheList);
+	clear();
+	vector<dir_discHdr>().swap(*this);
+}
+
+vector<dir_discHdr> ListGenerator::TakeList(void)
+{
+	vector<dir_discHdr> list;
+	list.swap(*this);
+	return list;
 }
 
 void ListGenerator::OpenConfigs()
@@ -74,22 +71,13 @@ void ListGenerator::CloseConfigs()
 		CustomTitles.unload();
 }
 
-/*
-static const u32 LIST_TMP_SIZE = 5000;
-dir_discHdr *tmpList = NULL;
-u32 tmpListPos = 0;
-static void AddToList(const dir_discHdr *element)
-{
-	
-}
-*/
-
 /* used for adding wii games to the list */
-static void AddISO(const char *GameID, const char *GameTitle, const char *GamePath, 
+void ListGenerator::AddISO(const char *GameID, const char *GameTitle, const char *GamePath, 
 							u32 GameColor, u8 Type)
 {
+	dir_discHdr ListElement;
 	memset((void*)&ListElement, 0, sizeof(dir_discHdr));
-	ListElement.index = m_cacheList.size();
+	ListElement.index = size();
 	if(GameID != NULL) strncpy(ListElement.id, GameID, 6);
 	if(GamePath != NULL) strncpy(ListElement.path, GamePath, sizeof(ListElement.path) - 1);
 	ListElement.casecolor = CustomTitles.getColor("COVERS", ListElement.id, GameColor).intVal();
@@ -118,12 +106,13 @@ static void AddISO(const char *GameID, const char *GameTitle, const char *GamePa
 	Asciify(ListElement.title);
 
 	ListElement.type = Type;
-	m_cacheList.push_back(ListElement);
+	push_back(ListElement);
 }
 
 /* read wbfs partition to add wii games to the list */
-static void Create_Wii_WBFS_List(wbfs_t *handle)
+void ListGenerator::Create_Wii_WBFS_List(wbfs_t *handle)
 {
+	discHdr wii_hdr;
 	for(u32 i = 0; i < wbfs_count_discs(handle); i++)
 	{
 		memset((void*)&wii_hdr, 0, sizeof(discHdr));
@@ -135,11 +124,12 @@ static void Create_Wii_WBFS_List(wbfs_t *handle)
 }
 
 /* add wii game iso(ntfs) or wbfs(fat) to the list. wbf1 and wbf2 are skipped and not added. */
-static void Add_Wii_Game(char *FullPath)
+void ListGenerator::Add_Wii_Game(char *FullPath)
 {
 	FILE *fp = fopen(FullPath, "rb");
 	if(fp)
 	{
+		discHdr wii_hdr;
 		fseek(fp, strcasestr(FullPath, ".wbfs") != NULL ? 512 : 0, SEEK_SET);
 		fread((void*)&wii_hdr, 1, sizeof(discHdr), fp);
 		if(wii_hdr.magic == WII_MAGIC)
@@ -150,12 +140,13 @@ static void Add_Wii_Game(char *FullPath)
 }
 
 /* add gamecube game to the list */
-u8 gc_disc[1];
-const char *FST_APPEND = "sys/boot.bin";
-const u8 FST_APPEND_SIZE = strlen(FST_APPEND);
+static const char *FST_APPEND = "sys/boot.bin";
+static const u8 FST_APPEND_SIZE = strlen(FST_APPEND);
 static const u8 CISO_MAGIC[8] = {'C','I','S','O',0x00,0x00,0x20,0x00};
-static void Add_GameCube_Game(char *FullPath)
+void ListGenerator::Add_GameCube_Game(char *FullPath)
 {
+	gc_discHdr gc_hdr;
+	u8 gc_disc[1];
 	u32 hdr_offset = 0x00;
 	FILE *fp = fopen(FullPath, "rb");
 	if(!fp && strstr(FullPath, "/root") != NULL) //fst folder (extracted game)
@@ -187,12 +178,13 @@ static void Add_GameCube_Game(char *FullPath)
 }
 
 /* add homebrew boot.dol to the list */
-static void Add_Homebrew_Dol(char *FullPath)
+void ListGenerator::Add_Homebrew_Dol(char *FullPath)
 {
 	if(strcasestr(FullPath, "boot.") == NULL)
 		return;
+	dir_discHdr ListElement;
 	memset((void*)&ListElement, 0, sizeof(dir_discHdr));
-	ListElement.index = m_cacheList.size();
+	ListElement.index = size();
 	*strrchr(FullPath, '/') = '\0';
 	strncpy(ListElement.path, FullPath, sizeof(ListElement.path) - 1);
 	memcpy(ListElement.id, "HB_APP", 6);
@@ -207,20 +199,20 @@ static void Add_Homebrew_Dol(char *FullPath)
 	Asciify(ListElement.title);
 
 	ListElement.type = TYPE_HOMEBREW;
-	m_cacheList.push_back(ListElement);
+	push_back(ListElement);
 }
 
 /* create channel list from nand or emu nand */
-Channel *chan = NULL;
-static void Create_Channel_List()
+void ListGenerator::Create_Channel_List()
 {
+	dir_discHdr ListElement;
 	for(u32 i = 0; i < ChannelHandle.Count(); i++)
 	{
-		chan = ChannelHandle.GetChannel(i);
+		Channel *chan = ChannelHandle.GetChannel(i);
 		if(strlen(chan->id) == 0) 
 			continue; // Skip invalid channels
 		memset((void*)&ListElement, 0, sizeof(dir_discHdr));
-		ListElement.index = m_cacheList.size();
+		ListElement.index = size();
 		ListElement.settings[0] = TITLE_UPPER(chan->title);
 		ListElement.settings[1] = TITLE_LOWER(chan->title);
 		if(chan->title == HBC_108)
@@ -251,17 +243,17 @@ static void Create_Channel_List()
 			ListElement.type = TYPE_CHANNEL;
 		else
 			ListElement.type = TYPE_EMUCHANNEL;
-		m_cacheList.push_back(ListElement);
+		push_back(ListElement);
 	}
 }
 
 /* add plugin rom, song, or video to the list. */
-static void Add_Plugin_Game(char *FullPath)
+void ListGenerator::Add_Plugin_Game(char *FullPath)
 {
 	/* only add disc 1 of multi disc games */
 	const char *RomFilename = strrchr(FullPath, '/') + 1;
 
-	if (std::regex_search(std::string(FullPath), fileNameSkipRegex)) 
+	if(fileNameSkip.Search(RomFilename))
 	{
 		//gprintf("Add_Plugin_Game: skipping '%s'\n", FullPath);
 		return;
@@ -276,13 +268,14 @@ static void Add_Plugin_Game(char *FullPath)
 	if(gameTDB.IsLoaded())
 	{
 		/* Get 6 character unique romID (from Screenscraper.fr) using shortName. if fails then use CRC or CD serial to get romID */
-		romID = m_plugin.GetRomId(FullPath, m_cacheList.Magic, romNamesDB, pluginsDataDir.c_str(), platformName.c_str(), ShortName.c_str());
+		romID = m_plugin.GetRomId(FullPath, Magic, romNamesDB, pluginsDataDir.c_str(), platformName.c_str(), ShortName.c_str());
 	}
 	if(romID.empty())
 		romID = "PLUGIN";
 	//gprintf("romID=%s\n", romID.c_str());
 
 	/* add rom to list */
+	dir_discHdr ListElement;
 	memset((void*)&ListElement, 0, sizeof(dir_discHdr));
 
 	strncpy(ListElement.path, FullPath, sizeof(ListElement.path) - 1);
@@ -291,10 +284,10 @@ static void Add_Plugin_Game(char *FullPath)
 	/* Get titles - Rom filename, custom title, and database xml title */
 	*strrchr(RomFilename, '.') = '\0';// remove extension
 	
-	string customTitle = CustomTitles.getStringCustomTitles(m_plugin.PluginMagicWord, RomFilename, "");
+	string customTitle = CustomTitles.getStringCustomTitles(magicWord, RomFilename, "");
 	
 	const char *gameTDB_Title = NULL;
-	if(gameTDB.IsLoaded() && customTitle.empty() && m_cacheList.usePluginDBTitles)
+	if(gameTDB.IsLoaded() && customTitle.empty() && usePluginDBTitles)
 		gameTDB.GetTitle(ListElement.id, gameTDB_Title, true);
 	
 	/* set the roms title */
@@ -306,16 +299,17 @@ static void Add_Plugin_Game(char *FullPath)
 		mbstowcs(ListElement.title, RomFilename, 63);
 	Asciify(ListElement.title);
 	
-	ListElement.settings[0] = m_cacheList.Magic; //Plugin magic
-	ListElement.casecolor = m_cacheList.Color;
+	ListElement.settings[0] = Magic; //Plugin magic
+	ListElement.casecolor = Color;
 	ListElement.type = TYPE_PLUGIN;
-	m_cacheList.push_back(ListElement);
+	push_back(ListElement);
 }
 
 /* the [GameDomain] is used as the path even though it isn't the path */
 /* the [GameDomain] is usually short without any '/' */
 /* in scummvm.ini the path is the path without the exe or main app file added on */
-void ListGenerator::ParseScummvmINI(Config &ini, const char *Device, const char *datadir, const char *platform, const string& DBName, bool UpdateCache)
+/* scummvm.ini itself is only loaded when there is no usable cache */
+void ListGenerator::ParseScummvmINI(const char *iniPath, const char *Device, const char *datadir, const char *platform, const string& DBName, bool UpdateCache)
 {
 	Clear();
 	if(!DBName.empty())
@@ -332,6 +326,9 @@ void ListGenerator::ParseScummvmINI(Config &ini, const char *Device, const char
 	}
 	
 	gprintf("Parsing scummvm.ini\n");
+	Config ini;
+	ini.load(iniPath);
+	// should add error msg if loading scummvm fails or is not found
 	if(!ini.loaded())
 		return;
 
@@ -376,11 +373,12 @@ void ListGenerator::ParseScummvmINI(Config &ini, const char *Device, const char
 				GameID = searchID[0];
 		}
 		
+		dir_discHdr ListElement;
 		memset((void*)&ListElement, 0, sizeof(dir_discHdr));
 		memcpy(ListElement.id, GameID.c_str(), 6);
 
 		const char *gameTDB_Title = NULL;
-		if(gameTDB.IsLoaded() && m_cacheList.usePluginDBTitles)
+		if(gameTDB.IsLoaded() && usePluginDBTitles)
 		{
 			gameTDB.GetTitle(ListElement.id, gameTDB_Title, true);
 		}
@@ -392,13 +390,14 @@ void ListGenerator::ParseScummvmINI(Config &ini, const char *Device, const char
 		Asciify(ListElement.title);
 		strcpy(ListElement.path, GameDomain);
 
-		ListElement.settings[0] = m_cacheList.Magic; //scummvm magic
-		ListElement.casecolor = m_cacheList.Color;
+		ListElement.settings[0] = Magic; //scummvm magic
+		ListElement.casecolor = Color;
 		ListElement.type = TYPE_PLUGIN;
-		m_cacheList.push_back(ListElement);
+		push_back(ListElement);
 		GameDomain = ini.nextDomain().c_str();
 	}
 	m_crc.unload();
+	ini.unload();
   CloseConfigs();
 	if(!this->empty() && !DBName.empty()) /* Write a new Cache */
 		CCache(*this, DBName, SAVE);
@@ -421,11 +420,12 @@ void ListGenerator::CreateRomList(Config &platform_cfg, const string& romsDir, c
 		}
 	}
 	
+	magicWord = sfmt("%08x", Magic);
 	platformName = "";
 	if(platform_cfg.loaded())
 	{
 		/* Search platform.ini to find plugin magic to get platformName */
-		platformName = platform_cfg.getString("PLUGINS", m_plugin.PluginMagicWord);
+		platformName = platform_cfg.getString("PLUGINS", magicWord);
 		if(!platformName.empty())
 		{
 			/* check COMBINED for platform names that mean the same system just different region */
@@ -447,7 +447,7 @@ void ListGenerator::CreateRomList(Config &platform_cfg, const string& romsDir, c
 	}
 	CustomTitles.load(CustomTitlesPath.c_str());
 	CustomTitles.groupCustomTitles();
-	GetFiles(romsDir.c_str(), FileTypes, Add_Plugin_Game, false, 30);//wow 30 subfolders! really?
+	GetFiles(romsDir.c_str(), FileTypes, [this](char *FullPath) { Add_Plugin_Game(FullPath); }, false, 30);//wow 30 subfolders! really?
 	CloseConfigs();
 	romNamesDB.unload();
 	if(!this->empty() && !DBName.empty()) /* Write a new Cache */
@@ -476,7 +476,7 @@ void ListGenerator::CreateList(u32 Flow, const string& Path, const vector<string
 		if(DeviceHandle.GetFSType(Device) == PART_FS_WBFS)
 			Create_Wii_WBFS_List(DeviceHandle.GetWbfsHandle(Device));
 		else
-			GetFiles(Path.c_str(), FileTypes, Add_Wii_Game, false);
+			GetFiles(Path.c_str(), FileTypes, [this](char *FullPath) { Add_Wii_Game(FullPath); }, false);
 	}
 	else if(Flow == COVERFLOW_CHANNEL)
 	{
@@ -486,9 +486,9 @@ void ListGenerator::CreateList(u32 Flow, const string& Path, const vector<string
 	else if(DeviceHandle.GetFSType(Device) != PART_FS_WBFS)
 	{
 		if(Flow == COVERFLOW_GAMECUBE)
-			GetFiles(Path.c_str(), FileTypes, Add_GameCube_Game, true);// true means to look for a folder (/root)
+			GetFiles(Path.c_str(), FileTypes, [this](char *FullPath) { Add_GameCube_Game(FullPath); }, true);// true means to look for a folder (/root)
 		else if(Flow == COVERFLOW_HOMEBREW)
-			GetFiles(Path.c_str(), FileTypes, Add_Homebrew_Dol, false);
+			GetFiles(Path.c_str(), FileTypes, [this](char *FullPath) { Add_Homebrew_Dol(FullPath); }, false);
 	}
 	CloseConfigs();
 	if(!this->empty() && !DBName.empty()) /* Write a new Cache */
@@ -514,23 +514,21 @@ static inline bool IsFileSupported(const char *File, const vector<string>& FileT
 	return false;
 }
 
-const char *NewFileName = NULL;
-char *FullPathChar = NULL;
-dirent *pent = NULL;
-DIR *pdir = NULL;
-void GetFiles(const char *Path, const vector<string>& FileTypes, 
-				FileAdder AddFile, bool CompareFolders, u32 max_depth, u32 depth)
+/* FullPathChar is a MAX_MSG_SIZE buffer shared by the whole walk, the adders may change it */
+static void ScanFiles(const char *Path, const vector<string>& FileTypes, 
+				const FileAdder &AddFile, bool CompareFolders, u32 max_depth, u32 depth, char *FullPathChar)
 {
 	vector<string> SubPaths;
+	dirent *pent = NULL;
 
-	pdir = opendir(Path);
+	DIR *pdir = opendir(Path);
 	if(pdir == NULL)
 		return;
 	while((pent = readdir(pdir)) != NULL)
 	{
 		if(pent->d_name[0] == '.')
 			continue;
-		FullPathChar = fmt("%s/%s", Path, pent->d_name);
+		snprintf(FullPathChar, MAX_MSG_SIZE, "%s/%s", Path, pent->d_name);
 		if(pent->d_type == DT_DIR)
 		{
 			if(CompareFolders && IsFileSupported(pent->d_name, FileTypes))//if root folder for extracted gc games
@@ -552,10 +550,17 @@ void GetFiles(const char *Path, const vector<string>& FileTypes,
 	}
 	closedir(pdir);
 	for(vector<string>::const_iterator p = SubPaths.begin(); p != SubPaths.end(); ++p)
-		GetFiles(p->c_str(), FileTypes, AddFile, CompareFolders, max_depth, depth + 1);
+		ScanFiles(p->c_str(), FileTypes, AddFile, CompareFolders, max_depth, depth + 1, FullPathChar);
 	SubPaths.clear();
 }
 
+void GetFiles(const char *Path, const vector<string>& FileTypes, 
+				const FileAdder &AddFile, bool CompareFolders, u32 max_depth, u32 depth)
+{
+	vector<char> FullPathChar(MAX_MSG_SIZE);
+	ScanFiles(Path, FileTypes, AddFile, CompareFolders, max_depth, depth, &FullPathChar[0]);
+}
+
 /* create sourceflow list from current source_menu.ini */
 void ListGenerator::createSFList(u8 maxBtns, Config &m_sourceMenuCfg, const string& sourceDir)
 {
@@ -570,8 +575,9 @@ void ListGenerator::createSFList(u8 maxBtns, Config &m_sourceMenuCfg, const stri
 			continue;
 		const char *path = fmt("%s/%s", sourceDir.c_str(), m_sourceMenuCfg.getString(btn_selected, "image", "").c_str());
 		
+		dir_discHdr ListElement;
 		memset((void*)&ListElement, 0, sizeof(dir_discHdr));
-		ListElement.index = m_cacheList.size();
+		ListElement.index = size();
 		memcpy(ListElement.id, "SOURCE", 6);
 		strncpy(ListElement.path, path, sizeof(ListElement.path) - 1);
 		ListElement.casecolor = 0xFFFFFF;
@@ -583,6 +589,6 @@ void ListGenerator::createSFList(u8 maxBtns, Config &m_sourceMenuCfg, const stri
 		strncpy(SourceTitle, m_sourceMenuCfg.getString(btn_selected, "title", fmt("title_%i", i)).c_str(), 63);
 		mbstowcs(ListElement.title, SourceTitle, 63);
 		Asciify(ListElement.title);
-		m_cacheList.push_back(ListElement);
+		push_back(ListElement);
 	}
 }
@@ -17,6 +17,7 @@
 #ifndef _LISTGENERATOR_HPP_
 #define _LISTGENERATOR_HPP_
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <stdio.h>
@@ -28,18 +29,24 @@
 #include "loader/disc.h"
 #include "gui/GameTDB.hpp"
 #include "plugin/plugin.hpp"
+#include "FileNameMatcher.hpp"
 
 #define CONFIG_FILENAME_SKIP_DOMAIN	"PLUGINS"
 #define CONFIG_FILENAME_SKIP_KEY	"filename_skip_regex"
 #define CONFIG_FILENAME_SKIP_DEFAULT	"((dis[ck]|tape|side|track)[ _-]([b-l][^a-z]|0*[2-9]|0*[1-9][0-9]))|(^disc2[.]iso$)|(^neogeo[.]zip$)|(^funboot[.]rom$)|(^(ecs|exec|grom)[.]bin$)"
 
+/* the scan state of a list lives in its generator instead of globals, but
+   the plugin rom ids, the channel handle and the emu nand paths are still
+   shared and only m_cacheList is ever Init()ed, so lists are built one at
+   a time through m_cacheList */
 class ListGenerator : public std::vector<dir_discHdr>
 {
 public:
 	void createSFList(u8 maxBtns, Config &m_sourceMenuCfg, const string& sourceDir);
 	void Init(const char *settingsDir, const char *Language, const char *plgnsDataDir, const std::string& fileNameSkipPattern);
 	void Clear();
-	void ParseScummvmINI(Config &ini, const char *Device, const char *datadir, const char *platform, const string& DBName, bool UpdateCache);
+	std::vector<dir_discHdr> TakeList(void);
+	void ParseScummvmINI(const char *iniPath, const char *Device, const char *datadir, const char *platform, const string& DBName, bool UpdateCache);
 	void CreateRomList(Config &platform_cfg, const string& romsDir, const vector<string>& FileTypes, const string& DBName, bool UpdateCache);
 	void CreateList(u32 Flow, const string& Path, const vector<string>& FileTypes, const string& DBName, bool UpdateCache);
 	u32 Color;
@@ -48,14 +55,28 @@ public:
 private:
 	void OpenConfigs();
 	void CloseConfigs();
+	void AddISO(const char *GameID, const char *GameTitle, const char *GamePath, u32 GameColor, u8 Type);
+	void Create_Wii_WBFS_List(wbfs_t *handle);
+	void Create_Channel_List();
+	void Add_Wii_Game(char *FullPath);
+	void Add_GameCube_Game(char *FullPath);
+	void Add_Homebrew_Dol(char *FullPath);
+	void Add_Plugin_Game(char *FullPath);
 	string gameTDB_Path;
 	string CustomTitlesPath;
 	string gameTDB_Language;
+	string pluginsDataDir;
+	string platformName;
+	string magicWord;
+	Config CustomTitles;
+	Config romNamesDB;
+	GameTDB gameTDB;
+	FileNameMatcher fileNameSkip;
 };
 
-typedef void (*FileAdder)(char *Path);
+typedef std::function<void (char *Path)> FileAdder;
 void GetFiles(const char *Path, const std::vector<string>& FileTypes, 
-			FileAdder AddFile, bool CompareFolders, u32 max_depth = 2, u32 depth = 1);
+			const FileAdder &AddFile, bool CompareFolders, u32 max_depth = 2, u32 depth = 1);
 extern ListGenerator m_cacheList;
 
 #endif /*_LISTGENERATOR_HPP_*/
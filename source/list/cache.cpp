@@ -28,10 +28,10 @@ CCache::~CCache()
 	cache = NULL;
 }
 
-void CCache::SaveAll(vector<dir_discHdr> list)
+void CCache::SaveAll(const vector<dir_discHdr> &list)
 {
 	//gprintf("Updating DB: %s\n", filename.c_str());
-	if(!cache) return;
+	if(!cache || list.empty()) return;
 	fwrite((void *)&list[0], 1, list.size() * sizeof(dir_discHdr), cache);
 }
 
@@ -41,20 +41,16 @@ void CCache::LoadAll(vector<dir_discHdr> &list)
 
 	//gprintf("Loading DB: %s\n", filename.c_str());
 
-	dir_discHdr tmp;
 	fseek(cache, 0, SEEK_END);
 	u64 fileSize = ftell(cache);
 	fseek(cache, 0, SEEK_SET);
 
 	u32 count = (u32)(fileSize / sizeof(dir_discHdr));
-	
-	list.reserve(count + list.size());
-	for(u32 i = 0; i < count; i++)
-	{
-		//gprintf("Fetching Item number %u in DB: %s\n", index, filename.c_str());
-		fseek(cache, i * sizeof(dir_discHdr), SEEK_SET);
-		fread((void *)&tmp, 1, sizeof(dir_discHdr), cache);
-		//gprintf("Path %s\n", tmp.path);
-		list.push_back(tmp);
-	}
+	if(count == 0) return;
+
+	/* the db is a flat array of headers, read it straight into the list */
+	u32 start = list.size();
+	list.resize(start + count);
+	u32 read = fread((void *)&list[start], sizeof(dir_discHdr), count, cache);
+	list.resize(start + read);
 }
@@ -28,7 +28,7 @@ class CCache
 		 CCache(vector<dir_discHdr> &list, string path, CMode mode);
 		~CCache();
 	private:
-		void SaveAll(vector<dir_discHdr> list);
+		void SaveAll(const vector<dir_discHdr> &list);
 		void LoadAll(vector<dir_discHdr> &list);
 
 		FILE *cache;
@@ -71,6 +71,8 @@ struct gc_discHdr
 	u8 unused2[64];
 } ATTRIBUTE_PACKED;
 
+/* one flat entry per game. the list .db caches are raw dumps of this and
+   the views write path and title in place, so it isn't split up */
 struct dir_discHdr
 {
 	char id[7]; //6+1 for null character
@@ -59,6 +59,8 @@ int load_wip_patches(u8 *dir, u8 *gameid)
 		if(!tmp)
 		{
 			free(CodeList);
+			CodeList = NULL;
+			CodesCount = 0;
 			fclose(fp);
 			return -1;
 		}
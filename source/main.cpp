@@ -21,6 +21,7 @@
 #include "loader/nk.h"
 #include "menu/menu.hpp"
 #include "memory/memory.h"
+#include "memory/scratch.hpp"
 
 bool isWiiVC = false;
 bool useMainIOS = true;
@@ -31,6 +32,7 @@ volatile bool networkInit = false;
 int main(int argc, char **argv)
 {
 	MEM_init(); //Inits both mem1lo and mem2
+	ScratchArena::Get(SCRATCH_MAIN).Bind();
 	mainIOS = DOL_MAIN_IOS;// 249
 	__exception_setreload(10);
 	Gecko_Init(); //USB Gecko and SD/WiFi buffer
@@ -6,6 +6,7 @@
 
 #include "mem2.hpp"
 #include "mem_manager.hpp"
+#include "mem_trace.hpp"
 #include "gecko/gecko.hpp"
 #include "loader/utils.h"
 
@@ -41,6 +42,57 @@ extern __typeof(memalign) __real_memalign;
 extern __typeof(free) __real_free;
 extern __typeof(malloc_usable_size) __real_malloc_usable_size;
 
+#ifdef MEM_TRACE
+static u8 poolOf(void *p)
+{
+	if((u8*)p >= MEM1_lo_start && (u8*)p < MEM1_lo_end)
+		return MEM_POOL_MEM1_LO;
+	if(((u32)p & 0x10000000) == 0)
+		return MEM_POOL_MEM1;
+	return (u8*)p >= MEM2_start ? MEM_POOL_MEM2 : MEM_POOL_MEM2_LO;
+}
+
+static u32 poolBlockSize(u8 pool, void *p)
+{
+	switch(pool)
+	{
+		case MEM_POOL_MEM1_LO:
+			return g_mem1lo.MemBlockSize(p);
+		case MEM_POOL_MEM2_LO:
+			return g_mem2lo.MemBlockSize(p);
+		case MEM_POOL_MEM2:
+			return g_mem2gp.MemBlockSize(p);
+		default:
+			return __real_malloc_usable_size(p);
+	}
+}
+
+static inline void *traceAlloc(void *p, void *site)
+{
+	if(p != NULL)
+	{
+		u8 pool = poolOf(p);
+		MEM_trace_alloc(pool, p, poolBlockSize(pool, p), site);
+	}
+	return p;
+}
+
+static inline void traceFree(void *p)
+{
+	if(p != NULL)
+	{
+		u8 pool = poolOf(p);
+		MEM_trace_free(pool, p, poolBlockSize(pool, p));
+	}
+}
+
+#define TRACE_ALLOC(p)		traceAlloc(p, __builtin_return_address(0))
+#define TRACE_FREE(p)		traceFree(p)
+#else
+#define TRACE_ALLOC(p)		(p)
+#define TRACE_FREE(p)
+#endif
+
 void MEM_init()
 {
 	g_mem1lo.Init(MEM1_lo_start, MEM1_lo_list, (u32)(MEM1_lo_end-MEM1_lo_start)); //about 6mb
@@ -55,13 +107,14 @@ void MEM_init()
 
 void *MEM1_lo_alloc(unsigned int s)
 {
-	return g_mem1lo.Alloc(s);
+	return TRACE_ALLOC(g_mem1lo.Alloc(s));
 }
 
 void MEM1_lo_free(void *p)
 {
 	if(!p)
 		return;
+	TRACE_FREE(p);
 	g_mem1lo.Free(p);
 }
 
@@ -70,26 +123,40 @@ unsigned int MEM1_lo_freesize()
 	return g_mem1lo.FreeSize();
 }
 
+unsigned int MEM1_lo_largestfree()
+{
+	return g_mem1lo.LargestFreeSize();
+}
+
 
 void *MEM1_alloc(unsigned int s)
 {
-	return __real_malloc(s);
+	return TRACE_ALLOC(__real_malloc(s));
 }
 
 void *MEM1_memalign(unsigned int a, unsigned int s)
 {
-	return __real_memalign(a, s);
+	return TRACE_ALLOC(__real_memalign(a, s));
 }
 
 void *MEM1_realloc(void *p, unsigned int s)
 {
+#ifdef MEM_TRACE
+	u32 oldSize = p ? __real_malloc_usable_size(p) : 0;
+	void *n = __real_realloc(p, s);
+	if(n != NULL && p != NULL)
+		MEM_trace_free(MEM_POOL_MEM1, p, oldSize);
+	return TRACE_ALLOC(n);
+#else
 	return __real_realloc(p, s);
+#endif
 }
 
 void MEM1_free(void *p)
 {
 	if(!p)
 		return;
+	TRACE_FREE(p);
 	__real_free(p);
 }
 
@@ -103,12 +170,28 @@ void MEM2_lo_free(void *p)
 {
 	if(!p)
 		return;
+	TRACE_FREE(p);
 	g_mem2lo.Free(p);
 }
 
 void *MEM2_lo_alloc(unsigned int s)
 {
-	return g_mem2lo.Alloc(s);
+	return TRACE_ALLOC(g_mem2lo.Alloc(s));
+}
+
+unsigned int MEM2_lo_freesize()
+{
+	return g_mem2lo.FreeSize();
+}
+
+unsigned int MEM2_lo_largestfree()
+{
+	return g_mem2lo.LargestFreeSize();
+}
+
+int MEM2_lo_contains(const void *p)
+{
+	return (u8*)p >= MEM2_lo_start && (u8*)p < MEM2_lo_end;
 }
 
 
@@ -116,23 +199,32 @@ void MEM2_free(void *p)
 {
 	if(!p)
 		return;
+	TRACE_FREE(p);
 	g_mem2gp.Free(p);
 }
 
 void *MEM2_alloc(unsigned int s)
 {
-	return g_mem2gp.Alloc(s);
+	return TRACE_ALLOC(g_mem2gp.Alloc(s));
 }
 
 /* Placeholder, will be needed with new memory manager */
 void *MEM2_memalign(unsigned int /* alignment */, unsigned int s)
 {
-	return g_mem2gp.Alloc(s);
+	return TRACE_ALLOC(g_mem2gp.Alloc(s));
 }
 
 void *MEM2_realloc(void *p, unsigned int s)
 {
+#ifdef MEM_TRACE
+	u32 oldSize = p ? g_mem2gp.MemBlockSize(p) : 0;
+	void *n = g_mem2gp.ReAlloc(p, s);
+	if(p != NULL && (n != NULL || s == 0))
+		MEM_trace_free(MEM_POOL_MEM2, p, oldSize);
+	return TRACE_ALLOC(n);
+#else
 	return g_mem2gp.ReAlloc(p, s);
+#endif
 }
 
 unsigned int MEM2_usableSize(void *p)
@@ -145,9 +237,14 @@ unsigned int MEM2_freesize()
 	return g_mem2gp.FreeSize();
 }
 
+unsigned int MEM2_largestfree()
+{
+	return g_mem2gp.LargestFreeSize();
+}
+
 // these wrap's are used when malloc, calloc, memalign, free are called in wiiflow.
 // they decide based on if the size >= mem2_prio_size (4k) to use mem2 or mem1. using the __real means to use mem1 because MALLOC_MEM2 = 0.
-void *__wrap_malloc(size_t size)
+static inline void *mem_malloc(size_t size)
 {
 	void *p;
 	if(size >= MEM2_PRIORITY_SIZE)
@@ -163,7 +260,12 @@ void *__wrap_malloc(size_t size)
 	return g_mem2gp.Alloc(size);
 }
 
-void *__wrap_calloc(size_t n, size_t size)
+void *__wrap_malloc(size_t size)
+{
+	return TRACE_ALLOC(mem_malloc(size));
+}
+
+static inline void *mem_calloc(size_t n, size_t size)
 {
 	void *p;
 	if((n * size) >= MEM2_PRIORITY_SIZE)
@@ -186,7 +288,12 @@ void *__wrap_calloc(size_t n, size_t size)
 	return p;
 }
 
-void *__wrap_memalign(size_t a, size_t size)
+void *__wrap_calloc(size_t n, size_t size)
+{
+	return TRACE_ALLOC(mem_calloc(n, size));
+}
+
+static inline void *mem_memalign(size_t a, size_t size)
 {
 	void *p;
 	if(size >= MEM2_PRIORITY_SIZE)
@@ -206,11 +313,17 @@ void *__wrap_memalign(size_t a, size_t size)
 	return g_mem2gp.Alloc(size);
 }
 
+void *__wrap_memalign(size_t a, size_t size)
+{
+	return TRACE_ALLOC(mem_memalign(a, size));
+}
+
 void __wrap_free(void *p)
 {
 	if(!p)
 		return;
 
+	TRACE_FREE(p);
 	if(((u32)p & 0x10000000) != 0)
 	{
 		if(p > MEM2_start)
@@ -219,10 +332,10 @@ void __wrap_free(void *p)
 			g_mem2lo.Free(p);
 	}
 	else
-		MEM1_free(p);
+		__real_free(p);
 }
 
-void *__wrap_realloc(void *p, size_t size)
+static inline void *mem_realloc(void *p, size_t size)
 {
 	void *n;
 	// ptr from mem2
@@ -256,6 +369,20 @@ void *__wrap_realloc(void *p, size_t size)
 	return n;
 }
 
+void *__wrap_realloc(void *p, size_t size)
+{
+#ifdef MEM_TRACE
+	u8 oldPool = p ? poolOf(p) : MEM_POOL_MEM1;
+	u32 oldSize = p ? poolBlockSize(oldPool, p) : 0;
+	void *n = mem_realloc(p, size);
+	if(p != NULL && (n != NULL || size == 0))
+		MEM_trace_free(oldPool, p, oldSize);
+	return TRACE_ALLOC(n);
+#else
+	return mem_realloc(p, size);
+#endif
+}
+
 size_t __wrap_malloc_usable_size(void *p)
 {
 	if(((u32)p & 0x10000000) != 0)
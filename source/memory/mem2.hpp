@@ -12,6 +12,7 @@ void MEM_init();
 void *MEM1_lo_alloc(unsigned int s);
 void MEM1_lo_free(void *p);
 unsigned int MEM1_lo_freesize();
+unsigned int MEM1_lo_largestfree();
 
 void *MEM1_alloc(unsigned int s);
 void *MEM1_memalign(unsigned int a, unsigned int s);
@@ -21,6 +22,9 @@ unsigned int MEM1_freesize();
 
 void MEM2_lo_free(void *p);
 void *MEM2_lo_alloc(unsigned int s);
+unsigned int MEM2_lo_freesize();
+unsigned int MEM2_lo_largestfree();
+int MEM2_lo_contains(const void *p);
 
 void MEM2_free(void *p);
 void *MEM2_alloc(unsigned int s);
@@ -28,6 +32,7 @@ void *MEM2_memalign(unsigned int /* alignment */, unsigned int s);
 void *MEM2_realloc(void *p, unsigned int s);
 unsigned int MEM2_usableSize(void *p);
 unsigned int MEM2_freesize();
+unsigned int MEM2_largestfree();
 
 #ifdef __cplusplus
 }
@@ -16,11 +16,73 @@
  ****************************************************************************/
 #include <string.h>
 #include <algorithm>
+#include <ogc/cache.h>
 #include "mem_manager.hpp"
 #include "gecko/gecko.hpp"
 #include "loader/utils.h"
 
 static const u32 MEM_BLOCK_SIZE = 0x80;// 128
+static const u32 MEM_NO_BLOCK = 0xFFFFFFFF;
+
+/* block map tags, written to the first and last block of every extent */
+static const u8 TAG_USED = 0x80;
+static const u8 TAG_LONG = 0x40;// length >= 64, stored in the 3 bytes after the head and before the tail
+static const u8 TAG_LEN_MASK = 0x3F;
+static const u32 TAG_SHORT_MAX = 0x3F;
+/* slab blocks are tagged TAG_LONG | (block offset in slab + 1), a free long extent is TAG_LONG alone */
+
+static const u32 MEM_SLAB_BLOCKS = 16;// 2k per slab
+static const u32 MEM_SLAB_SIZES[MEM_SLAB_CLASSES] = { 32, 64 };
+
+/* free extents start with their list links */
+typedef struct
+{
+	u32 prev;
+	u32 next;
+} MemFreeNode;
+
+/* first object slot of every slab */
+typedef struct
+{
+	u32 prev;
+	u32 next;
+	u32 freeList;// offset of the first free object, 0 if full
+	u16 used;
+	u16 objSize;
+} MemSlab;
+
+static inline bool tagIsFree(u8 tag)
+{
+	return (tag & TAG_USED) == 0 && (tag == TAG_LONG || (tag & TAG_LONG) == 0);
+}
+
+static inline bool tagIsSlab(u8 tag)
+{
+	return (tag & (TAG_USED | TAG_LONG)) == TAG_LONG && (tag & TAG_LEN_MASK) != 0;
+}
+
+static inline u32 fls32(u32 v)
+{
+	return 31 - __builtin_clz(v);
+}
+
+/* size class holding extents of len blocks */
+static inline u32 sizeClass(u32 len)
+{
+	if(len < MEM_SL_COUNT)
+		return len;
+	u32 fl = fls32(len);
+	u32 sl = (len >> (fl - MEM_SL_BITS)) & (MEM_SL_COUNT - 1);
+	return MEM_SL_COUNT + (fl - MEM_SL_BITS) * MEM_SL_COUNT + sl;
+}
+
+/* first size class where every extent is at least len blocks */
+static inline u32 searchClass(u32 len)
+{
+	if(len >= MEM_SL_COUNT)
+		len += (1 << (fls32(len) - MEM_SL_BITS)) - 1;
+	return sizeClass(len);
+}
 
 MemManager::MemManager()
 {
@@ -28,6 +90,8 @@ MemManager::MemManager()
 	memList = NULL;
 	memListEnd = NULL;
 	memSize = 0;
+	freeBlocks = 0;
+	_resetFreeLists();
 	LWP_MutexInit(&memMutex, 0);
 }
 
@@ -45,8 +109,11 @@ void MemManager::Init(u8 *start, u8 *list, u32 size)
 	memList = list;
 	memSize = ALIGN(MEM_BLOCK_SIZE, size) / MEM_BLOCK_SIZE;
 	memListEnd = list + memSize;
-	memset(memList, MEM_FREE , memSize);
-	memset(memListEnd, MEM_END, 1); //thats the +1
+	*memListEnd = TAG_USED | 1; //thats the +1, never merged with
+
+	_resetFreeLists();
+	_setExtent(0, memSize, false);
+	_insertFree(0, memSize);
 
 	LWP_MutexUnlock(memMutex);
 }
@@ -59,80 +126,311 @@ void MemManager::ClearMem()
 	u32 MemFull = memSize * MEM_BLOCK_SIZE;
 	memset(startAddr, 0, MemFull);
 
+	/* the free list links live in the free memory, rebuild them */
+	_resetFreeLists();
+	for(u32 block = 0; block < memSize; )
+	{
+		u8 tag = memList[block];
+		if(tagIsSlab(tag))
+		{
+			block += MEM_SLAB_BLOCKS;
+			continue;
+		}
+		u32 len = _extentLen(block);
+		if(tagIsFree(tag))
+			_insertFree(block, len);
+		block += len;
+	}
+
 	LWP_MutexUnlock(memMutex);
 }
 
-void *MemManager::Alloc(u32 size)
+u32 MemManager::_extentLen(u32 block)
 {
-	size = ALIGN(MEM_BLOCK_SIZE, size) / MEM_BLOCK_SIZE;
-	if(size > memSize)
-		return NULL;
+	u8 tag = memList[block];
+	if(tag & TAG_LONG)
+		return (memList[block + 1] << 16) | (memList[block + 2] << 8) | memList[block + 3];
+	return tag & TAG_LEN_MASK;
+}
 
-	LWP_MutexLock(memMutex);
+u32 MemManager::_tailLen(u32 block)
+{
+	u8 tag = memList[block];
+	if(tag & TAG_LONG)
+		return (memList[block - 3] << 16) | (memList[block - 2] << 8) | memList[block - 1];
+	return tag & TAG_LEN_MASK;
+}
 
-	vu8 *tmp_block;
-	u32 blocksFree;
-	for(vu8 *block = memList; block < memListEnd; block++)
+void MemManager::_setExtent(u32 block, u32 len, bool used)
+{
+	u8 state = used ? TAG_USED : 0;
+	u32 end = block + len - 1;
+	if(len <= TAG_SHORT_MAX)
+	{
+		memList[block] = state | len;
+		memList[end] = state | len;
+		return;
+	}
+	memList[block] = state | TAG_LONG;
+	memList[block + 1] = memList[end - 3] = (len >> 16) & 0xFF;
+	memList[block + 2] = memList[end - 2] = (len >> 8) & 0xFF;
+	memList[block + 3] = memList[end - 1] = len & 0xFF;
+	memList[end] = state | TAG_LONG;
+}
+
+void MemManager::_resetFreeLists()
+{
+	freeBlocks = 0;
+	for(u32 i = 0; i < MEM_FREE_LISTS; ++i)
+		freeHeads[i] = MEM_NO_BLOCK;
+	memset(freeBitmap, 0, sizeof(freeBitmap));
+	for(u32 i = 0; i < MEM_SLAB_CLASSES; ++i)
+		slabHeads[i] = MEM_NO_BLOCK;
+}
+
+void MemManager::_insertFree(u32 block, u32 len)
+{
+	u32 fc = sizeClass(len);
+	MemFreeNode *node = (MemFreeNode *)(startAddr + block * MEM_BLOCK_SIZE);
+	node->prev = MEM_NO_BLOCK;
+	node->next = freeHeads[fc];
+	if(node->next != MEM_NO_BLOCK)
+		((MemFreeNode *)(startAddr + node->next * MEM_BLOCK_SIZE))->prev = block;
+	freeHeads[fc] = block;
+	freeBitmap[fc >> 5] |= 1u << (fc & 31);
+	freeBlocks += len;
+}
+
+void MemManager::_removeFree(u32 block, u32 len)
+{
+	u32 fc = sizeClass(len);
+	MemFreeNode *node = (MemFreeNode *)(startAddr + block * MEM_BLOCK_SIZE);
+	if(node->prev != MEM_NO_BLOCK)
+		((MemFreeNode *)(startAddr + node->prev * MEM_BLOCK_SIZE))->next = node->next;
+	else
+		freeHeads[fc] = node->next;
+	if(node->next != MEM_NO_BLOCK)
+		((MemFreeNode *)(startAddr + node->next * MEM_BLOCK_SIZE))->prev = node->prev;
+	if(freeHeads[fc] == MEM_NO_BLOCK)
+		freeBitmap[fc >> 5] &= ~(1u << (fc & 31));
+	freeBlocks -= len;
+}
+
+u32 MemManager::_allocBlocks(u32 len)
+{
+	if(len == 0 || len > memSize)
+		return MEM_NO_BLOCK;
+
+	/* an extent of the exact class may already be big enough */
+	u32 block = freeHeads[sizeClass(len)];
+	if(block == MEM_NO_BLOCK || _extentLen(block) < len)
 	{
-		for( ; *block & (ALLOC_USED | ALLOC_END); block++) ;
-		blocksFree = 0;
-		for(tmp_block = block; *tmp_block == MEM_FREE; tmp_block++)
+		block = MEM_NO_BLOCK;
+		u32 fc = searchClass(len);
+		for(u32 word = fc >> 5; word < MEM_FREE_LISTS / 32; ++word)
 		{
-			blocksFree++;
-			if(blocksFree == size)
+			u32 bits = freeBitmap[word];
+			if(word == (fc >> 5))
+				bits &= ~0u << (fc & 31);
+			if(bits != 0)
 			{
-				u8 *addr = (u8*)block;
-				memset(addr, ALLOC_USED, blocksFree - 1); //start blocks
-				memset(addr + blocksFree - 1, ALLOC_END, 1); //end block
-				void *ptr = (void*)(startAddr + ((addr - memList)*MEM_BLOCK_SIZE));
-				//gprintf("Alloc %x mem, %i blocks\n", ptr, blocksFree);
-				LWP_MutexUnlock(memMutex);
-				return ptr;
+				block = freeHeads[(word << 5) + __builtin_ctz(bits)];
+				break;
 			}
 		}
-		block = tmp_block;
+		if(block == MEM_NO_BLOCK)
+			return MEM_NO_BLOCK;
 	}
-	LWP_MutexUnlock(memMutex);
-	return NULL;
+
+	u32 extLen = _extentLen(block);
+	_removeFree(block, extLen);
+	_setExtent(block, len, true);
+	if(extLen > len)
+	{
+		_setExtent(block + len, extLen - len, false);
+		_insertFree(block + len, extLen - len);
+	}
+	return block;
 }
 
-void MemManager::Free(void *mem)
+void MemManager::_freeBlocks(u32 block)
+{
+	u32 len = _extentLen(block);
+
+	u32 next = block + len;
+	if(next < memSize && tagIsFree(memList[next]))
+	{
+		u32 nextLen = _extentLen(next);
+		_removeFree(next, nextLen);
+		len += nextLen;
+	}
+	if(block > 0 && tagIsFree(memList[block - 1]))
+	{
+		u32 prevLen = _tailLen(block - 1);
+		block -= prevLen;
+		_removeFree(block, prevLen);
+		len += prevLen;
+	}
+	_setExtent(block, len, false);
+	_insertFree(block, len);
+}
+
+void MemManager::_shrinkBlocks(u32 block, u32 len, u32 newLen)
 {
-	vu8 *blockUsed = memList+(((u8*)mem-startAddr) / MEM_BLOCK_SIZE);
-	if(blockUsed < memList || blockUsed >= memListEnd || *blockUsed == 0)
+	if(newLen >= len)
 		return;
+	_setExtent(block, newLen, true);
+	_setExtent(block + newLen, len - newLen, true);
+	_freeBlocks(block + newLen);
+}
 
-	LWP_MutexLock(memMutex);
+void *MemManager::_slabAlloc(u32 slabClass)
+{
+	u32 objSize = MEM_SLAB_SIZES[slabClass];
+	u32 block = slabHeads[slabClass];
+	MemSlab *slab;
+	if(block == MEM_NO_BLOCK)
+	{
+		block = _allocBlocks(MEM_SLAB_BLOCKS);
+		if(block == MEM_NO_BLOCK)
+			return NULL;
+		for(u32 i = 0; i < MEM_SLAB_BLOCKS; ++i)
+			memList[block + i] = TAG_LONG | (i + 1);
+
+		u8 *base = startAddr + block * MEM_BLOCK_SIZE;
+		slab = (MemSlab *)base;
+		slab->prev = MEM_NO_BLOCK;
+		slab->next = MEM_NO_BLOCK;
+		slab->used = 0;
+		slab->objSize = objSize;
+		/* slot 0 holds the slab header */
+		u32 slabBytes = MEM_SLAB_BLOCKS * MEM_BLOCK_SIZE;
+		for(u32 off = objSize; off < slabBytes; off += objSize)
+			*(u32 *)(base + off) = off + objSize < slabBytes ? off + objSize : 0;
+		slab->freeList = objSize;
+		DCFlushRange(base, slabBytes);
+		slabHeads[slabClass] = block;
+	}
+	u8 *base = startAddr + block * MEM_BLOCK_SIZE;
+	slab = (MemSlab *)base;
 
-	//gprintf("Free %x mem, %x block\n", mem, blockUsed);
+	u8 *obj = base + slab->freeList;
+	slab->freeList = *(u32 *)obj;
+	slab->used++;
+	if(slab->freeList == 0)
+	{
+		/* full, drop it from the partial list */
+		slabHeads[slabClass] = slab->next;
+		if(slab->next != MEM_NO_BLOCK)
+			((MemSlab *)(startAddr + slab->next * MEM_BLOCK_SIZE))->prev = MEM_NO_BLOCK;
+		slab->next = MEM_NO_BLOCK;
+	}
+	/* don't leave our link dirty in the cache, the caller may DMA into the object */
+	DCFlushRange(obj, 32);
+	return obj;
+}
 
-	u32 size = 0;
-	vu8 *tmp_block = blockUsed;
-	for( ; *tmp_block == ALLOC_USED; tmp_block++)
-		size++;
-	if(*tmp_block == ALLOC_END)
-		size++;
+void MemManager::_slabFree(u32 block, u8 *mem)
+{
+	block -= (memList[block] & TAG_LEN_MASK) - 1;
+	u8 *base = startAddr + block * MEM_BLOCK_SIZE;
+	MemSlab *slab = (MemSlab *)base;
+	u32 off = mem - base;
+	if(off == 0 || off % slab->objSize != 0)
+		return;
+
+	u32 slabClass = slab->objSize == MEM_SLAB_SIZES[0] ? 0 : 1;
+	bool wasFull = slab->freeList == 0;
+	*(u32 *)mem = slab->freeList;
+	slab->freeList = off;
+	slab->used--;
+
+	if(wasFull)
+	{
+		slab->prev = MEM_NO_BLOCK;
+		slab->next = slabHeads[slabClass];
+		if(slab->next != MEM_NO_BLOCK)
+			((MemSlab *)(startAddr + slab->next * MEM_BLOCK_SIZE))->prev = block;
+		slabHeads[slabClass] = block;
+	}
+	if(slab->used == 0)
+	{
+		/* empty, give the blocks back */
+		if(slab->prev != MEM_NO_BLOCK)
+			((MemSlab *)(startAddr + slab->prev * MEM_BLOCK_SIZE))->next = slab->next;
+		else
+			slabHeads[slabClass] = slab->next;
+		if(slab->next != MEM_NO_BLOCK)
+			((MemSlab *)(startAddr + slab->next * MEM_BLOCK_SIZE))->prev = slab->prev;
+		_setExtent(block, MEM_SLAB_BLOCKS, true);
+		_freeBlocks(block);
+	}
+}
 
-	u8 *addr = (u8*)blockUsed;
-	memset(addr, MEM_FREE, size);
+void *MemManager::_alloc(u32 size)
+{
+	if(size == 0)
+		return NULL;
+	for(u32 i = 0; i < MEM_SLAB_CLASSES; ++i)
+	{
+		if(size <= MEM_SLAB_SIZES[i])
+			return _slabAlloc(i);
+	}
+
+	u32 block = _allocBlocks(ALIGN(MEM_BLOCK_SIZE, size) / MEM_BLOCK_SIZE);
+	if(block == MEM_NO_BLOCK)
+		return NULL;
+	void *ptr = (void*)(startAddr + block * MEM_BLOCK_SIZE);
+	//gprintf("Alloc %x mem, %i blocks\n", ptr, ALIGN(MEM_BLOCK_SIZE, size) / MEM_BLOCK_SIZE);
+	DCFlushRange(ptr, 32);
+	return ptr;
+}
+
+void MemManager::_free(void *mem)
+{
+	if((u8*)mem < startAddr || (u8*)mem >= startAddr + memSize * MEM_BLOCK_SIZE)
+		return;
+	u32 offset = (u8*)mem - startAddr;
+	u32 block = offset / MEM_BLOCK_SIZE;
+	u8 tag = memList[block];
+
+	//gprintf("Free %x mem, %x block\n", mem, block);
+
+	if(tagIsSlab(tag))
+		_slabFree(block, (u8*)mem);
+	else if((tag & TAG_USED) && (offset % MEM_BLOCK_SIZE) == 0)
+		_freeBlocks(block);
+}
+
+void *MemManager::Alloc(u32 size)
+{
+	LWP_MutexLock(memMutex);
+	void *ptr = _alloc(size);
+	LWP_MutexUnlock(memMutex);
+	return ptr;
+}
 
+void MemManager::Free(void *mem)
+{
+	LWP_MutexLock(memMutex);
+	_free(mem);
 	LWP_MutexUnlock(memMutex);
 }
 
 u32 MemManager::MemBlockSize(void *mem)
 {
-	vu8 *blockUsed = memList+(((u8*)mem-startAddr) / MEM_BLOCK_SIZE);
-	if(blockUsed < memList || blockUsed >= memListEnd || *blockUsed == 0)
+	if((u8*)mem < startAddr || (u8*)mem >= startAddr + memSize * MEM_BLOCK_SIZE)
 		return 0;
+	u32 block = ((u8*)mem - startAddr) / MEM_BLOCK_SIZE;
 
 	LWP_MutexLock(memMutex);
 
 	u32 size = 0;
-	for( ; *blockUsed == ALLOC_USED; blockUsed++)
-		size++;
-	if(*blockUsed == ALLOC_END)
-		size++;
-	size *= MEM_BLOCK_SIZE;
+	u8 tag = memList[block];
+	if(tagIsSlab(tag))
+		size = ((MemSlab *)(startAddr + (block - (tag & TAG_LEN_MASK) + 1) * MEM_BLOCK_SIZE))->objSize;
+	else if(tag & TAG_USED)
+		size = _extentLen(block) * MEM_BLOCK_SIZE;
 
 	LWP_MutexUnlock(memMutex);
 
@@ -140,41 +438,92 @@ u32 MemManager::MemBlockSize(void *mem)
 }
 
 u32 MemManager::FreeSize()
+{
+	return freeBlocks * MEM_BLOCK_SIZE;
+}
+
+u32 MemManager::LargestFreeSize()
 {
 	LWP_MutexLock(memMutex);
 
-	u32 free = 0;
-	for(vu8 *block = memList; block < memListEnd; block++)
+	/* the largest extent sits in the highest non-empty size class */
+	u32 largest = 0;
+	for(int word = MEM_FREE_LISTS / 32 - 1; word >= 0 && largest == 0; --word)
 	{
-		for( ; *block == MEM_FREE; block++)
-			free++;
+		if(freeBitmap[word] == 0)
+			continue;
+		u32 fc = (word << 5) + fls32(freeBitmap[word]);
+		for(u32 block = freeHeads[fc]; block != MEM_NO_BLOCK; block = ((MemFreeNode *)(startAddr + block * MEM_BLOCK_SIZE))->next)
+			largest = std::max(largest, _extentLen(block));
 	}
-	free *= MEM_BLOCK_SIZE;
 
 	LWP_MutexUnlock(memMutex);
 
-	return free;
+	return largest * MEM_BLOCK_SIZE;
 }
 
 void *MemManager::ReAlloc(void *mem, u32 size)
 {
 	if(mem == NULL)
 		return Alloc(size);
-
-	//gprintf("Realloc %x, %i\n", mem, size);
-	void *new_m = Alloc(size);
-	if(new_m == NULL)
+	if(size == 0)
 	{
 		Free(mem);
 		return NULL;
 	}
-	const u32 copysize = std::min(MemBlockSize(mem), size);
+
+	//gprintf("Realloc %x, %i\n", mem, size);
+	if((u8*)mem < startAddr || (u8*)mem >= startAddr + memSize * MEM_BLOCK_SIZE)
+		return Alloc(size);
 
 	LWP_MutexLock(memMutex);
-	memcpy(new_m, mem, copysize);
-	LWP_MutexUnlock(memMutex);
 
-	Free(mem);
+	u32 block = ((u8*)mem - startAddr) / MEM_BLOCK_SIZE;
+	u8 tag = memList[block];
+	u32 oldSize;
+	if(tagIsSlab(tag))
+	{
+		oldSize = ((MemSlab *)(startAddr + (block - (tag & TAG_LEN_MASK) + 1) * MEM_BLOCK_SIZE))->objSize;
+		if(size <= oldSize)
+		{
+			LWP_MutexUnlock(memMutex);
+			return mem;
+		}
+	}
+	else
+	{
+		u32 len = _extentLen(block);
+		u32 newLen = ALIGN(MEM_BLOCK_SIZE, size) / MEM_BLOCK_SIZE;
+		oldSize = len * MEM_BLOCK_SIZE;
+		if(newLen > len)
+		{
+			/* grow in place into the following free extent */
+			u32 next = block + len;
+			if(next < memSize && tagIsFree(memList[next]) && len + _extentLen(next) >= newLen)
+			{
+				u32 nextLen = _extentLen(next);
+				_removeFree(next, nextLen);
+				len += nextLen;
+				_setExtent(block, len, true);
+			}
+		}
+		if(newLen <= len)
+		{
+			_shrinkBlocks(block, len, newLen);
+			LWP_MutexUnlock(memMutex);
+			return mem;
+		}
+	}
+
+	/* keep the old memory if we are out of space, like realloc does */
+	void *new_m = _alloc(size);
+	if(new_m != NULL)
+	{
+		memcpy(new_m, mem, std::min(oldSize, size));
+		_free(mem);
+	}
+
+	LWP_MutexUnlock(memMutex);
 
 	return new_m;
 }
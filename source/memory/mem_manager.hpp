@@ -20,14 +20,17 @@
 #include <ogcsys.h>
 #include <ogc/mutex.h>
 
-enum mem_states
-{
-	MEM_FREE = (1<<0),//1
-	ALLOC_USED = (1<<1),//2
-	ALLOC_END = (1<<2),//4
-	MEM_END = (1<<3),//8
-};
+#define MEM_SL_BITS			3
+#define MEM_SL_COUNT		(1 << MEM_SL_BITS)
+#define MEM_FREE_LISTS		160	// size classes for extents of up to 2^20 blocks
+#define MEM_SLAB_CLASSES	2	// 32 and 64 byte objects
 
+/*
+ * Segregated fit allocator over a block map with one byte per 128 byte block.
+ * Every extent has a tag at its first and last block holding its state and
+ * length, free extents are kept in size class lists linked through the free
+ * memory itself. Small objects are served from slabs of one size class.
+ */
 class MemManager {
 public:
 	MemManager();
@@ -38,13 +41,32 @@ public:
 	void Free(void *mem);
 	u32 MemBlockSize(void *mem);
 	u32 FreeSize();
+	u32 LargestFreeSize();
 	void *ReAlloc(void *mem, u32 size);
 private:
+	u32 _extentLen(u32 block);
+	u32 _tailLen(u32 block);
+	void _setExtent(u32 block, u32 len, bool used);
+	void _insertFree(u32 block, u32 len);
+	void _removeFree(u32 block, u32 len);
+	void _resetFreeLists();
+	u32 _allocBlocks(u32 len);
+	void _freeBlocks(u32 block);
+	void _shrinkBlocks(u32 block, u32 len, u32 newLen);
+	void *_alloc(u32 size);
+	void _free(void *mem);
+	void *_slabAlloc(u32 slabClass);
+	void _slabFree(u32 block, u8 *mem);
+
 	mutex_t memMutex;
 	u8 *startAddr;
 	u8 *memList;
 	u8 *memListEnd;
 	u32 memSize;
+	u32 freeBlocks;
+	u32 freeHeads[MEM_FREE_LISTS];
+	u32 freeBitmap[MEM_FREE_LISTS / 32];
+	u32 slabHeads[MEM_SLAB_CLASSES];
 };
 
 #endif
@@ -0,0 +1,248 @@
+/****************************************************************************
+ * Allocation tracing and heap fragmentation telemetry, only built with
+ * MEM_TRACE defined. The tables are static so tracing never allocates.
+ ****************************************************************************/
+#ifdef MEM_TRACE
+
+#include <stdio.h>
+#include <string.h>
+#include <ogc/machine/processor.h>
+
+#include "mem_trace.hpp"
+#include "mem2.hpp"
+#include "gecko/gecko.hpp"
+
+#define TRACE_SITES			1024	// must be a power of 2
+#define TRACE_LIVE			16384	// must be a power of 2
+#define TRACE_RECORDS		32768
+#define TRACE_TOP_SITES		16
+
+typedef struct
+{
+	u32 site;
+	u32 allocs;
+	u32 liveCount;
+	u32 liveBytes;
+	u32 highWater;
+} MemTraceSite;
+
+typedef struct
+{
+	u32 ptr;
+	u16 site;
+	u8 used;
+	u8 pool;
+} MemTraceLive;
+
+static MemTracePool tracePools[MEM_POOL_COUNT];
+static MemTraceSite traceSites[TRACE_SITES];
+static MemTraceLive traceLive[TRACE_LIVE];
+static MemTraceRecord traceRecords[TRACE_RECORDS];
+static u32 traceRecordCount = 0;
+static u32 traceDropped = 0;
+static bool tracePaused = false;
+
+static const char *poolNames[MEM_POOL_COUNT] = { "MEM1", "MEM1 lo", "MEM2 lo", "MEM2" };
+
+static inline u32 traceHash(u32 v)
+{
+	return (v >> 2) * 2654435761u;
+}
+
+static u32 siteIndex(u32 site)
+{
+	u32 idx = traceHash(site) & (TRACE_SITES - 1);
+	for(u32 i = 0; i < TRACE_SITES; ++i, idx = (idx + 1) & (TRACE_SITES - 1))
+	{
+		if(traceSites[idx].site == site)
+			return idx;
+		if(traceSites[idx].site == 0)
+		{
+			traceSites[idx].site = site;
+			return idx;
+		}
+	}
+	return 0;// table full, count it on whatever sits in slot 0
+}
+
+static void addRecord(u8 op, u8 pool, u32 ptr, u32 size, u32 site)
+{
+	if(traceRecordCount >= TRACE_RECORDS)
+	{
+		traceDropped++;
+		return;
+	}
+	MemTraceRecord *rec = &traceRecords[traceRecordCount++];
+	rec->op = op;
+	rec->pool = pool;
+	rec->pad = 0;
+	rec->ptr = ptr;
+	rec->size = size;
+	rec->site = site;
+}
+
+extern "C"
+{
+
+void MEM_trace_alloc(u8 pool, void *ptr, u32 size, void *site)
+{
+	if(tracePaused || ptr == NULL || pool >= MEM_POOL_COUNT)
+		return;
+
+	u32 level;
+	_CPU_ISR_Disable(level);
+
+	MemTracePool *p = &tracePools[pool];
+	p->allocs++;
+	p->liveBytes += size;
+	if(p->liveBytes > p->highWater)
+		p->highWater = p->liveBytes;
+
+	u32 sidx = siteIndex((u32)site);
+	MemTraceSite *s = &traceSites[sidx];
+	s->allocs++;
+	s->liveCount++;
+	s->liveBytes += size;
+	if(s->liveBytes > s->highWater)
+		s->highWater = s->liveBytes;
+
+	/* remember the call site of the pointer so the free can be attributed */
+	u32 idx = traceHash((u32)ptr) & (TRACE_LIVE - 1);
+	for(u32 i = 0; i < TRACE_LIVE; ++i, idx = (idx + 1) & (TRACE_LIVE - 1))
+	{
+		if(!traceLive[idx].used)
+		{
+			traceLive[idx].ptr = (u32)ptr;
+			traceLive[idx].site = sidx;
+			traceLive[idx].pool = pool;
+			traceLive[idx].used = 1;
+			break;
+		}
+	}
+
+	addRecord(MEM_TRACE_ALLOC, pool, (u32)ptr, size, (u32)site);
+
+	_CPU_ISR_Restore(level);
+}
+
+void MEM_trace_free(u8 pool, void *ptr, u32 size)
+{
+	if(tracePaused || ptr == NULL || pool >= MEM_POOL_COUNT)
+		return;
+
+	u32 level;
+	_CPU_ISR_Disable(level);
+
+	MemTracePool *p = &tracePools[pool];
+	p->frees++;
+	p->liveBytes -= size < p->liveBytes ? size : p->liveBytes;
+
+	u32 site = 0;
+	u32 idx = traceHash((u32)ptr) & (TRACE_LIVE - 1);
+	for(u32 i = 0; i < TRACE_LIVE; ++i, idx = (idx + 1) & (TRACE_LIVE - 1))
+	{
+		if(!traceLive[idx].used)
+			break;
+		if(traceLive[idx].ptr == (u32)ptr && traceLive[idx].pool == pool)
+		{
+			MemTraceSite *s = &traceSites[traceLive[idx].site];
+			s->liveCount--;
+			s->liveBytes -= size < s->liveBytes ? size : s->liveBytes;
+			site = s->site;
+			/* backward shift deletion keeps the probe chains intact */
+			u32 hole = idx;
+			u32 next = (idx + 1) & (TRACE_LIVE - 1);
+			while(traceLive[next].used)
+			{
+				u32 home = traceHash(traceLive[next].ptr) & (TRACE_LIVE - 1);
+				if(((next - home) & (TRACE_LIVE - 1)) >= ((next - hole) & (TRACE_LIVE - 1)))
+				{
+					traceLive[hole] = traceLive[next];
+					hole = next;
+				}
+				next = (next + 1) & (TRACE_LIVE - 1);
+			}
+			traceLive[hole].used = 0;
+			break;
+		}
+	}
+
+	addRecord(MEM_TRACE_FREE, pool, (u32)ptr, size, site);
+
+	_CPU_ISR_Restore(level);
+}
+
+static void updatePoolFree(void)
+{
+	tracePools[MEM_POOL_MEM1].freeBytes = MEM1_freesize();
+	tracePools[MEM_POOL_MEM1].largestFree = 0;// libc heap, unknown
+	tracePools[MEM_POOL_MEM1_LO].freeBytes = MEM1_lo_freesize();
+	tracePools[MEM_POOL_MEM1_LO].largestFree = MEM1_lo_largestfree();
+	tracePools[MEM_POOL_MEM2_LO].freeBytes = MEM2_lo_freesize();
+	tracePools[MEM_POOL_MEM2_LO].largestFree = MEM2_lo_largestfree();
+	tracePools[MEM_POOL_MEM2].freeBytes = MEM2_freesize();
+	tracePools[MEM_POOL_MEM2].largestFree = MEM2_largestfree();
+}
+
+void MEM_trace_dump(void)
+{
+	tracePaused = true;
+	updatePoolFree();
+
+	gprintf("Memory trace, %u records, %u dropped\n", traceRecordCount, traceDropped);
+	for(u32 i = 0; i < MEM_POOL_COUNT; ++i)
+	{
+		MemTracePool *p = &tracePools[i];
+		gprintf("%s: %u allocs, %u frees, live %u, high water %u, free %u, largest free %u\n",
+			poolNames[i], p->allocs, p->frees, p->liveBytes, p->highWater, p->freeBytes, p->largestFree);
+	}
+
+	/* biggest live call sites, a simple selection is enough for a debug dump */
+	bool shown[TRACE_SITES];
+	memset(shown, 0, sizeof(shown));
+	for(u32 n = 0; n < TRACE_TOP_SITES; ++n)
+	{
+		u32 best = TRACE_SITES;
+		for(u32 i = 0; i < TRACE_SITES; ++i)
+		{
+			if(shown[i] || traceSites[i].site == 0)
+				continue;
+			if(best == TRACE_SITES || traceSites[i].liveBytes > traceSites[best].liveBytes)
+				best = i;
+		}
+		if(best == TRACE_SITES)
+			break;
+		shown[best] = true;
+		MemTraceSite *s = &traceSites[best];
+		gprintf("site %08x: %u allocs, %u live (%u bytes), high water %u\n",
+			s->site, s->allocs, s->liveCount, s->liveBytes, s->highWater);
+	}
+	tracePaused = false;
+}
+
+bool MEM_trace_write(const char *path)
+{
+	tracePaused = true;
+	updatePoolFree();
+
+	FILE *fp = fopen(path, "wb");
+	if(fp == NULL)
+	{
+		tracePaused = false;
+		return false;
+	}
+	u32 header[4] = { 0x57464D54, MEM_TRACE_VERSION, traceRecordCount, traceDropped };// WFMT
+	bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+	ok = ok && fwrite(tracePools, sizeof(tracePools), 1, fp) == 1;
+	if(traceRecordCount > 0)
+		ok = ok && fwrite(traceRecords, sizeof(MemTraceRecord), traceRecordCount, fp) == traceRecordCount;
+	fclose(fp);
+
+	gprintf("Memory trace written to %s\n", path);
+	tracePaused = false;
+	return ok;
+}
+
+} ///extern "C"
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef __MEM_TRACE_HPP
+#define __MEM_TRACE_HPP
+
+/*
+ * Optional allocation tracing, build with MEMTRACE=1 to enable it.
+ * Every allocation and free going through mem2.cpp is counted per pool and
+ * per call site and appended to a replay log.
+ *
+ * Replay file layout (big endian, as written by the Wii):
+ *   char magic[4] = "WFMT", u32 version, u32 record count, u32 dropped records
+ *   MemTracePool pools[MEM_POOL_COUNT]
+ *   MemTraceRecord records[record count]
+ */
+
+#include <gctypes.h>
+
+#define MEM_TRACE_VERSION	1
+
+enum
+{
+	MEM_POOL_MEM1 = 0,
+	MEM_POOL_MEM1_LO,
+	MEM_POOL_MEM2_LO,
+	MEM_POOL_MEM2,
+	MEM_POOL_COUNT
+};
+
+enum
+{
+	MEM_TRACE_ALLOC = 1,
+	MEM_TRACE_FREE = 2,
+};
+
+typedef struct
+{
+	u8 op;
+	u8 pool;
+	u16 pad;
+	u32 ptr;
+	u32 size;// usable size of the block
+	u32 site;// return address of the caller
+} MemTraceRecord;
+
+typedef struct
+{
+	u32 allocs;
+	u32 frees;
+	u32 liveBytes;
+	u32 highWater;
+	u32 freeBytes;
+	u32 largestFree;
+} MemTracePool;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef MEM_TRACE
+void MEM_trace_alloc(u8 pool, void *ptr, u32 size, void *site);
+void MEM_trace_free(u8 pool, void *ptr, u32 size);
+void MEM_trace_dump(void);
+bool MEM_trace_write(const char *path);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !defined(__MEM_TRACE_HPP)
@@ -0,0 +1,110 @@
+/****************************************************************************
+ * Per-thread scratch arenas, see scratch.hpp
+ ****************************************************************************/
+#include <string.h>
+
+#include "scratch.hpp"
+#include "mem2.hpp"
+#include "gui/fmt.h"
+#include "gecko/gecko.hpp"
+#include "loader/utils.h"
+
+static const u32 SCRATCH_SIZE = 0x10000;// 64k per thread
+
+static ScratchArena g_arenas[SCRATCH_MAX];
+
+ScratchArena::ScratchArena()
+{
+	owner = LWP_THREAD_NULL;
+	buffer = NULL;
+	used = 0;
+	scopes = 0;
+	fmtBuffers = NULL;
+	fmtCurrent = 0;
+	allocs = 0;
+	highWater = 0;
+	overflows = 0;
+}
+
+ScratchArena &ScratchArena::Get(u32 arena)
+{
+	return g_arenas[arena < SCRATCH_MAX ? arena : SCRATCH_MAIN];
+}
+
+ScratchArena *ScratchArena::Current()
+{
+	lwp_t self = LWP_GetSelf();
+	for(u32 i = 0; i < SCRATCH_MAX; ++i)
+	{
+		if(g_arenas[i].owner == self)
+			return &g_arenas[i];
+	}
+	return NULL;
+}
+
+/* called by the thread itself at its start, the memory stays for the next thread using the arena */
+bool ScratchArena::Bind()
+{
+	if(buffer == NULL)
+	{
+		buffer = (u8*)MEM2_alloc(SCRATCH_SIZE + MAX_USES * MAX_MSG_SIZE);
+		if(buffer == NULL)
+			return false;
+		fmtBuffers = (char*)(buffer + SCRATCH_SIZE);
+	}
+	used = 0;
+	scopes = 0;
+	owner = LWP_GetSelf();
+	return true;
+}
+
+void ScratchArena::Unbind()
+{
+	owner = LWP_THREAD_NULL;
+	used = 0;
+	scopes = 0;
+}
+
+void *ScratchArena::Alloc(u32 size)
+{
+	u32 start = ALIGN32(used);
+	if(buffer == NULL || start + size > SCRATCH_SIZE)
+	{
+		overflows++;
+		return NULL;
+	}
+	used = start + size;
+	if(used > highWater)
+		highWater = used;
+	allocs++;
+	return buffer + start;
+}
+
+char *ScratchArena::Strdup(const char *str)
+{
+	u32 len = strlen(str) + 1;
+	char *ret = (char*)Alloc(len);
+	if(ret != NULL)
+		memcpy(ret, str, len);
+	return ret;
+}
+
+void ScratchArena::Reset()
+{
+	if(scopes == 0)
+		used = 0;
+}
+
+void ScratchArena::DumpStats(const char *name)
+{
+	gprintf("Scratch %s: %u allocs, high water %u, overflows %u\n", name, allocs, highWater, overflows);
+}
+
+extern "C" char *Scratch_FmtBuffer(void)
+{
+	ScratchArena *arena = ScratchArena::Current();
+	if(arena == NULL || arena->fmtBuffers == NULL)
+		return NULL;
+	arena->fmtCurrent = (arena->fmtCurrent + 1) % MAX_USES;
+	return arena->fmtBuffers + arena->fmtCurrent * MAX_MSG_SIZE;
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+ * Per-thread scratch arenas for transient strings and buffers.
+ *
+ * Each long running thread binds one arena. Memory is bump allocated and
+ * handed back all at once, either when a ScratchScope ends or when the thread
+ * calls Reset at its loop boundary. Nothing in here touches the general heap
+ * after the arena is bound.
+ ****************************************************************************/
+#ifndef _SCRATCH_HPP_
+#define _SCRATCH_HPP_
+
+#include <gctypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* next rotating fmt buffer of the calling thread, NULL if it has no arena */
+char *Scratch_FmtBuffer(void);
+
+#ifdef __cplusplus
+}
+
+#include <ogc/lwp.h>
+
+enum
+{
+	SCRATCH_MAIN = 0,	// main thread and UI
+	SCRATCH_COVERS,		// cover loader
+	SCRATCH_SOUND,		// sound thread
+	SCRATCH_WORKER,		// download and progress threads
+	SCRATCH_BANNER,		// banner and game sound loader
+	SCRATCH_PREFETCH,	// banner prefetch worker
+	SCRATCH_MAX
+};
+
+class ScratchArena
+{
+public:
+	ScratchArena();
+	bool Bind();
+	void Unbind();
+	void *Alloc(u32 size);
+	char *Strdup(const char *str);
+	void Reset();
+	void DumpStats(const char *name);
+
+	static ScratchArena *Current();
+	static ScratchArena &Get(u32 arena);
+private:
+	friend class ScratchScope;
+	friend char *Scratch_FmtBuffer(void);
+
+	lwp_t owner;
+	u8 *buffer;
+	u32 used;
+	u32 scopes;// open ScratchScopes, Reset does nothing while one is active
+	char *fmtBuffers;
+	u32 fmtCurrent;
+	/* counters */
+	u32 allocs;
+	u32 highWater;
+	u32 overflows;// requests the arena could not serve, callers fell back to the heap
+};
+
+/* hands back everything allocated through it when it goes out of scope */
+class ScratchScope
+{
+public:
+	ScratchScope(ScratchArena &a) : arena(a), mark(a.used) { arena.scopes++; }
+	~ScratchScope() { arena.used = mark; arena.scopes--; }
+	void *Alloc(u32 size) { return arena.Alloc(size); }
+	char *Strdup(const char *str) { return arena.Strdup(str); }
+private:
+	ScratchArena &arena;
+	u32 mark;
+};
+
+#endif
+
+#endif
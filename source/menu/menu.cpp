@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <fstream>
 #include <sys/stat.h>
 #include <dirent.h>
@@ -10,18 +11,23 @@
 #include "menu.hpp"
 #include "types.h"
 #include "fonts.h"
+#include "banner/BannerCache.hpp"
 #include "banner/BannerWindow.hpp"
 #include "channel/nand.hpp"
 #include "channel/nand_save.hpp"
 #include "gc/gc.hpp"
 #include "hw/Gekko.h"
 #include "gui/WiiMovie.hpp"
+#include "gui/profiler.hpp"
+#include "list/cache.hpp"
 #include "loader/alt_ios.h"
 #include "loader/cios.h"
 #include "loader/fs.h"
 #include "loader/nk.h"
 #include "loader/playlog.h"
 #include "loader/wbfs.h"
+#include "memory/mem_trace.hpp"
+#include "memory/scratch.hpp"
 #include "music/SoundHandler.hpp"
 #include "network/gcard.h"
 #include "unzip/U8Archive.h"
@@ -53,6 +59,10 @@ CMenu::CMenu()
 	m_showtimer = 0;
 	m_gameSoundThread = LWP_THREAD_NULL;
 	m_soundThrdBusy = false;
+	m_bnrPrefetchStop = false;
+	m_bnrPrefetchExit = false;
+	m_bnrPrefetchThread = LWP_THREAD_NULL;
+	m_bnrPrefetchCount = 0;
 	m_numCFVersions = 0;
 	m_bgCrossFade = 0;
 	m_bnrSndVol = 0;
@@ -136,6 +146,9 @@ bool CMenu::init(bool usb_mounted)
 	/* ------------------------------------------------------*/
 	/* setup debugging stuff after loading wiiflow.ini */
 	show_mem = m_cfg.getBool("DEBUG", "show_mem", false);
+#ifdef FRAME_PROFILER
+	Profiler::SetOverlay(m_cfg.getBool("DEBUG", "profiler_overlay", true));
+#endif
 	
 	/* Check if we want WiFi Gecko */
 	m_use_wifi_gecko = m_cfg.getBool("DEBUG", "wifi_gecko", false);
@@ -469,10 +482,13 @@ bool CMenu::init(bool usb_mounted)
 	MusicPlayer.Init(m_cfg, m_musicDir, fmt("%s/music", m_themeDataDir.c_str()));
 	m_music_info = m_cfg.getBool("GENERAL", "display_music_info", false);
 	MusicPlayer.SetResampleSetting(m_cfg.getBool("general", "resample_to_48khz", false));
+	MusicPlayer.SetResampleQuality(min(max(0, m_cfg.getInt("general", "resample_quality", RESAMPLE_MEDIUM)), RESAMPLE_QUALITY_MAX - 1));
 
 	/* set sound volumes */
 	CoverFlow.setSoundVolume(m_cfg.getInt("GENERAL", "sound_volume_coverflow", 255));
 	m_bnrSndVol = m_cfg.getInt("GENERAL", "sound_volume_bnr", 255);
+	BnrCache.Init(min(max(0, m_cfg.getInt("GENERAL", "banner_cache_size", 6)), 32) * 0x100000);// MB
+	_startBannerPrefetch();
 	m_bnr_settings = m_cfg.getBool("GENERAL", "banner_in_settings", true);
 
 	/* Init Button Manager and build the menus */
@@ -492,6 +508,8 @@ void CMenu::cleanup()
 	MusicPlayer.Cleanup();
 	_cleanupDefaultFont();
 	CoverFlow.shutdown(); /* possibly plugin flow crash so cleanup early */
+	_stopGameSoundThread();
+	_stopBannerPrefetch();
 	m_banner.DeleteBanner();
 	m_plugin.Cleanup();
 	m_source.save(true);
@@ -503,6 +521,7 @@ void CMenu::cleanup()
 		m_cursor[chan].cleanup();
 		
 	m_gameSound.FreeMemory();
+	BnrCache.Clear();
 	SoundHandle.Cleanup();
 	soundDeinit();
 
@@ -515,6 +534,19 @@ void CMenu::cleanup()
 	cleaned_up = true;
 	//gprintf(" \nMemory cleaned up\n");
 	gprintf("MEM1_freesize(): %i\nMEM2_freesize(): %i\n", MEM1_freesize(), MEM2_freesize());
+	ScratchArena::Get(SCRATCH_MAIN).DumpStats("main");
+	ScratchArena::Get(SCRATCH_COVERS).DumpStats("covers");
+	ScratchArena::Get(SCRATCH_SOUND).DumpStats("sound");
+	ScratchArena::Get(SCRATCH_WORKER).DumpStats("worker");
+	ScratchArena::Get(SCRATCH_BANNER).DumpStats("banner");
+	ScratchArena::Get(SCRATCH_PREFETCH).DumpStats("prefetch");
+#ifdef MEM_TRACE
+	MEM_trace_dump();
+	MEM_trace_write(fmt("%s/memtrace.bin", m_dataDir.c_str()));
+#endif
+#ifdef FRAME_PROFILER
+	Profiler::Write(fmt("%s/profile.txt", m_dataDir.c_str()));
+#endif
 }
 
 void CMenu::_Theme_Cleanup(void)
@@ -611,6 +643,10 @@ void CMenu::_Theme_Cleanup(void)
 		TexHandle.Cleanup(texture->second);
 	for(vector<SFont>::iterator font = theme.fontSet.begin(); font != theme.fontSet.end(); ++font)
 		font->ClearData();
+	u32 layoutHits, layoutMisses;
+	CText::getLayoutCacheStats(layoutHits, layoutMisses);
+	gprintf("Text layout cache: %u hits, %u misses\n", layoutHits, layoutMisses);
+	CText::clearLayoutCache();
 	for(SoundSet::iterator sound = theme.soundSet.begin(); sound != theme.soundSet.end(); ++sound)
 		sound->second->FreeMemory();
 	theme.texSet.clear();
@@ -1290,6 +1326,13 @@ void CMenu::_buildMenus(void)
 	_initPluginSettingsMenu();
 	_initCheckboxesMenu();
 
+	/* optionally pack every glyph of the theme fonts into atlases now instead of on first draw */
+	if(m_theme.getBool("GENERAL", "precache_fonts", false))
+	{
+		for(vector<SFont>::iterator font = theme.fontSet.begin(); font != theme.fontSet.end(); ++font)
+			font->font->cacheGlyphDataComplete(font->fSize);
+	}
+
 	_loadCFCfg();
 }
 
@@ -1688,6 +1731,12 @@ void CMenu::_addUserLabels(s16 *ids, u32 start, u32 size, const char *domain)
 bool musicPaused = false;
 void CMenu::_mainLoopCommon(bool withCF, bool adjusting)
 {
+	PROFILE_NEXT_FRAME();
+	PROFILE_ZONE(PROF_FRAME);
+	/* everything in the calling thread's scratch arena is from the last frame */
+	ScratchArena *scratch = ScratchArena::Current();
+	if(scratch != NULL)
+		scratch->Reset();
 	if(m_thrdWorking)
 	{
 		musicPaused = true;
@@ -1712,20 +1761,36 @@ void CMenu::_mainLoopCommon(bool withCF, bool adjusting)
 	
 	/* ticks - for moving and scaling covers and gui buttons and text */
 	if(withCF)
+	{
+		PROFILE_ZONE(PROF_CF_TICK);
 		CoverFlow.tick();
-	m_btnMgr.tick();
-	m_fa.tick();
+		PROFILE_COUNT(PROF_CNT_TEX_LOADS, CoverFlow.getRenderStats().texLoads);
+		PROFILE_COUNT(PROF_CNT_COLORS, CoverFlow.getRenderStats().colorChanges);
+		PROFILE_COUNT(PROF_CNT_MTX_LOADS, CoverFlow.getRenderStats().mtxLoads);
+		PROFILE_COUNT(PROF_CNT_MESHES, CoverFlow.getRenderStats().meshes);
+	}
+	{
+		PROFILE_ZONE(PROF_GUI_TICK);
+		m_btnMgr.tick();
+	}
+	{
+		PROFILE_ZONE(PROF_FANART_TICK);
+		m_fa.tick();
+	}
 
 	/* video setup */
 	m_vid.prepare();
 	m_vid.setup2DProjection(false, true);
 	
 	/* background and coverflow drawing */
-	_updateBg();
-	if(CoverFlow.getRenderTex())
-		CoverFlow.RenderTex();
-	if(withCF && m_lqBg != NULL)
-		CoverFlow.makeEffectTexture(m_lqBg);
+	{
+		PROFILE_ZONE(PROF_BACKGROUND);
+		_updateBg();
+		if(CoverFlow.getRenderTex())
+			CoverFlow.RenderTex();
+		if(withCF && m_lqBg != NULL)
+			CoverFlow.makeEffectTexture(m_lqBg);
+	}
 	if(withCF && m_aa > 0)
 	{
 		m_vid.setAA(m_aa, true);
@@ -1733,7 +1798,11 @@ void CMenu::_mainLoopCommon(bool withCF, bool adjusting)
 		{
 			m_vid.prepareAAPass(i);
 			m_vid.setup2DProjection(false, true);
-			_drawBg();
+			{
+				PROFILE_ZONE(PROF_BACKGROUND);
+				_drawBg();
+			}
+			PROFILE_ZONE(PROF_CF_DRAW);
 			CoverFlow.draw();
 			m_vid.setup2DProjection(false, true);
 			CoverFlow.drawEffect();
@@ -1747,9 +1816,13 @@ void CMenu::_mainLoopCommon(bool withCF, bool adjusting)
 	else
 	{
 		m_vid.setup2DProjection();
-		_drawBg();
+		{
+			PROFILE_ZONE(PROF_BACKGROUND);
+			_drawBg();
+		}
 		if(withCF)
 		{
+			PROFILE_ZONE(PROF_CF_DRAW);
 			CoverFlow.draw();
 			m_vid.setup2DProjection();
 			CoverFlow.drawEffect();
@@ -1761,6 +1834,7 @@ void CMenu::_mainLoopCommon(bool withCF, bool adjusting)
 	/* game video or banner drawing */
 	if(m_gameSelected)
 	{
+		PROFILE_ZONE(PROF_BANNER);
 		if(m_fa.isLoaded())
 			m_fa.draw();
 		else if(m_video_playing)
@@ -1781,17 +1855,30 @@ void CMenu::_mainLoopCommon(bool withCF, bool adjusting)
 	}
 	
 	/* gui buttons and text drawing */
-	m_btnMgr.draw();
+	{
+		PROFILE_ZONE(PROF_GUI_DRAW);
+		m_btnMgr.draw();
+	}
 	
 	/* reading controller inputs and drawing cursor pointers*/	
-	ScanInput();
+	{
+		PROFILE_ZONE(PROF_INPUT);
+		ScanInput();
+	}
 	
 	/* check if we want screensaver and if its idle long enuff, if so draw full screen black square with mild alpha */
 	if(!m_cfg.getBool("GENERAL", "screensaver_disabled", true))
 		m_vid.screensaver(NoInputTime(), m_cfg.getInt("GENERAL", "screensaver_idle_seconds", 60));
 
+#ifdef FRAME_PROFILER
+	Profiler::DrawOverlay(m_vid.vid_50hz());
+#endif
+
 	/* render everything on screen */
-	m_vid.render();
+	{
+		PROFILE_ZONE(PROF_RENDER);
+		m_vid.render();
+	}
 	
 	// check if power button is pressed and exit wiiflow
 	if(Sys_Exiting())
@@ -2009,6 +2096,86 @@ const wstringEx CMenu::_fmt(const char *key, const wchar_t *def)
 	return def;
 }
 
+/* categories are stored one char each, 32 + the category number */
+void CMenu::SCatFilter::compile(const string &requiredCats, const string &selectedCats, const string &hiddenCats)
+{
+	memset(this, 0, sizeof(*this));
+	numRequired = requiredCats.length();
+	numSelected = selectedCats.length();
+	numHidden = hiddenCats.length();
+	for(string::size_type i = 0; i < requiredCats.length(); ++i)
+	{
+		int k = static_cast<int>(requiredCats[i]) - 32;
+		if(k > 0)
+			++required[k];
+	}
+	for(string::size_type i = 0; i < selectedCats.length(); ++i)
+	{
+		int k = static_cast<int>(selectedCats[i]) - 32;
+		if(k > 0)
+			selected[k >> 5] |= 1u << (k & 31);
+	}
+	for(string::size_type i = 0; i < hiddenCats.length(); ++i)
+	{
+		int k = static_cast<int>(hiddenCats[i]) - 32;
+		if(k > 0)
+			hidden[k >> 5] |= 1u << (k & 31);
+	}
+}
+
+bool CMenu::SCatFilter::pass(const string *idCats) const
+{
+	bool inaCat = false;
+	bool inHiddenCat = false;
+	int reqMatch = 0;
+	if(idCats != NULL)
+	{
+		u8 numIdCats = idCats->length();
+		for(u8 j = 0; j < numIdCats; ++j)
+		{
+			int k = static_cast<int>((*idCats)[j]) - 32;
+			if(k <= 0)
+				continue;
+			if(required[k] != 0)
+			{
+				reqMatch += required[k];
+				inaCat = true;
+			}
+			else if(selected[k >> 5] & (1u << (k & 31)))
+				inaCat = true;
+			else if(hidden[k >> 5] & (1u << (k & 31)))
+				inHiddenCat = true;
+		}
+	}
+	if(inHiddenCat)
+		return false;
+	if(numRequired != reqMatch)
+		return false;
+	if(!inaCat)
+	{
+		if(numHidden == 0)
+			return false;
+		else if(numSelected > 0)
+			return false;
+	}
+	return true;
+}
+
+/* config lookup without copies and without adding the key, keys are lower case */
+const string *CMenu::_findKey(const Config::KeyMap *keys, const char *key)
+{
+	char lower[128];
+	u32 len = 0;
+	if(keys == NULL || key[0] == '\0')
+		return NULL;
+	for(; key[len] != '\0' && len < sizeof(lower) - 1; ++len)
+		lower[len] = (key[len] >= 'A' && key[len] <= 'Z') ? (key[len] | 0x20) : key[len];
+	Config::KeyMap::const_iterator i = keys->find(std::string_view(lower, len));
+	if(i == keys->end())
+		return NULL;
+	return &i->second;
+}
+
 void CMenu::_initCF(void)
 {
 	Config dump;
@@ -2018,24 +2185,44 @@ void CMenu::_initCF(void)
 	CoverFlow.clear();
 	CoverFlow.reserve(m_gameList.size());
 
-	string requiredCats;
-	string selectedCats;
-	string hiddenCats;
 	char id[74];
 	char catID[64];
+
+	/* everything the filter needs is looked up once, not for every game */
+	SCatFilter filter;
+	filter.compile(m_cat.getString("GENERAL", "required_categories", ""),
+		m_cat.getString("GENERAL", "selected_categories", ""),
+		m_cat.getString("GENERAL", "hidden_categories", ""));
+	SCatFilter pluginFilter;
+	bool pluginFilterSet = false;
+
+	const Config::KeyMap *favorites = m_gcfg1.getDomain("FAVORITES");
+	const Config::KeyMap *adultOnly = m_gcfg1.getDomain("ADULTONLY");
+	const Config::KeyMap *pluginFavorites = m_gcfg1.getDomain("FAVORITES_PLUGINS");
+	const Config::KeyMap *pluginAdultOnly = m_gcfg1.getDomain("ADULTONLY_PLUGINS");
+	const Config::KeyMap *playCounts = m_gcfg1.getDomain("PLAYCOUNT");
+	const Config::KeyMap *lastPlayed = m_gcfg1.getDomain("LASTPLAYED");
+	const Config::KeyMap *nandCats = m_cat.getDomain("NAND");
+	const Config::KeyMap *channelCats = m_cat.getDomain("CHANNELS");
+	const Config::KeyMap *gcCats = m_cat.getDomain("GAMECUBE");
+	const Config::KeyMap *wiiCats = m_cat.getDomain("WII");
+	const Config::KeyMap *hbCats = m_cat.getDomain("HOMEBREW");
+	/* plugin games mostly come in runs of the same plugin */
+	u32 pluginMagic = 0;
+	char pluginMagicWord[9] = "";
+	const Config::KeyMap *pluginCats = NULL;
+	bool pluginEnabled = false;
 	
 	// filter list based on categories and favorites
 	for(vector<dir_discHdr>::iterator hdr = m_gameList.begin(); hdr != m_gameList.end(); ++hdr)
 	{
-		requiredCats = m_cat.getString("GENERAL", "required_categories", "");
-		selectedCats = m_cat.getString("GENERAL", "selected_categories", "");
-		hiddenCats = m_cat.getString("GENERAL", "hidden_categories", "");
-		
+		const SCatFilter *catFilter = &filter;
+		const Config::KeyMap *favKeys = favorites;
+		const Config::KeyMap *adultKeys = adultOnly;
+		const Config::KeyMap *catKeys = NULL;
 		const char *favDomain = "FAVORITES";
 		const char *adultDomain = "ADULTONLY";
-		
-		memset(id, 0, 74);
-		memset(catID, 0, 64);
+		const char *catDomain = NULL;
 		
 		if(m_sourceflow)
 		{
@@ -2043,123 +2230,89 @@ void CMenu::_initCF(void)
 				CoverFlow.addItem(&(*hdr), 0, 0);
 			continue;
 		}
-		else if(hdr->type == TYPE_HOMEBREW)
+
+		memset(id, 0, 74);
+		memset(catID, 0, 64);
+		if(hdr->type == TYPE_HOMEBREW)
 		{
 			wcstombs(id, hdr->title, 63);
 			strcpy(catID, id);
+			catKeys = hbCats;
+			catDomain = "HOMEBREW";
 		}
 		else if(hdr->type == TYPE_PLUGIN)
 		{
-			if(m_cat.hasDomain("PLUGINS"))// if using new style categories_lite.ini
+			if(!pluginFilterSet)
 			{
-				requiredCats = m_cat.getString("PLUGINS", "required_categories", "");
-				selectedCats = m_cat.getString("PLUGINS", "selected_categories", "");
-				hiddenCats = m_cat.getString("PLUGINS", "hidden_categories", "");
+				if(m_cat.hasDomain("PLUGINS"))// if using new style categories_lite.ini
+					pluginFilter.compile(m_cat.getString("PLUGINS", "required_categories", ""),
+						m_cat.getString("PLUGINS", "selected_categories", ""),
+						m_cat.getString("PLUGINS", "hidden_categories", ""));
+				else
+					pluginFilter = filter;
+				pluginFilterSet = true;
 			}
-			
-			strncpy(m_plugin.PluginMagicWord, fmt("%08x", hdr->settings[0]), 8);
+			catFilter = &pluginFilter;
+			if(pluginMagicWord[0] == '\0' || hdr->settings[0] != pluginMagic)
+			{
+				pluginMagic = hdr->settings[0];
+				snprintf(pluginMagicWord, sizeof(pluginMagicWord), "%08x", pluginMagic);
+				pluginCats = m_cat.getDomain(pluginMagicWord);
+				pluginEnabled = m_plugin.GetEnabledStatus(m_plugin.GetPluginPosition(pluginMagic));
+			}
+			strncpy(m_plugin.PluginMagicWord, pluginMagicWord, 8);
 			if(strrchr(hdr->path, '/') != NULL)
 				wcstombs(catID, hdr->title, 63);
 			else
 				strncpy(catID, hdr->path, 63);// scummvm
-			strcpy(id, m_plugin.PluginMagicWord);
-			strcat(id, fmt("/%s", catID));
+			snprintf(id, sizeof(id), "%s/%s", pluginMagicWord, catID);
 			favDomain = "FAVORITES_PLUGINS";
 			adultDomain = "ADULTONLY_PLUGINS";
+			favKeys = pluginFavorites;
+			adultKeys = pluginAdultOnly;
+			catKeys = pluginCats;
+			catDomain = pluginMagicWord;
 		}
 		else // wii, gc, channels
 		{
 			strcpy(id, hdr->id);
 			strcpy(catID, id);
-		}
-		
-		u8 numReqCats = requiredCats.length();
-		u8 numSelCats = selectedCats.length();
-		u8 numHidCats = hiddenCats.length();
-		
-		if((!m_favorites || m_gcfg1.getBool(favDomain, id, false))
-			&& (!m_locked || !m_gcfg1.getBool(adultDomain, id, false)))
-		{
-			string catDomain = "";
 			if(hdr->type == TYPE_CHANNEL)
+			{
+				catKeys = nandCats;
 				catDomain = "NAND";
+			}
 			else if(hdr->type == TYPE_EMUCHANNEL)
+			{
+				catKeys = channelCats;
 				catDomain = "CHANNELS";
+			}
 			else if(hdr->type == TYPE_GC_GAME)
+			{
+				catKeys = gcCats;
 				catDomain = "GAMECUBE";
-			else if(hdr->type == TYPE_WII_GAME)
-				catDomain = "WII";
-			else if(hdr->type == TYPE_HOMEBREW)
-				catDomain = "HOMEBREW";
+			}
 			else
-				catDomain = m_plugin.PluginMagicWord;
+			{
+				catKeys = wiiCats;
+				catDomain = "WII";
+			}
+		}
 
-			if(numReqCats != 0 || numSelCats != 0 || numHidCats != 0) // if all 0 skip checking cats and show all games
+		const string *fav = _findKey(favKeys, id);
+		const string *adult = _findKey(adultKeys, id);
+		if((!m_favorites || (fav != NULL && Config::isTrue(*fav)))
+			&& (!m_locked || adult == NULL || !Config::isTrue(*adult)))
+		{
+			if(catFilter->active()) // if all 0 skip checking cats and show all games
 			{
-				string idCats= m_cat.getString(catDomain, catID, "");
-				u8 numIdCats = idCats.length();
-				if(numIdCats == 0)
+				const string *idCats = _findKey(catKeys, catID);
+				bool show = catFilter->pass(idCats);
+				if(idCats != NULL && idCats->empty())
 					m_cat.remove(catDomain, catID);
-				bool inaCat = false;
-				bool inHiddenCat = false;
-				int reqMatch = 0;
-				if(numIdCats != 0)
-				{
-					for(u8 j = 0; j < numIdCats; ++j)
-					{
-						int k = (static_cast<int>(idCats[j])) - 32;
-						if(k <= 0)
-							continue;
-						bool match = false;
-						if(numReqCats != 0)
-						{
-							for(u8 l = 0; l < numReqCats; ++l)
-							{
-								if(k == (static_cast<int>(requiredCats[l]) - 32))
-								{
-									match = true;
-									reqMatch++;
-									inaCat = true;
-								}
-							}
-						}
-						if(match)
-							continue;
-						if(numSelCats != 0)
-						{
-							for(u8 l = 0; l < numSelCats; ++l)
-							{
-								if(k == (static_cast<int>(selectedCats[l]) - 32))
-								{
-									match = true;
-									inaCat = true;
-								}
-							}
-						}
-						if(match)
-							continue;
-						if(numHidCats != 0)
-						{
-							for(u8 l = 0; l < numHidCats; ++l)
-							{
-								if(k == (static_cast<int>(hiddenCats[l]) - 32))
-									inHiddenCat = true;
-							}
-						}
-					}
-				}
 				//continue; means don't add game to list (don't show)
-				if(inHiddenCat)
-					continue;
-				if(numReqCats != reqMatch)
+				if(!show)
 					continue;
-				if(!inaCat)
-				{
-					if(numHidCats == 0)
-						continue;
-					else if(numSelCats > 0)
-						continue;
-				}
 			}
 
 			if(dumpGameLst && !NoGameID(hdr->type))
@@ -2183,19 +2336,20 @@ void CMenu::_initCF(void)
 				dump.setWString(domain, id, hdr->title);
 			}
 
-			if(hdr->type == TYPE_PLUGIN && m_plugin.GetEnabledStatus(m_plugin.GetPluginPosition(hdr->settings[0])))
+			if(hdr->type == TYPE_PLUGIN && pluginEnabled)
 				CoverFlow.addItem(&(*hdr), 0, 0);
 			else
 			{
-				int playcount = m_gcfg1.getInt("PLAYCOUNT", id, 0);
-				unsigned int lastPlayed = m_gcfg1.getUInt("LASTPLAYED", id, 0);
-				CoverFlow.addItem(&(*hdr), playcount, lastPlayed);
+				const string *count = _findKey(playCounts, id);
+				const string *played = _findKey(lastPlayed, id);
+				CoverFlow.addItem(&(*hdr), count != NULL ? (int)strtol(count->c_str(), 0, 10) : 0,
+					played != NULL ? strtoul(played->c_str(), 0, 10) : 0);
 			}
 		}
 		/* remove them if false to keep file short */
-		if(!m_gcfg1.getBool(favDomain, id))
+		if(fav != NULL && !Config::isTrue(*fav))
 			m_gcfg1.remove(favDomain, id);
-		if(!m_gcfg1.getBool(adultDomain, id))
+		if(adult != NULL && !Config::isTrue(*adult))
 			m_gcfg1.remove(adultDomain, id);
 	}
 
@@ -2360,8 +2514,7 @@ bool CMenu::_loadList(void)
 	if(m_sourceflow)
 	{
 		m_cacheList.createSFList(m_max_source_btn, m_source, m_sourceDir);
-		for(vector<dir_discHdr>::iterator tmp_itr = m_cacheList.begin(); tmp_itr != m_cacheList.end(); tmp_itr++)
-			m_gameList.push_back(*tmp_itr);
+		_takeCacheList();
 		m_cacheList.Clear();
 		if(SF_cacheCovers)
 		{
@@ -2392,6 +2545,19 @@ bool CMenu::_loadList(void)
 	return m_gameList.size() > 0 ? true : false;
 }
 
+/* hands the entries m_cacheList just built over to m_gameList. the first list
+   is swapped in whole, later ones are appended with a single reallocation */
+void CMenu::_takeCacheList(void)
+{
+	if(m_gameList.empty())
+		m_gameList = m_cacheList.TakeList();
+	else
+	{
+		m_gameList.reserve(m_gameList.size() + m_cacheList.size());
+		m_gameList.insert(m_gameList.end(), m_cacheList.begin(), m_cacheList.end());
+	}
+}
+
 bool CMenu::_loadWiiList(void)
 {
 	currentPartition = m_cfg.getInt(WII_DOMAIN, "partition", USB1);
@@ -2407,8 +2573,7 @@ bool CMenu::_loadWiiList(void)
 	m_cacheList.CreateList(COVERFLOW_WII, gameDir, stringToVector(".wbfs|.iso", '|'), cacheDir, updateCache);
 	WBFS_Close();
 	m_cfg.remove(WII_DOMAIN, "update_cache");
-	for(vector<dir_discHdr>::iterator tmp_itr = m_cacheList.begin(); tmp_itr != m_cacheList.end(); tmp_itr++)
-		m_gameList.push_back(*tmp_itr);
+	_takeCacheList();
 	if(updateCache || (!preCachedList && fsop_FileExist(cacheDir.c_str())))
 		cacheCovers = true;
 	return true;
@@ -2427,8 +2592,7 @@ bool CMenu::_loadHomebrewList(const char *HB_Dir)
 	bool preCachedList = fsop_FileExist(cacheDir.c_str());
 	m_cacheList.CreateList(COVERFLOW_HOMEBREW, gameDir, stringToVector(".dol|.elf", '|'), cacheDir, updateCache);
 	m_cfg.remove(HOMEBREW_DOMAIN, "update_cache");
-	for(vector<dir_discHdr>::iterator tmp_itr = m_cacheList.begin(); tmp_itr != m_cacheList.end(); tmp_itr++)
-		m_gameList.push_back(*tmp_itr);
+	_takeCacheList();
 	if(updateCache || (!preCachedList && fsop_FileExist(cacheDir.c_str())))
 		cacheCovers = true;
 	return true;
@@ -2447,12 +2611,10 @@ bool CMenu::_loadGamecubeList()
 	bool preCachedList = fsop_FileExist(cacheDir.c_str());
 	m_cacheList.CreateList(COVERFLOW_GAMECUBE, gameDir, stringToVector(".iso|.gcm|.ciso|root", '|'), cacheDir, updateCache);
 	m_cfg.remove(GC_DOMAIN, "update_cache");
-	for(vector<dir_discHdr>::iterator tmp_itr = m_cacheList.begin(); tmp_itr != m_cacheList.end(); tmp_itr++)
-	{
-		if(tmp_itr->settings[0] == 1) /* disc 2 */
-			continue;// skip gc disc 2 if its still part of the cached list
-		m_gameList.push_back(*tmp_itr);
-	}
+	/* skip gc disc 2 if its still part of the cached list */
+	m_cacheList.erase(std::remove_if(m_cacheList.begin(), m_cacheList.end(),
+		[](const dir_discHdr &hdr) { return hdr.settings[0] == 1; }), m_cacheList.end());
+	_takeCacheList();
 	if(updateCache || (!preCachedList && fsop_FileExist(cacheDir.c_str())))
 		cacheCovers = true;
 	return true;
@@ -2476,8 +2638,7 @@ bool CMenu::_loadChannelList(void)
 		if(updateCache)
 			cacheCovers = true;// real nand channels list is not cached but covers may still need to be updated
 		m_cacheList.CreateList(COVERFLOW_CHANNEL, std::string(), NullVector, std::string(), false);
-		for(vector<dir_discHdr>::iterator tmp_itr = m_cacheList.begin(); tmp_itr != m_cacheList.end(); tmp_itr++)
-			m_gameList.push_back(*tmp_itr);
+		_takeCacheList();
 	}
 	if(chantypes & CHANNELS_EMU)
 	{
@@ -2490,8 +2651,7 @@ bool CMenu::_loadChannelList(void)
 			string cacheDir = fmt("%s/%s_channels.db", m_listCacheDir.c_str(), DeviceName[currentPartition]);
 			bool preCachedList = fsop_FileExist(cacheDir.c_str());
 			m_cacheList.CreateList(COVERFLOW_CHANNEL, std::string(), NullVector, cacheDir, updateCache);
-			for(vector<dir_discHdr>::iterator tmp_itr = m_cacheList.begin(); tmp_itr != m_cacheList.end(); tmp_itr++)
-				m_gameList.push_back(*tmp_itr);
+			_takeCacheList();
 			if(updateCache || (!preCachedList && fsop_FileExist(cacheDir.c_str())))
 				cacheCovers = true;
 		}
@@ -2560,8 +2720,7 @@ bool CMenu::_loadPluginList()
 				m_cacheList.Magic = m_plugin.GetPluginMagic(i);
 				m_cacheList.usePluginDBTitles = m_cfg.getBool(PLUGIN_DOMAIN, "database_titles", true);
 				m_cacheList.CreateRomList(m_platform, romsDir, FileTypes, cachedListFile, updateCache);
-				for(vector<dir_discHdr>::iterator tmp_itr = m_cacheList.begin(); tmp_itr != m_cacheList.end(); tmp_itr++)
-					m_gameList.push_back(*tmp_itr);
+				_takeCacheList();
 				if(updateCache || (!preCachedList && fsop_FileExist(cachedListFile.c_str())))
 					cacheCovers = true;
 			}
@@ -2570,25 +2729,19 @@ bool CMenu::_loadPluginList()
 		{
 			string cachedListFile(fmt("%s/%s_%s.db", m_listCacheDir.c_str(), DeviceName[currentPartition], m_plugin.PluginMagicWord));
 			bool preCachedList = fsop_FileExist(cachedListFile.c_str());
-			
-			Config scummvm;
+			string scummvmIni(romDir);
 			if(strchr(romDir, ':') == NULL || !fsop_FileExist(romDir))
-				scummvm.load(fmt("%s/%s", m_pluginsDir.c_str(), romDir));
-			else
-				scummvm.load(romDir);
-			// should add error msg if loading scummvm fails or is not found
+				scummvmIni = fmt("%s/%s", m_pluginsDir.c_str(), romDir);
 			string platformName = "";
 			if(m_platform.loaded())/* convert plugin magic to platform name */
 				platformName = m_platform.getString("PLUGINS", m_plugin.PluginMagicWord);
 			m_cacheList.Color = m_plugin.GetCaseColor(i);
 			m_cacheList.Magic = m_plugin.GetPluginMagic(i);
 			m_cacheList.usePluginDBTitles = m_cfg.getBool(PLUGIN_DOMAIN, "database_titles", true);
-			m_cacheList.ParseScummvmINI(scummvm, DeviceName[currentPartition], m_pluginDataDir.c_str(), platformName.c_str(), cachedListFile, updateCache);
-			for(vector<dir_discHdr>::iterator tmp_itr = m_cacheList.begin(); tmp_itr != m_cacheList.end(); tmp_itr++)
-				m_gameList.push_back(*tmp_itr);
+			m_cacheList.ParseScummvmINI(scummvmIni.c_str(), DeviceName[currentPartition], m_pluginDataDir.c_str(), platformName.c_str(), cachedListFile, updateCache);
+			_takeCacheList();
 			if(updateCache || (!preCachedList && fsop_FileExist(cachedListFile.c_str())))
 				cacheCovers = true;
-			scummvm.unload();
 		}
 	}
 	m_cfg.remove(PLUGIN_DOMAIN, "update_cache");
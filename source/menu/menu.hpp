@@ -937,9 +937,22 @@ private:
 	void _playGameSound(void);
 	void _stopGameSoundThread(void);
 	static void * _gameSoundThread(void *obj);
+	static void * _gameSoundLoad(void *obj);
+	void _startBannerPrefetch(void);
+	void _stopBannerPrefetch(void);
+	void _queueBannerPrefetch(void);
+	static void * _bannerPrefetchThread(void *obj);
+	void _prefetchBanner(const dir_discHdr *hdr);
 	GuiSound m_gameSound;
 	volatile bool m_gameSelected;
 	volatile bool m_soundThrdBusy;
+	volatile bool m_bnrPrefetchStop;
+	bool m_bnrPrefetchExit;
+	lwp_t m_bnrPrefetchThread;
+	mutex_t m_bnrPrefetchMutex;
+	cond_t m_bnrPrefetchCond;
+	dir_discHdr m_bnrPrefetchHdr[2];// copies, the coverflow can change while the worker reads them
+	u8 m_bnrPrefetchCount;
 	lwp_t m_gameSoundThread;
 	bool m_gamesound_changed;
 	u8 m_bnrSndVol;
@@ -947,12 +960,27 @@ private:
 	
 // gamelist functions
 	bool _loadList(void);
+	void _takeCacheList(void);
 	bool _loadWiiList(void);
 	bool _loadGamecubeList(void);
 	bool _loadChannelList(void);
 	bool _loadPluginList(void);
 	bool _loadHomebrewList(const char *HB_Dir);
 	void _initCF(void);
+	/* required/selected/hidden categories compiled once for _initCF */
+	struct SCatFilter
+	{
+		u8 required[256];// how often a category is required
+		u32 selected[8];
+		u32 hidden[8];
+		u8 numRequired;
+		u8 numSelected;
+		u8 numHidden;
+		void compile(const string &requiredCats, const string &selectedCats, const string &hiddenCats);
+		bool active(void) const { return numRequired != 0 || numSelected != 0 || numHidden != 0; }
+		bool pass(const string *idCats) const;
+	};
+	static const string *_findKey(const Config::KeyMap *keys, const char *key);
 	
 //background handling functions
 	void _getCustomBgTex(void);
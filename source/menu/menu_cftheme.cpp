@@ -419,7 +419,7 @@ void CMenu::_cfTheme(void)
 			if (m_btnMgr.selected(m_cfThemeBtnSave))
 			{
 				CoverFlow.stopCoverLoader();
-				m_coverflow.save();
+				m_coverflow.saveLater();
 				break;
 			}
 			else if (m_btnMgr.selected(m_cfThemeBtnCancel))
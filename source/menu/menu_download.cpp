@@ -13,6 +13,7 @@
 #include "loader/fs.h"
 #include "loader/wbfs.h"
 #include "loader/wdvd.h"
+#include "memory/scratch.hpp"
 #include "network/https.h"
 #include "unzip/ZipFile.h"
 
@@ -861,6 +862,8 @@ void CMenu::_downloadProgress(void *obj, int size, int position)
 void * CMenu::_pThread(void *obj)
 {
 	CMenu *m = (CMenu*)obj;
+	ScratchArena &scratch = ScratchArena::Get(SCRATCH_WORKER);
+	scratch.Bind();
 	m->SetupInput();
 	while(m->m_thrdInstalling)
 	{
@@ -883,6 +886,7 @@ void * CMenu::_pThread(void *obj)
 				m_btnMgr.setText(m->m_downloadLblDialog, m->m_thrdMessage);
 		}
 	}
+	scratch.Unbind();
 	m->m_thrdWorking = false;
 	return 0;
 }
@@ -1,8 +1,11 @@
 
 #include "menu.hpp"
+#include "banner/BannerCache.hpp"
 #include "banner/BannerWindow.hpp"
 #include "gc/gcdisc.hpp"
 #include "gui/WiiMovie.hpp"
+#include "lockMutex.hpp"
+#include "memory/scratch.hpp"
 
 //sounds
 extern const u8 gc_ogg[];
@@ -839,8 +842,183 @@ struct IMD5Header
 	u8 crypto[16];
 } ATTRIBUTE_PACKED;
 
+/* decompresses an IMD5 sound.bin. takes over soundBin and returns a buffer for free() */
+static u8 *_decompressSound(u8 *soundBin, u32 *size)
+{
+	/* sized from the header and decoded straight into MEM2, MEM2_lo is left for the banner archives */
+	u32 newSize = DecompressedSize(soundBin, *size);
+	u8 *newSound = newSize > 0 ? (u8*)MEM2_alloc(newSize) : NULL;
+	if(newSound != NULL && DecompressTo(soundBin, *size, newSound, newSize) != newSize)
+	{
+		MEM2_free(newSound);
+		newSound = NULL;
+	}
+	free(soundBin);
+	*size = newSound != NULL ? newSize : 0;
+	return newSound;
+}
+
+/* hands the banner just loaded and its sound over to the banner cache */
+static const BannerCacheEntry *_cacheBanner(const dir_discHdr *hdr, u8 *sound, u32 soundSize)
+{
+	Layout *layout = NULL;
+	u8 *archive = NULL;
+	u32 archiveSize = 0;
+	if(!gameBanner.GetLayout(layout, archive, archiveSize))
+		return NULL;
+	const BannerCacheEntry *entry = BnrCache.Insert(hdr, layout, archive, archiveSize, sound, soundSize, true);
+	if(entry == NULL)
+		return NULL;
+	gameBanner.Release();
+	return entry;
+}
+
+/* prepares a neighbour's banner for the cache. only .bnr files already on the */
+/* storage device, extracting from disc or nand is left to the actual selection. */
+void CMenu::_prefetchBanner(const dir_discHdr *hdr)
+{
+	if(hdr == NULL || m_bnrPrefetchStop || BnrCache.Contains(hdr))
+		return;
+	if(hdr->type != TYPE_WII_GAME && hdr->type != TYPE_GC_GAME && hdr->type != TYPE_CHANNEL && hdr->type != TYPE_EMUCHANNEL)
+		return;
+
+	bool custom = true;
+	const char *bnrPath = fmt("%s/%s.bnr", m_customBnrDir.c_str(), hdr->id);
+	if(!fsop_FileExist(bnrPath))
+		bnrPath = fmt("%s/%.3s.bnr", m_customBnrDir.c_str(), hdr->id);
+	if(!fsop_FileExist(bnrPath))
+	{
+		if(hdr->type == TYPE_GC_GAME)// gc banners without a custom one are built on selection
+			return;
+		custom = false;
+		bnrPath = fmt("%s/%s.bnr", m_bnrCacheDir.c_str(), hdr->id);
+	}
+	u32 bnrSize = 0;
+	u8 *bnrFile = fsop_ReadFile(bnrPath, &bnrSize);
+	if(bnrFile == NULL)
+		return;
+
+	Banner banner;
+	banner.SetBanner(bnrFile, bnrSize, custom, true);
+	AnimatedBanner prepared;
+	prepared.LoadFont(m_wbf1_font, m_wbf2_font);
+	if(m_bnrPrefetchStop || !banner.IsValid() || !prepared.LoadBanner(banner))
+	{
+		prepared.Clear();
+		banner.ClearBanner();
+		return;
+	}
+	u32 sndSize = 0;
+	u8 *soundBin = banner.GetFile("sound.bin", &sndSize);
+	banner.ClearBanner();
+	if(soundBin != NULL && memcmp(&((IMD5Header *)soundBin)->fcc, "IMD5", 4) == 0)
+		soundBin = _decompressSound(soundBin, &sndSize);
+	if(soundBin == NULL)
+		sndSize = 0;
+
+	Layout *layout = NULL;
+	u8 *archive = NULL;
+	u32 archiveSize = 0;
+	if(!m_bnrPrefetchStop && prepared.GetLayout(layout, archive, archiveSize)
+		&& BnrCache.Insert(hdr, layout, archive, archiveSize, soundBin, sndSize, false) != NULL)
+		prepared.Release();
+	else if(soundBin != NULL)
+		free(soundBin);
+	prepared.Clear();
+}
+
+/* waits for copies of the neighbours' headers from _queueBannerPrefetch and prepares their banners */
+void * CMenu::_bannerPrefetchThread(void *obj)
+{
+	CMenu *m = (CMenu*)obj;
+	ScratchArena &scratch = ScratchArena::Get(SCRATCH_PREFETCH);
+	scratch.Bind();
+	dir_discHdr hdr;
+	while(true)
+	{
+		{
+			LockMutex lock(m->m_bnrPrefetchMutex);
+			while(m->m_bnrPrefetchCount == 0 && !m->m_bnrPrefetchExit)
+				LWP_CondWait(m->m_bnrPrefetchCond, m->m_bnrPrefetchMutex);
+			if(m->m_bnrPrefetchExit)
+				break;
+			hdr = m->m_bnrPrefetchHdr[0];
+			m->m_bnrPrefetchHdr[0] = m->m_bnrPrefetchHdr[1];
+			m->m_bnrPrefetchCount--;
+			m->m_bnrPrefetchStop = false;
+		}
+		/* the selected game's own banner goes first */
+		while(m->m_soundThrdBusy && !m->m_bnrPrefetchStop)
+			usleep(1000);
+		m->_prefetchBanner(&hdr);
+		scratch.Reset();
+	}
+	scratch.Unbind();
+	return NULL;
+}
+
+u8 *BnrPrefetchStack = NULL;
+u32 BnrPrefetchSize = 0x10000; //64kb
+void CMenu::_startBannerPrefetch(void)
+{
+	if(m_bnrPrefetchThread != LWP_THREAD_NULL || !BnrCache.Enabled())
+		return;
+	m_bnrPrefetchCount = 0;
+	m_bnrPrefetchStop = false;
+	m_bnrPrefetchExit = false;
+	LWP_MutexInit(&m_bnrPrefetchMutex, false);
+	LWP_CondInit(&m_bnrPrefetchCond);
+	BnrPrefetchStack = (u8*)MEM2_lo_alloc(BnrPrefetchSize);
+	LWP_CreateThread(&m_bnrPrefetchThread, _bannerPrefetchThread, this, BnrPrefetchStack, BnrPrefetchSize, 40);
+}
+
+void CMenu::_stopBannerPrefetch(void)
+{
+	if(m_bnrPrefetchThread == LWP_THREAD_NULL)
+		return;
+	{
+		LockMutex lock(m_bnrPrefetchMutex);
+		m_bnrPrefetchExit = true;
+		m_bnrPrefetchStop = true;
+		LWP_CondSignal(m_bnrPrefetchCond);
+	}
+	LWP_JoinThread(m_bnrPrefetchThread, NULL);
+	m_bnrPrefetchThread = LWP_THREAD_NULL;
+	LWP_CondDestroy(m_bnrPrefetchCond);
+	LWP_MutexDestroy(m_bnrPrefetchMutex);
+	if(BnrPrefetchStack)
+		MEM2_lo_free(BnrPrefetchStack);
+	BnrPrefetchStack = NULL;
+}
+
+/* hands the worker copies of the neighbours' headers, whatever it is still preparing is dropped */
+void CMenu::_queueBannerPrefetch(void)
+{
+	if(m_bnrPrefetchThread == LWP_THREAD_NULL)
+		return;
+	const dir_discHdr *nextHdr = CoverFlow.getNextHdr();
+	const dir_discHdr *prevHdr = CoverFlow.getPrevHdr();
+	LockMutex lock(m_bnrPrefetchMutex);
+	m_bnrPrefetchCount = 0;
+	if(nextHdr != NULL)
+		m_bnrPrefetchHdr[m_bnrPrefetchCount++] = *nextHdr;
+	if(prevHdr != NULL && prevHdr != nextHdr)
+		m_bnrPrefetchHdr[m_bnrPrefetchCount++] = *prevHdr;
+	m_bnrPrefetchStop = true;
+	LWP_CondSignal(m_bnrPrefetchCond);
+}
+
 // loads game banner and sound to be played by mainloop
 void * CMenu::_gameSoundThread(void *obj)
+{
+	ScratchArena &scratch = ScratchArena::Get(SCRATCH_BANNER);
+	scratch.Bind();
+	_gameSoundLoad(obj);
+	scratch.Unbind();
+	return NULL;
+}
+
+void * CMenu::_gameSoundLoad(void *obj)
 {
 	CMenu *m = (CMenu*)obj;
 	m->m_soundThrdBusy = true;
@@ -849,6 +1027,7 @@ void * CMenu::_gameSoundThread(void *obj)
 	m_banner_loaded = false;
 
 	CurrentBanner.ClearBanner();//clear current banner from memory
+	BnrCache.SetActive(NULL);
 
 	/* Set to empty textures to clear current snapshot from screen */
 	TexData emptyTex;
@@ -1030,6 +1209,20 @@ void * CMenu::_gameSoundThread(void *obj)
 	}
 	else
 	{
+		/* banner prepared before, shown already or prefetched while on a neighbour */
+		const BannerCacheEntry *cached = BnrCache.Find(GameHdr);
+		if(cached != NULL)
+		{
+			m_banner.LoadCachedBanner(cached->layout, cached->archive, m->m_wbf1_font, m->m_wbf2_font);
+			m_banner_loaded = true;
+			if(cached->sound != NULL && (GameHdr->type != TYPE_GC_GAME || m->m_gc_play_banner_sound))
+				m->m_gameSound.Load(cached->sound, cached->soundSize, false);
+			else
+				m->m_gameSound.FreeMemory();
+			m->m_gamesound_changed = true;
+			m->m_soundThrdBusy = false;
+			return NULL;
+		}
 		/* try to get custom banner for wii, gc, and channels */
 		/* check custom ID6 first */
 		strncpy(custom_banner, fmt("%s/%s.bnr", m->m_customBnrDir.c_str(), GameHdr->id), 255);
@@ -1138,17 +1331,19 @@ void * CMenu::_gameSoundThread(void *obj)
 	{
 		if(memcmp(&((IMD5Header *)soundBin)->fcc, "IMD5", 4) == 0)
 		{
-			u32 newSize = 0;
-			u8 *newSound = DecompressCopy(soundBin, sndSize, &newSize);
-			free(soundBin);// no longer needed, now using decompressed newSound
-			if(newSound == NULL || newSize == 0 || !m->m_gameSound.Load(newSound, newSize))
+			soundBin = _decompressSound(soundBin, &sndSize);// frees the compressed soundBin
+			if(soundBin == NULL)
 			{
-				m->m_gameSound.FreeMemory();// frees newSound
+				m->m_gameSound.FreeMemory();
 				m_banner.DeleteBanner();// the same as UnloadBanner
 				m->m_soundThrdBusy = false;
 				return NULL;
 			}
 		}
+		/* keep the prepared banner and its sound for the next time this game is selected */
+		const BannerCacheEntry *cached = _cacheBanner(GameHdr, soundBin, sndSize);
+		if(cached != NULL)
+			m->m_gameSound.Load(cached->sound, cached->soundSize, false);
 		else
 			m->m_gameSound.Load(soundBin, sndSize);
 
@@ -1164,6 +1359,8 @@ void * CMenu::_gameSoundThread(void *obj)
 	{
 		if(soundBin != NULL)
 			free(soundBin);
+		else
+			_cacheBanner(GameHdr, NULL, 0);
 		//gprintf("WARNING: No sound found in banner!\n");
 		m->m_gamesound_changed = true;
 		m->m_gameSound.FreeMemory();// frees previous game sound
@@ -1178,13 +1375,15 @@ void CMenu::_playGameSound(void)// starts banner and gamesound loading thread
 {
 	_cleanupBanner(true);
 	m_gamesound_changed = false;
-	if(m_bnrSndVol == 0) 
-		return;
-
-	if(m_gameSoundThread != LWP_THREAD_NULL)
-		_stopGameSoundThread();
-	GameSoundStack = (u8*)MEM2_lo_alloc(GameSoundSize);
-	LWP_CreateThread(&m_gameSoundThread, _gameSoundThread, this, GameSoundStack, GameSoundSize, 60);
+	if(m_bnrSndVol != 0)
+	{
+		if(m_gameSoundThread != LWP_THREAD_NULL)
+			_stopGameSoundThread();
+		GameSoundStack = (u8*)MEM2_lo_alloc(GameSoundSize);
+		LWP_CreateThread(&m_gameSoundThread, _gameSoundThread, this, GameSoundStack, GameSoundSize, 60);
+	}
+	/* the neighbours are prepared whether or not the banner sound plays */
+	_queueBannerPrefetch();
 }
 
 void CMenu::_stopGameSoundThread()//stops banner and gamesound loading thread
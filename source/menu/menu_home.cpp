@@ -77,7 +77,7 @@ bool CMenu::_Home(void)
 		else if(BTN_1_PRESSED)
 		{
 			//m_theme.load(fmt("%s.ini", m_themeDataDir.c_str()));
-			m_theme.save();
+			m_theme.saveLater();
 			_hideHome();
 			_error(_t("savedtheme", L"Theme config saved!"));
 			_showHome();
@@ -1,5 +1,6 @@
 
 #include <unistd.h>
+#include <wctype.h>
 #include <fstream>
 #include <sys/stat.h>
 
@@ -762,6 +763,46 @@ int CMenu::main(void)
 					m_btnMgr.show(m_mainLblNotice);
 				}
 			}
+			/* b+1 or b+2 while a letter shows = type more of the title, 1 adds the next letter of the current cover, 2 steps the last letter */
+			else if(!CoverFlow.empty() && m_showtimer > 0 && !curLetter.empty() && (BTN_1_PRESSED || BTN_2_PRESSED)
+				&& m_cfg.getInt(domain, "sort", SORT_ALPHA) == SORT_ALPHA)
+			{
+				bUsed = true;
+				wstringEx prefix(curLetter);
+				bool moved = false;
+				if(BTN_1_PRESSED)
+				{
+					const dir_discHdr *hdr = CoverFlow.getHdr();
+					const wchar_t *title = hdr != NULL ? CCoverFlow::navTitle(hdr->title) : NULL;
+					if(title != NULL && wcslen(title) > prefix.size())
+					{
+						prefix.push_back(towupper(title[prefix.size()]));
+						moved = CoverFlow.jumpToPrefix(prefix.c_str());
+					}
+				}
+				else
+				{
+					/* titles compare without case, so only the printable ascii without upper case is tried */
+					wchar_t last = towlower(prefix[prefix.size() - 1]);
+					wchar_t c = last;
+					for(u32 tries = 0; tries < 95 && !moved; ++tries)
+					{
+						c = (c < L' ' || c >= L'~') ? L' ' : c + 1;
+						if(c == last)
+							break;
+						if(c >= L'A' && c <= L'Z')
+							continue;
+						prefix[prefix.size() - 1] = c;
+						moved = CoverFlow.jumpToPrefix(prefix.c_str());
+					}
+					prefix[prefix.size() - 1] = towupper(c);
+				}
+				if(moved)
+					curLetter = prefix;
+				m_showtimer = 120;
+				m_btnMgr.setText(m_mainLblLetter, curLetter);
+				m_btnMgr.show(m_mainLblLetter);
+			}
 			else if(BTN_LEFT_PRESSED)// b+left = previous song
 			{
 				bUsed = true;
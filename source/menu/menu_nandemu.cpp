@@ -207,7 +207,7 @@ int CMenu::_NandEmuCfg(void)
 		{
 			if(m_btnMgr.selected(m_nandemuBtnBack))
 			{
-				m_cfg.save();
+				m_cfg.saveLater();
 				break;
 			}
 			if(nandemuPage == 1)
@@ -354,7 +354,7 @@ void CMenu::_checkboxesMenu(u8 md)
 			}
 		}
 	}
-	m_source.save();
+	m_source.saveLater();
 	_hideCheckboxesMenu();
 }
 
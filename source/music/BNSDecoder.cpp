@@ -27,122 +27,11 @@
 #include <string.h>
 #include <math.h>
 #include <unistd.h>
+#include <algorithm>
 #include <gccore.h>
 #include "BNSDecoder.hpp"
 #include "memory/mem2.hpp"
 
-SoundBlock DecodefromBNS(const u8 *buffer, u32 size);
-
-BNSDecoder::BNSDecoder(const char * filepath)
-	: SoundDecoder(filepath)
-{
-	SoundType = SOUND_BNS;
-	memset(&SoundData, 0, sizeof(SoundBlock));
-
-	if(!file_fd)
-		return;
-
-	OpenFile();
-}
-
-BNSDecoder::BNSDecoder(const u8 * snd, int len)
-	: SoundDecoder(snd, len)
-{
-	SoundType = SOUND_BNS;
-	memset(&SoundData, 0, sizeof(SoundBlock));
-
-	if(!file_fd)
-		return;
-
-	OpenFile();
-}
-
-BNSDecoder::~BNSDecoder()
-{
-	ExitRequested = true;
-	while(Decoding)
-		usleep(100);
-
-	if(SoundData.buffer != NULL)
-		free(SoundData.buffer);
-
-	SoundData.buffer = NULL;
-}
-
-void BNSDecoder::OpenFile()
-{
-	u8 *tempbuff = (u8*)MEM2_alloc(file_fd->size());
-	if(!tempbuff)
-	{
-		CloseFile();
-		return;
-	}
-
-	int done = 0;
-
-	while(done < file_fd->size())
-	{
-		int read = file_fd->read(tempbuff+done, file_fd->size()-done);
-		if(read > 0)
-			done += read;
-		else
-		{
-			CloseFile();
-			MEM2_free(tempbuff);
-			return;
-		}
-	}
-
-	SoundData = DecodefromBNS(tempbuff, done);
-	MEM2_free(tempbuff);
-	if(SoundData.buffer == NULL)
-	{
-		CloseFile();
-		return;
-	}
-	// set sound information
-	Format = SoundData.format;
-	SampleRate = SoundData.frequency;
-	Decode();
-}
-
-void BNSDecoder::CloseFile()
-{
-	if(file_fd)
-		delete file_fd;
-
-	file_fd = NULL;
-}
-
-int BNSDecoder::Read(u8 * buffer, int buffer_size)
-{
-	if(!SoundData.buffer)
-		return -1;
-
-	if(SoundData.loopFlag)
-	{
-		int factor = SoundData.format == VOICE_STEREO_16BIT ? 4 : 2;
-		if(CurPos >= (int) SoundData.loopEnd*factor)
-			CurPos = SoundData.loopStart*factor;
-
-		if(buffer_size > (int) SoundData.loopEnd*factor-CurPos)
-			buffer_size = SoundData.loopEnd*factor-CurPos;
-	}
-	else
-	{
-		if(CurPos >= (int) SoundData.size)
-			return 0;
-
-		if(buffer_size > (int) SoundData.size-CurPos)
-			buffer_size = SoundData.size-CurPos;
-	}
-
-	memcpy(buffer, SoundData.buffer+CurPos, buffer_size);
-	CurPos += buffer_size;
-
-	return buffer_size;
-}
-
 struct BNSHeader
 {
 	u32 fccBNS;
@@ -215,154 +104,282 @@ struct BNSADPCMBlock
 	ADPCMByte samples[7];
 } ATTRIBUTE_PACKED;
 
-struct BNSDecObj
+/* the offsets in the info chunk count from behind its 8 byte header */
+static inline bool inBNSInfo(u32 offset, u32 len, u32 infoSize)
 {
-	s16 prevSamples[2];
-	s16 coeff[8][2];
-};
+	return offset <= infoSize - 8 && len <= infoSize - 8 - offset;
+}
 
-static void loadBNSInfo(BNSInfo &bnsInfo, const u8 *buffer)
+static bool loadBNSInfo(BNSInfo &bnsInfo, const u8 *buffer, u32 infoSize)
 {
 	const u8 *ptr = buffer + 8;
+	const u32 coeffSize = (u8 *)bnsInfo.coefficients2 - (u8 *)&bnsInfo.coefficients1;
 	bnsInfo = *(const BNSInfo *)buffer;
 	if (bnsInfo.offsetToChanStarts == 0x18 && bnsInfo.chan1StartOffset == 0x20 && bnsInfo.chan2StartOffset == 0x2C
 		&& bnsInfo.coeff1Offset == 0x38 && bnsInfo.coeff2Offset == 0x68)
-		return;
+		return true;
+	if (!inBNSInfo(bnsInfo.offsetToChanStarts, bnsInfo.chanCount == 2 ? 8 : 4, infoSize))
+		return false;
 	bnsInfo.chan1StartOffset = *(const u32 *)(ptr + bnsInfo.offsetToChanStarts);
+	if (!inBNSInfo(bnsInfo.chan1StartOffset, 8, infoSize))
+		return false;
 	bnsInfo.chan1Start = *(const u32 *)(ptr + bnsInfo.chan1StartOffset);
 	bnsInfo.coeff1Offset = *(const u32 *)(ptr + bnsInfo.chan1StartOffset + 4);
+	if (!inBNSInfo(bnsInfo.coeff1Offset, coeffSize, infoSize))
+		return false;
 	if ((u8 *)bnsInfo.coefficients1 != ptr + bnsInfo.coeff1Offset)
-		memcpy(bnsInfo.coefficients1, ptr + bnsInfo.coeff1Offset, (u8 *)bnsInfo.coefficients2 - (u8 *)&bnsInfo.coefficients1);
+		memcpy(bnsInfo.coefficients1, ptr + bnsInfo.coeff1Offset, coeffSize);
 	if (bnsInfo.chanCount == 2)
 	{
 		bnsInfo.chan2StartOffset = *(const u32 *)(ptr + bnsInfo.offsetToChanStarts + 4);
+		if (!inBNSInfo(bnsInfo.chan2StartOffset, 8, infoSize))
+			return false;
 		bnsInfo.chan2Start = *(const u32 *)(ptr + bnsInfo.chan2StartOffset);
 		bnsInfo.coeff2Offset = *(const u32 *)(ptr + bnsInfo.chan2StartOffset + 4);
+		if (!inBNSInfo(bnsInfo.coeff2Offset, coeffSize, infoSize))
+			return false;
 		if ((u8 *)bnsInfo.coefficients2 != ptr + bnsInfo.coeff2Offset)
-			memcpy(bnsInfo.coefficients2, ptr + bnsInfo.coeff2Offset, (u8 *)bnsInfo.coefficients2 - (u8 *)&bnsInfo.coefficients1);
+			memcpy(bnsInfo.coefficients2, ptr + bnsInfo.coeff2Offset, coeffSize);
 	}
+	return true;
 }
 
-static void decodeADPCMBlock(s16 *buffer, const BNSADPCMBlock &block, BNSDecObj &bnsDec)
+static void decodeADPCMBlock(s16 *buffer, int stride, const BNSADPCMBlock &block, s16 *prevSamples, const s16 coeff[8][2])
 {
-	int h1 = bnsDec.prevSamples[0];
-	int h2 = bnsDec.prevSamples[1];
-	int c1 = bnsDec.coeff[block.coeffIndex][0];
-	int c2 = bnsDec.coeff[block.coeffIndex][1];
-	for (int i = 0; i < 14; ++i)
+	int h1 = prevSamples[0];
+	int h2 = prevSamples[1];
+	int c1 = coeff[block.coeffIndex][0];
+	int c2 = coeff[block.coeffIndex][1];
+	for (int i = 0; i < BNS_FRAME_SAMPLES; ++i)
 	{
 		int nibSample = ((i & 1) == 0) ? block.samples[i / 2].sample1 : block.samples[i / 2].sample2;
 		int sampleDeltaHP = (nibSample << block.lshift) << 11;
 		int predictedSampleHP = c1 * h1 + c2 * h2;
 		int sampleHP = predictedSampleHP + sampleDeltaHP;
-		buffer[i] = std::min(std::max(-32768, (sampleHP + 1024) >> 11), 32767);
 		h2 = h1;
-		h1 = buffer[i];
+		h1 = std::min(std::max(-32768, (sampleHP + 1024) >> 11), 32767);
+		buffer[i * stride] = h1;
+	}
+	prevSamples[0] = h1;
+	prevSamples[1] = h2;
+}
+
+BNSDecoder::BNSDecoder(const char * filepath)
+	: SoundDecoder(filepath)
+{
+	SoundType = SOUND_BNS;
+	DataOffset = 0;
+	NumFrames = 0;
+	Channels = 1;
+	LoopFlag = false;
+	LoopHistoryValid = false;
+	ChunkFrame = 0;
+	DecodeFrame = 0;
+
+	if(!file_fd)
+		return;
+
+	OpenFile();
+}
+
+BNSDecoder::BNSDecoder(const u8 * snd, int len)
+	: SoundDecoder(snd, len)
+{
+	SoundType = SOUND_BNS;
+	DataOffset = 0;
+	NumFrames = 0;
+	Channels = 1;
+	LoopFlag = false;
+	LoopHistoryValid = false;
+	ChunkFrame = 0;
+	DecodeFrame = 0;
+
+	if(!file_fd)
+		return;
+
+	OpenFile();
+}
+
+BNSDecoder::~BNSDecoder()
+{
+	ExitRequested = true;
+	while(Decoding)
+		usleep(100);
+}
+
+void BNSDecoder::OpenFile()
+{
+	BNSHeader hdr;
+	if(file_fd->read((u8 *)&hdr, sizeof(BNSHeader)) != sizeof(BNSHeader) || memcmp(&hdr.fccBNS, "BNS ", 4) != 0)
+	{
+		CloseFile();
+		return;
+	}
+	// Check sizes
+	u32 size = file_fd->size();
+	if (size < hdr.size || size < hdr.infoOffset + hdr.infoSize || size < hdr.dataOffset + hdr.dataSize
+		|| hdr.infoSize < 0x60 || hdr.dataSize < sizeof(BNSData))
+	{
+		CloseFile();
+		return;
 	}
-	bnsDec.prevSamples[0] = h1;
-	bnsDec.prevSamples[1] = h2;
+
+	// only the info chunk is read in, the sound data stays where it is
+	u32 infoBufSize = std::max((u32)sizeof(BNSInfo), hdr.infoSize);
+	u8 *infoBuf = (u8 *)MEM2_alloc(infoBufSize);
+	if(!infoBuf)
+	{
+		CloseFile();
+		return;
+	}
+	memset(infoBuf, 0, infoBufSize);
+	file_fd->seek(hdr.infoOffset, SEEK_SET);
+	int read = file_fd->read(infoBuf, hdr.infoSize);
+
+	BNSInfo infoChunk;
+	bool infoOk = read == (int)hdr.infoSize && loadBNSInfo(infoChunk, infoBuf, hdr.infoSize);
+	MEM2_free(infoBuf);
+
+	u32 dataChunk[2];
+	file_fd->seek(hdr.dataOffset, SEEK_SET);
+	if(!infoOk || file_fd->read((u8 *)dataChunk, sizeof(dataChunk)) != sizeof(dataChunk)
+		|| infoChunk.size != hdr.infoSize || dataChunk[1] > hdr.dataSize || dataChunk[1] < 8)
+	{
+		CloseFile();
+		return;
+	}
+	// Check format, only codec i've found : 0 = ADPCM
+	if(infoChunk.codecNum != 0 || (infoChunk.chanCount != 1 && infoChunk.chanCount != 2))
+	{
+		CloseFile();
+		return;
+	}
+
+	Channels = infoChunk.chanCount;
+	NumFrames = (dataChunk[1] - 8) / 8 / Channels;
+	DataOffset = hdr.dataOffset + sizeof(dataChunk);
+	memcpy(Coefficients[0], infoChunk.coefficients1, sizeof(Coefficients[0]));
+	memcpy(Coefficients[1], infoChunk.coefficients2, sizeof(Coefficients[1]));
+	memcpy(StartHistory[0], infoChunk.chan1PrevSamples, sizeof(StartHistory[0]));
+	memcpy(StartHistory[1], infoChunk.chan2PrevSamples, sizeof(StartHistory[1]));
+	memcpy(History, StartHistory, sizeof(History));
+
+	LoopFlag = infoChunk.loopFlag != 0;
+	LoopEndSample = std::min(infoChunk.loopEnd, NumFrames * BNS_FRAME_SAMPLES);
+	LoopStartSample = infoChunk.loopStart;
+	if(LoopStartSample >= LoopEndSample)
+		LoopFlag = false;
+
+	// set sound information
+	Format = Channels == 2 ? VOICE_STEREO_16BIT : VOICE_MONO_16BIT;
+	SampleRate = infoChunk.freq;
+	Decode();
 }
 
-static u8 * decodeBNS(u32 &size, const BNSInfo &bnsInfo, const BNSData &bnsData)
+void BNSDecoder::CloseFile()
 {
-	static s16 smplBlock[14];
-	BNSDecObj decObj;
-	int numBlocks = (bnsData.size - 8) / 8;
-	int numSamples = numBlocks * 14;
-	const BNSADPCMBlock *inputBuf = (const BNSADPCMBlock *)&bnsData.data;
-	u8 * buffer = (u8 *) malloc(numSamples * sizeof (s16));
-	s16 *outputBuf;
-
-	if (!buffer)
-		return buffer;
-	memcpy(decObj.coeff, bnsInfo.coefficients1, sizeof decObj.coeff);
-	memcpy(decObj.prevSamples, bnsInfo.chan1PrevSamples, sizeof decObj.prevSamples);
-	outputBuf = (s16 *)buffer;
-	if (bnsInfo.chanCount == 1)
-		for (int i = 0; i < numBlocks; ++i)
+	if(file_fd)
+		delete file_fd;
+
+	file_fd = NULL;
+}
+
+bool BNSDecoder::DecodeChunk(u32 frames, s16 *out)
+{
+	const u32 loopFrame = LoopStartSample / BNS_FRAME_SAMPLES;
+	const bool saveLoop = LoopFlag && !LoopHistoryValid && loopFrame >= DecodeFrame && loopFrame < DecodeFrame + frames;
+
+	// the channels are stored one after the other, the pcm gets interleaved
+	for(u32 chan = 0; chan < Channels; ++chan)
+	{
+		file_fd->seek(DataOffset + (chan * NumFrames + DecodeFrame) * 8, SEEK_SET);
+		if(file_fd->read(FrameData, frames * 8) != (int)(frames * 8))
+			return false;
+
+		for(u32 i = 0; i < frames; ++i)
 		{
-			decodeADPCMBlock(smplBlock, inputBuf[i], decObj);
-			memcpy(outputBuf, smplBlock, sizeof smplBlock);
-			outputBuf += 14;
+			if(saveLoop && DecodeFrame + i == loopFrame)
+				memcpy(LoopHistory[chan], History[chan], sizeof(LoopHistory[chan]));
+			decodeADPCMBlock(out + i * BNS_FRAME_SAMPLES * Channels + chan, Channels,
+							*(const BNSADPCMBlock *)(FrameData + i * 8), History[chan], Coefficients[chan]);
 		}
-	else
+	}
+	if(saveLoop)
+		LoopHistoryValid = true;
+
+	DecodeFrame += frames;
+	return true;
+}
+
+bool BNSDecoder::DecodeFrom(u32 frame)
+{
+	if(frame >= NumFrames)
+		return false;
+
+	if(frame != DecodeFrame)
 	{
-		numBlocks /= 2;
-		for (int i = 0; i < numBlocks; ++i)
+		if(LoopHistoryValid && frame == LoopStartSample / BNS_FRAME_SAMPLES)
 		{
-			decodeADPCMBlock(smplBlock, inputBuf[i], decObj);
-			for (int j = 0; j < 14; ++j)
-				outputBuf[j * 2] = smplBlock[j];
-			outputBuf += 2 * 14;
+			memcpy(History, LoopHistory, sizeof(History));
+			DecodeFrame = frame;
 		}
-		outputBuf = (s16 *)buffer + 1;
-		memcpy(decObj.coeff, bnsInfo.coefficients2, sizeof decObj.coeff);
-		memcpy(decObj.prevSamples, bnsInfo.chan2PrevSamples, sizeof decObj.prevSamples);
-		for (int i = 0; i < numBlocks; ++i)
+		else
 		{
-			decodeADPCMBlock(smplBlock, inputBuf[numBlocks + i], decObj);
-			for (int j = 0; j < 14; ++j)
-				outputBuf[j * 2] = smplBlock[j];
-			outputBuf += 2 * 14;
+			if(frame < DecodeFrame)
+			{
+				memcpy(History, StartHistory, sizeof(History));
+				DecodeFrame = 0;
+			}
+			// the prediction needs every frame before this one
+			while(DecodeFrame < frame)
+			{
+				if(!DecodeChunk(std::min(frame - DecodeFrame, (u32)BNS_CHUNK_FRAMES), ChunkPCM))
+				{
+					ChunkFrame = DecodeFrame;
+					return false;
+				}
+			}
 		}
 	}
-	size = numSamples * sizeof (s16);
-	return buffer;
+
+	ChunkFrame = DecodeFrame;
+	return DecodeChunk(std::min(NumFrames - DecodeFrame, (u32)BNS_CHUNK_FRAMES), ChunkPCM);
 }
 
-SoundBlock DecodefromBNS(const u8 *buffer, u32 size)
+int BNSDecoder::Read(u8 * buffer, int buffer_size)
 {
-	SoundBlock OutBlock;
-	memset(&OutBlock, 0, sizeof(SoundBlock));
-
-	const BNSHeader &hdr = *(BNSHeader *)buffer;
-	if(size < sizeof hdr)
-		return OutBlock;
-	if(memcmp(&hdr.fccBNS, "BNS ", 4) != 0)
-		return OutBlock;
-	// Find info and data
-	BNSInfo infoChunk;
-	loadBNSInfo(infoChunk, buffer + hdr.infoOffset);
-	const BNSData &dataChunk = *(const BNSData *)(buffer + hdr.dataOffset);
-	// Check sizes
-	if (size < hdr.size || size < hdr.infoOffset + hdr.infoSize || size < hdr.dataOffset + hdr.dataSize
-		|| hdr.infoSize < 0x60 || hdr.dataSize < sizeof dataChunk
-		|| infoChunk.size != hdr.infoSize || dataChunk.size > hdr.dataSize)
-		return OutBlock;
-	// Check format
-	if (infoChunk.codecNum != 0)	// Only codec i've found : 0 = ADPCM. Maybe there's also 1 and 2 for PCM 8 or 16 bits ?
-		return OutBlock;
-	u8 format = (u8)-1;
-	if (infoChunk.chanCount == 1 && infoChunk.codecNum == 0)
-		format = VOICE_MONO_16BIT;
-	else if (infoChunk.chanCount == 2 && infoChunk.codecNum == 0)
-		format = VOICE_STEREO_16BIT;
-	if (format == (u8)-1)
-		return OutBlock;
-	u32 freq = (u32) infoChunk.freq;
-	u32 length = 0;
-	// Copy data
-	if (infoChunk.codecNum == 0)
+	if(!file_fd || NumFrames == 0)
+		return -1;
+
+	const int factor = Channels * 2;
+	int end = NumFrames * BNS_FRAME_SAMPLES * factor;
+	if(LoopFlag)
 	{
-		OutBlock.buffer = decodeBNS(length, infoChunk, dataChunk);
-		if (!OutBlock.buffer)
-			return OutBlock;
+		if(CurPos >= (int) LoopEndSample*factor)
+			CurPos = LoopStartSample*factor;
+		end = LoopEndSample*factor;
 	}
-	else
+
+	if(CurPos >= end)
+		return 0;
+
+	if(buffer_size > end-CurPos)
+		buffer_size = end-CurPos;
+
+	u32 frame = CurPos / (BNS_FRAME_SAMPLES*factor);
+	if(frame < ChunkFrame || frame >= DecodeFrame)
 	{
-		OutBlock.buffer = (u8*) malloc(dataChunk.size);
-		if (!OutBlock.buffer)
-			return OutBlock;
-		memcpy(OutBlock.buffer, &dataChunk.data, dataChunk.size);
-		length = dataChunk.size;
+		if(!DecodeFrom(frame))
+			return -1;
 	}
 
-	OutBlock.frequency = freq;
-	OutBlock.format = format;
-	OutBlock.size = length;
-	OutBlock.loopStart = infoChunk.loopStart;
-	OutBlock.loopEnd = infoChunk.loopEnd;
-	OutBlock.loopFlag = infoChunk.loopFlag;
+	int offset = CurPos - ChunkFrame*BNS_FRAME_SAMPLES*factor;
+	int avail = (DecodeFrame - ChunkFrame)*BNS_FRAME_SAMPLES*factor - offset;
+	if(buffer_size > avail)
+		buffer_size = avail;
 
-	return OutBlock;
+	memcpy(buffer, ((u8 *)ChunkPCM)+offset, buffer_size);
+	CurPos += buffer_size;
+
+	return buffer_size;
 }
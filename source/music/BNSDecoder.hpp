@@ -28,16 +28,8 @@
 
 #include "SoundDecoder.hpp"
 
-typedef struct _SoundBlock
-{
-	u8 * buffer;
-	u32 size;
-	u8 format;
-	u32 frequency;
-	u32 loopStart;
-	u32 loopEnd;
-	u8 loopFlag;
-} SoundBlock;
+#define BNS_FRAME_SAMPLES	14
+#define BNS_CHUNK_FRAMES	64
 
 class BNSDecoder : public SoundDecoder
 {
@@ -46,10 +38,33 @@ public:
 	BNSDecoder(const u8 * snd, int len);
 	virtual ~BNSDecoder();
 	int Read(u8 * buffer, int buffer_size);
+	int Seek(int pos) { CurPos = pos; ResetUpsample(); return 0; };
+	int Rewind() { CurPos = 0; EndOfFile = false; ResetUpsample(); return 0; };
 protected:
 	void OpenFile();
 	void CloseFile();
-	SoundBlock SoundData;
+	bool DecodeChunk(u32 frames, s16 *out);
+	bool DecodeFrom(u32 frame);
+
+	/* the ADPCM data stays in the file and is decoded one chunk of frames at a time */
+	u32 DataOffset;
+	u32 NumFrames;
+	u8 Channels;
+	/* the loop is played from here, SoundDecoder::LoopStart/LoopEnd stay unused */
+	bool LoopFlag;
+	u32 LoopStartSample;
+	u32 LoopEndSample;
+	s16 Coefficients[2][8][2];
+	s16 StartHistory[2][2];
+	s16 History[2][2];
+	/* decoder history at the start of the loop frame, saved the first time it is decoded */
+	s16 LoopHistory[2][2];
+	bool LoopHistoryValid;
+	/* pcm of the frames ChunkFrame up to DecodeFrame */
+	u32 ChunkFrame;
+	u32 DecodeFrame;
+	u8 FrameData[BNS_CHUNK_FRAMES * 8];
+	s16 ChunkPCM[BNS_CHUNK_FRAMES * BNS_FRAME_SAMPLES * 2];
 };
 
 #endif
@@ -31,14 +31,17 @@ BufferCircle::BufferCircle()
 {
 	which = 0;
 	BufferBlockSize = 0;
+	for(int i = 0; i < MAX_BUFFER_BLOCKS; i++)
+	{
+		BufferSize[i] = 0;
+		BufferReady[i] = false;
+	}
 }
 
 BufferCircle::~BufferCircle()
 {
 	FreeBuffer();
 	SoundBuffer.clear();
-	BufferSize.clear();
-	BufferReady.clear();
 }
 
 void BufferCircle::SetBufferBlockSize(int size)
@@ -62,6 +65,9 @@ void BufferCircle::SetBufferBlockSize(int size)
 
 void BufferCircle::Resize(int size)
 {
+	if(size > MAX_BUFFER_BLOCKS)
+		size = MAX_BUFFER_BLOCKS;
+
 	// this while() only gets done if new size is smaller than old size
 	while(size < Size())
 		RemoveBuffer(Size()-1);
@@ -69,8 +75,6 @@ void BufferCircle::Resize(int size)
 	int oldSize = Size();
 
 	SoundBuffer.resize(size);
-	BufferSize.resize(size);
-	BufferReady.resize(size);
 
 	// this for() only gets done if new size is bigger than old size
 	for(int i = oldSize; i < Size(); i++)
@@ -96,8 +100,13 @@ void BufferCircle::RemoveBuffer(int pos)
 		MEM2_free(SoundBuffer[pos]);
 
 	SoundBuffer.erase(SoundBuffer.begin()+pos);
-	BufferSize.erase(BufferSize.begin()+pos);
-	BufferReady.erase(BufferReady.begin()+pos);
+	for(int i = pos; i < Size(); i++)
+	{
+		BufferSize[i] = BufferSize[i+1];
+		BufferReady[i] = BufferReady[i+1];
+	}
+	BufferSize[Size()] = 0;
+	BufferReady[Size()] = false;
 }
 
 void BufferCircle::ClearBuffer()
@@ -116,6 +125,7 @@ void BufferCircle::FreeBuffer()
 	{
 		if(SoundBuffer[i] != NULL)
 			MEM2_free(SoundBuffer[i]);
+		SoundBuffer[i] = NULL;
 		BufferSize[i] = 0;
 		BufferReady[i] = false;
 	}
@@ -123,13 +133,41 @@ void BufferCircle::FreeBuffer()
 
 void BufferCircle::LoadNext()
 {
+	if(Size() <= 0)
+		return;
+
+	// the buffer played before the current one goes back to the producer
 	int pos = (which+Size()-1) % Size();
-	BufferReady[pos] = false;
 	BufferSize[pos] = 0;
+	BufferBarrier();
+	BufferReady[pos] = false;
 
 	which = (which+1) % Size();
 }
 
+int BufferCircle::GetFreeBuffer()
+{
+	// two buffers stay with the consumer, the one playing and the one before it
+	int pos = which;
+	for(int i = 0; i < Size()-2; i++)
+	{
+		if(!BufferReady[pos])
+			return pos;
+		pos = (pos+1) % Size();
+	}
+	return -1;
+}
+
+void BufferCircle::CommitBuffer(int pos, int size)
+{
+	if(!Valid(pos))
+		return;
+
+	BufferSize[pos] = size;
+	BufferBarrier();
+	BufferReady[pos] = true;
+}
+
 void BufferCircle::SetBufferReady(int pos, bool state)
 {
 	if(!Valid(pos))
@@ -30,6 +30,17 @@
 #include <gctypes.h>
 #include <string.h>
 
+#define MAX_BUFFER_BLOCKS	16
+
+/*
+ * Single producer (the sound thread) / single consumer (the voice callback).
+ * The producer owns every buffer that is not ready, the consumer owns the ready
+ * ones until LoadNext hands the one played before back. Sizes and data are
+ * published before the ready flag and the flag is cleared only after the
+ * consumer is done with the data.
+ */
+static inline void BufferBarrier() { __sync_synchronize(); }
+
 class BufferCircle
 {
 public:
@@ -66,28 +77,35 @@ public:
 	//!> Get previous buffer size
 	u32 GetLastBufferSize() { if(Size() <= 0) return 0; else return BufferSize[(which+Size()-1) % Size()]; };
 	//!> Is current buffer ready
-	bool IsBufferReady() { if(!Valid(which)) return false; else return BufferReady[which]; };
+	bool IsBufferReady() { return IsBufferReady(which); };
 	//!> Is  a buffer at a position ready
-	bool IsBufferReady(int pos) { if(!Valid(pos)) return false; else return BufferReady[pos]; };
+	bool IsBufferReady(int pos) { if(!Valid(pos) || !BufferReady[pos]) return false; BufferBarrier(); return true; };
 	//!> Is next buffer ready
-	bool IsNextBufferReady() { if(Size() <= 0) return false; else return BufferReady[(which+1) % Size()]; };
+	bool IsNextBufferReady() { if(Size() <= 0) return false; else return IsBufferReady((which+1) % Size()); };
 	//!> Is last buffer ready
-	bool IsLastBufferReady() { if(Size() <= 0) return false; else return BufferReady[(which+Size()-1) % Size()]; };
+	bool IsLastBufferReady() { if(Size() <= 0) return false; else return IsBufferReady((which+Size()-1) % Size()); };
 	//!> Set a buffer at a position to a ready state
 	void SetBufferReady(int pos, bool st);
 	//!> Set the buffersize at a position
 	void SetBufferSize(int pos, int size);
+	//!> Producer: get a free buffer to fill, -1 if the circle is full
+	int GetFreeBuffer();
+	//!> Producer: hand a filled buffer to the consumer
+	void CommitBuffer(int pos, int size);
+	//!> Get the block size of each buffer
+	u32 GetBufferBlockSize() { return BufferBlockSize; };
 	//!> Get the current position in the circle
 	u16 Which() { return which; };
 protected:
 	//!> Check if the position is a valid position in the vector
 	bool Valid(int pos) { return !(pos < 0 || pos >= Size()); };
 
-	u16 which;
+	volatile u16 which;
 	u32 BufferBlockSize;
 	std::vector<u8 *> SoundBuffer;
-	std::vector<u32> BufferSize;
-	std::vector<bool> BufferReady;
+	//!> kept out of a vector<bool> so both sides never write the same word
+	volatile u32 BufferSize[MAX_BUFFER_BLOCKS];
+	volatile bool BufferReady[MAX_BUFFER_BLOCKS];
 };
 
 #endif
@@ -17,6 +17,7 @@
 #include <cstdio>
 #include <algorithm>
 #include <fstream>
+#include <sys/stat.h>
 
 #include "MusicPlayer.hpp"
 #include "SoundHandler.hpp"
@@ -31,8 +32,45 @@ Musicplayer MusicPlayer;
 static vector<string> FileNames;
 static vector<string>::const_iterator CurrentFileName;
 
+/* the last folder scan, reused as long as no scanned folder changed */
+static string ScannedMusicDir;
+static string ScannedThemeMusicDir;
+static vector<string> ScannedFiles;
+static vector<pair<string, time_t> > ScannedDirs;
+
+static time_t DirTime(const string &dir)
+{
+	struct stat st;
+	if(stat(dir.c_str(), &st) != 0)
+		return 0;
+	return st.st_mtime;
+}
+
+static bool ScanCacheValid(const string& musicDir, const string& themeMusicDir)
+{
+	if(ScannedDirs.empty() || musicDir != ScannedMusicDir || themeMusicDir != ScannedThemeMusicDir)
+		return false;
+	for(vector<pair<string, time_t> >::const_iterator dir = ScannedDirs.begin(); dir != ScannedDirs.end(); ++dir)
+	{
+		if(DirTime(dir->first) != dir->second)
+			return false;
+	}
+	return true;
+}
+
+static void AddScannedDir(const string &dir)
+{
+	for(vector<pair<string, time_t> >::const_iterator d = ScannedDirs.begin(); d != ScannedDirs.end(); ++d)
+	{
+		if(d->first == dir)
+			return;
+	}
+	ScannedDirs.push_back(make_pair(dir, DirTime(dir)));
+}
+
 void Musicplayer::Cleanup()
 {
+	SoundHandle.ClearNext(MusicFile.GetVoice());
 	Stop();
 	DisplayTime = 0;
 	CurrentPosition = 0;
@@ -58,12 +96,30 @@ void Musicplayer::Init(Config &cfg, const string& musicDir, const string& themeM
 	FadeRate = cfg.getInt("GENERAL", "music_fade_rate", 8);
 	Volume = cfg.getInt("GENERAL", "sound_volume_music", 255);
 
+	Gapless = cfg.getBool("GENERAL", "music_gapless", true);
+	SwitchCount = SoundHandle.GetSwitchCount(0);
+
 	MusicFile.SetVoice(0);
 	SetVolume(0);
 
-	vector<string> Types = stringToVector(".mp3|.ogg", '|');
-	GetFiles(musicDir.c_str(), Types, FileNameAdder, false, MUSIC_DEPTH);
-	GetFiles(themeMusicDir.c_str(), Types, FileNameAdder, false, MUSIC_DEPTH);
+	if(ScanCacheValid(musicDir, themeMusicDir))
+		FileNames = ScannedFiles;
+	else
+	{
+		vector<string> Types = stringToVector(".mp3|.ogg", '|');
+		GetFiles(musicDir.c_str(), Types, FileNameAdder, false, MUSIC_DEPTH);
+		GetFiles(themeMusicDir.c_str(), Types, FileNameAdder, false, MUSIC_DEPTH);
+
+		/* remember every folder a song came from, new songs change its time */
+		ScannedMusicDir = musicDir;
+		ScannedThemeMusicDir = themeMusicDir;
+		ScannedFiles = FileNames;
+		ScannedDirs.clear();
+		AddScannedDir(musicDir);
+		AddScannedDir(themeMusicDir);
+		for(vector<string>::const_iterator file = FileNames.begin(); file != FileNames.end(); ++file)
+			AddScannedDir(file->substr(0, file->find_last_of('/')));
+	}
 	if(cfg.getBool("GENERAL", "randomize_music", true) && FileNames.size() > 0)
 	{
 		srand(unsigned(time(NULL)));
@@ -143,6 +199,11 @@ void Musicplayer::SetResampleSetting(bool resample)
 	ResampleSetting = resample;
 }
 
+void Musicplayer::SetResampleQuality(u8 quality)
+{
+	ResampleQuality = quality;
+}
+
 void Musicplayer::Previous()
 {
 	if(FileNames.empty() || PosFromPrevFile())
@@ -182,6 +243,7 @@ bool Musicplayer::PosFromPrevFile()
 
 void Musicplayer::Stop()
 {
+	SoundHandle.ClearNext(MusicFile.GetVoice());
 	if(!MusicFile.IsPlaying())
 		return;
 	MusicFile.Pause();// pause for now
@@ -210,10 +272,39 @@ void Musicplayer::Tick(bool attenuate)// attenuate means fade to zero volume
 		SetVolume(CurrentVolume + FadeRate > Volume ? Volume : CurrentVolume + FadeRate);
 	else if(attenuate && CurrentVolume > 0)
 		SetVolume(CurrentVolume - FadeRate < 0 ? 0 : CurrentVolume - FadeRate);
+	/* the voice went on to the queued song by itself */
+	u32 switches = SoundHandle.GetSwitchCount(MusicFile.GetVoice());
+	if(switches != SwitchCount)
+	{
+		SwitchCount = switches;
+		++CurrentFileName;
+		if(CurrentFileName == FileNames.end())
+			CurrentFileName = FileNames.begin();
+		MusicFile.SetName(CurrentFileName->c_str());
+		CurrentPosition = 0;
+		MusicChanged = true;
+		QueueFollowingFile();
+	}
 	if(!attenuate && !MusicFile.IsPlaying())
 		Next();
 }
 
+void Musicplayer::QueueFollowingFile()
+{
+	/* open the next song while this one plays so it can follow without a gap */
+	if(!Gapless || FileNames.empty() || strcmp(MusicFile.GetName(), CurrentFileName->c_str()) != 0)
+	{
+		SoundHandle.ClearNext(MusicFile.GetVoice());
+		return;
+	}
+	vector<string>::const_iterator following = CurrentFileName + 1;
+	if(following == FileNames.end())
+		following = FileNames.begin();
+	if(*following == PLUGIN_DOMAIN)
+		return;
+	SoundHandle.QueueNext(MusicFile.GetVoice(), following->c_str());
+}
+
 void Musicplayer::LoadCurrentFile()
 {
 	LoadFile(CurrentFileName->c_str());
@@ -238,6 +329,8 @@ void Musicplayer::LoadFile(const char *name, bool display_change)
 	CurrentPosition = 0;
 	MusicStopped = false;
 	MusicChanged = display_change;
+	SwitchCount = SoundHandle.GetSwitchCount(MusicFile.GetVoice());
+	QueueFollowingFile();
 }
 
 void Musicplayer::ReLoadCurrentFile()
@@ -37,6 +37,8 @@ public:
 	u8 GetMaxVolume() { return Volume; };
 	bool ResampleSetting;
 	void SetResampleSetting(bool resample);
+	u8 ResampleQuality;
+	void SetResampleQuality(u8 quality);
 
 	void Previous();
 	void Next();
@@ -57,6 +59,7 @@ public:
 	void ReLoadCurrentFile();
 protected:
 	bool PosFromPrevFile();
+	void QueueFollowingFile();
 
 	u8 Volume;
 	u8 CurrentVolume;
@@ -67,6 +70,8 @@ protected:
 	const char *curPlaylist;
 	bool usingPlaylist = false;
 	u8 pl_device;
+	bool Gapless;
+	u32 SwitchCount;
 
 	GuiSound MusicFile;
 };
@@ -116,6 +116,7 @@ int OggDecoder::Rewind()
 	int ret = ov_time_seek(&ogg_file, 0);
 	CurPos = 0;
 	EndOfFile = false;
+	ResetUpsample();
 
 	return ret;
 }
@@ -127,6 +128,7 @@ int OggDecoder::Tell()
 
 int OggDecoder::Seek(int pos)
 {
+	ResetUpsample();
 	return ov_raw_seek(&ogg_file, pos);
 }
 
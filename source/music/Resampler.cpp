@@ -0,0 +1,169 @@
+/****************************************************************************
+ * Streaming polyphase resampler for 16 bit pcm.
+ ****************************************************************************/
+#include <math.h>
+#include <string.h>
+#include "Resampler.hpp"
+#include "memory/mem2.hpp"
+
+static const u8 ResampleTaps[RESAMPLE_QUALITY_MAX] = { 2, 8, 16 };
+static const int CoeffShift = 14;
+
+Resampler::Resampler()
+{
+	Coeffs = NULL;
+	Work = NULL;
+	WorkFrames = 0;
+	WorkSize = 0;
+	Pos = 0;
+	Step = 0;
+	Taps = 0;
+	Channels = 0;
+}
+
+Resampler::~Resampler()
+{
+	Free();
+}
+
+void Resampler::Free()
+{
+	if(Coeffs != NULL)
+		MEM2_free(Coeffs);
+	if(Work != NULL)
+		MEM2_free(Work);
+	Coeffs = NULL;
+	Work = NULL;
+	WorkFrames = 0;
+	WorkSize = 0;
+}
+
+bool Resampler::Init(u32 srcRate, u32 dstRate, u8 channels, u8 quality, u32 maxSrcFrames)
+{
+	Free();
+	if(srcRate == 0 || dstRate == 0 || channels == 0 || channels > 2)
+		return false;
+	if(quality >= RESAMPLE_QUALITY_MAX)
+		quality = RESAMPLE_QUALITY_MAX - 1;
+
+	Taps = ResampleTaps[quality];
+	Channels = channels;
+	Step = (u32)(((u64)srcRate << 16) / dstRate);
+	/* leftovers stay below one call's input, the rest is headroom */
+	WorkSize = maxSrcFrames * 2 + Taps;
+
+	Coeffs = (s16 *)MEM2_alloc(RESAMPLE_PHASES * Taps * sizeof(s16));
+	Work = (s16 *)MEM2_alloc(WorkSize * Channels * sizeof(s16));
+	if(Coeffs == NULL || Work == NULL)
+	{
+		Free();
+		return false;
+	}
+
+	/* below the lower nyquist when going down, a little under it going up */
+	const float cutoff = (srcRate > dstRate ? (float)dstRate / srcRate : 1.f) * (Taps > 2 ? 0.92f : 1.f);
+	for(int phase = 0; phase < RESAMPLE_PHASES; ++phase)
+	{
+		const float frac = (float)phase / RESAMPLE_PHASES;
+		float h[16];
+		float sum = 0.f;
+		for(int k = 0; k < Taps; ++k)
+		{
+			/* distance of the tap from the output position */
+			const float x = k - (Taps / 2 - 1) - frac;
+			if(Taps == 2)
+				h[k] = 1.f - fabsf(x);
+			else
+			{
+				const float px = M_PI * cutoff * x;
+				const float sinc = fabsf(x) < 1e-6f ? 1.f : sinf(px) / px;
+				const float w = 2.f * M_PI * x / Taps;
+				h[k] = sinc * (0.42f + 0.5f * cosf(w) + 0.08f * cosf(2.f * w));
+			}
+			sum += h[k];
+		}
+		/* unity gain for every phase, the rounding error goes to the biggest tap */
+		s16 *c = Coeffs + phase * Taps;
+		int total = 0, peak = 0;
+		for(int k = 0; k < Taps; ++k)
+		{
+			c[k] = (s16)lrintf(h[k] / sum * (1 << CoeffShift));
+			total += c[k];
+			if(c[k] > c[peak])
+				peak = k;
+		}
+		c[peak] += (1 << CoeffShift) - total;
+	}
+
+	Reset();
+	return true;
+}
+
+void Resampler::Reset()
+{
+	if(Work == NULL)
+		return;
+
+	/* silence in front so the first output lands on the first input frame */
+	WorkFrames = Taps / 2 - 1;
+	memset(Work, 0, WorkFrames * Channels * sizeof(s16));
+	Pos = 0;
+}
+
+u32 Resampler::Flush(s16 *dst, u32 maxDstFrames)
+{
+	if(Coeffs == NULL)
+		return 0;
+
+	/* enough silence behind the last frame to bring it to the middle of the filter */
+	static const s16 silence[16 * 2] = { 0 };
+	u32 frames = Taps / 2;
+	u32 out = Process(silence, frames, dst, maxDstFrames);
+	Reset();
+	return out;
+}
+
+u32 Resampler::Process(const s16 *src, u32 &srcFrames, s16 *dst, u32 maxDstFrames)
+{
+	if(Coeffs == NULL)
+	{
+		srcFrames = 0;
+		return 0;
+	}
+
+	if(srcFrames > WorkSize - WorkFrames)
+		srcFrames = WorkSize - WorkFrames;
+	memcpy(Work + WorkFrames * Channels, src, srcFrames * Channels * sizeof(s16));
+	WorkFrames += srcFrames;
+
+	u32 out = 0;
+	while(out < maxDstFrames)
+	{
+		const u32 idx = Pos >> 16;
+		if(idx + Taps > WorkFrames)
+			break;
+
+		const s16 *c = Coeffs + ((Pos & 0xFFFF) >> (16 - RESAMPLE_PHASE_BITS)) * Taps;
+		const s16 *in = Work + idx * Channels;
+		for(u32 chan = 0; chan < Channels; ++chan)
+		{
+			s32 acc = 1 << (CoeffShift - 1);
+			for(u32 k = 0; k < Taps; ++k)
+				acc += in[k * Channels + chan] * c[k];
+			acc >>= CoeffShift;
+			dst[out * Channels + chan] = acc < -32768 ? -32768 : (acc > 32767 ? 32767 : acc);
+		}
+		Pos += Step;
+		++out;
+	}
+
+	/* keep the input the next outputs still need */
+	u32 used = Pos >> 16;
+	if(used > WorkFrames)
+		used = WorkFrames;
+	memmove(Work, Work + used * Channels, (WorkFrames - used) * Channels * sizeof(s16));
+	WorkFrames -= used;
+	Pos -= used << 16;
+
+	return out;
+}
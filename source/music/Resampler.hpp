@@ -0,0 +1,52 @@
+/****************************************************************************
+ * Streaming polyphase resampler for 16 bit pcm.
+ *
+ * The filter is a windowed sinc split into RESAMPLE_PHASES phases of Q14
+ * taps, built once per stream. The input frames the next outputs still need
+ * are kept between calls, so decoded blocks join without clicks.
+ ****************************************************************************/
+#ifndef _RESAMPLER_HPP_
+#define _RESAMPLER_HPP_
+
+#include <gctypes.h>
+
+#define RESAMPLE_PHASE_BITS	8
+#define RESAMPLE_PHASES		(1 << RESAMPLE_PHASE_BITS)
+
+enum
+{
+	RESAMPLE_LINEAR = 0,	/* 2 taps, what the old upsampler did */
+	RESAMPLE_MEDIUM,		/* 8 taps */
+	RESAMPLE_HIGH,			/* 16 taps */
+	RESAMPLE_QUALITY_MAX
+};
+
+class Resampler
+{
+public:
+	Resampler();
+	~Resampler();
+	/* maxSrcFrames is the most input a single Process call gets */
+	bool Init(u32 srcRate, u32 dstRate, u8 channels, u8 quality, u32 maxSrcFrames);
+	void Free();
+	/* forget the kept input, for seeking */
+	void Reset();
+	/* push out what the filter still holds at the end of the stream, then Reset */
+	u32 Flush(s16 *dst, u32 maxDstFrames);
+	bool IsActive() const { return Coeffs != NULL; }
+	u8 GetTaps() const { return Taps; }
+	/* returns the output frames written. srcFrames is set to the input frames taken,
+	   less than asked only when dst filled up first, pass the rest again next time */
+	u32 Process(const s16 *src, u32 &srcFrames, s16 *dst, u32 maxDstFrames);
+private:
+	s16 *Coeffs;
+	s16 *Work;
+	u32 WorkFrames;
+	u32 WorkSize;
+	u32 Pos;
+	u32 Step;
+	u8 Taps;
+	u8 Channels;
+};
+
+#endif
@@ -32,9 +32,6 @@
 #include "SoundDecoder.hpp"
 #include "MusicPlayer.hpp"
 
-static const u32 FixedPointShift = 15;
-static const u32 FixedPointScale = 1 << FixedPointShift;
-
 SoundDecoder::SoundDecoder()
 {
 	file_fd = NULL;
@@ -73,6 +70,7 @@ void SoundDecoder::Init()
 	SoundBlocks = 8;
 	SoundBlockSize = 8192;
 	ResampleTo48kHz = MusicPlayer.ResampleSetting;
+	ResampleQuality = MusicPlayer.ResampleQuality;
 	CurPos = 0;
 	LoopStart = 0;
 	LoopEnd = 0;
@@ -83,13 +81,15 @@ void SoundDecoder::Init()
 	SoundBuffer.SetBufferBlockSize(SoundBlockSize);
 	SoundBuffer.Resize(SoundBlocks);
 	ResampleBuffer = NULL;
-	ResampleRatio = 0;
+	ResampleKept = 0;
+	Underruns = 0;
 }
 
 int SoundDecoder::Rewind()
 {
 	CurPos = 0;
 	EndOfFile = false;
+	ResetUpsample();
 	file_fd->rewind();
 
 	return 0;
@@ -106,61 +106,70 @@ int SoundDecoder::Read(u8 * buffer, int buffer_size)
 void SoundDecoder::EnableUpsample(void)
 {
 	if(   (ResampleBuffer == NULL)
-	   && IsStereo() && Is16Bit()
+	   && Is16Bit()
 	   && SampleRate != 32000
 	   && SampleRate < 48000)
 	{
+		const int frameSize = IsStereo() ? 4 : 2;
+		// read less per block so the upsampled block still fits, less the filter history
+		int readSize = (int)(((u64)SoundBlockSize * SampleRate) / 48000);
+		readSize = (readSize / frameSize - 16) * frameSize;
+		if(readSize <= 0)
+			return;
+
 		ResampleBuffer = (u8*)memalign(32, SoundBlockSize);
-		ResampleRatio =  ( FixedPointScale * SampleRate ) / 48000;
-		SoundBlockSize = ( SoundBlockSize * ResampleRatio ) / FixedPointScale;
-		SoundBlockSize &= ~0x03;
+		if(!ResampleBuffer)
+			return;
+		if(!Upsampler.Init(SampleRate, 48000, frameSize / 2, ResampleQuality, readSize / frameSize))
+		{
+			free(ResampleBuffer);
+			ResampleBuffer = NULL;
+			return;
+		}
+		SoundBlockSize = readSize;
 		// set new sample rate
 		SampleRate = 48000;
 	}
 }
 
-void SoundDecoder::Upsample(s16 *src, s16 *dst, u32 nr_src_samples, u32 nr_dst_samples)
+int SoundDecoder::Upsample(const u8 *src, int &size, u8 *dst, int dstSize, bool flush)
 {
-	int timer = 0;
-
-	for(u32 i = 0, n = 0; i < nr_dst_samples; i += 2)
+	const int frameSize = IsStereo() ? 4 : 2;
+	const u32 maxOut = dstSize / frameSize;
+	u32 left = size / frameSize;
+	u32 out = 0;
+	// the filter takes as much as its history has room for, go on until dst is full
+	while(left > 0 && out < maxOut)
 	{
-		if((n+3) < nr_src_samples) {
-			// simple fixed point linear interpolation
-			dst[i]   = src[n] +   ( ((src[n+2] - src[n]  ) * timer) >> FixedPointShift );
-			dst[i+1] = src[n+1] + ( ((src[n+3] - src[n+1]) * timer) >> FixedPointShift );
-		}
-		else {
-			dst[i]   = src[n];
-			dst[i+1] = src[n+1];
-		}
-
-		timer += ResampleRatio;
-
-		if(timer >= (int)FixedPointScale) {
-			n += 2;
-			timer -= FixedPointScale;
-		}
+		u32 taken = left;
+		out += Upsampler.Process((const s16*)src, taken, (s16*)dst + out * (frameSize / 2), maxOut - out);
+		if(taken == 0)
+			break;
+		src += taken * frameSize;
+		left -= taken;
 	}
+	size -= left * frameSize;
+	// the tail only comes out after the last input went in
+	if(flush && left == 0)
+		out += Upsampler.Flush((s16*)dst + out * (frameSize / 2), maxOut - out);
+
+	return out * frameSize;
 }
 
 void SoundDecoder::Decode()
 {
-	if(!file_fd || ExitRequested || EndOfFile)
-		return;
-
-	u16 newWhich = SoundBuffer.Which();
-	u16 i = 0;
-	for(i = 0; i < SoundBuffer.Size()-2; i++)
-	{
-		if(!SoundBuffer.IsBufferReady(newWhich))
-			break;
+	while(DecodeBlock())
+		;
+}
 
-		newWhich = (newWhich+1) % SoundBuffer.Size();
-	}
+bool SoundDecoder::DecodeBlock()
+{
+	if(!file_fd || ExitRequested || EndOfFile)
+		return false;
 
-	if(i == SoundBuffer.Size()-2)
-		return;
+	int newWhich = SoundBuffer.GetFreeBuffer();
+	if(newWhich < 0)
+		return false;
 
 	Decoding = true;
 
@@ -170,24 +179,42 @@ void SoundDecoder::Decode()
 	{
 		ExitRequested = true;
 		Decoding = false;
-		return;
+		return false;
 	}
 
 	//*******************************************
 	if(ResampleTo48kHz && !ResampleBuffer)
 		EnableUpsample();
 
+	// with the resampler on the decoder writes to the side buffer first,
+	// behind what the last block could not pass on
+	u8 *read_buf = ResampleBuffer ? ResampleBuffer : write_buf;
+	if(ResampleBuffer)
+		done = ResampleKept;
+	int written = 0;
+	int start = 0;
+	bool rewound = false;
 	while(done < SoundBlockSize)
 	{
-		int ret = Read(&write_buf[done], SoundBlockSize-done);
+		int ret = Read(&read_buf[done], SoundBlockSize-done);
 
 		if(ret <= 0)
 		{
-			if(Loop || LoopStart || LoopEnd)
+			// let the end of the song out of the filter before a rewind resets it
+			if(ResampleBuffer)
+			{
+				int used = done - start;
+				written += Upsample(&read_buf[start], used, &write_buf[written],
+							SoundBuffer.GetBufferBlockSize() - written, true);
+				start += used;
+			}
+			// a rewind that gives nothing would spin here forever
+			if((Loop || LoopStart || LoopEnd) && !rewound)
 			{
 				Rewind();
 				if(LoopStart)
 					CurPos = LoopStart;
+				rewound = true;
 				continue;
 			}
 			else
@@ -197,29 +224,28 @@ void SoundDecoder::Decode()
 			}
 		}
 
+		rewound = false;
 		done += ret;
 	}
 
-	if(done > 0)
+	if(ResampleBuffer)
 	{
-		// check if we need to resample
-		if(ResampleBuffer && ResampleRatio)
-		{
-			memcpy(ResampleBuffer, write_buf, done);
-
-			int src_samples = done >> 1;
-			int dest_samples = ( src_samples * FixedPointScale ) / ResampleRatio;
-			dest_samples &= ~0x01;
-			Upsample((s16*)ResampleBuffer, (s16*)write_buf, src_samples, dest_samples);
-			done = dest_samples << 1;
-		}
-		SoundBuffer.SetBufferSize(newWhich, done);
-		SoundBuffer.SetBufferReady(newWhich, true);
+		int used = done - start;
+		int end = done;
+		done = written + Upsample(&read_buf[start], used, &write_buf[written],
+							SoundBuffer.GetBufferBlockSize() - written, false);
+		start += used;
+		// input the block had no room for goes in front of the next one,
+		// at the end of the file that next block also flushes the filter
+		ResampleKept = end - start;
+		memmove(read_buf, &read_buf[start], ResampleKept);
+		if(ResampleKept > 0)
+			EndOfFile = false;
 	}
-
-	if(!SoundBuffer.IsBufferReady((newWhich+1) % SoundBuffer.Size()))
-		Decode();
+	if(done > 0)
+		SoundBuffer.CommitBuffer(newWhich, done);
 
 	Decoding = false;
-}
 
+	return !EndOfFile && SoundBuffer.GetFreeBuffer() >= 0;
+}
@@ -32,6 +32,7 @@
 //#include "Tools/timer.h"
 #include "File.hpp"
 #include "BufferCircle.hpp"
+#include "Resampler.hpp"
 #include "loader/utils.h"
 
 enum
@@ -53,11 +54,13 @@ public:
 	virtual ~SoundDecoder();
 	virtual int Read(u8 * buffer, int buffer_size);
 	virtual int Tell() { return CurPos; };
-	virtual int Seek(int pos) { CurPos = pos; return file_fd->seek(CurPos, SEEK_SET); };
+	virtual int Seek(int pos) { CurPos = pos; ResetUpsample(); return file_fd->seek(CurPos, SEEK_SET); };
 	virtual int Rewind();
 	virtual u8 GetFormat() { return Format; }
 	virtual u32 GetSampleRate() { return SampleRate; }
 	virtual void Decode();
+	//!> decode one block, true if there is room for another one
+	bool DecodeBlock();
 	virtual u32 GetBufferSize() { return SoundBuffer.GetBufferSize(); };
 	virtual u8 * GetBuffer() { return SoundBuffer.GetBuffer(); };
 	virtual u8 * GetNextBuffer() { return SoundBuffer.GetNextBuffer(); };
@@ -76,9 +79,14 @@ public:
 	virtual bool Is16Bit() { return (GetFormat() == VOICE_STEREO_16BIT || GetFormat() == VOICE_MONO_16BIT); };
 	
 	void EnableUpsample(void);
+	//!> the voice wanted a buffer that was not decoded yet
+	void AddUnderrun() { ++Underruns; };
+	u32 GetUnderruns() { return Underruns; };
 protected:
 	void Init();
-	void Upsample(s16 *src, s16 *dst, u32 nr_src_samples, u32 nr_dst_samples);
+	//!> size is set to the bytes taken from src, the rest has to be passed again
+	int Upsample(const u8 *src, int &size, u8 *dst, int dstSize, bool flush);
+	void ResetUpsample() { Upsampler.Reset(); ResampleKept = 0; };
 	
 	CFile * file_fd;
 	BufferCircle SoundBuffer;
@@ -87,6 +95,7 @@ protected:
 	int SoundBlockSize;
 	int CurPos;
 	bool ResampleTo48kHz;
+	u8 ResampleQuality;
 	bool Loop;
 	int LoopStart;
 	int LoopEnd;
@@ -96,7 +105,9 @@ protected:
 	u8 Format;
 	u32 SampleRate;
 	u8 *ResampleBuffer;
-	u32 ResampleRatio;
+	int ResampleKept;//!> bytes at the start of ResampleBuffer the last block had no room for
+	Resampler Upsampler;
+	u32 Underruns;
 };
 
 #endif
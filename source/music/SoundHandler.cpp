@@ -33,6 +33,7 @@
 #include "BNSDecoder.hpp"
 #include "gecko/gecko.hpp"
 #include "memory/mem2.hpp"
+#include "memory/scratch.hpp"
 
 SoundHandler SoundHandle;
 
@@ -44,7 +45,14 @@ void SoundHandler::Init()
 	Decoding = false;
 	ExitRequested = false;
 	for(u32 i = 0; i < MAX_DECODERS; ++i)
+	{
 		DecoderList[i] = NULL;
+		NextDecoder[i] = NULL;
+		RetiredDecoder[i] = NULL;
+		RetiredAge[i] = 0;
+		SwitchCount[i] = 0;
+	}
+	LWP_MutexInit(&NextMutex, false);
 
 	LWP_CreateThread(&SoundThread, UpdateThread, this, SoundStack, SoundStackSize, 64);
 	gprintf("Running sound thread\n");
@@ -60,6 +68,7 @@ void SoundHandler::Cleanup()
 	SoundThread = LWP_THREAD_NULL;
 
 	ClearDecoderList();
+	LWP_MutexDestroy(NextMutex);
 	gprintf("Stopped sound thread\n");
 }
 
@@ -94,6 +103,25 @@ void SoundHandler::AddDecoder(int voice, const u8 * snd, int len)
 	DecoderList[voice] = GetSoundDecoder(snd, len);
 }
 
+void SoundHandler::DeleteDecoder(SoundDecoder *decoder)
+{
+	if(decoder->GetUnderruns() > 0)
+		gprintf("SoundHandler: decoder ran dry %u times\n", decoder->GetUnderruns());
+	decoder->ClearBuffer();
+	if(decoder->GetSoundType() == SOUND_OGG)
+		delete((OggDecoder *)decoder);
+	else if(decoder->GetSoundType() == SOUND_MP3)
+		delete((Mp3Decoder *)decoder);
+	else if(decoder->GetSoundType() == SOUND_WAV)
+		delete((WavDecoder *)decoder);
+	else if(decoder->GetSoundType() == SOUND_AIF)
+		delete((AifDecoder *)decoder);
+	else if(decoder->GetSoundType() == SOUND_BNS)
+		delete((BNSDecoder *)decoder);
+	else
+		delete decoder;
+}
+
 void SoundHandler::RemoveDecoder(int voice)
 {
 	if(voice < 0 || voice >= MAX_DECODERS)
@@ -101,27 +129,157 @@ void SoundHandler::RemoveDecoder(int voice)
 
 	if(DecoderList[voice] != NULL)
 	{
-		(*DecoderList[voice]).ClearBuffer();
-		if(DecoderList[voice]->GetSoundType() == SOUND_OGG)
-			delete((OggDecoder *)DecoderList[voice]);
-		else if(DecoderList[voice]->GetSoundType() == SOUND_MP3)
-			delete((Mp3Decoder *)DecoderList[voice]);
-		else if(DecoderList[voice]->GetSoundType() == SOUND_WAV)
-			delete((WavDecoder *)DecoderList[voice]);
-		else if(DecoderList[voice]->GetSoundType() == SOUND_AIF)
-			delete((AifDecoder *)DecoderList[voice]);
-		else if(DecoderList[voice]->GetSoundType() == SOUND_BNS)
-			delete((BNSDecoder *)DecoderList[voice]);
-		else
-			delete DecoderList[voice];
+		SoundDecoder *decoder = DecoderList[voice];
 		DecoderList[voice] = NULL;
+		DeleteDecoder(decoder);
 	}
+	// the voice is stopped when a decoder gets removed, nothing plays the old buffers anymore
+	u32 level = IRQ_Disable();
+	SoundDecoder *retired = RetiredDecoder[voice];
+	RetiredDecoder[voice] = NULL;
+	IRQ_Restore(level);
+	if(retired != NULL)
+		DeleteDecoder(retired);
 }
 
 void SoundHandler::ClearDecoderList()
 {
 	for(u32 i = 0; i < MAX_DECODERS; ++i)
+	{
+		ClearNext(i);
 		RemoveDecoder(i);
+	}
+}
+
+void SoundHandler::QueueNext(int voice, const char *filepath)
+{
+	if(voice < 0 || voice >= MAX_DECODERS || filepath == NULL)
+		return;
+
+	LWP_MutexLock(NextMutex);
+	bool same = (NextPath[voice] == filepath);
+	LWP_MutexUnlock(NextMutex);
+	if(same)
+		return;
+
+	ClearNext(voice);
+	LWP_MutexLock(NextMutex);
+	NextPath[voice] = filepath;
+	LWP_MutexUnlock(NextMutex);
+	ThreadSignal();
+}
+
+void SoundHandler::ClearNext(int voice)
+{
+	if(voice < 0 || voice >= MAX_DECODERS)
+		return;
+
+	LWP_MutexLock(NextMutex);
+	NextPath[voice].clear();
+	u32 level = IRQ_Disable();
+	SoundDecoder *next = NextDecoder[voice];
+	NextDecoder[voice] = NULL;
+	IRQ_Restore(level);
+	LWP_MutexUnlock(NextMutex);
+
+	if(next != NULL)
+		DeleteDecoder(next);
+}
+
+bool SoundHandler::SwitchToNext(int voice)
+{
+	SoundDecoder *cur = DecoderList[voice];
+	SoundDecoder *next = NextDecoder[voice];
+	// the old decoder has to wait until its last buffer is played out
+	if(cur == NULL || next == NULL || RetiredDecoder[voice] != NULL || !next->IsBufferReady())
+		return false;
+	// asnd can't change the format of a running voice
+	if(next->GetFormat() != cur->GetFormat() || next->GetSampleRate() != cur->GetSampleRate())
+		return false;
+
+	RetiredDecoder[voice] = cur;
+	RetiredAge[voice] = 0;
+	DecoderList[voice] = next;
+	NextDecoder[voice] = NULL;
+	++SwitchCount[voice];
+	return true;
+}
+
+bool SoundHandler::UseNextDecoder(int voice, const char *filepath)
+{
+	if(voice < 0 || voice >= MAX_DECODERS || filepath == NULL)
+		return false;
+
+	LWP_MutexLock(NextMutex);
+	SoundDecoder *next = NULL;
+	if(NextPath[voice] == filepath)
+	{
+		u32 level = IRQ_Disable();
+		next = NextDecoder[voice];
+		NextDecoder[voice] = NULL;
+		IRQ_Restore(level);
+		if(next != NULL)
+			NextPath[voice].clear();
+	}
+	LWP_MutexUnlock(NextMutex);
+
+	if(next == NULL)
+		return false;
+
+	RemoveDecoder(voice);
+	DecoderList[voice] = next;
+	return true;
+}
+
+void SoundHandler::PrepareNextDecoders()
+{
+	for(int i = 0; i < MAX_DECODERS && !ExitRequested; ++i)
+	{
+		LWP_MutexLock(NextMutex);
+		std::string path;
+		if(NextDecoder[i] == NULL)
+			path = NextPath[i];
+		LWP_MutexUnlock(NextMutex);
+		if(path.empty())
+			continue;
+
+		// opening and decoding the first blocks happens here, not in the gui thread
+		SoundDecoder *decoder = GetSoundDecoder(path.c_str());
+
+		LWP_MutexLock(NextMutex);
+		if(NextPath[i] == path)
+		{
+			if(decoder != NULL && decoder->IsBufferReady())
+			{
+				NextDecoder[i] = decoder;
+				decoder = NULL;
+			}
+			else // don't try that file again
+				NextPath[i].clear();
+		}
+		LWP_MutexUnlock(NextMutex);
+
+		if(decoder != NULL)
+			DeleteDecoder(decoder);
+	}
+}
+
+void SoundHandler::FreeRetiredDecoders(bool force)
+{
+	for(int i = 0; i < MAX_DECODERS; ++i)
+	{
+		if(RetiredDecoder[i] == NULL)
+			continue;
+		if(!force && RetiredAge[i] < 2 && ASND_StatusVoice(i) != SND_UNUSED)
+			continue;
+
+		u32 level = IRQ_Disable();
+		SoundDecoder *retired = RetiredDecoder[i];
+		RetiredDecoder[i] = NULL;
+		IRQ_Restore(level);
+		if(retired != NULL)
+			DeleteDecoder(retired);
+	}
 }
 
 static inline bool CheckMP3Signature(const u8 * buffer)
@@ -234,21 +392,34 @@ void * SoundHandler::UpdateThread(void *arg)
 void SoundHandler::InternalSoundUpdates()
 {
 	u16 i = 0;
+	ScratchArena &scratch = ScratchArena::Get(SCRATCH_SOUND);
+	scratch.Bind();
 	LWP_InitQueue(&ThreadQueue);
 	while(!ExitRequested)
 	{
 		LWP_ThreadSleep(ThreadQueue);
 
-		for(i = 0; i < MAX_DECODERS; ++i)
+		// one block per decoder and round, so a slow stream can't starve the others
+		bool more = true;
+		while(more && !ExitRequested)
 		{
-			if(DecoderList[i] == NULL)
-				continue;
-
-			Decoding = true;
-			DecoderList[i]->Decode();
+			more = false;
+			for(i = 0; i < MAX_DECODERS; ++i)
+			{
+				if(DecoderList[i] == NULL)
+					continue;
+
+				Decoding = true;
+				if(DecoderList[i]->DecodeBlock())
+					more = true;
+			}
 		}
 		Decoding = false;
+		FreeRetiredDecoders(false);
+		PrepareNextDecoders();
+		scratch.Reset();
 	}
+	scratch.Unbind();
 	LWP_CloseQueue(ThreadQueue);
 	ThreadQueue = LWP_TQUEUE_NULL;
 }
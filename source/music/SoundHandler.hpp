@@ -27,6 +27,7 @@
 #define SOUNDHANDLER_H_
 
 #include <vector>
+#include <string>
 #include <gccore.h>
 #include "SoundDecoder.hpp"
 
@@ -46,6 +47,19 @@ public:
 	SoundDecoder *Decoder(int i) { return ((i < 0 || i >= MAX_DECODERS) ? NULL : DecoderList[i]); };
 	void ThreadSignal() { LWP_ThreadSignal(ThreadQueue); };
 	bool IsDecoding() { return Decoding; };
+
+	/* gapless playback: the sound thread opens the queued file ahead of time and
+	   the voice callback moves over to it once the current decoder runs out */
+	void QueueNext(int voice, const char *filepath);
+	void ClearNext(int voice);
+	//!> voice callback, true if the voice now plays the queued decoder
+	bool SwitchToNext(int voice);
+	//!> use the queued decoder for filepath right away instead of opening it again
+	bool UseNextDecoder(int voice, const char *filepath);
+	//!> how often the voice moved on to a queued decoder
+	u32 GetSwitchCount(int voice) { return ((voice < 0 || voice >= MAX_DECODERS) ? 0 : SwitchCount[voice]); };
+	//!> voice callback, tells when the buffers of a replaced decoder are played out
+	void VoiceCallback(int voice) { if(voice >= 0 && voice < MAX_DECODERS && RetiredDecoder[voice] != NULL) ++RetiredAge[voice]; };
 private: //thread stack
 	static u8 SoundStack[32768];
 	static const u32 SoundStackSize;
@@ -53,6 +67,9 @@ protected:
 	static void *UpdateThread(void *arg);
 	void InternalSoundUpdates();
 	void ClearDecoderList();
+	void PrepareNextDecoders();
+	void FreeRetiredDecoders(bool force);
+	void DeleteDecoder(SoundDecoder *decoder);
 	SoundDecoder *GetSoundDecoder(const char *filepath);
 	SoundDecoder *GetSoundDecoder(const u8 *sound, int length);
 
@@ -62,6 +79,13 @@ protected:
 	bool ExitRequested;
 
 	SoundDecoder *DecoderList[MAX_DECODERS];
+
+	mutex_t NextMutex;
+	std::string NextPath[MAX_DECODERS];
+	SoundDecoder *volatile NextDecoder[MAX_DECODERS];
+	SoundDecoder *volatile RetiredDecoder[MAX_DECODERS];
+	volatile u8 RetiredAge[MAX_DECODERS];
+	volatile u32 SwitchCount[MAX_DECODERS];
 };
 extern SoundHandler SoundHandle;
 
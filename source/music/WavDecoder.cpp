@@ -133,8 +133,11 @@ void WavDecoder::OpenFile()
 		{
 			file_fd->seek(-8, SEEK_CUR);
 			file_fd->read((u8*)&SmplChunk, sizeof(SWaveSmplChunk));
-			SmplChunk.Start = ((le32(SmplChunk.Start) * le16(FmtChunk.channels) * le16(FmtChunk.bps) / 8) + 8191) & ~8191;
-			SmplChunk.End = ((le32(SmplChunk.End) * le16(FmtChunk.channels) * le16(FmtChunk.bps) / 8) + 8191) & ~8191;
+			// sample numbers to byte positions, the end sample is still played
+			SmplChunk.Start = le32(SmplChunk.Start) * le16(FmtChunk.channels) * le16(FmtChunk.bps) / 8;
+			SmplChunk.End = (le32(SmplChunk.End) + 1) * le16(FmtChunk.channels) * le16(FmtChunk.bps) / 8;
+			if(SmplChunk.End > DataSize || SmplChunk.Start >= SmplChunk.End)
+				SmplChunk.Start = SmplChunk.End = 0;
 			break;
 		}
 		file_fd->seek(le32(LoopChunk.size), SEEK_CUR);
@@ -157,13 +160,15 @@ int WavDecoder::Read(u8 * buffer, int buffer_size)
 	if(!file_fd)
 		return -1;
 
-	if(CurPos >= (int) DataSize)
+	// stop at the loop end so the decoder jumps back to the loop start
+	int end = LoopEnd > 0 ? LoopEnd : (int) DataSize;
+	if(CurPos >= end)
 		return 0;
 
 	file_fd->seek(DataOffset+CurPos, SEEK_SET);
 
-	if(buffer_size > (int) DataSize-CurPos)
-		buffer_size = DataSize-CurPos;
+	if(buffer_size > end-CurPos)
+		buffer_size = end-CurPos;
 
 	int read = file_fd->read(buffer, buffer_size);
 	if(read > 0)
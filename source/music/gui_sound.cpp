@@ -57,10 +57,15 @@ static inline int GetFirstUnusedVoice()
 
 extern "C" void SoundCallback(s32 voice)
 {
+	SoundHandle.VoiceCallback(voice);
 	SoundDecoder *decoder = SoundHandle.Decoder(voice);
 	if(!decoder)
 		return;
 
+	// a queued sound continues right where this one ends
+	if(!decoder->IsBufferReady() && decoder->IsEOF() && SoundHandle.SwitchToNext(voice))
+		decoder = SoundHandle.Decoder(voice);
+
 	if(decoder->IsBufferReady())
 	{
 		if(ASND_AddVoice(voice, decoder->GetBuffer(), decoder->GetBufferSize()) == SND_OK)
@@ -72,7 +77,10 @@ extern "C" void SoundCallback(s32 voice)
 	else if(decoder->IsEOF())
 		ASND_StopVoice(voice);
 	else
+	{
+		decoder->AddUnderrun();
 		SoundHandle.ThreadSignal();
+	}
 }
 
 GuiSound::GuiSound()
@@ -171,7 +179,8 @@ bool GuiSound::Load(const char *path)
 		return false;
 	}
 
-	SoundHandle.AddDecoder(this->voice, path);
+	if(!SoundHandle.UseNextDecoder(this->voice, path))
+		SoundHandle.AddDecoder(this->voice, path);
 	//gprintf("gui_sound.cpp: Loading %s using voice %d\n", path, this->voice);
 	SoundDecoder *decoder = SoundHandle.Decoder(this->voice);
 	if(!decoder)
@@ -250,7 +259,12 @@ bool GuiSound::LoadSoundEffect(const u8 * snd, u32 len)
 		done += read;
 	}
 
-	sound = (u8 *)MEM2_realloc(sound, done);
+	if(done > 0)// keep the bigger buffer if it can't be shrunk, size 0 would free it
+	{
+		u8 *tmpsnd = (u8 *)MEM2_realloc(sound, done);
+		if(tmpsnd != NULL)
+			sound = tmpsnd;
+	}
 	SoundEffectLength = done;
 	allocated = true;
 
@@ -376,6 +390,11 @@ void GuiSound::SetVoice(s8 v)
 {
 	this->voice = v;
 }
+void GuiSound::SetName(const char *path)
+{
+	strncpy(this->filepath, path, 255);
+	this->filepath[255] = '\0';
+}
 
 void soundInit(void)
 {
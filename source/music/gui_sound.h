@@ -88,6 +88,8 @@ public:
 	void SetVoice(s8 v);
 	//!Needed for music :P
 	s8 GetVoice() { return voice; }
+	//!The voice went on to a queued file by itself
+	void SetName(const char *path);
 private:
 	//!Initializes the GuiSound object by setting the default values
 	void Init();
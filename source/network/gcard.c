@@ -21,7 +21,13 @@ u8 register_card_provider(const char *url, const char *key)
 {
 	if(strlen(url) > 0 && strlen(key) > 0 && strstr(url, "{KEY}") != NULL && strstr(url, "{ID6}") != NULL)
 	{
-		providers = (struct provider*)MEM2_realloc(providers, (amount_of_providers + 1) * sizeof(struct provider));
+		struct provider *tmp = (struct provider*)MEM2_realloc(providers, (amount_of_providers + 1) * sizeof(struct provider));
+		if(tmp == NULL)
+		{
+			gprintf("Out of memory for gamercard provider!\n");
+			return -1;
+		}
+		providers = tmp;
 		memset(&providers[amount_of_providers], 0, sizeof(struct provider));
 		strncpy(providers[amount_of_providers].url, url, 127);
 		strncpy(providers[amount_of_providers].key, key, 128);
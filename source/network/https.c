@@ -164,8 +164,9 @@ bool read_chunked(HTTP_INFO *httpinfo, struct download *buffer, size_t start_pos
             gprintf("Increased buffer size\n");
 #endif
             capacity *= 2;
-            buffer->data = MEM2_realloc(buffer->data, capacity);
-            if (!buffer->data) // A custom theme is using too much memory
+            // on failure the old buffer stays with the caller, who frees it
+            char *data = MEM2_realloc(buffer->data, capacity);
+            if (!data) // A custom theme is using too much memory
             {
 #ifdef DEBUG_NETWORK
                 gprintf("Out of memory!\n");
@@ -173,6 +174,7 @@ bool read_chunked(HTTP_INFO *httpinfo, struct download *buffer, size_t start_pos
                 errno = ENOMEM;
                 return false;
             }
+            buffer->data = data;
         }
         if ((ret = https_read(httpinfo, &buffer->data[start_pos], capacity - start_pos, false)) < 1)
             return false;
@@ -188,7 +190,13 @@ bool read_chunked(HTTP_INFO *httpinfo, struct download *buffer, size_t start_pos
         start_pos += rsize;
     } while (pret == -2);
     buffer->size = start_pos;
-    buffer->data = MEM2_realloc(buffer->data, buffer->size);
+    // keep the bigger buffer if it can't be shrunk, size 0 would free it
+    if (buffer->size > 0)
+    {
+        char *data = MEM2_realloc(buffer->data, buffer->size);
+        if (data)
+            buffer->data = data;
+    }
     return true;
 }
 
@@ -207,8 +215,9 @@ bool read_all(HTTP_INFO *httpinfo, struct download *buffer, size_t start_pos)
             gprintf("Increased buffer size\n");
 #endif
             capacity *= 2;
-            buffer->data = MEM2_realloc(buffer->data, capacity);
-            if (!buffer->data) // A custom theme is using too much memory
+            // on failure the old buffer stays with the caller, who frees it
+            char *data = MEM2_realloc(buffer->data, capacity);
+            if (!data) // A custom theme is using too much memory
             {
 #ifdef DEBUG_NETWORK
                 gprintf("Out of memory!\n");
@@ -216,6 +225,7 @@ bool read_all(HTTP_INFO *httpinfo, struct download *buffer, size_t start_pos)
                 errno = ENOMEM;
                 return false;
             }
+            buffer->data = data;
         }
         if ((ret = https_read(httpinfo, &buffer->data[start_pos], capacity - start_pos, false)) == 0)
             break;
@@ -224,7 +234,13 @@ bool read_all(HTTP_INFO *httpinfo, struct download *buffer, size_t start_pos)
         start_pos += ret;
     };
     buffer->size = start_pos;
-    buffer->data = MEM2_realloc(buffer->data, buffer->size);
+    // keep the bigger buffer if it can't be shrunk, size 0 would free it
+    if (buffer->size > 0)
+    {
+        char *data = MEM2_realloc(buffer->data, buffer->size);
+        if (data)
+            buffer->data = data;
+    }
     return (buffer->content_length > 0 && buffer->content_length == start_pos);
 }
 
@@ -27,7 +27,9 @@
  ***************************************************************************/
 
 #include <string.h>
+#include <ctype.h>
 #include "U8Archive.h"
+#include "memory/mem2.hpp"
 
 static char *u8Filename(const struct U8Entry *fst, int i)
 {
@@ -72,4 +74,182 @@ const u8 *u8_get_file(const u8 *archive, const char *filename, u32 *size)
 		
 	*size = fst[i].fileLength;
 	return archive + fst[i].fileOffset;
-}
\ No newline at end of file
+}
+
+static u32 u8NameHash(const char *name, u32 len)
+{
+	u32 hash = 2166136261u;
+	u32 i;
+	for (i = 0; i < len; ++i)
+		hash = (hash ^ (u8)tolower((u8)name[i])) * 16777619u;
+	return hash;
+}
+
+bool u8_index_init(struct U8Index *idx, const u8 *archive, u32 size)
+{
+	u32 i;
+	memset(idx, 0, sizeof(struct U8Index));
+	if (archive == NULL || size < sizeof(struct U8Header)) return false;
+
+	struct U8Header *arcHdr = open_u8_archive(archive);
+	if (arcHdr == NULL || arcHdr->rootNodeOffset > size - sizeof(struct U8Entry)) return false;
+
+	const struct U8Entry *fst = (const struct U8Entry *)(archive + arcHdr->rootNodeOffset);
+	u32 numEntries = fst[0].numEntries;
+	if (fst[0].fileType == 0 || numEntries == 0 || numEntries > (size - arcHdr->rootNodeOffset) / sizeof(struct U8Entry))
+		return false;
+
+	u32 tableSize = 16;
+	while (tableSize < numEntries * 2)
+		tableSize <<= 1;
+
+	idx->parents = (u32 *)MEM2_alloc((numEntries + tableSize) * sizeof(u32));
+	if (idx->parents == NULL) return false;
+	idx->table = idx->parents + numEntries;
+	memset(idx->table, 0, tableSize * sizeof(u32));
+
+	idx->archive = archive;
+	idx->fst = fst;
+	idx->names = (const char *)(fst + numEntries);
+	idx->numEntries = numEntries;
+	idx->tableMask = tableSize - 1;
+
+	const u32 namesSize = size - (u32)((const u8 *)idx->names - archive);
+	u32 dir = 0;
+	idx->parents[0] = 0;
+	for (i = 1; i < numEntries; ++i)
+	{
+		while (dir != 0 && i >= fst[dir].numEntries)
+			dir = idx->parents[dir];
+		idx->parents[i] = dir;
+		if (fst[i].fileType != 0)
+			dir = i;
+
+		/* files pointing outside the archive and broken names are left out */
+		if (fst[i].nameOffset >= namesSize || memchr(idx->names + fst[i].nameOffset, 0, namesSize - fst[i].nameOffset) == NULL)
+			continue;
+		if (fst[i].fileType == 0 && (fst[i].fileOffset > size || fst[i].fileLength > size - fst[i].fileOffset))
+			continue;
+
+		/* linear probing in entry order keeps the first entry of a name in front */
+		const char *name = idx->names + fst[i].nameOffset;
+		u32 slot = u8NameHash(name, strlen(name)) & idx->tableMask;
+		while (idx->table[slot] != 0)
+			slot = (slot + 1) & idx->tableMask;
+		idx->table[slot] = i;
+	}
+	return true;
+}
+
+void u8_index_free(struct U8Index *idx)
+{
+	if (idx->parents != NULL)
+		MEM2_free(idx->parents);
+	memset(idx, 0, sizeof(struct U8Index));
+}
+
+static bool u8PathMatches(const struct U8Index *idx, u32 entry, const char *path, u32 len)
+{
+	/* compare the directories from the back, the name itself already matched */
+	while (len > 0 && path[len - 1] != '/')
+		--len;
+	while (len > 0)
+	{
+		--len; /* the slash */
+		u32 start = len;
+		while (start > 0 && path[start - 1] != '/')
+			--start;
+
+		entry = idx->parents[entry];
+		if (start == len && start == 0)
+			return entry == 0; /* leading slash */
+		if (entry == 0)
+			return false;
+
+		const char *name = u8Filename(idx->fst, entry);
+		if (strlen(name) != len - start || strncasecmp(name, path + start, len - start) != 0)
+			return false;
+		len = start;
+	}
+	return idx->parents[entry] == 0;
+}
+
+static s32 u8IndexLookup(const struct U8Index *idx, const char *path, bool dirs)
+{
+	if (idx->table == NULL || path == NULL) return -1;
+
+	u32 len = strlen(path);
+	const char *slash = strrchr(path, '/');
+	const char *name = slash ? slash + 1 : path;
+	u32 nameLen = len - (u32)(name - path);
+
+	u32 slot = u8NameHash(name, nameLen) & idx->tableMask;
+	while (idx->table[slot] != 0)
+	{
+		u32 entry = idx->table[slot];
+		if ((idx->fst[entry].fileType != 0) == dirs && strcasecmp(u8Filename(idx->fst, entry), name) == 0
+				&& (slash == NULL || u8PathMatches(idx, entry, path, len)))
+			return entry;
+		slot = (slot + 1) & idx->tableMask;
+	}
+	return -1;
+}
+
+s32 u8_index_find(const struct U8Index *idx, const char *path)
+{
+	return u8IndexLookup(idx, path, false);
+}
+
+const u8 *u8_index_get_data(const struct U8Index *idx, u32 entry, u32 *size)
+{
+	if (entry == 0 || entry >= idx->numEntries || idx->fst[entry].fileType != 0)
+		return NULL;
+
+	*size = idx->fst[entry].fileLength;
+	return idx->archive + idx->fst[entry].fileOffset;
+}
+
+const u8 *u8_index_get_file(const struct U8Index *idx, const char *path, u32 *size)
+{
+	s32 entry = u8_index_find(idx, path);
+	if (entry < 0)
+		return NULL;
+	return u8_index_get_data(idx, entry, size);
+}
+
+s32 u8_index_find_dir(const struct U8Index *idx, const char *path)
+{
+	if (idx->table == NULL) return -1;
+	if (path == NULL || path[0] == 0 || strcmp(path, "/") == 0)
+		return 0;
+	return u8IndexLookup(idx, path, true);
+}
+
+u32 u8_index_next(const struct U8Index *idx, u32 dir, u32 entry)
+{
+	if (dir >= idx->numEntries || idx->fst[dir].fileType == 0)
+		return 0;
+
+	/* skip over the contents of a subdirectory */
+	if (entry == dir)
+		++entry;
+	else if (idx->fst[entry].fileType != 0 && idx->fst[entry].numEntries > entry)
+		entry = idx->fst[entry].numEntries;
+	else
+		++entry;
+
+	u32 end = dir == 0 ? idx->numEntries : idx->fst[dir].numEntries;
+	if (end > idx->numEntries)
+		end = idx->numEntries;
+	return entry < end ? entry : 0;
+}
+
+const char *u8_index_name(const struct U8Index *idx, u32 entry)
+{
+	return entry < idx->numEntries ? u8Filename(idx->fst, entry) : NULL;
+}
+
+bool u8_index_is_dir(const struct U8Index *idx, u32 entry)
+{
+	return entry < idx->numEntries && idx->fst[entry].fileType != 0;
+}
@@ -55,6 +55,18 @@ struct U8Entry
 	};
 } ATTRIBUTE_PACKED;
 
+/* Lookup index over an archive that stays in memory, the returned files point into it */
+struct U8Index
+{
+	const u8 *archive;
+	const struct U8Entry *fst;
+	const char *names;
+	u32 numEntries;
+	u32 *parents;
+	u32 *table;
+	u32 tableMask;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -62,6 +74,19 @@ extern "C" {
 const u8 *u8_get_file_by_index(const u8 *archive, u32 index, u32 *size);
 const u8 *u8_get_file(const u8 *archive, const char *filename, u32 *size);
 
+/* names without a slash match in any directory like u8_get_file, others are full paths */
+bool u8_index_init(struct U8Index *idx, const u8 *archive, u32 size);
+void u8_index_free(struct U8Index *idx);
+s32 u8_index_find(const struct U8Index *idx, const char *path);
+const u8 *u8_index_get_file(const struct U8Index *idx, const char *path, u32 *size);
+const u8 *u8_index_get_data(const struct U8Index *idx, u32 entry, u32 *size);
+
+/* directory walk, pass the directory itself as entry to get the first child, 0 means done */
+s32 u8_index_find_dir(const struct U8Index *idx, const char *path);
+u32 u8_index_next(const struct U8Index *idx, u32 dir, u32 entry);
+const char *u8_index_name(const struct U8Index *idx, u32 entry);
+bool u8_index_is_dir(const struct U8Index *idx, u32 entry);
+
 #ifdef __cplusplus
 }
 #endif
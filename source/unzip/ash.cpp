@@ -19,435 +19,312 @@
 #include <memory/mem2.hpp>
 //#include <malloc.h>
 #include <string.h>
+#include <new>
 
 #include "ash.h"
 #include "gecko/gecko.hpp"
+#include "memory/scratch.hpp"
+
+/* ASH0 layout: "ASH0", decompressed size, offset of the distance stream, symbol stream from 0xC on.
+   Both streams are big endian 32 bit words read msb first. Each starts with its huffman tree in
+   preorder (1 = inner node, 0 = leaf followed by 9 or 11 bits), followed by the codes. Symbols
+   below 0x100 are literals, the others copy (symbol - 0xFD) bytes from distance + 1 back. */
+
+static inline u32 ReadBE32( const u8 *p )
+{
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
 
 bool IsAshCompressed( const u8 *stuff, u32 len )
 {
 	return ( len > 0x10 &&
-			 ((*(u32*)( stuff )) & 0xFFFFFF00 ) == 0x41534800 );
+			 (ReadBE32( stuff ) & 0xFFFFFF00 ) == 0x41534800 );
 }
 
-u8*	DecompressAsh( const u8 *stuff, u32 &len )
+u32 GetAshDecompressedSize( const u8 *stuff, u32 len )
 {
 	if( !IsAshCompressed( stuff, len ) )
-	{
-		return NULL;
-	}
-
-	unsigned int r[32];
-	unsigned int count = 0;
-	unsigned int t;
-
-	r[4] = (u32)stuff;	  //in
-
-	r[5] = 0x415348;
-	r[6] = 0x415348;
+		return 0;
+	return ReadBE32( stuff + 4 ) & 0x00FFFFFF;
+}
 
-	r[5] = s32(*(unsigned int *)(r[4]+4));
-	r[5] = r[5] & 0x00FFFFFF;
+inline void AshDecoder::InitBits( BitReader &br, u32 start )
+{
+	br.pos = start;
+	br.buf = 0;
+	br.count = 0;
+	Refill( br );
+}
 
-	u32 size = r[5];
-	//gprintf("Decompressed size: %d\n", size);
-	u8* buf1 = (u8*)MEM2_lo_alloc(size);
-	if( !buf1 )
+inline void AshDecoder::Refill( BitReader &br )
+{
+	while( br.count <= 32 )
 	{
-		gprintf( "ASH: no memory\n" );
-		return NULL;
+		u32 word = 0;
+		if( br.pos + 4 <= br.end )
+			word = ReadBE32( br.data + br.pos );
+		else
+		{
+			for( u32 i = 0; i < 4; ++i )
+				word = (word << 8) | (br.pos + i < br.end ? br.data[br.pos + i] : 0);
+		}
+		br.buf |= (u64)word << (32 - br.count);
+		br.count += 32;
+		br.pos += 4;
 	}
-	r[3] = (u32)buf1;   //out
-	memset( (void*)buf1, 0, size );
-	//printf("r[3] :%08X\n", r[3]);
+}
 
-	//printf("\n\n");
+inline u32 AshDecoder::GetBits( BitReader &br, u32 n )
+{
+	if( br.count < n )
+		Refill( br );
+	u32 ret = (u32)(br.buf >> (64 - n));
+	br.buf <<= n;
+	br.count -= n;
+	return ret;
+}
 
-	r[24] = 0x10;
-	r[28] = s32(*(unsigned int *)(r[4]+8));
-	r[25] = 0;
-	r[29] = 0;
-	r[26] = s32(*(unsigned int *)(r[4]+0xC));
-	r[30] = s32(*(unsigned int *)(r[4]+r[28]));
-	r[28] = r[28] + 4;
-	//r[8]  = 0x8108<<16;
-	//HACK, pointer to RAM
-	u8* workingBuffer = (u8*)MEM2_lo_alloc(0x100000);
-	if( !workingBuffer )
+/* the tree comes in preorder, pending children are kept on a stack. 0x4000 marks a */
+/* missing left child, 0x8000 a missing right one, the same as the original decoder. */
+u16 AshDecoder::BuildTree( BitReader &br, u32 leafBits, u16 base, u32 maxNodes, u16 *left, u16 *right )
+{
+	u32 sp = 0;
+	u32 next = base;
+	while( !error )
 	{
-		gprintf( "ASH: no memory 2\n" );
-		MEM2_lo_free(buf1);
-		return NULL;
+		if( GetBits( br, 1 ) )
+		{
+			if( next >= base + maxNodes )
+				break;
+			stack[sp++] = next | 0x8000;
+			stack[sp++] = next | 0x4000;
+			next++;
+			continue;
+		}
+		u16 value = GetBits( br, leafBits );
+		while( sp > 0 )
+		{
+			u16 entry = stack[--sp];
+			u16 node = entry & 0x1FFF;
+			if( entry & 0x4000 )
+			{
+				left[node - base] = value;
+				break;
+			}
+			right[node - base] = value;
+			value = node;
+			if( sp == 0 )
+				return value;
+		}
+		if( sp == 0 )
+			break;// a tree that is just one leaf
 	}
-	r[8]  = (u32)workingBuffer;
-	memset( (void*)workingBuffer, 0, 0x100000 );
-	//printf("r[8] :%08X\n", r[8]);
-
-	r[8]  = r[8];
-	r[9]  = r[8]  + 0x07FE;
-	r[10] = r[9]  + 0x07FE;
-	r[11] = r[10] + 0x1FFE;
-	r[31] = r[11] + 0x1FFE;
-	r[23] = 0x200;
-	r[22] = 0x200;
-	r[27] = 0;
-
-loc_81332124:
-
-	if( r[25] != 0x1F )
-		goto loc_81332140;
-
-	r[0] = r[26] >> 31;
-	r[26]= s32(*(unsigned int *)(r[4] + r[24]));
-	r[25]= 0;
-	r[24]= r[24] + 4;
-	goto loc_8133214C;
-
-loc_81332140:
-
-	r[0] = r[26] >> 31;
-	r[25]= r[25] + 1;
-	r[26]= r[26] << 1;
-
-loc_8133214C:
-
-	if( r[0] == 0 )
-		goto loc_81332174;
-
-	r[0] = r[23] | 0x8000;
-	*(unsigned short *)(r[31]) = s16(r[0]);
-	r[0] = r[23] | 0x4000;
-	*(unsigned short *)(r[31]+2) = s16(r[0]);
-
-	r[31] = r[31] + 4;
-	r[27] = r[27] + 2;
-	r[23] = r[23] + 1;
-	r[22] = r[22] + 1;
-
-	goto loc_81332124;
-
-loc_81332174:
-
-	r[12] = 9;
-	r[21] = r[25] + r[12];
-	t = r[21];
-	if( r[21] > 0x20 )
-		goto loc_813321AC;
-
-	r[21] = (~(r[12] - 0x20))+1;
-	r[6]  = r[26] >> r[21];
-	if( t == 0x20 )
-		goto loc_8133219C;
-
-	r[26] = r[26] << r[12];
-	r[25] = r[25] +  r[12];
-	goto loc_813321D0;
-
-loc_8133219C:
-
-	r[26]= s32(*(unsigned int *)(r[4] + r[24]));
-	r[25]= 0;
-	r[24]= r[24] + 4;
-	goto loc_813321D0;
-
-loc_813321AC:
-
-	r[0] = (~(r[12] - 0x20))+1;
-	r[6] = r[26] >> r[0];
-	r[26]= s32(*(unsigned int *)(r[4] + r[24]));
-	r[0] = (~(r[21] - 0x40))+1;
-	r[24]= r[24] + 4;
-	r[0] = r[26] >> r[0];
-	r[6] = r[6] | r[0];
-	r[25] = r[21] - 0x20;
-	r[26] = r[26] << r[25];
-
-loc_813321D0:
-
-	r[12]= s16(*(unsigned short *)(r[31] - 2));
-	r[31] -= 2;
-	r[27]= r[27] - 1;
-	r[0] = r[12] & 0x8000;
-	r[12]= (r[12] & 0x1FFF) << 1;
-	if( r[0] == 0 )
-		goto loc_813321F8;
-
-	*(unsigned short *)(r[9]+r[12]) = s16(r[6]);
-	r[6] = (r[12] & 0x3FFF)>>1;					 //   extrwi  %r6, %r12, 14,17
-	if( r[27] != 0 )
-		goto loc_813321D0;
-
-	goto loc_81332204;
-
-loc_813321F8:
-
-	*(unsigned short *)(r[8]+r[12]) = s16(r[6]);
-	r[23] = r[22];
-	goto loc_81332124;
-
-loc_81332204:
-
-	r[23] = 0x800;
-	r[22] = 0x800;
-
-loc_8133220C:
-
-	if( r[29] != 0x1F )
-		goto loc_81332228;
-
-	r[0] = r[30] >> 31;
-	r[30]= s32(*(unsigned int *)(r[4] + r[28]));
-	r[29]= 0;
-	r[28]= r[28] + 4;
-	goto loc_81332234;
-
-loc_81332228:
-
-	r[0] = r[30] >> 31;
-	r[29]= r[29] +  1;
-	r[30]= r[30] << 1;
-
-loc_81332234:
-
-	if( r[0] == 0 )
-		goto loc_8133225C;
-
-	r[0] = r[23] | 0x8000;
-	*(unsigned short *)(r[31]) = s16(r[0]);
-	r[0] = r[23] | 0x4000;
-	*(unsigned short *)(r[31]+2) = s16(r[0]);
-
-	r[31] = r[31] + 4;
-	r[27] = r[27] + 2;
-	r[23] = r[23] + 1;
-	r[22] = r[22] + 1;
-
-	goto loc_8133220C;
-
-loc_8133225C:
-
-	r[12] = 0xB;
-	r[21] = r[29] + r[12];
-	t = r[21];
-	if( r[21] > 0x20 )
-		goto loc_81332294;
-
-	r[21] = (~(r[12] - 0x20))+1;
-	r[7]  = r[30] >> r[21];
-	if( t == 0x20 )
-		goto loc_81332284;
-
-	r[30] = r[30] << r[12];
-	r[29] = r[29] +  r[12];
-	goto loc_813322B8;
-
-loc_81332284:
-
-	r[30]= s32(*(unsigned int *)(r[4] + r[28]));
-	r[29]= 0;
-	r[28]= r[28] + 4;
-	goto loc_813322B8;
-
-loc_81332294:
-
-	r[0] = (~(r[12] - 0x20))+1;
-	r[7] = r[30] >> r[0];
-	r[30]= s32(*(unsigned int *)(r[4] + r[28]));
-	r[0] = (~(r[21] - 0x40))+1;
-	r[28]= r[28] + 4;
-	r[0] = r[30] >> r[0];
-	r[7] = r[7] | r[0];
-	r[29]= r[21] - 0x20;
-	r[30]= r[30] << r[29];
-
-loc_813322B8:
-
-	r[12]= s16(*(unsigned short *)(r[31] - 2));
-	r[31] -= 2;
-	r[27]= r[27] - 1;
-	r[0] = r[12] & 0x8000;
-	r[12]= (r[12] & 0x1FFF) << 1;
-	if( r[0] == 0 )
-		goto loc_813322E0;
-
-	*(unsigned short *)(r[11]+r[12]) = s16(r[7]);
-	r[7] = (r[12] & 0x3FFF)>>1;					 // extrwi  %r7, %r12, 14,17
-	if( r[27] != 0 )
-		goto loc_813322B8;
-
-	goto loc_813322EC;
-
-loc_813322E0:
-
-	*(unsigned short *)(r[10]+r[12]) = s16(r[7]);
-	r[23] = r[22];
-	goto loc_8133220C;
-
-loc_813322EC:
-
-	r[0] = r[5];
-
-loc_813322F0:
-
-	r[12]= r[6];
-
-loc_813322F4:
-
-	if( r[12] < 0x200 )
-		goto loc_8133233C;
-
-	if( r[25] != 0x1F )
-		goto loc_81332318;
-
-	r[31] = r[26] >> 31;
-	r[26] = s32(*(unsigned int *)(r[4] + r[24]));
-	r[24] = r[24] + 4;
-	r[25] = 0;
-	goto loc_81332324;
-
-loc_81332318:
-
-	r[31] = r[26] >> 31;
-	r[25] = r[25] +  1;
-	r[26] = r[26] << 1;
-
-loc_81332324:
-
-	r[27] = r[12] << 1;
-	if( r[31] != 0 )
-		goto loc_81332334;
-
-	r[12] = s16(*(unsigned short *)(r[8] + r[27]));
-	goto loc_813322F4;
-
-loc_81332334:
-
-	r[12] = s16(*(unsigned short *)(r[9] + r[27]));
-	goto loc_813322F4;
-
-loc_8133233C:
-
-	if( r[12] >= 0x100 )
-		goto loc_8133235C;
-
-	*(unsigned char *)(r[3]) = r[12];
-	r[3] = r[3] + 1;
-	r[5] = r[5] - 1;
-	if( r[5] != 0 )
-		goto loc_813322F0;
-
-	goto loc_81332434;
-
-loc_8133235C:
-
-	r[23] = r[7];
-
-loc_81332360:
-
-	if( r[23] < 0x800 )
-		goto loc_813323A8;
-
-	if( r[29] != 0x1F )
-		goto loc_81332384;
-
-	r[31] = r[30] >> 31;
-	r[30] = s32(*(unsigned int *)(r[4] + r[28]));
-	r[28] = r[28] + 4;
-	r[29] = 0;
-	goto loc_81332390;
-
-loc_81332384:
-
-	r[31] = r[30] >> 31;
-	r[29] = r[29] +  1;
-	r[30] = r[30] << 1;
-
-loc_81332390:
-
-	r[27] = r[23] << 1;
-	if( r[31] != 0 )
-		goto loc_813323A0;
-
-	r[23] = s16(*(unsigned short *)(r[10] + r[27]));
-	goto loc_81332360;
-
-loc_813323A0:
-
-	r[23] = s16(*(unsigned short *)(r[11] + r[27]));
-	goto loc_81332360;
-
-loc_813323A8:
-
-	r[12] = r[12] - 0xFD;
-	r[23] = ~r[23] + r[3] + 1;
-	r[5]  = ~r[12] + r[5] + 1;
-	r[31] = r[12] >> 3;
-
-	if( r[31] == 0 )
-		goto loc_81332414;
-
-	count = r[31];
-
-loc_813323C0:
-
-	r[31] = *(unsigned char *)(r[23] - 1);
-	*(unsigned char *)(r[3]) = r[31];
-
-	r[31] = *(unsigned char *)(r[23]);
-	*(unsigned char *)(r[3]+1) = r[31];
-
-	r[31] = *(unsigned char *)(r[23] + 1);
-	*(unsigned char *)(r[3]+2) = r[31];
-
-	r[31] = *(unsigned char *)(r[23] + 2);
-	*(unsigned char *)(r[3]+3) = r[31];
-
-	r[31] = *(unsigned char *)(r[23] + 3);
-	*(unsigned char *)(r[3]+4) = r[31];
-
-	r[31] = *(unsigned char *)(r[23] + 4);
-	*(unsigned char *)(r[3]+5) = r[31];
-
-	r[31] = *(unsigned char *)(r[23] + 5);
-	*(unsigned char *)(r[3]+6) = r[31];
-
-	r[31] = *(unsigned char *)(r[23] + 6);
-	*(unsigned char *)(r[3]+7) = r[31];
-
-	r[23] = r[23] + 8;
-	r[3]  = r[3]  + 8;
-
-	if( --count )
-		goto loc_813323C0;
-
-	r[12] = r[12] & 7;
-	if( r[12] == 0 )
-		goto loc_8133242C;
+	error = true;
+	return 0;
+}
 
-loc_81332414:
+void AshDecoder::BuildTable( u16 *table, u16 node, u32 depth, u32 code, u16 base, const u16 *left, const u16 *right )
+{
+	if( node < base || depth == ASH_TABLE_BITS )
+	{
+		u32 shift = ASH_TABLE_BITS - depth;
+		u16 entry = node | (depth << 12);
+		for( u32 i = 0; i < (1u << shift); ++i )
+			table[(code << shift) + i] = entry;
+		return;
+	}
+	BuildTable( table, left[node - base], depth + 1, code << 1, base, left, right );
+	BuildTable( table, right[node - base], depth + 1, (code << 1) | 1, base, left, right );
+}
 
-	count = r[12];
+inline u16 AshDecoder::DecodeSym( BitReader &br, const u16 *table, u16 base, const u16 *left, const u16 *right )
+{
+	if( br.count < ASH_TABLE_BITS )
+		Refill( br );
+	u16 entry = table[br.buf >> (64 - ASH_TABLE_BITS)];
+	u32 len = entry >> 12;
+	br.buf <<= len;
+	br.count -= len;
+	u16 node = entry & 0xFFF;
+	/* codes longer than the table walk the rest of the tree */
+	while( node >= base )
+		node = GetBits( br, 1 ) ? right[node - base] : left[node - base];
+	return node;
+}
 
-loc_81332418:
+bool AshDecoder::Open( const u8 *stuff, u32 len )
+{
+	error = true;
+	if( !IsAshCompressed( stuff, len ) )
+		return false;
+
+	u32 distStart = ReadBE32( stuff + 8 );
+	if( distStart < 0xC || distStart >= len )
+		return false;
+	size = ReadBE32( stuff + 4 ) & 0x00FFFFFF;
+	symBits.data = distBits.data = stuff;
+	symBits.end = distBits.end = len;
+	InitBits( symBits, 0xC );
+	InitBits( distBits, distStart );
+
+	error = false;
+	u16 symRoot = BuildTree( symBits, 9, ASH_SYM_NODES, ASH_SYM_NODES, symLeft, symRight );
+	u16 distRoot = BuildTree( distBits, 11, ASH_DIST_NODES, ASH_DIST_NODES, distLeft, distRight );
+	if( error )
+		return false;
+	BuildTable( symTable, symRoot, 0, 0, ASH_SYM_NODES, symLeft, symRight );
+	BuildTable( distTable, distRoot, 0, 0, ASH_DIST_NODES, distLeft, distRight );
+
+	remaining = size;
+	matchLen = 0;
+	matchDist = 0;
+	windowPos = 0;
+	return true;
+}
 
-	r[31] = *(unsigned char *)(r[23] - 1);
-	r[23] = r[23] + 1;
-	*(unsigned char *)(r[3]) = r[31];
-	r[3]  = r[3] + 1;
+bool AshDecoder::Decode( u8 *out )
+{
+	if( error || remaining != size )
+		return false;
 
-	if( --count )
-		goto loc_81332418;
+	u8 *dst = out;
+	u32 left = remaining;
+	while( left > 0 )
+	{
+		u16 sym = DecodeSym( symBits, symTable, ASH_SYM_NODES, symLeft, symRight );
+		if( sym < 0x100 )
+		{
+			*dst++ = sym;
+			left--;
+			continue;
+		}
+		u32 dist = DecodeSym( distBits, distTable, ASH_DIST_NODES, distLeft, distRight ) + 1;
+		u32 count = sym - 0xFD;
+		if( count > left || dist > (u32)(dst - out) )
+		{
+			error = true;
+			break;
+		}
+		const u8 *src = dst - dist;
+		left -= count;
+		if( dist >= count && count >= 32 )
+		{
+			memcpy( dst, src, count );
+			dst += count;
+		}
+		else /* short or overlapping, an overlap repeats the last dist bytes */
+		{
+			while( count-- )
+				*dst++ = *src++;
+		}
+	}
+	remaining = left;
+	return !error;
+}
 
-loc_8133242C:
+u32 AshDecoder::Read( u8 *out, u32 outSize )
+{
+	u32 done = 0;
+	while( done < outSize && remaining > 0 && !error )
+	{
+		if( matchLen == 0 )
+		{
+			u16 sym = DecodeSym( symBits, symTable, ASH_SYM_NODES, symLeft, symRight );
+			if( sym < 0x100 )
+			{
+				window[windowPos++ & (ASH_WINDOW - 1)] = sym;
+				out[done++] = sym;
+				remaining--;
+				continue;
+			}
+			matchDist = DecodeSym( distBits, distTable, ASH_DIST_NODES, distLeft, distRight ) + 1;
+			matchLen = sym - 0xFD;
+			if( matchLen > remaining || matchDist > windowPos )
+			{
+				error = true;
+				break;
+			}
+		}
+		u32 count = matchLen < outSize - done ? matchLen : outSize - done;
+		for( u32 i = 0; i < count; ++i )
+		{
+			u8 b = window[(windowPos - matchDist) & (ASH_WINDOW - 1)];
+			window[windowPos++ & (ASH_WINDOW - 1)] = b;
+			out[done++] = b;
+		}
+		matchLen -= count;
+		remaining -= count;
+	}
+	return error ? 0 : done;
+}
 
-	if( r[5] != 0 )
-		goto loc_813322F0;
+static u32 DecodeAshTo( AshDecoder *ash, const u8 *stuff, u32 len, u8 *out, u32 outSize )
+{
+	if( ash->Open( stuff, len ) && ash->Size() <= outSize && ash->Decode( out ) )
+		return ash->Size();
+	return 0;
+}
 
-loc_81332434:
+u32 DecompressAshTo( const u8 *stuff, u32 len, u8 *out, u32 outSize, AshDecoder *decoder )
+{
+	if( decoder != NULL )
+		return DecodeAshTo( decoder, stuff, len, out, outSize );
+	ScratchArena *arena = ScratchArena::Current();
+	if( arena != NULL )
+	{
+		ScratchScope scratch( *arena );
+		void *mem = scratch.Alloc( sizeof( AshDecoder ) );
+		if( mem != NULL )
+			return DecodeAshTo( new( mem ) AshDecoder, stuff, len, out, outSize );
+	}
+	AshDecoder *ash = new (std::nothrow) AshDecoder;
+	if( ash == NULL )
+	{
+		gprintf( "ASH: no memory\n" );
+		return 0;
+	}
+	u32 ret = DecodeAshTo( ash, stuff, len, out, outSize );
+	delete ash;
+	return ret;
+}
 
-	r[3] = r[0];
-	len = r[3];
+static u8 *DecodeAsh( AshDecoder *ash, const u8 *stuff, u32 &len )
+{
+	u8 *buf = NULL;
+	if( ash->Open( stuff, len ) )
+	{
+		buf = (u8*)MEM2_lo_alloc( ash->Size() );
+		if( buf == NULL )
+			gprintf( "ASH: no memory\n" );
+		else if( !ash->Decode( buf ) )
+		{
+			MEM2_lo_free( buf );
+			buf = NULL;
+		}
+		else
+			len = ash->Size();
+	}
+	return buf;
+}
 
-	//gprintf("Decompressed %d bytes\n", r[3]);
-	MEM2_lo_free(workingBuffer);
-	return buf1;
+u8*	DecompressAsh( const u8 *stuff, u32 &len )
+{
+	/* the decoder's work memory comes from the calling thread's scratch arena if it has one */
+	ScratchArena *arena = ScratchArena::Current();
+	if( arena != NULL )
+	{
+		ScratchScope scratch( *arena );
+		void *mem = scratch.Alloc( sizeof( AshDecoder ) );
+		if( mem != NULL )
+			return DecodeAsh( new( mem ) AshDecoder, stuff, len );
+	}
+	AshDecoder *ash = new (std::nothrow) AshDecoder;
+	if( ash == NULL )
+	{
+		gprintf( "ASH: no memory\n" );
+		return NULL;
+	}
+	u8 *buf = DecodeAsh( ash, stuff, len );
+	delete ash;
+	return buf;
 }
@@ -27,4 +27,68 @@ bool IsAshCompressed( const u8 *stuff, u32 len );
 //! this allocates memory with memalign, free it when you are done with it
 
 u8*	DecompressAsh( const u8 *stuff, u32 &len );
+
+// decompressed size from the header, 0 if the data is no ash
+u32 GetAshDecompressedSize( const u8 *stuff, u32 len );
+
+#define ASH_TABLE_BITS	10
+#define ASH_SYM_NODES	0x200
+#define ASH_DIST_NODES	0x800
+#define ASH_WINDOW		0x1000
+
+//! ASH0 decoder with its work memory, keep one around to decode several files.
+//! Either decode everything at once with Decode or pull the output with Read.
+class AshDecoder
+{
+public:
+	//! parses the header and both trees, false if the data is no valid ash
+	bool Open( const u8 *stuff, u32 len );
+	//! decompressed size of the opened data
+	u32 Size() const { return size; }
+	//! decodes the whole file into out, which has to hold at least Size() bytes
+	bool Decode( u8 *out );
+	//! streaming, decodes the next bytes into out. returns the bytes written, 0 at the end or on errors
+	u32 Read( u8 *out, u32 outSize );
+	bool Failed() const { return error; }
+private:
+	struct BitReader
+	{
+		const u8 *data;
+		u32 pos;
+		u32 end;
+		u64 buf;		// next bits, msb first
+		u32 count;		// valid bits in buf
+	};
+	inline void InitBits( BitReader &br, u32 start );
+	inline void Refill( BitReader &br );
+	inline u32 GetBits( BitReader &br, u32 n );
+	u16 BuildTree( BitReader &br, u32 leafBits, u16 base, u32 maxNodes, u16 *left, u16 *right );
+	void BuildTable( u16 *table, u16 node, u32 depth, u32 code, u16 base, const u16 *left, const u16 *right );
+	inline u16 DecodeSym( BitReader &br, const u16 *table, u16 base, const u16 *left, const u16 *right );
+
+	BitReader symBits;
+	BitReader distBits;
+	u32 size;
+	u32 remaining;
+	bool error;
+	/* trees, indexed by node - base */
+	u16 symLeft[ASH_SYM_NODES];
+	u16 symRight[ASH_SYM_NODES];
+	u16 distLeft[ASH_DIST_NODES];
+	u16 distRight[ASH_DIST_NODES];
+	/* first ASH_TABLE_BITS of each code, value in the low 12 bits and code length above */
+	u16 symTable[1 << ASH_TABLE_BITS];
+	u16 distTable[1 << ASH_TABLE_BITS];
+	u16 stack[ASH_DIST_NODES * 2];
+	/* streaming state */
+	u32 matchLen;
+	u32 matchDist;
+	u32 windowPos;
+	u8 window[ASH_WINDOW];
+};
+
+//! decompresses into a caller provided buffer of at least outSize bytes, returns the decompressed size or 0
+//! the decoder is optional, pass one to reuse its work memory
+u32 DecompressAshTo( const u8 *stuff, u32 len, u8 *out, u32 outSize, AshDecoder *decoder = NULL );
+
 #endif // ASH_H
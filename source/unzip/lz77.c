@@ -14,97 +14,143 @@
  ******************************************************************************/
 #include <gccore.h>
 #include <stdlib.h>
+#include <string.h>
 #include "lz77.h"
 #include "memory/mem2.hpp"
 
 static inline u32 packBytes(int a, int b, int c, int d)
 {
-	return (d << 24) | (c << 16) | (b << 8) | (a);
+	return ((u32)d << 24) | (c << 16) | (b << 8) | (a);
 }
 
-static int __decompressLZ77_11(const u8 *in, u32 inputLen, u8 **output, u32 *outputLen)
+/* header size and decompressed size, 0 if the header is broken */
+static u32 __headerLZ77(const u8 *in, u32 inputLen, u32 *decompressedSize)
 {
-	int x = 0;
-	u32 y = 0;
-	u32 compressedPos = 0x4;
-	u32 decompressedPos = 0;
-	u32 decompressedSize = packBytes(in[0], in[1], in[2], in[3]) >> 8;
-	if(decompressedSize == 0)
+	if(inputLen < 4)
+		return 0;
+	*decompressedSize = packBytes(in[0], in[1], in[2], in[3]) >> 8;
+	if(*decompressedSize == 0 && in[0] == LZ77_0x11_FLAG)
 	{
-		decompressedSize = packBytes(in[4], in[5], in[6], in[7]);
-		compressedPos += 0x4;
+		if(inputLen < 8)
+			return 0;
+		*decompressedSize = packBytes(in[4], in[5], in[6], in[7]);
+		return 8;
 	}
-	//printf("Decompressed size : %i\n", decompressedSize);
+	return 4;
+}
 
-	u8 *out = (u8*)MEM2_alloc(decompressedSize);
-	if(out == NULL)
+/* reads one back reference, returns 0 if it runs past the input */
+static inline int __matchLZ77(const u8 *in, u32 inputLen, u32 *compressedPos, u8 type, u32 *pos, u32 *copyLen)
+{
+	u32 cur = *compressedPos;
+	if(cur + 2 > inputLen)
+		return 0;
+	u8 first = in[cur];
+	u8 second = in[cur + 1];
+	if(type == LZ77_0x10_FLAG)
 	{
-		//printf("Out of memory\n");
-		return -1;
+		*pos = (((first << 8) | second) & 0xFFF) + 1;
+		*copyLen = (first >> 4) + 3;
+		*compressedPos = cur + 2;
 	}
+	else if(first >= 0x20)
+	{
+		*pos = (((first & 0xF) << 8) | second) + 1;
+		*copyLen = (first >> 4) + 1;
+		*compressedPos = cur + 2;
+	}
+	else if(first >= 0x10)
+	{
+		if(cur + 4 > inputLen)
+			return 0;
+		u8 third = in[cur + 2];
+		u8 fourth = in[cur + 3];
+		*pos = (((third & 0xF) << 8) | fourth) + 1;
+		*copyLen = ((second << 4) | ((first & 0xF) << 12) | (third >> 4)) + 273;
+		*compressedPos = cur + 4;
+	}
+	else
+	{
+		if(cur + 3 > inputLen)
+			return 0;
+		u8 third = in[cur + 2];
+		*pos = (((second & 0xF) << 8) | third) + 1;
+		*copyLen = (((first & 0xF) << 4) | (second >> 4)) + 17;
+		*compressedPos = cur + 3;
+	}
+	return 1;
+}
+
+static int __decompressLZ77(const u8 *in, u32 inputLen, u8 *out, u32 decompressedSize)
+{
+	u32 decompressedPos = 0;
+	u32 compressedPos = __headerLZ77(in, inputLen, &decompressedSize);
+	u8 type = in[0];
+	if(compressedPos == 0)
+		return -1;
 
 	while(compressedPos < inputLen && decompressedPos < decompressedSize)
 	{
-		u8 byteFlag = in[compressedPos];
-		compressedPos++;
-
-		for(x = 7; x >= 0; x--)
+		u8 byteFlag = in[compressedPos++];
+		int x;
+		for(x = 0; x < 8 && compressedPos < inputLen && decompressedPos < decompressedSize; ++x, byteFlag <<= 1)
 		{
-			if((byteFlag & (1 << x)) > 0)
+			if((byteFlag & 0x80) == 0)
 			{
-				u8 first = in[compressedPos];
-				u8 second = in[compressedPos + 1];
-
-				u32 pos, copyLen;
-				if(first < 0x20)
-				{
-					u8 third = in[compressedPos + 2];
-					if(first >= 0x10)
-					{
-						u32 fourth = in[compressedPos + 3];
-						pos = (u32)(((third & 0xF) << 8) | fourth) + 1;
-						copyLen = (u32)((second << 4) | ((first & 0xF) << 12) | (third >> 4)) + 273;
-						compressedPos += 4;
-					}
-					else
-					{
-						pos = (u32)(((second & 0xF) << 8) | third) + 1;
-						copyLen = (u32)(((first & 0xF) << 4) | (second >> 4)) + 17;
-						compressedPos += 3;
-					}
-				}
-				else
-				{
-					pos = (u32)(((first & 0xF) << 8) | second) + 1;
-					copyLen = (u32)(first >> 4) + 1;
-					compressedPos += 2;
-				}
-				for(y = 0; y < copyLen; y++)
-					out[decompressedPos + y] = out[decompressedPos - pos + y];
-				decompressedPos += copyLen;
+				out[decompressedPos++] = in[compressedPos++];
+				continue;
 			}
-			else
+			u32 pos, copyLen;
+			if(!__matchLZ77(in, inputLen, &compressedPos, type, &pos, &copyLen) || pos > decompressedPos)
+				return -1;
+			if(copyLen > decompressedSize - decompressedPos)
+				copyLen = decompressedSize - decompressedPos;
+			u8 *dst = out + decompressedPos;
+			const u8 *src = dst - pos;
+			decompressedPos += copyLen;
+			if(pos >= copyLen && copyLen >= 32)
+				memcpy(dst, src, copyLen);
+			else /* short or overlapping, an overlap repeats the last pos bytes */
 			{
-				out[decompressedPos] = in[compressedPos];
-				decompressedPos++;
-				compressedPos++;
+				while(copyLen--)
+					*dst++ = *src++;
 			}
-			if(compressedPos >= inputLen || decompressedPos >= decompressedSize)
-				break;
 		}
 	}
-	*output = out;
-	*outputLen = decompressedSize;
+	/* truncated input, keep the output defined */
+	if(decompressedPos < decompressedSize)
+		memset(out + decompressedPos, 0, decompressedSize - decompressedPos);
 	return 0;
 }
 
-static int __decompressLZ77_10(const u8 *in, u8 **output, u32 *outputLen)
+int isLZ77compressed(const u8 *buffer)
 {
-	int x = 0;
-	u32 y = 0;
-	u32 compressedPos = 0x4;
-	u32 decompressedPos = 0;
-	u32 decompressedSize = packBytes(in[0], in[1], in[2], in[3]) >> 8;
+	if((buffer[0] == LZ77_0x10_FLAG) || (buffer[0] == LZ77_0x11_FLAG))
+		return 1;
+	return 0;
+}
+
+u32 getLZ77decompressedSize(const u8 *buffer, u32 length)
+{
+	u32 decompressedSize = 0;
+	if(!isLZ77compressed(buffer) || __headerLZ77(buffer, length, &decompressedSize) == 0)
+		return 0;
+	return decompressedSize;
+}
+
+int decompressLZ77contentTo(const u8 *buffer, u32 length, u8 *output, u32 outputLen)
+{
+	u32 decompressedSize = getLZ77decompressedSize(buffer, length);
+	if(decompressedSize == 0 || decompressedSize > outputLen)
+		return -1;
+	return __decompressLZ77(buffer, length, output, decompressedSize);
+}
+
+int decompressLZ77content(const u8 *buffer, u32 length, u8 **output, u32 *outputLen)
+{
+	u32 decompressedSize = getLZ77decompressedSize(buffer, length);
+	if(decompressedSize == 0)
+		return -1;
 	//printf("Decompressed size : %i\n", decompressedSize);
 
 	u8 *out = (u8*)MEM2_alloc(decompressedSize);
@@ -113,65 +159,73 @@ static int __decompressLZ77_10(const u8 *in, u8 **output, u32 *outputLen)
 		//printf("Out of memory\n");
 		return -1;
 	}
-
-	while(decompressedPos < decompressedSize)
+	if(__decompressLZ77(buffer, length, out, decompressedSize) < 0)
 	{
-		u8 byteFlag = in[compressedPos];
-		compressedPos ++;
-
-		for(x = 0; x < 8; ++x)
-		{
-			if(byteFlag & 0x80)
-			{
-				u8 first = in[compressedPos];
-				u8 second = in[compressedPos + 1];
-				u16 pos = (u16)((((first << 8) + second) & 0xFFF) + 1);
-				u8 copyLen = (u8)(3 + ((first >> 4) & 0xF));
-				for(y = 0; y < copyLen; y++)
-					out[decompressedPos + y] = out[decompressedPos - pos + (y % pos)];
-				compressedPos += 2;
-				decompressedPos += copyLen;
-			}
-			else
-			{
-				out[decompressedPos] = in[compressedPos];
-				compressedPos += 1;
-				decompressedPos += 1;
-			}
-			byteFlag <<= 1;
-			if(decompressedPos >= decompressedSize)
-				break;
-		}
+		MEM2_free(out);
+		return -1;
 	}
 	*output = out;
 	*outputLen = decompressedSize;
 	return 0;
 }
 
-int isLZ77compressed(const u8 *buffer)
+int lz77StreamInit(lz77Stream *s, const u8 *buffer, u32 length)
 {
-	if((buffer[0] == LZ77_0x10_FLAG) || (buffer[0] == LZ77_0x11_FLAG))
-		return 1;
+	memset(s, 0, sizeof(lz77Stream));
+	if(!isLZ77compressed(buffer))
+		return -1;
+	s->inPos = __headerLZ77(buffer, length, &s->outSize);
+	if(s->inPos == 0)
+		return -1;
+	s->in = buffer;
+	s->inLen = length;
+	s->type = buffer[0];
 	return 0;
 }
 
-int decompressLZ77content(const u8 *buffer, u32 length, u8 **output, u32 *outputLen)
+u32 lz77StreamRead(lz77Stream *s, u8 *out, u32 size)
 {
-	int ret = 0;
-	switch(buffer[0])
+	u32 done = 0;
+	while(done < size && s->outPos < s->outSize)
 	{
-		case LZ77_0x10_FLAG:
-			//printf("LZ77 variant 0x10 compressed content...unpacking may take a while...\n");
-			ret = __decompressLZ77_10(buffer, output, outputLen);
-			break;
-		case LZ77_0x11_FLAG:
-			//printf("LZ77 variant 0x11 compressed content...unpacking may take a while...\n");
-			ret = __decompressLZ77_11(buffer, length, output, outputLen);
-			break;
-		default:
-			//printf("Not compressed ...\n");
-			ret = -1;
-			break;
+		if(s->matchLen == 0)
+		{
+			if(s->inPos >= s->inLen)
+				break;
+			if(s->flagBits == 0)
+			{
+				s->flags = s->in[s->inPos++];
+				s->flagBits = 8;
+				if(s->inPos >= s->inLen)
+					break;
+			}
+			u8 isMatch = s->flags & 0x80;
+			s->flags <<= 1;
+			s->flagBits--;
+			if(!isMatch)
+			{
+				u8 b = s->in[s->inPos++];
+				s->window[s->outPos++ & (LZ77_WINDOW - 1)] = b;
+				out[done++] = b;
+				continue;
+			}
+			if(!__matchLZ77(s->in, s->inLen, &s->inPos, s->type, &s->matchDist, &s->matchLen) || s->matchDist > s->outPos)
+			{
+				s->outSize = s->outPos;// broken stream, end it here
+				break;
+			}
+			if(s->matchLen > s->outSize - s->outPos)
+				s->matchLen = s->outSize - s->outPos;
+		}
+		u32 count = s->matchLen < size - done ? s->matchLen : size - done;
+		u32 i;
+		for(i = 0; i < count; ++i)
+		{
+			u8 b = s->window[(s->outPos - s->matchDist) & (LZ77_WINDOW - 1)];
+			s->window[s->outPos++ & (LZ77_WINDOW - 1)] = b;
+			out[done++] = b;
+		}
+		s->matchLen -= count;
 	}
-	return ret;
+	return done;
 }
@@ -18,6 +18,23 @@
  
 #define LZ77_0x10_FLAG 0x10
 #define LZ77_0x11_FLAG 0x11
+#define LZ77_WINDOW 0x1000
+
+/* streaming state, references go back at most LZ77_WINDOW bytes */
+typedef struct
+{
+	const u8 *in;
+	u32 inLen;
+	u32 inPos;
+	u32 outSize;
+	u32 outPos;
+	u32 matchLen;
+	u32 matchDist;
+	u8 type;
+	u8 flags;
+	u8 flagBits;
+	u8 window[LZ77_WINDOW];
+} lz77Stream;
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,6 +42,13 @@ extern "C" {
 
 int isLZ77compressed(const u8 *buffer);
 int decompressLZ77content(const u8 *buffer, u32 length, u8 **output, u32 *outputLen);
+/* 0 if the header is broken */
+u32 getLZ77decompressedSize(const u8 *buffer, u32 length);
+/* decompresses into a caller provided buffer, outputLen has to hold getLZ77decompressedSize bytes */
+int decompressLZ77contentTo(const u8 *buffer, u32 length, u8 *output, u32 outputLen);
+/* streaming, lz77StreamRead returns the bytes written to out, 0 at the end */
+int lz77StreamInit(lz77Stream *s, const u8 *buffer, u32 length);
+u32 lz77StreamRead(lz77Stream *s, u8 *out, u32 size);
 
 #ifdef __cplusplus
 }